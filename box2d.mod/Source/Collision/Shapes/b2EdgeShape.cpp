@@ -25,6 +25,11 @@ b2EdgeShape::b2EdgeShape(const b2Vec2& v1, const b2Vec2& v2, const b2ShapeDef* d
 
 	m_type = e_edgeShape;
 	
+	Set(v1, v2);
+}
+
+void b2EdgeShape::Set(const b2Vec2& v1, const b2Vec2& v2)
+{
 	m_prevEdge = NULL;
 	m_nextEdge = NULL;
 	
@@ -38,8 +43,11 @@ b2EdgeShape::b2EdgeShape(const b2Vec2& v1, const b2Vec2& v2, const b2ShapeDef* d
 	m_coreV1 = -b2_toiSlop * (m_normal - m_direction) + m_v1;
 	m_coreV2 = -b2_toiSlop * (m_normal + m_direction) + m_v2;
 	
+	// An open end stays like this, a neighbor set by b2ConnectEdges replaces it.
 	m_cornerDir1 = m_normal;
 	m_cornerDir2 = -1.0f * m_normal;
+	m_cornerConvex1 = true;
+	m_cornerConvex2 = true;
 }
 
 void b2EdgeShape::UpdateSweepRadius(const b2Vec2& center)
@@ -134,6 +142,19 @@ b2Vec2 b2EdgeShape::Support(const b2XForm& xf, const b2Vec2& d) const
 	return b2Dot(v1, d) > b2Dot(v2, d) ? v1 : v2;
 }
 
+float32 b2ConnectEdges(b2EdgeShape* s1, b2EdgeShape* s2, float32 angle1)
+{
+	float32 angle2 = b2Atan2(s2->GetDirectionVector().y, s2->GetDirectionVector().x);
+	b2Vec2 core = tanf((angle2 - angle1) * 0.5f) * s2->GetDirectionVector();
+	core = b2_toiSlop * (core - s2->GetNormalVector()) + s2->GetVertex1();
+	b2Vec2 cornerDir = s1->GetDirectionVector() + s2->GetDirectionVector();
+	cornerDir.Normalize();
+	bool convex = b2Dot(s1->GetDirectionVector(), s2->GetNormalVector()) > 0.0f;
+	s1->SetNextEdge(s2, core, cornerDir, convex);
+	s2->SetPrevEdge(s1, core, cornerDir, convex);
+	return angle2;
+}
+
 void b2EdgeShape::SetPrevEdge(b2EdgeShape* edge, const b2Vec2& core, const b2Vec2& cornerDir, bool convex)
 {
 	m_prevEdge = edge;
@@ -120,9 +120,14 @@ private:
 
 	friend class b2Shape;
 	friend class b2Body;
+	friend class b2MeshShape;
+	friend class b2HeightfieldShape;
 
 	b2EdgeShape(const b2Vec2& v1, const b2Vec2& v2, const b2ShapeDef* def);
 
+	// Move the vertices. This disconnects the edge from its neighbors.
+	void Set(const b2Vec2& v1, const b2Vec2& v2);
+
 	void UpdateSweepRadius(const b2Vec2& center);
 
 	b2Vec2 m_v1;
@@ -150,6 +155,11 @@ private:
 	b2EdgeShape* m_prevEdge;
 };
 
+/// Join two consecutive edges of a chain, setting up their shared core vertex and corner.
+/// @param angle1 the direction angle of the first edge.
+/// @return the direction angle of the second edge.
+float32 b2ConnectEdges(b2EdgeShape* s1, b2EdgeShape* s2, float32 angle1);
+
 inline float32 b2EdgeShape::GetLength() const
 {
 	return m_length;
@@ -0,0 +1,263 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2HeightfieldShape.h"
+#include "b2EdgeShape.h"
+
+#include <new>
+#include <cmath>
+
+b2HeightfieldShape::b2HeightfieldShape(const b2ShapeDef* def)
+: b2Shape(def)
+{
+	b2Assert(def->type == e_heightfieldShape);
+	m_type = e_heightfieldShape;
+	const b2HeightfieldDef* fieldDef = (const b2HeightfieldDef*)def;
+
+	b2Assert(fieldDef->sampleCount >= 2);
+	b2Assert(fieldDef->spacing > b2_linearSlop);
+	m_sampleCount = fieldDef->sampleCount;
+	m_spacing = fieldDef->spacing;
+
+	m_lowerHeight = fieldDef->minHeight;
+	m_upperHeight = fieldDef->maxHeight;
+	m_heights = (float32*)b2Alloc(m_sampleCount * sizeof(float32));
+	for (int32 i = 0; i < m_sampleCount; ++i)
+	{
+		m_heights[i] = fieldDef->heights[i];
+		m_lowerHeight = b2Min(m_lowerHeight, m_heights[i]);
+		m_upperHeight = b2Max(m_upperHeight, m_heights[i]);
+	}
+
+	// The edges share the heightfield's material.
+	b2ShapeDef edgeDef = *def;
+	edgeDef.type = e_edgeShape;
+
+	int32 edgeCount = m_sampleCount - 1;
+	m_edges = (b2EdgeShape*)b2Alloc(edgeCount * sizeof(b2EdgeShape));
+	for (int32 i = 0; i < edgeCount; ++i)
+	{
+		b2Vec2 v1((i + 1) * m_spacing, m_heights[i + 1]);
+		b2Vec2 v2(i * m_spacing, m_heights[i]);
+		new (m_edges + i) b2EdgeShape(v1, v2, &edgeDef);
+	}
+
+	m_sweepCenter.SetZero();
+	UpdateEdges(0, edgeCount - 1);
+}
+
+b2HeightfieldShape::~b2HeightfieldShape()
+{
+	for (int32 i = 0; i < m_sampleCount - 1; ++i)
+	{
+		m_edges[i].~b2EdgeShape();
+	}
+
+	b2Free(m_edges);
+	b2Free(m_heights);
+}
+
+void b2HeightfieldShape::SetHeight(int32 index, float32 height)
+{
+	SetHeights(index, &height, 1);
+}
+
+void b2HeightfieldShape::SetHeights(int32 first, const float32* heights, int32 count)
+{
+	b2Assert(0 <= first && count > 0 && first + count <= m_sampleCount);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		m_heights[first + i] = b2Clamp(heights[i], m_lowerHeight, m_upperHeight);
+	}
+
+	// Only the edges touching the changed samples move.
+	int32 edgeCount = m_sampleCount - 1;
+	int32 firstEdge = b2Max(first - 1, 0);
+	int32 lastEdge = b2Min(first + count - 1, edgeCount - 1);
+	for (int32 i = firstEdge; i <= lastEdge; ++i)
+	{
+		m_edges[i].Set(b2Vec2((i + 1) * m_spacing, m_heights[i + 1]), b2Vec2(i * m_spacing, m_heights[i]));
+	}
+
+	UpdateEdges(firstEdge, lastEdge);
+}
+
+// Rejoin the edges in [first, last] to each other and to their neighbors.
+// Edge i is followed by edge i - 1 along the chain.
+void b2HeightfieldShape::UpdateEdges(int32 first, int32 last)
+{
+	int32 edgeCount = m_sampleCount - 1;
+	int32 i = b2Min(last + 1, edgeCount - 1);
+	const b2Vec2& d = m_edges[i].GetDirectionVector();
+	float32 angle = b2Atan2(d.y, d.x);
+	for (; i > 0 && i > first - 1; --i)
+	{
+		angle = b2ConnectEdges(m_edges + i, m_edges + i - 1, angle);
+	}
+
+	for (i = first; i <= last; ++i)
+	{
+		m_edges[i].UpdateSweepRadius(m_sweepCenter);
+	}
+}
+
+const b2EdgeShape* b2HeightfieldShape::GetEdge(int32 index) const
+{
+	b2Assert(0 <= index && index < m_sampleCount - 1);
+	return m_edges + index;
+}
+
+int32 b2HeightfieldShape::Query(const b2AABB& aabb, int32* indices, int32 maxCount) const
+{
+	float32 inv = 1.0f / m_spacing;
+	int32 first = b2Max((int32)floorf(aabb.lowerBound.x * inv), 0);
+	int32 last = b2Min((int32)floorf(aabb.upperBound.x * inv), m_sampleCount - 2);
+
+	int32 count = 0;
+	for (int32 i = first; i <= last; ++i)
+	{
+		float32 h1 = m_heights[i];
+		float32 h2 = m_heights[i + 1];
+		if (b2Max(h1, h2) < aabb.lowerBound.y || aabb.upperBound.y < b2Min(h1, h2))
+		{
+			continue;
+		}
+
+		if (count < maxCount)
+		{
+			indices[count] = i;
+		}
+		++count;
+	}
+
+	return count;
+}
+
+bool b2HeightfieldShape::TestPoint(const b2XForm& transform, const b2Vec2& p) const
+{
+	b2Vec2 pLocal = b2MulT(transform, p);
+	float32 x = pLocal.x / m_spacing;
+	if (x < 0.0f || x > m_sampleCount - 1)
+	{
+		return false;
+	}
+
+	int32 i = b2Min((int32)x, m_sampleCount - 2);
+	float32 t = x - i;
+	float32 height = (1.0f - t) * m_heights[i] + t * m_heights[i + 1];
+	return m_lowerHeight <= pLocal.y && pLocal.y <= height;
+}
+
+b2SegmentCollide b2HeightfieldShape::TestSegment(const b2XForm& transform,
+								float32* lambda,
+								b2Vec2* normal,
+								const b2Segment& segment,
+								float32 maxLambda) const
+{
+	// Work in the local frame. The transform preserves the segment fraction.
+	b2Segment local;
+	local.p1 = b2MulT(transform, segment.p1);
+	local.p2 = b2MulT(transform, segment.p2);
+	b2Vec2 d = local.p2 - local.p1;
+
+	// Find the columns spanned by the segment.
+	float32 inv = 1.0f / m_spacing;
+	float32 x1 = local.p1.x * inv;
+	float32 x2 = (local.p1.x + maxLambda * d.x) * inv;
+	int32 lastColumn = m_sampleCount - 2;
+	int32 first = (int32)floorf(x1);
+	int32 last = (int32)floorf(x2);
+	int32 step = last >= first ? 1 : -1;
+	if (b2Max(first, last) < 0 || b2Min(first, last) > lastColumn)
+	{
+		return e_missCollide;
+	}
+
+	first = b2Clamp(first, 0, lastColumn);
+	last = b2Clamp(last, 0, lastColumn);
+
+	// Step through the columns in the ray direction, so the first hit is the closest.
+	for (int32 i = first; ; i += step)
+	{
+		b2Vec2 edgeNormal;
+		if (m_edges[i].TestSegment(b2XForm_identity, lambda, &edgeNormal, local, maxLambda) == e_hitCollide)
+		{
+			*normal = b2Mul(transform.R, edgeNormal);
+			return e_hitCollide;
+		}
+
+		if (i == last)
+		{
+			break;
+		}
+	}
+
+	return e_missCollide;
+}
+
+void b2HeightfieldShape::ComputeAABB(b2AABB* aabb, const b2XForm& transform) const
+{
+	b2Vec2 lower(0.0f, m_lowerHeight);
+	b2Vec2 upper((m_sampleCount - 1) * m_spacing, m_upperHeight);
+	b2Vec2 center = b2Mul(transform, 0.5f * (lower + upper));
+	b2Vec2 extents = b2Mul(b2Abs(transform.R), 0.5f * (upper - lower));
+	aabb->lowerBound = center - extents;
+	aabb->upperBound = center + extents;
+}
+
+void b2HeightfieldShape::ComputeSweptAABB(b2AABB* aabb, const b2XForm& transform1, const b2XForm& transform2) const
+{
+	b2AABB aabb1, aabb2;
+	ComputeAABB(&aabb1, transform1);
+	ComputeAABB(&aabb2, transform2);
+	aabb->lowerBound = b2Min(aabb1.lowerBound, aabb2.lowerBound);
+	aabb->upperBound = b2Max(aabb1.upperBound, aabb2.upperBound);
+}
+
+void b2HeightfieldShape::ComputeMass(b2MassData* massData) const
+{
+	massData->mass = 0;
+	massData->center = b2Vec2_zero;
+
+	// inertia about the local origin
+	massData->I = 0;
+}
+
+float32 b2HeightfieldShape::ComputeSubmergedArea(	const b2Vec2& normal,
+												float32 offset,
+												const b2XForm& xf, 
+												b2Vec2* c) const
+{
+	B2_NOT_USED(normal);
+	B2_NOT_USED(offset);
+	B2_NOT_USED(xf);
+	c->SetZero();
+	return 0.0f;
+}
+
+void b2HeightfieldShape::UpdateSweepRadius(const b2Vec2& center)
+{
+	m_sweepCenter = center;
+	m_sweepRadius = 0.0f;
+	for (int32 i = 0; i < m_sampleCount - 1; ++i)
+	{
+		m_edges[i].UpdateSweepRadius(center);
+		m_sweepRadius = b2Max(m_sweepRadius, m_edges[i].GetSweepRadius());
+	}
+}
@@ -0,0 +1,165 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_HEIGHTFIELD_SHAPE_H
+#define B2_HEIGHTFIELD_SHAPE_H
+
+#include "b2Shape.h"
+
+class b2EdgeShape;
+
+/// This structure is used to build heightfield shapes. A heightfield is a
+/// terrain profile sampled at regular intervals, solid below the surface.
+/// Sample i lies at x = i * spacing in local coordinates.
+struct b2HeightfieldDef : public b2ShapeDef
+{
+	b2HeightfieldDef()
+	{
+		type = e_heightfieldShape;
+		heights = NULL;
+		sampleCount = 0;
+		spacing = 1.0f;
+		minHeight = 0.0f;
+		maxHeight = 0.0f;
+	}
+
+	/// The sample heights. They are copied by the shape.
+	const float32* heights;
+
+	/// The number of samples, at least two.
+	int32 sampleCount;
+
+	/// The horizontal distance between samples.
+	float32 spacing;
+
+	/// The range heights may be changed to after creation. The shape's bounds
+	/// cover this range as well as the initial samples.
+	float32 minHeight;
+	float32 maxHeight;
+};
+
+/// A terrain profile collided as one shape. Contacts and rays only visit the
+/// columns under the other shape, found by indexing, and the heights can be
+/// changed in place.
+class b2HeightfieldShape : public b2Shape
+{
+public:
+	/// @see b2Shape::TestPoint
+	bool TestPoint(const b2XForm& transform, const b2Vec2& p) const;
+
+	/// @see b2Shape::TestSegment
+	b2SegmentCollide TestSegment(	const b2XForm& transform,
+						float32* lambda,
+						b2Vec2* normal,
+						const b2Segment& segment,
+						float32 maxLambda) const;
+
+	/// @see b2Shape::ComputeAABB
+	void ComputeAABB(b2AABB* aabb, const b2XForm& transform) const;
+
+	/// @see b2Shape::ComputeSweptAABB
+	void ComputeSweptAABB(	b2AABB* aabb,
+							const b2XForm& transform1,
+							const b2XForm& transform2) const;
+
+	/// @see b2Shape::ComputeMass
+	void ComputeMass(b2MassData* massData) const;
+
+	/// A heightfield has no closed area, so this is always zero.
+	/// @see b2Shape::ComputeSubmergedArea
+	float32 ComputeSubmergedArea(	const b2Vec2& normal,
+									float32 offset,
+									const b2XForm& xf, 
+									b2Vec2* c) const;
+
+	/// Get the number of samples.
+	int32 GetSampleCount() const;
+
+	/// Get the horizontal distance between samples.
+	float32 GetSpacing() const;
+
+	/// Get a sample height.
+	float32 GetHeight(int32 index) const;
+
+	/// Change a sample height. The height is clamped to the range given in the
+	/// definition. Contacts pick up the change on the next step.
+	/// @warning bodies resting on the terrain are not woken up.
+	void SetHeight(int32 index, float32 height);
+
+	/// Change a run of sample heights at once.
+	void SetHeights(int32 first, const float32* heights, int32 count);
+
+	/// Get the edge over a column. Edge i joins sample i + 1 to sample i, so the
+	/// solid side is below.
+	const b2EdgeShape* GetEdge(int32 index) const;
+
+	/// Get the number of edges, one less than the number of samples.
+	int32 GetEdgeCount() const;
+
+	/// Find the columns whose edges overlap an AABB given in the local frame.
+	/// @param indices returns up to maxCount edge indices.
+	/// @return the number of overlapping edges, which may be more than maxCount.
+	int32 Query(const b2AABB& aabb, int32* indices, int32 maxCount) const;
+
+private:
+
+	friend class b2Shape;
+
+	b2HeightfieldShape(const b2ShapeDef* def);
+	~b2HeightfieldShape();
+
+	void UpdateEdges(int32 first, int32 last);
+
+	void UpdateSweepRadius(const b2Vec2& center);
+
+	float32* m_heights;
+	int32 m_sampleCount;
+	float32 m_spacing;
+
+	// The bounds of every height the samples may take.
+	float32 m_lowerHeight;
+	float32 m_upperHeight;
+
+	b2EdgeShape* m_edges;
+
+	// The center last given to UpdateSweepRadius.
+	b2Vec2 m_sweepCenter;
+};
+
+inline int32 b2HeightfieldShape::GetSampleCount() const
+{
+	return m_sampleCount;
+}
+
+inline float32 b2HeightfieldShape::GetSpacing() const
+{
+	return m_spacing;
+}
+
+inline float32 b2HeightfieldShape::GetHeight(int32 index) const
+{
+	b2Assert(0 <= index && index < m_sampleCount);
+	return m_heights[index];
+}
+
+inline int32 b2HeightfieldShape::GetEdgeCount() const
+{
+	return m_sampleCount - 1;
+}
+
+#endif
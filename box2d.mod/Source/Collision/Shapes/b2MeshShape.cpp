@@ -0,0 +1,376 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2MeshShape.h"
+#include "b2EdgeShape.h"
+#include "b2HeightfieldShape.h"
+
+#include <new>
+#include <algorithm>
+
+// The hierarchy depth is logarithmic in the edge count because nodes are split at
+// the median.
+const int32 b2_meshStackSize = 64;
+
+b2MeshShape::b2MeshShape(const b2ShapeDef* def)
+: b2Shape(def)
+{
+	b2Assert(def->type == e_meshShape);
+	m_type = e_meshShape;
+	const b2MeshDef* meshDef = (const b2MeshDef*)def;
+
+	b2Assert(meshDef->vertexCount >= (meshDef->isALoop ? 3 : 2));
+	m_edgeCount = meshDef->isALoop ? meshDef->vertexCount : meshDef->vertexCount - 1;
+
+	// The edges share the mesh's material.
+	b2ShapeDef edgeDef = *def;
+	edgeDef.type = e_edgeShape;
+
+	m_edges = (b2EdgeShape*)b2Alloc(m_edgeCount * sizeof(b2EdgeShape));
+	float32 angle = 0.0f;
+	for (int32 i = 0; i < m_edgeCount; ++i)
+	{
+		b2Vec2 v1 = meshDef->vertices[i];
+		b2Vec2 v2 = meshDef->vertices[i + 1 < meshDef->vertexCount ? i + 1 : 0];
+		b2EdgeShape* edge = new (m_edges + i) b2EdgeShape(v1, v2, &edgeDef);
+
+		if (i == 0)
+		{
+			angle = b2Atan2(edge->GetDirectionVector().y, edge->GetDirectionVector().x);
+		}
+		else
+		{
+			angle = b2ConnectEdges(m_edges + i - 1, edge, angle);
+		}
+	}
+
+	if (meshDef->isALoop)
+	{
+		b2ConnectEdges(m_edges + m_edgeCount - 1, m_edges, angle);
+	}
+
+	// Build the hierarchy top down. A binary tree over n leaves has 2n - 1 nodes.
+	m_nodes = (b2MeshNode*)b2Alloc((2 * m_edgeCount - 1) * sizeof(b2MeshNode));
+	m_nodeCount = 0;
+
+	int32* edges = (int32*)b2Alloc(m_edgeCount * sizeof(int32));
+	for (int32 i = 0; i < m_edgeCount; ++i)
+	{
+		edges[i] = i;
+	}
+
+	BuildNode(edges, m_edgeCount);
+	b2Assert(m_nodeCount == 2 * m_edgeCount - 1);
+
+	b2Free(edges);
+}
+
+b2MeshShape::~b2MeshShape()
+{
+	for (int32 i = 0; i < m_edgeCount; ++i)
+	{
+		m_edges[i].~b2EdgeShape();
+	}
+
+	b2Free(m_edges);
+	b2Free(m_nodes);
+}
+
+// Orders edge indices by their midpoint along one axis.
+struct b2MeshEdgeLess
+{
+	bool operator () (int32 a, int32 b) const
+	{
+		b2Vec2 ca = mesh->GetMidpoint(a);
+		b2Vec2 cb = mesh->GetMidpoint(b);
+		return axis == 0 ? ca.x < cb.x : ca.y < cb.y;
+	}
+
+	const b2MeshShape* mesh;
+	int32 axis;
+};
+
+b2Vec2 b2MeshShape::GetMidpoint(int32 index) const
+{
+	return 0.5f * (m_edges[index].GetVertex1() + m_edges[index].GetVertex2());
+}
+
+// Build the subtree over the edges and return its root. Children directly follow
+// their parent so a query walks memory forward.
+int32 b2MeshShape::BuildNode(int32* edges, int32 count)
+{
+	int32 index = m_nodeCount++;
+	b2MeshNode* node = m_nodes + index;
+
+	if (count == 1)
+	{
+		m_edges[edges[0]].ComputeAABB(&node->aabb, b2XForm_identity);
+		node->child1 = -1;
+		node->child2 = -1;
+		node->edge = edges[0];
+		return index;
+	}
+
+	// Split at the median along the longest axis of the edge midpoints.
+	b2Vec2 lower(B2_FLT_MAX, B2_FLT_MAX);
+	b2Vec2 upper(-B2_FLT_MAX, -B2_FLT_MAX);
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Vec2 c = GetMidpoint(edges[i]);
+		lower = b2Min(lower, c);
+		upper = b2Max(upper, c);
+	}
+
+	b2MeshEdgeLess less;
+	less.mesh = this;
+	less.axis = upper.x - lower.x >= upper.y - lower.y ? 0 : 1;
+
+	int32 mid = count / 2;
+	std::nth_element(edges, edges + mid, edges + count, less);
+
+	int32 child1 = BuildNode(edges, mid);
+	int32 child2 = BuildNode(edges + mid, count - mid);
+
+	node = m_nodes + index;
+	node->child1 = child1;
+	node->child2 = child2;
+	node->edge = -1;
+
+	const b2AABB& aabb1 = m_nodes[child1].aabb;
+	const b2AABB& aabb2 = m_nodes[child2].aabb;
+	node->aabb.lowerBound = b2Min(aabb1.lowerBound, aabb2.lowerBound);
+	node->aabb.upperBound = b2Max(aabb1.upperBound, aabb2.upperBound);
+	return index;
+}
+
+const b2EdgeShape* b2MeshShape::GetEdge(int32 index) const
+{
+	b2Assert(0 <= index && index < m_edgeCount);
+	return m_edges + index;
+}
+
+int32 b2MeshShape::Query(const b2AABB& aabb, int32* indices, int32 maxCount) const
+{
+	int32 stack[b2_meshStackSize];
+	int32 stackCount = 0;
+	stack[stackCount++] = 0;
+
+	int32 count = 0;
+	while (stackCount > 0)
+	{
+		const b2MeshNode* node = m_nodes + stack[--stackCount];
+		if (b2TestOverlap(node->aabb, aabb) == false)
+		{
+			continue;
+		}
+
+		if (node->edge >= 0)
+		{
+			if (count < maxCount)
+			{
+				indices[count] = node->edge;
+			}
+			++count;
+		}
+		else
+		{
+			b2Assert(stackCount + 2 <= b2_meshStackSize);
+			stack[stackCount++] = node->child2;
+			stack[stackCount++] = node->child1;
+		}
+	}
+
+	return count;
+}
+
+bool b2MeshShape::TestPoint(const b2XForm& transform, const b2Vec2& p) const
+{
+	B2_NOT_USED(transform);
+	B2_NOT_USED(p);
+	return false;
+}
+
+// Does the segment p1 + t * d, 0 <= t <= maxLambda, touch the box?
+static bool b2TestSegmentAABB(const b2AABB& aabb, const b2Vec2& p1, const b2Vec2& d, float32 maxLambda)
+{
+	float32 tmin = 0.0f;
+	float32 tmax = maxLambda;
+
+	for (int32 i = 0; i < 2; ++i)
+	{
+		float32 p = i == 0 ? p1.x : p1.y;
+		float32 r = i == 0 ? d.x : d.y;
+		float32 lower = i == 0 ? aabb.lowerBound.x : aabb.lowerBound.y;
+		float32 upper = i == 0 ? aabb.upperBound.x : aabb.upperBound.y;
+
+		if (b2Abs(r) < B2_FLT_EPSILON)
+		{
+			if (p < lower || upper < p)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			float32 inv = 1.0f / r;
+			float32 t1 = (lower - p) * inv;
+			float32 t2 = (upper - p) * inv;
+			tmin = b2Max(tmin, b2Min(t1, t2));
+			tmax = b2Min(tmax, b2Max(t1, t2));
+			if (tmin > tmax)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+b2SegmentCollide b2MeshShape::TestSegment(const b2XForm& transform,
+								float32* lambda,
+								b2Vec2* normal,
+								const b2Segment& segment,
+								float32 maxLambda) const
+{
+	// Work in the mesh frame. The transform preserves the segment fraction.
+	b2Segment local;
+	local.p1 = b2MulT(transform, segment.p1);
+	local.p2 = b2MulT(transform, segment.p2);
+	b2Vec2 d = local.p2 - local.p1;
+
+	b2SegmentCollide result = e_missCollide;
+	int32 stack[b2_meshStackSize];
+	int32 stackCount = 0;
+	stack[stackCount++] = 0;
+
+	while (stackCount > 0)
+	{
+		const b2MeshNode* node = m_nodes + stack[--stackCount];
+		if (b2TestSegmentAABB(node->aabb, local.p1, d, maxLambda) == false)
+		{
+			continue;
+		}
+
+		if (node->edge >= 0)
+		{
+			float32 edgeLambda;
+			b2Vec2 edgeNormal;
+			if (m_edges[node->edge].TestSegment(b2XForm_identity, &edgeLambda, &edgeNormal, local, maxLambda) == e_hitCollide)
+			{
+				// Keep the closest hit and shorten the ray.
+				maxLambda = edgeLambda;
+				*lambda = edgeLambda;
+				*normal = b2Mul(transform.R, edgeNormal);
+				result = e_hitCollide;
+			}
+		}
+		else
+		{
+			b2Assert(stackCount + 2 <= b2_meshStackSize);
+			stack[stackCount++] = node->child2;
+			stack[stackCount++] = node->child1;
+		}
+	}
+
+	return result;
+}
+
+void b2MeshShape::ComputeAABB(b2AABB* aabb, const b2XForm& transform) const
+{
+	// Bound the transformed root box.
+	const b2AABB& root = m_nodes[0].aabb;
+	b2Vec2 center = b2Mul(transform, 0.5f * (root.lowerBound + root.upperBound));
+	b2Vec2 extents = b2Mul(b2Abs(transform.R), 0.5f * (root.upperBound - root.lowerBound));
+	aabb->lowerBound = center - extents;
+	aabb->upperBound = center + extents;
+}
+
+void b2MeshShape::ComputeSweptAABB(b2AABB* aabb, const b2XForm& transform1, const b2XForm& transform2) const
+{
+	b2AABB aabb1, aabb2;
+	ComputeAABB(&aabb1, transform1);
+	ComputeAABB(&aabb2, transform2);
+	aabb->lowerBound = b2Min(aabb1.lowerBound, aabb2.lowerBound);
+	aabb->upperBound = b2Max(aabb1.upperBound, aabb2.upperBound);
+}
+
+void b2MeshShape::ComputeMass(b2MassData* massData) const
+{
+	massData->mass = 0;
+	massData->center = m_edges[0].GetVertex1();
+
+	// inertia about the local origin
+	massData->I = 0;
+}
+
+float32 b2MeshShape::ComputeSubmergedArea(	const b2Vec2& normal,
+												float32 offset,
+												const b2XForm& xf, 
+												b2Vec2* c) const
+{
+	float32 area = 0.0f;
+	b2Vec2 center = b2Vec2_zero;
+	for (int32 i = 0; i < m_edgeCount; ++i)
+	{
+		b2Vec2 edgeCenter;
+		float32 edgeArea = m_edges[i].ComputeSubmergedArea(normal, offset, xf, &edgeCenter);
+		area += edgeArea;
+		center += edgeArea * edgeCenter;
+	}
+
+	if (area != 0.0f)
+	{
+		center *= 1.0f / area;
+	}
+
+	*c = center;
+	return area;
+}
+
+void b2MeshShape::UpdateSweepRadius(const b2Vec2& center)
+{
+	m_sweepRadius = 0.0f;
+	for (int32 i = 0; i < m_edgeCount; ++i)
+	{
+		m_edges[i].UpdateSweepRadius(center);
+		m_sweepRadius = b2Max(m_sweepRadius, m_edges[i].GetSweepRadius());
+	}
+}
+
+int32 b2QueryEdges(const b2Shape* shape, const b2AABB& aabb, int32* indices, int32 maxCount)
+{
+	if (shape->GetType() == e_heightfieldShape)
+	{
+		return ((const b2HeightfieldShape*)shape)->Query(aabb, indices, maxCount);
+	}
+
+	b2Assert(shape->GetType() == e_meshShape);
+	return ((const b2MeshShape*)shape)->Query(aabb, indices, maxCount);
+}
+
+const b2EdgeShape* b2GetEdge(const b2Shape* shape, int32 index)
+{
+	if (shape->GetType() == e_heightfieldShape)
+	{
+		return ((const b2HeightfieldShape*)shape)->GetEdge(index);
+	}
+
+	b2Assert(shape->GetType() == e_meshShape);
+	return ((const b2MeshShape*)shape)->GetEdge(index);
+}
@@ -0,0 +1,151 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_MESH_SHAPE_H
+#define B2_MESH_SHAPE_H
+
+#include "b2Shape.h"
+
+class b2EdgeShape;
+
+/// This structure is used to build mesh shapes. A mesh is an edge chain
+/// stored in a single shape with a single broad-phase proxy. The edges are
+/// kept in a bounding volume hierarchy, so very long chains stay cheap.
+struct b2MeshDef : public b2ShapeDef
+{
+	b2MeshDef()
+	{
+		type = e_meshShape;
+		vertexCount = 0;
+		isALoop = true;
+		vertices = NULL;
+	}
+
+	/// The vertices in local coordinates. They are copied by the shape.
+	b2Vec2* vertices;
+
+	/// The number of vertices in the chain.
+	int32 vertexCount;
+
+	/// Whether to create an extra edge between the first and last vertices.
+	bool isALoop;
+};
+
+/// A node in the bounding volume hierarchy of a mesh.
+struct b2MeshNode
+{
+	b2AABB aabb;
+	int32 child1;
+	int32 child2;
+	int32 edge;		///< the edge index for leaves, otherwise -1
+};
+
+/// A chain of edges collided as one shape. Contacts are only generated against
+/// the edges near the other shape.
+class b2MeshShape : public b2Shape
+{
+public:
+	/// @see b2Shape::TestPoint
+	bool TestPoint(const b2XForm& transform, const b2Vec2& p) const;
+
+	/// @see b2Shape::TestSegment
+	b2SegmentCollide TestSegment(	const b2XForm& transform,
+						float32* lambda,
+						b2Vec2* normal,
+						const b2Segment& segment,
+						float32 maxLambda) const;
+
+	/// @see b2Shape::ComputeAABB
+	void ComputeAABB(b2AABB* aabb, const b2XForm& transform) const;
+
+	/// @see b2Shape::ComputeSweptAABB
+	void ComputeSweptAABB(	b2AABB* aabb,
+							const b2XForm& transform1,
+							const b2XForm& transform2) const;
+
+	/// @see b2Shape::ComputeMass
+	void ComputeMass(b2MassData* massData) const;
+
+	/// @warning This only gives a sensible answer for closed loops.
+	/// @see b2Shape::ComputeSubmergedArea
+	float32 ComputeSubmergedArea(	const b2Vec2& normal,
+									float32 offset,
+									const b2XForm& xf, 
+									b2Vec2* c) const;
+
+	/// Get the number of edges.
+	int32 GetEdgeCount() const;
+
+	/// Get an edge. Edges are in chain order.
+	const b2EdgeShape* GetEdge(int32 index) const;
+
+	/// Find the edges whose bounds overlap an AABB given in the mesh's local frame.
+	/// @param indices returns up to maxCount edge indices.
+	/// @return the number of overlapping edges, which may be more than maxCount.
+	int32 Query(const b2AABB& aabb, int32* indices, int32 maxCount) const;
+
+	/// Get the hierarchy nodes. The first node is the root.
+	const b2MeshNode* GetNodes() const;
+
+	/// Get the number of hierarchy nodes.
+	int32 GetNodeCount() const;
+
+private:
+
+	friend class b2Shape;
+	friend struct b2MeshEdgeLess;
+
+	b2MeshShape(const b2ShapeDef* def);
+	~b2MeshShape();
+
+	b2Vec2 GetMidpoint(int32 index) const;
+	int32 BuildNode(int32* edges, int32 count);
+
+	void UpdateSweepRadius(const b2Vec2& center);
+
+	b2EdgeShape* m_edges;
+	int32 m_edgeCount;
+
+	b2MeshNode* m_nodes;
+	int32 m_nodeCount;
+};
+
+/// Find the edges of a mesh or heightfield that overlap an AABB given in the
+/// shape's local frame.
+/// @see b2MeshShape::Query
+int32 b2QueryEdges(const b2Shape* shape, const b2AABB& aabb, int32* indices, int32 maxCount);
+
+/// Get an edge of a mesh or heightfield.
+const b2EdgeShape* b2GetEdge(const b2Shape* shape, int32 index);
+
+inline int32 b2MeshShape::GetEdgeCount() const
+{
+	return m_edgeCount;
+}
+
+inline const b2MeshNode* b2MeshShape::GetNodes() const
+{
+	return m_nodes;
+}
+
+inline int32 b2MeshShape::GetNodeCount() const
+{
+	return m_nodeCount;
+}
+
+#endif
@@ -228,6 +228,10 @@ b2PolygonShape::b2PolygonShape(const b2ShapeDef* def)
 		A.col1.y = n2.x; A.col2.y = n2.y;
 		m_coreVertices[i] = A.Solve(d) + m_centroid;
 	}
+
+	b2PadPolygonLanes(m_vertices, m_vertexCount);
+	b2PadPolygonLanes(m_normals, m_vertexCount);
+	b2PadPolygonLanes(m_coreVertices, m_vertexCount);
 }
 
 void b2PolygonShape::UpdateSweepRadius(const b2Vec2& center)
@@ -552,18 +556,6 @@ b2Vec2 b2PolygonShape::Centroid(const b2XForm& xf) const
 b2Vec2 b2PolygonShape::Support(const b2XForm& xf, const b2Vec2& d) const
 {
 	b2Vec2 dLocal = b2MulT(xf.R, d);
-
-	int32 bestIndex = 0;
-	float32 bestValue = b2Dot(m_coreVertices[0], dLocal);
-	for (int32 i = 1; i < m_vertexCount; ++i)
-	{
-		float32 value = b2Dot(m_coreVertices[i], dLocal);
-		if (value > bestValue)
-		{
-			bestIndex = i;
-			bestValue = value;
-		}
-	}
-
+	int32 bestIndex = b2FindMaxDot(m_coreVertices, m_vertexCount, dLocal);
 	return b2Mul(xf, m_coreVertices[bestIndex]);
 }
@@ -20,6 +20,7 @@
 #define B2_POLYGON_SHAPE_H
 
 #include "b2Shape.h"
+#include "../../Common/b2Simd.h"
 
 /// Convex polygon. The vertices must be in CCW order for a right-handed
 /// coordinate system with the z-axis coming out of the screen.
@@ -115,6 +116,7 @@ public:
 private:
 
 	friend class b2Shape;
+	friend class b2TileGridShape;
 
 	b2PolygonShape(const b2ShapeDef* def);
 
@@ -125,9 +127,10 @@ private:
 
 	b2OBB m_obb;
 
-	b2Vec2 m_vertices[b2_maxPolygonVertices];
-	b2Vec2 m_normals[b2_maxPolygonVertices];
-	b2Vec2 m_coreVertices[b2_maxPolygonVertices];
+	// Padded for the SIMD kernels, see b2PadPolygonLanes.
+	b2Vec2 m_vertices[b2_polygonLaneCount];
+	b2Vec2 m_normals[b2_polygonLaneCount];
+	b2Vec2 m_coreVertices[b2_polygonLaneCount];
 	int32 m_vertexCount;
 };
 
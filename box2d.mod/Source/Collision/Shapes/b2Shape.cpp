@@ -20,9 +20,13 @@
 #include "b2CircleShape.h"
 #include "b2PolygonShape.h"
 #include "b2EdgeShape.h"
+#include "b2MeshShape.h"
+#include "b2TileGridShape.h"
+#include "b2HeightfieldShape.h"
 #include "../b2Collision.h"
 #include "../b2BroadPhase.h"
 #include "../../Common/b2BlockAllocator.h"
+#include "../../Dynamics/Contacts/b2SensorPair.h"
 
 #include <new>
 
@@ -42,6 +46,24 @@ b2Shape* b2Shape::Create(const b2ShapeDef* def, b2BlockAllocator* allocator)
 			return new (mem) b2PolygonShape(def);
 		}
 
+	case e_meshShape:
+		{
+			void* mem = allocator->Allocate(sizeof(b2MeshShape));
+			return new (mem) b2MeshShape(def);
+		}
+
+	case e_tileGridShape:
+		{
+			void* mem = allocator->Allocate(sizeof(b2TileGridShape));
+			return new (mem) b2TileGridShape(def);
+		}
+
+	case e_heightfieldShape:
+		{
+			void* mem = allocator->Allocate(sizeof(b2HeightfieldShape));
+			return new (mem) b2HeightfieldShape(def);
+		}
+
 	default:
 		b2Assert(false);
 		return NULL;
@@ -71,6 +93,21 @@ void b2Shape::Destroy(b2Shape* s, b2BlockAllocator* allocator)
 		allocator->Free(s, sizeof(b2EdgeShape));
 		break;
 
+	case e_meshShape:
+		s->~b2Shape();
+		allocator->Free(s, sizeof(b2MeshShape));
+		break;
+
+	case e_tileGridShape:
+		s->~b2Shape();
+		allocator->Free(s, sizeof(b2TileGridShape));
+		break;
+
+	case e_heightfieldShape:
+		s->~b2Shape();
+		allocator->Free(s, sizeof(b2HeightfieldShape));
+		break;
+
 	default:
 		b2Assert(false);
 	}
@@ -91,12 +128,29 @@ b2Shape::b2Shape(const b2ShapeDef* def)
 
 	m_filter = def->filter;
 
+	m_id = 0;
+
 	m_isSensor = def->isSensor;
+
+	m_overlapList = NULL;
+	m_overlapCount = 0;
 }
 
 b2Shape::~b2Shape()
 {
 	b2Assert(m_proxyId == b2_nullProxy);
+	b2Assert(m_overlapList == NULL);
+}
+
+int32 b2Shape::GetOverlaps(b2Shape** shapes, int32 maxCount) const
+{
+	int32 count = 0;
+	for (b2SensorEdge* edge = m_overlapList; edge && count < maxCount; edge = edge->next)
+	{
+		shapes[count++] = edge->other;
+	}
+
+	return count;
 }
 
 void b2Shape::CreateProxy(b2BroadPhase* broadPhase, const b2XForm& transform)
@@ -25,6 +25,7 @@
 class b2BlockAllocator;
 class b2Body;
 class b2BroadPhase;
+struct b2SensorEdge;
 
 /// This holds the mass data computed for a shape.
 struct b2MassData
@@ -62,6 +63,9 @@ enum b2ShapeType
 	e_circleShape,
 	e_polygonShape,
 	e_edgeShape,
+	e_meshShape,
+	e_tileGridShape,
+	e_heightfieldShape,
 	e_shapeTypeCount,
 };
 
@@ -108,8 +112,8 @@ struct b2ShapeDef
 	/// The shape's density, usually in kg/m^2.
 	float32 density;
 
-	/// A sensor shape collects contact information but never generates a collision
-	/// response.
+	/// A sensor shape never generates a collision response. It only tracks which
+	/// shapes it overlaps, see b2Shape::GetOverlapList and b2SensorListener.
 	bool isSensor;
 
 	/// Contact filtering data.
@@ -130,6 +134,17 @@ public:
 	/// @return the true if the shape is a sensor.
 	bool IsSensor() const;
 
+	/// Get the list of shapes this sensor overlaps. This is updated each time step
+	/// and is always empty for shapes that are not sensors.
+	b2SensorEdge* GetOverlapList();
+
+	/// Get the number of shapes this sensor overlaps.
+	int32 GetOverlapCount() const;
+
+	/// Copy the shapes this sensor overlaps into an array.
+	/// @return the number of shapes written, at most maxCount.
+	int32 GetOverlaps(b2Shape** shapes, int32 maxCount) const;
+
 	/// Set the contact filtering data. You must call b2World::Refilter to correct
 	/// existing contacts/non-contacts.
 	void SetFilterData(const b2FilterData& filter);
@@ -225,6 +240,9 @@ protected:
 
 	friend class b2Body;
 	friend class b2World;
+	friend class b2SensorPair;
+	friend class b2WorldRecorder;
+	friend class b2WorldPlayer;
 
 	static b2Shape* Create(const b2ShapeDef* def, b2BlockAllocator* allocator);
 	static void Destroy(b2Shape* shape, b2BlockAllocator* allocator);
@@ -253,8 +271,15 @@ protected:
 	uint16 m_proxyId;
 	b2FilterData m_filter;
 
+	// Assigned by the world in creation order, used to record and replay the world.
+	uint32 m_id;
+
 	bool m_isSensor;
 
+	// Shapes overlapping this sensor.
+	b2SensorEdge* m_overlapList;
+	int32 m_overlapCount;
+
 	void* m_userData;
 };
 
@@ -268,6 +293,16 @@ inline bool b2Shape::IsSensor() const
 	return m_isSensor;
 }
 
+inline b2SensorEdge* b2Shape::GetOverlapList()
+{
+	return m_overlapList;
+}
+
+inline int32 b2Shape::GetOverlapCount() const
+{
+	return m_overlapCount;
+}
+
 inline void b2Shape::SetFilterData(const b2FilterData& filter)
 {
 	m_filter = filter;
@@ -0,0 +1,389 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2TileGridShape.h"
+#include "b2PolygonShape.h"
+
+#include <new>
+#include <cstring>
+#include <cmath>
+
+// The cell faces each tile type fills completely.
+enum
+{
+	e_tileFaceLeft = 0x01,
+	e_tileFaceRight = 0x02,
+	e_tileFaceBottom = 0x04,
+	e_tileFaceTop = 0x08,
+};
+
+static const uint8 b2_tileFaces[e_tileTypeCount] =
+{
+	0,
+	e_tileFaceLeft | e_tileFaceRight | e_tileFaceBottom | e_tileFaceTop,
+	e_tileFaceLeft | e_tileFaceBottom,
+	e_tileFaceRight | e_tileFaceBottom,
+	e_tileFaceLeft | e_tileFaceTop,
+	e_tileFaceRight | e_tileFaceTop,
+};
+
+b2TileGridShape::b2TileGridShape(const b2ShapeDef* def)
+: b2Shape(def)
+{
+	b2Assert(def->type == e_tileGridShape);
+	m_type = e_tileGridShape;
+	const b2TileGridDef* gridDef = (const b2TileGridDef*)def;
+
+	b2Assert(gridDef->width > 0 && gridDef->height > 0);
+	b2Assert(gridDef->tileSize > 10.0f * b2_toiSlop);
+	m_width = gridDef->width;
+	m_height = gridDef->height;
+	m_tileSize = gridDef->tileSize;
+
+	int32 count = m_width * m_height;
+	m_tiles = (uint8*)b2Alloc(count * sizeof(uint8));
+	if (gridDef->tiles)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2Assert(gridDef->tiles[i] < e_tileTypeCount);
+			m_tiles[i] = gridDef->tiles[i];
+		}
+	}
+	else
+	{
+		memset(m_tiles, e_tileEmpty, count * sizeof(uint8));
+	}
+
+	// Build the tile polygons in cell coordinates. They share the grid's material.
+	b2PolygonDef polyDef;
+	(b2ShapeDef&)polyDef = *def;
+	polyDef.type = e_polygonShape;
+
+	float32 s = m_tileSize;
+	m_polygons = (b2PolygonShape*)b2Alloc((e_tileTypeCount - 1) * sizeof(b2PolygonShape));
+	for (int32 i = e_tileSolid; i < e_tileTypeCount; ++i)
+	{
+		polyDef.vertexCount = 3;
+		switch (i)
+		{
+		case e_tileSolid:
+			polyDef.SetAsBox(0.5f * s, 0.5f * s, b2Vec2(0.5f * s, 0.5f * s), 0.0f);
+			break;
+
+		case e_tileSlopeLowerLeft:
+			polyDef.vertices[0].Set(0.0f, 0.0f);
+			polyDef.vertices[1].Set(s, 0.0f);
+			polyDef.vertices[2].Set(0.0f, s);
+			break;
+
+		case e_tileSlopeLowerRight:
+			polyDef.vertices[0].Set(0.0f, 0.0f);
+			polyDef.vertices[1].Set(s, 0.0f);
+			polyDef.vertices[2].Set(s, s);
+			break;
+
+		case e_tileSlopeUpperLeft:
+			polyDef.vertices[0].Set(0.0f, 0.0f);
+			polyDef.vertices[1].Set(s, s);
+			polyDef.vertices[2].Set(0.0f, s);
+			break;
+
+		case e_tileSlopeUpperRight:
+			polyDef.vertices[0].Set(s, 0.0f);
+			polyDef.vertices[1].Set(s, s);
+			polyDef.vertices[2].Set(0.0f, s);
+			break;
+		}
+
+		new (m_polygons + i - 1) b2PolygonShape(&polyDef);
+	}
+}
+
+b2TileGridShape::~b2TileGridShape()
+{
+	for (int32 i = e_tileSolid; i < e_tileTypeCount; ++i)
+	{
+		m_polygons[i - 1].~b2PolygonShape();
+	}
+
+	b2Free(m_polygons);
+	b2Free(m_tiles);
+}
+
+void b2TileGridShape::SetTile(int32 x, int32 y, uint8 type)
+{
+	b2Assert(0 <= x && x < m_width && 0 <= y && y < m_height);
+	b2Assert(type < e_tileTypeCount);
+	m_tiles[y * m_width + x] = type;
+}
+
+const b2PolygonShape* b2TileGridShape::GetTilePolygon(uint8 type) const
+{
+	b2Assert(type < e_tileTypeCount);
+	if (type == e_tileEmpty)
+	{
+		return NULL;
+	}
+
+	return m_polygons + type - 1;
+}
+
+bool b2TileGridShape::GetCellRange(const b2AABB& aabb, int32* lowerX, int32* lowerY, int32* upperX, int32* upperY) const
+{
+	float32 inv = 1.0f / m_tileSize;
+	int32 x1 = (int32)floorf(aabb.lowerBound.x * inv);
+	int32 y1 = (int32)floorf(aabb.lowerBound.y * inv);
+	int32 x2 = (int32)floorf(aabb.upperBound.x * inv);
+	int32 y2 = (int32)floorf(aabb.upperBound.y * inv);
+
+	if (x2 < 0 || y2 < 0 || x1 >= m_width || y1 >= m_height)
+	{
+		return false;
+	}
+
+	*lowerX = b2Max(x1, 0);
+	*lowerY = b2Max(y1, 0);
+	*upperX = b2Min(x2, m_width - 1);
+	*upperY = b2Min(y2, m_height - 1);
+	return true;
+}
+
+bool b2TileGridShape::IsInternalNormal(int32 x, int32 y, const b2Vec2& localNormal) const
+{
+	// Pick the face the normal leaves through and the neighbor across it.
+	uint8 face, neighborFace;
+	int32 nx = x, ny = y;
+	if (b2Abs(localNormal.x) > b2Abs(localNormal.y))
+	{
+		face = localNormal.x > 0.0f ? e_tileFaceRight : e_tileFaceLeft;
+		neighborFace = localNormal.x > 0.0f ? e_tileFaceLeft : e_tileFaceRight;
+		nx += localNormal.x > 0.0f ? 1 : -1;
+	}
+	else
+	{
+		face = localNormal.y > 0.0f ? e_tileFaceTop : e_tileFaceBottom;
+		neighborFace = localNormal.y > 0.0f ? e_tileFaceBottom : e_tileFaceTop;
+		ny += localNormal.y > 0.0f ? 1 : -1;
+	}
+
+	if (nx < 0 || ny < 0 || nx >= m_width || ny >= m_height)
+	{
+		return false;
+	}
+
+	return (b2_tileFaces[GetTile(x, y)] & face) != 0 && (b2_tileFaces[GetTile(nx, ny)] & neighborFace) != 0;
+}
+
+bool b2TileGridShape::TestPoint(const b2XForm& transform, const b2Vec2& p) const
+{
+	b2Vec2 pLocal = b2MulT(transform, p);
+	float32 inv = 1.0f / m_tileSize;
+	int32 x = (int32)floorf(pLocal.x * inv);
+	int32 y = (int32)floorf(pLocal.y * inv);
+	if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+	{
+		return false;
+	}
+
+	const b2PolygonShape* polygon = GetTilePolygon(GetTile(x, y));
+	if (polygon == NULL)
+	{
+		return false;
+	}
+
+	b2XForm cellXF(GetCellOffset(x, y), b2Mat22_identity);
+	return polygon->TestPoint(cellXF, pLocal);
+}
+
+b2SegmentCollide b2TileGridShape::TestSegment(const b2XForm& transform,
+								float32* lambda,
+								b2Vec2* normal,
+								const b2Segment& segment,
+								float32 maxLambda) const
+{
+	// Work in the grid frame. The transform preserves the segment fraction.
+	b2Segment local;
+	local.p1 = b2MulT(transform, segment.p1);
+	local.p2 = b2MulT(transform, segment.p2);
+	b2Vec2 d = local.p2 - local.p1;
+
+	// Clip the segment to the grid bounds.
+	float32 tmin = 0.0f;
+	float32 tmax = maxLambda;
+	b2Vec2 extents(m_width * m_tileSize, m_height * m_tileSize);
+	for (int32 i = 0; i < 2; ++i)
+	{
+		float32 p = i == 0 ? local.p1.x : local.p1.y;
+		float32 r = i == 0 ? d.x : d.y;
+		float32 upper = i == 0 ? extents.x : extents.y;
+
+		if (b2Abs(r) < B2_FLT_EPSILON)
+		{
+			if (p < 0.0f || upper < p)
+			{
+				return e_missCollide;
+			}
+		}
+		else
+		{
+			float32 t1 = -p / r;
+			float32 t2 = (upper - p) / r;
+			tmin = b2Max(tmin, b2Min(t1, t2));
+			tmax = b2Min(tmax, b2Max(t1, t2));
+			if (tmin > tmax)
+			{
+				return e_missCollide;
+			}
+		}
+	}
+
+	// Walk the cells along the segment in order (Amanatides and Woo), so the first
+	// hit is the closest.
+	float32 inv = 1.0f / m_tileSize;
+	b2Vec2 start = local.p1 + tmin * d;
+	int32 x = b2Clamp((int32)floorf(start.x * inv), 0, m_width - 1);
+	int32 y = b2Clamp((int32)floorf(start.y * inv), 0, m_height - 1);
+
+	int32 stepX = d.x > 0.0f ? 1 : -1;
+	int32 stepY = d.y > 0.0f ? 1 : -1;
+	float32 nextX = B2_FLT_MAX, nextY = B2_FLT_MAX;
+	float32 deltaX = B2_FLT_MAX, deltaY = B2_FLT_MAX;
+	if (b2Abs(d.x) >= B2_FLT_EPSILON)
+	{
+		nextX = ((x + (stepX > 0 ? 1 : 0)) * m_tileSize - local.p1.x) / d.x;
+		deltaX = m_tileSize / b2Abs(d.x);
+	}
+	if (b2Abs(d.y) >= B2_FLT_EPSILON)
+	{
+		nextY = ((y + (stepY > 0 ? 1 : 0)) * m_tileSize - local.p1.y) / d.y;
+		deltaY = m_tileSize / b2Abs(d.y);
+	}
+
+	for (;;)
+	{
+		const b2PolygonShape* polygon = GetTilePolygon(GetTile(x, y));
+		if (polygon != NULL)
+		{
+			b2XForm cellXF(GetCellOffset(x, y), b2Mat22_identity);
+			b2Vec2 cellNormal;
+			b2SegmentCollide result = polygon->TestSegment(cellXF, lambda, &cellNormal, local, maxLambda);
+			if (result != e_missCollide)
+			{
+				*normal = b2Mul(transform.R, cellNormal);
+				return result;
+			}
+		}
+
+		if (nextX < nextY)
+		{
+			if (nextX > tmax)
+			{
+				break;
+			}
+
+			x += stepX;
+			nextX += deltaX;
+		}
+		else
+		{
+			if (nextY > tmax)
+			{
+				break;
+			}
+
+			y += stepY;
+			nextY += deltaY;
+		}
+
+		if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+		{
+			break;
+		}
+	}
+
+	return e_missCollide;
+}
+
+void b2TileGridShape::ComputeAABB(b2AABB* aabb, const b2XForm& transform) const
+{
+	b2Vec2 h(0.5f * m_width * m_tileSize, 0.5f * m_height * m_tileSize);
+	b2Vec2 center = b2Mul(transform, h);
+	b2Vec2 extents = b2Mul(b2Abs(transform.R), h);
+	aabb->lowerBound = center - extents;
+	aabb->upperBound = center + extents;
+}
+
+void b2TileGridShape::ComputeSweptAABB(b2AABB* aabb, const b2XForm& transform1, const b2XForm& transform2) const
+{
+	b2AABB aabb1, aabb2;
+	ComputeAABB(&aabb1, transform1);
+	ComputeAABB(&aabb2, transform2);
+	aabb->lowerBound = b2Min(aabb1.lowerBound, aabb2.lowerBound);
+	aabb->upperBound = b2Max(aabb1.upperBound, aabb2.upperBound);
+}
+
+void b2TileGridShape::ComputeMass(b2MassData* massData) const
+{
+	massData->mass = 0;
+	massData->center = b2Vec2_zero;
+
+	// inertia about the local origin
+	massData->I = 0;
+}
+
+float32 b2TileGridShape::ComputeSubmergedArea(	const b2Vec2& normal,
+												float32 offset,
+												const b2XForm& xf, 
+												b2Vec2* c) const
+{
+	float32 area = 0.0f;
+	b2Vec2 center = b2Vec2_zero;
+	for (int32 y = 0; y < m_height; ++y)
+	{
+		for (int32 x = 0; x < m_width; ++x)
+		{
+			const b2PolygonShape* polygon = GetTilePolygon(GetTile(x, y));
+			if (polygon == NULL)
+			{
+				continue;
+			}
+
+			b2XForm cellXF(b2Mul(xf, GetCellOffset(x, y)), xf.R);
+			b2Vec2 cellCenter;
+			float32 cellArea = polygon->ComputeSubmergedArea(normal, offset, cellXF, &cellCenter);
+			area += cellArea;
+			center += cellArea * cellCenter;
+		}
+	}
+
+	if (area != 0.0f)
+	{
+		center *= 1.0f / area;
+	}
+
+	*c = center;
+	return area;
+}
+
+void b2TileGridShape::UpdateSweepRadius(const b2Vec2& center)
+{
+	b2Vec2 extents(m_width * m_tileSize, m_height * m_tileSize);
+	b2Vec2 d = b2Max(b2Abs(center), b2Abs(extents - center));
+	m_sweepRadius = d.Length();
+}
@@ -0,0 +1,176 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TILE_GRID_SHAPE_H
+#define B2_TILE_GRID_SHAPE_H
+
+#include "b2Shape.h"
+
+class b2PolygonShape;
+
+/// The contents of a tile grid cell. A slope is the right triangle filling the
+/// named corner of its cell.
+enum b2TileType
+{
+	e_tileEmpty = 0,
+	e_tileSolid,
+	e_tileSlopeLowerLeft,
+	e_tileSlopeLowerRight,
+	e_tileSlopeUpperLeft,
+	e_tileSlopeUpperRight,
+	e_tileTypeCount,
+};
+
+/// This structure is used to build tile grid shapes. A tile grid is a static
+/// map of square tiles stored as one byte per cell, in a single shape with a
+/// single broad-phase proxy. Cell (x, y) covers [x, x + 1] * tileSize by
+/// [y, y + 1] * tileSize in local coordinates, so row 0 is the bottom row.
+struct b2TileGridDef : public b2ShapeDef
+{
+	b2TileGridDef()
+	{
+		type = e_tileGridShape;
+		width = 0;
+		height = 0;
+		tileSize = 1.0f;
+		tiles = NULL;
+	}
+
+	/// The number of columns.
+	int32 width;
+
+	/// The number of rows.
+	int32 height;
+
+	/// The side length of a tile.
+	float32 tileSize;
+
+	/// The tile types, row by row from the bottom, width * height in all. They
+	/// are copied by the shape. If NULL every tile starts empty.
+	const uint8* tiles;
+};
+
+/// A grid of solid and sloped tiles collided as one shape. Contacts are found by
+/// indexing the cells under the other shape, and rays walk the grid cell by cell.
+class b2TileGridShape : public b2Shape
+{
+public:
+	/// @see b2Shape::TestPoint
+	bool TestPoint(const b2XForm& transform, const b2Vec2& p) const;
+
+	/// @see b2Shape::TestSegment
+	b2SegmentCollide TestSegment(	const b2XForm& transform,
+						float32* lambda,
+						b2Vec2* normal,
+						const b2Segment& segment,
+						float32 maxLambda) const;
+
+	/// @see b2Shape::ComputeAABB
+	void ComputeAABB(b2AABB* aabb, const b2XForm& transform) const;
+
+	/// @see b2Shape::ComputeSweptAABB
+	void ComputeSweptAABB(	b2AABB* aabb,
+							const b2XForm& transform1,
+							const b2XForm& transform2) const;
+
+	/// @see b2Shape::ComputeMass
+	void ComputeMass(b2MassData* massData) const;
+
+	/// @see b2Shape::ComputeSubmergedArea
+	float32 ComputeSubmergedArea(	const b2Vec2& normal,
+									float32 offset,
+									const b2XForm& xf, 
+									b2Vec2* c) const;
+
+	/// Get the number of columns.
+	int32 GetWidth() const;
+
+	/// Get the number of rows.
+	int32 GetHeight() const;
+
+	/// Get the side length of a tile.
+	float32 GetTileSize() const;
+
+	/// Get the type of a tile.
+	uint8 GetTile(int32 x, int32 y) const;
+
+	/// Change the type of a tile. Contacts pick up the change on the next step.
+	/// @warning bodies resting on the tile are not woken up.
+	void SetTile(int32 x, int32 y, uint8 type);
+
+	/// Get the cell range overlapped by an AABB given in the grid's local frame.
+	/// @return false if the AABB misses the grid.
+	bool GetCellRange(const b2AABB& aabb, int32* lowerX, int32* lowerY, int32* upperX, int32* upperY) const;
+
+	/// Get the polygon for a tile type, in cell coordinates. Offset it by
+	/// GetCellOffset to place it in the grid. Returns NULL for empty tiles.
+	const b2PolygonShape* GetTilePolygon(uint8 type) const;
+
+	/// Get the lower corner of a cell in the grid's local frame.
+	b2Vec2 GetCellOffset(int32 x, int32 y) const;
+
+	/// Does the contact normal of a tile point into a full face of its
+	/// neighbor? Such contacts come from the seam between two tiles.
+	/// @param localNormal the normal pointing away from the tile, in the grid's local frame.
+	bool IsInternalNormal(int32 x, int32 y, const b2Vec2& localNormal) const;
+
+private:
+
+	friend class b2Shape;
+
+	b2TileGridShape(const b2ShapeDef* def);
+	~b2TileGridShape();
+
+	void UpdateSweepRadius(const b2Vec2& center);
+
+	uint8* m_tiles;
+	int32 m_width;
+	int32 m_height;
+	float32 m_tileSize;
+
+	// One polygon per non-empty tile type.
+	b2PolygonShape* m_polygons;
+};
+
+inline int32 b2TileGridShape::GetWidth() const
+{
+	return m_width;
+}
+
+inline int32 b2TileGridShape::GetHeight() const
+{
+	return m_height;
+}
+
+inline float32 b2TileGridShape::GetTileSize() const
+{
+	return m_tileSize;
+}
+
+inline uint8 b2TileGridShape::GetTile(int32 x, int32 y) const
+{
+	b2Assert(0 <= x && x < m_width && 0 <= y && y < m_height);
+	return m_tiles[y * m_width + x];
+}
+
+inline b2Vec2 b2TileGridShape::GetCellOffset(int32 x, int32 y) const
+{
+	return b2Vec2(x * m_tileSize, y * m_tileSize);
+}
+
+#endif
@@ -17,9 +17,11 @@
 */
 
 #include "b2BroadPhase.h"
+#include "b2SpatialHash.h"
 #include <algorithm>
 
 #include <cstring>
+#include <new>
 
 // Notes:
 // - we use bound arrays instead of linked lists for cache coherence.
@@ -41,7 +43,7 @@ struct b2BoundValues
 	uint16 upperValues[2];
 };
 
-static int32 BinarySearch(b2Bound* bounds, int32 count, uint16 value)
+static int32 BinarySearch(const b2Bound* bounds, int32 count, uint16 value)
 {
 	int32 low = 0;
 	int32 high = count - 1;
@@ -66,6 +68,19 @@ static int32 BinarySearch(b2Bound* bounds, int32 count, uint16 value)
 }
 
 b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
+{
+	Initialize(worldAABB, callback);
+}
+
+b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback, float32 cellSize)
+{
+	Initialize(worldAABB, callback);
+
+	void* mem = b2Alloc(sizeof(b2SpatialHash));
+	m_spatialHash = new (mem) b2SpatialHash(worldAABB, cellSize, &m_pairManager);
+}
+
+void b2BroadPhase::Initialize(const b2AABB& worldAABB, b2PairCallback* callback)
 {
 	m_pairManager.Initialize(this, callback);
 
@@ -92,10 +107,17 @@ b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
 
 	m_timeStamp = 1;
 	m_queryResultCount = 0;
+
+	m_spatialHash = NULL;
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
+	if (m_spatialHash)
+	{
+		m_spatialHash->~b2SpatialHash();
+		b2Free(m_spatialHash);
+	}
 }
 
 // This one is only used for validation.
@@ -120,11 +142,11 @@ bool b2BroadPhase::TestOverlap(b2Proxy* p1, b2Proxy* p2)
 	return true;
 }
 
-bool b2BroadPhase::TestOverlap(const b2BoundValues& b, b2Proxy* p)
+bool b2BroadPhase::TestOverlap(const b2BoundValues& b, const b2Proxy* p) const
 {
 	for (int32 axis = 0; axis < 2; ++axis)
 	{
-		b2Bound* bounds = m_bounds[axis];
+		const b2Bound* bounds = m_bounds[axis];
 
 		b2Assert(p->lowerBounds[axis] < 2 * m_proxyCount);
 		b2Assert(p->upperBounds[axis] < 2 * m_proxyCount);
@@ -139,7 +161,7 @@ bool b2BroadPhase::TestOverlap(const b2BoundValues& b, b2Proxy* p)
 	return true;
 }
 
-void b2BroadPhase::ComputeBounds(uint16* lowerValues, uint16* upperValues, const b2AABB& aabb)
+void b2BroadPhase::ComputeBounds(uint16* lowerValues, uint16* upperValues, const b2AABB& aabb) const
 {
 	b2Assert(aabb.upperBound.x >= aabb.lowerBound.x);
 	b2Assert(aabb.upperBound.y >= aabb.lowerBound.y);
@@ -238,6 +260,11 @@ void b2BroadPhase::Query(int32* lowerQueryOut, int32* upperQueryOut,
 
 uint16 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 {
+	if (m_spatialHash)
+	{
+		return m_spatialHash->CreateProxy(aabb, userData);
+	}
+
 	b2Assert(m_proxyCount < b2_maxProxies);
 	b2Assert(m_freeProxy != b2_nullProxy);
 
@@ -324,6 +351,12 @@ uint16 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
+	if (m_spatialHash)
+	{
+		m_spatialHash->DestroyProxy(proxyId);
+		return;
+	}
+
 	b2Assert(0 < m_proxyCount && m_proxyCount <= b2_maxProxies);
 	b2Proxy* proxy = m_proxyPool + proxyId;
 	b2Assert(proxy->IsValid());
@@ -400,6 +433,12 @@ void b2BroadPhase::DestroyProxy(int32 proxyId)
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb)
 {
+	if (m_spatialHash)
+	{
+		m_spatialHash->MoveProxy(proxyId, aabb);
+		return;
+	}
+
 	if (proxyId == b2_nullProxy || b2_maxProxies <= proxyId)
 	{
 		b2Assert(false);
@@ -607,37 +646,191 @@ void b2BroadPhase::Commit()
 	m_pairManager.Commit();
 }
 
-int32 b2BroadPhase::Query(const b2AABB& aabb, void** userData, int32 maxCount)
+bool b2BroadPhase::IsProxyValid(int32 proxyId) const
 {
-	uint16 lowerValues[2];
-	uint16 upperValues[2];
-	ComputeBounds(lowerValues, upperValues, aabb);
+	if (m_spatialHash)
+	{
+		return m_spatialHash->IsProxyValid(proxyId);
+	}
 
-	int32 lowerIndex, upperIndex;
+	return 0 <= proxyId && proxyId < b2_maxProxies && m_proxyPool[proxyId].IsValid();
+}
 
-	Query(&lowerIndex, &upperIndex, lowerValues[0], upperValues[0], m_bounds[0], 2*m_proxyCount, 0);
-	Query(&lowerIndex, &upperIndex, lowerValues[1], upperValues[1], m_bounds[1], 2*m_proxyCount, 1);
+void* b2BroadPhase::GetUserData(int32 proxyId) const
+{
+	if (m_spatialHash)
+	{
+		return m_spatialHash->GetUserData(proxyId);
+	}
 
-	b2Assert(m_queryResultCount < b2_maxProxies);
+	b2Assert(IsProxyValid(proxyId));
+	return m_proxyPool[proxyId].userData;
+}
 
-	int32 count = 0;
-	for (int32 i = 0; i < m_queryResultCount && count < maxCount; ++i, ++count)
+void b2BroadPhase::SetUserData(int32 proxyId, void* userData)
+{
+	if (m_spatialHash)
 	{
-		b2Assert(m_queryResults[i] < b2_maxProxies);
-		b2Proxy* proxy = m_proxyPool + m_queryResults[i];
-		b2Assert(proxy->IsValid());
-		userData[i] = proxy->userData;
+		m_spatialHash->SetUserData(proxyId, userData);
+		return;
 	}
 
-	// Prepare for next query.
-	m_queryResultCount = 0;
-	IncrementTimeStamp();
+	b2Assert(IsProxyValid(proxyId));
+	m_proxyPool[proxyId].userData = userData;
+}
+
+// The sweep and prune bounds are quantized, so this is slightly larger than
+// the AABB the proxy was given.
+b2AABB b2BroadPhase::GetProxyAABB(int32 proxyId) const
+{
+	if (m_spatialHash)
+	{
+		return m_spatialHash->GetAABB(proxyId);
+	}
+
+	b2Assert(IsProxyValid(proxyId));
+	const b2Proxy* p = m_proxyPool + proxyId;
+
+	b2Vec2 invQ;
+	invQ.Set(1.0f / m_quantizationFactor.x, 1.0f / m_quantizationFactor.y);
+
+	b2AABB aabb;
+	aabb.lowerBound.x = m_worldAABB.lowerBound.x + invQ.x * m_bounds[0][p->lowerBounds[0]].value;
+	aabb.lowerBound.y = m_worldAABB.lowerBound.y + invQ.y * m_bounds[1][p->lowerBounds[1]].value;
+	aabb.upperBound.x = m_worldAABB.lowerBound.x + invQ.x * m_bounds[0][p->upperBounds[0]].value;
+	aabb.upperBound.y = m_worldAABB.lowerBound.y + invQ.y * m_bounds[1][p->upperBounds[1]].value;
+	return aabb;
+}
+
+int32 b2BroadPhase::GetProxyCount() const
+{
+	if (m_spatialHash)
+	{
+		return m_spatialHash->GetProxyCount();
+	}
+
+	return m_proxyCount;
+}
+
+int32 b2BroadPhase::GetProxyCapacity() const
+{
+	if (m_spatialHash)
+	{
+		return m_spatialHash->GetProxyCapacity();
+	}
+
+	return b2_maxProxies;
+}
+
+bool b2BroadPhase::TestOverlap(int32 proxyId1, int32 proxyId2)
+{
+	if (m_spatialHash)
+	{
+		return b2TestOverlap(m_spatialHash->GetAABB(proxyId1), m_spatialHash->GetAABB(proxyId2));
+	}
+
+	return TestOverlap(m_proxyPool + proxyId1, m_proxyPool + proxyId2);
+}
+
+// This walks the sorted bounds of the x-axis like Query above, but tests the
+// candidates directly instead of counting overlaps on the proxies.
+void b2BroadPhase::QueryBounds(const b2BoundValues& b, b2QueryResults* query) const
+{
+	const b2Bound* bounds = m_bounds[0];
+	int32 boundCount = 2 * m_proxyCount;
+
+	int32 lowerQuery = BinarySearch(bounds, boundCount, b.lowerValues[0]);
+	int32 upperQuery = BinarySearch(bounds, boundCount, b.upperValues[0]);
+
+	// Easy case: lowerQuery <= lowerIndex(i) < upperQuery
+	for (int32 i = lowerQuery; i < upperQuery && query->IsFull() == false; ++i)
+	{
+		const b2Proxy* proxy = m_proxyPool + bounds[i].proxyId;
+		if (bounds[i].IsLower() && TestOverlap(b, proxy))
+		{
+			query->Add(proxy->userData);
+		}
+	}
+
+	// Hard case: lowerIndex(i) < lowerQuery < upperIndex(i)
+	if (lowerQuery > 0)
+	{
+		int32 i = lowerQuery - 1;
+		int32 s = bounds[i].stabbingCount;
+
+		while (s && query->IsFull() == false)
+		{
+			b2Assert(i >= 0);
+
+			if (bounds[i].IsLower())
+			{
+				const b2Proxy* proxy = m_proxyPool + bounds[i].proxyId;
+				if (lowerQuery <= proxy->upperBounds[0])
+				{
+					if (TestOverlap(b, proxy))
+					{
+						query->Add(proxy->userData);
+					}
+					--s;
+				}
+			}
+			--i;
+		}
+	}
+}
+
+int32 b2BroadPhase::Query(const b2AABB& aabb, void** userData, int32 maxCount) const
+{
+	if (m_spatialHash)
+	{
+		return m_spatialHash->Query(aabb, userData, maxCount);
+	}
+
+	b2BoundValues b;
+	ComputeBounds(b.lowerValues, b.upperValues, aabb);
+
+	b2QueryResults query(userData, b2Min(maxCount, m_proxyCount), NULL, NULL);
+	QueryBounds(b, &query);
+	return query.count;
+}
+
+void b2BroadPhase::CopyQueryState(const b2BroadPhase* other)
+{
+	if (other->m_spatialHash)
+	{
+		if (m_spatialHash == NULL)
+		{
+			void* mem = b2Alloc(sizeof(b2SpatialHash));
+			m_spatialHash = new (mem) b2SpatialHash(other->m_worldAABB, other->m_spatialHash->GetCellSize(), &m_pairManager);
+		}
+
+		m_worldAABB = other->m_worldAABB;
+		m_spatialHash->CopyQueryState(other->m_spatialHash);
+		return;
+	}
+
+	m_worldAABB = other->m_worldAABB;
+	m_quantizationFactor = other->m_quantizationFactor;
+	m_proxyCount = other->m_proxyCount;
+	m_freeProxy = other->m_freeProxy;
+
+	memcpy(m_proxyPool, other->m_proxyPool, sizeof(m_proxyPool));
 
-	return count;
+	int32 boundCount = 2 * m_proxyCount;
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		memcpy(m_bounds[axis], other->m_bounds[axis], boundCount * sizeof(b2Bound));
+	}
 }
 
 void b2BroadPhase::Validate()
 {
+	if (m_spatialHash)
+	{
+		m_spatialHash->Validate();
+		return;
+	}
+
 	for (int32 axis = 0; axis < 2; ++axis)
 	{
 		b2Bound* bounds = m_bounds[axis];
@@ -669,8 +862,83 @@ void b2BroadPhase::Validate()
 }
 
 
-int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int32 maxCount, SortKeyFunc sortKey)
+b2QueryResults::b2QueryResults(void** userData, int32 maxCount, SortKeyFunc sortKey, void* context)
+{
+	results = userData;
+	sortKeys = stackKeys;
+	count = 0;
+	this->maxCount = maxCount;
+	this->sortKey = sortKey;
+	this->context = context;
+
+	if (sortKey && maxCount > e_stackKeyCount)
+	{
+		sortKeys = (float32*)b2Alloc(maxCount * sizeof(float32));
+	}
+}
+
+b2QueryResults::~b2QueryResults()
+{
+	if (sortKeys != stackKeys)
+	{
+		b2Free(sortKeys);
+	}
+}
+
+void b2QueryResults::Add(void* userData)
+{
+	if (sortKey == NULL)
+	{
+		if (count < maxCount)
+		{
+			results[count++] = userData;
+		}
+		return;
+	}
+
+	// Proxies with a negative key are filtered out.
+	float32 key = sortKey(context, userData);
+	if (key < 0.0f)
+	{
+		return;
+	}
+
+	// Merge the new key into the sorted list after any equal keys, dropping the
+	// last one if full.
+	int32 i = count;
+	while (i > 0 && sortKeys[i - 1] > key)
+	{
+		--i;
+	}
+
+	if (i == maxCount)
+	{
+		return;
+	}
+
+	if (count == maxCount)
+	{
+		--count;
+	}
+
+	for (int32 j = count; j > i; --j)
+	{
+		sortKeys[j] = sortKeys[j - 1];
+		results[j] = results[j - 1];
+	}
+
+	sortKeys[i] = key;
+	results[i] = userData;
+	++count;
+}
+
+int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int32 maxCount, SortKeyFunc sortKey, void* context) const
 {
+	if (m_spatialHash)
+	{
+		return m_spatialHash->QuerySegment(segment, userData, maxCount, sortKey, context);
+	}
+
 	float32 maxLambda = 1;
 
 	float32 dx = (segment.p2.x-segment.p1.x)*m_quantizationFactor.x;
@@ -691,7 +959,10 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 	int32 yIndex;
 
 	uint16 proxyId;
-	b2Proxy* proxy;
+	const b2Proxy* proxy;
+
+	// Results go straight into the caller's buffer, which keeps the query reentrant.
+	b2QueryResults query(userData, b2Min(maxCount, m_proxyCount), sortKey, context);
 	
 	// TODO_ERIN implement fast float to uint16 conversion.
 	startValues[0] = (uint16)(p1x) & (B2BROADPHASE_MAX - 1);
@@ -701,49 +972,17 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 	startValues2[1] = (uint16)(p1y) | 1;
 
 	//First deal with all the proxies that contain segment.p1
-	int32 lowerIndex;
-	int32 upperIndex;
-	Query(&lowerIndex,&upperIndex,startValues[0],startValues2[0],m_bounds[0],2*m_proxyCount,0);
-	if(sx>=0)	xIndex = upperIndex-1;
-	else		xIndex = lowerIndex;
-	Query(&lowerIndex,&upperIndex,startValues[1],startValues2[1],m_bounds[1],2*m_proxyCount,1);
-	if(sy>=0)	yIndex = upperIndex-1;
-	else		yIndex = lowerIndex;
-
-	//If we are using sortKey, then sort what we have so far, filtering negative keys
-	if(sortKey)
-	{
-		//Fill keys
-		for(int32 i=0;i<m_queryResultCount;i++)
-		{
-			m_querySortKeys[i] = sortKey(m_proxyPool[m_queryResults[i]].userData);
-		}
-		//Bubble sort keys
-		//Sorting negative values to the top, so we can easily remove them
-		int32 i = 0;
-		while(i<m_queryResultCount-1)
-		{
-			float32 a = m_querySortKeys[i];
-			float32 b = m_querySortKeys[i+1];
-			if((a<0)?(b>=0):(a>b&&b>=0))
-			{
-				m_querySortKeys[i+1] = a;
-				m_querySortKeys[i]   = b;
-				uint16 tempValue = m_queryResults[i+1];
-				m_queryResults[i+1] = m_queryResults[i];
-				m_queryResults[i] = tempValue;
-				i--;
-				if(i==-1) i=1;
-			}
-			else
-			{
-				i++;
-			}
-		}
-		//Skim off negative values
-		while(m_queryResultCount>0 && m_querySortKeys[m_queryResultCount-1]<0)
-			m_queryResultCount--;
-	}
+	b2BoundValues start;
+	start.lowerValues[0] = startValues[0];
+	start.upperValues[0] = startValues2[0];
+	start.lowerValues[1] = startValues[1];
+	start.upperValues[1] = startValues2[1];
+	QueryBounds(start, &query);
+
+	if(sx>=0)	xIndex = BinarySearch(m_bounds[0],2*m_proxyCount,startValues2[0])-1;
+	else		xIndex = BinarySearch(m_bounds[0],2*m_proxyCount,startValues[0]);
+	if(sy>=0)	yIndex = BinarySearch(m_bounds[1],2*m_proxyCount,startValues2[1])-1;
+	else		yIndex = BinarySearch(m_bounds[1],2*m_proxyCount,startValues[1]);
 
 	//Now work through the rest of the segment
 	for (;;)
@@ -779,15 +1018,7 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 						if(proxy->lowerBounds[1]<=yIndex-1&&proxy->upperBounds[1]>=yIndex)
 						{
 							//Add the proxy
-							if(sortKey)
-							{
-								AddProxyResult(proxyId,proxy,maxCount,sortKey);
-							}
-							else
-							{
-								m_queryResults[m_queryResultCount] = proxyId;
-								++m_queryResultCount;
-							}
+							query.Add(proxy->userData);
 						}
 					}
 					else
@@ -795,21 +1026,13 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 						if(proxy->lowerBounds[1]<=yIndex&&proxy->upperBounds[1]>=yIndex+1)
 						{
 							//Add the proxy
-							if(sortKey)
-							{
-								AddProxyResult(proxyId,proxy,maxCount,sortKey);
-							}
-							else
-							{
-								m_queryResults[m_queryResultCount] = proxyId;
-								++m_queryResultCount;
-							}
+							query.Add(proxy->userData);
 						}
 					}
 				}
 
 				//Early out
-				if(sortKey && m_queryResultCount==maxCount && m_queryResultCount>0 && xProgress>m_querySortKeys[m_queryResultCount-1])
+				if(sortKey && query.count==query.maxCount && query.count>0 && xProgress>query.sortKeys[query.count-1])
 					break;
 
 				//Move on to the next bound
@@ -842,15 +1065,7 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 						if(proxy->lowerBounds[0]<=xIndex-1&&proxy->upperBounds[0]>=xIndex)
 						{
 							//Add the proxy
-							if(sortKey)
-							{
-								AddProxyResult(proxyId,proxy,maxCount,sortKey);
-							}
-							else
-							{
-								m_queryResults[m_queryResultCount] = proxyId;
-								++m_queryResultCount;
-							}
+							query.Add(proxy->userData);
 						}
 					}
 					else
@@ -858,21 +1073,13 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 						if(proxy->lowerBounds[0]<=xIndex&&proxy->upperBounds[0]>=xIndex+1)
 						{
 							//Add the proxy
-							if(sortKey)
-							{
-								AddProxyResult(proxyId,proxy,maxCount,sortKey);
-							}
-							else
-							{
-								m_queryResults[m_queryResultCount] = proxyId;
-								++m_queryResultCount;
-							}
+							query.Add(proxy->userData);
 						}
 					}
 				}
 
 				//Early out
-				if(sortKey && m_queryResultCount==maxCount && m_queryResultCount>0 && yProgress>m_querySortKeys[m_queryResultCount-1])
+				if(sortKey && query.count==query.maxCount && query.count>0 && yProgress>query.sortKeys[query.count-1])
 					break;
 
 				//Move on to the next bound
@@ -895,44 +1102,6 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 		break;
 	}
 
-	int32 count = 0;
-	for(int32 i=0;i < m_queryResultCount && count<maxCount; ++i, ++count)
-	{
-		b2Assert(m_queryResults[i] < b2_maxProxies);
-		b2Proxy* proxy = m_proxyPool + m_queryResults[i];
-		b2Assert(proxy->IsValid());
-		userData[i] = proxy->userData;
-	}
-
-	// Prepare for next query.
-	m_queryResultCount = 0;
-	IncrementTimeStamp();
-	
-	return count;
+	return query.count;
 
 }
-void b2BroadPhase::AddProxyResult(uint16 proxyId, b2Proxy* proxy, int32 maxCount, SortKeyFunc sortKey)
-{
-	float32 key = sortKey(proxy->userData);
-	//Filter proxies on positive keys
-	if(key<0)
-		return;
-	//Merge the new key into the sorted list.
-	//float32* p = std::lower_bound(m_querySortKeys,m_querySortKeys+m_queryResultCount,key);
-	float32* p = m_querySortKeys;
-	while(*p<key&&p<m_querySortKeys+m_queryResultCount)
-		p++;
-	int32 i = (int32)(p-m_querySortKeys);
-	if(maxCount==m_queryResultCount&&i==m_queryResultCount)
-		return;
-	if(maxCount==m_queryResultCount)
-		m_queryResultCount--;
-	//std::copy_backward
-	for(int32 j=m_queryResultCount+1;j>i;--j){
-		m_querySortKeys[j] = m_querySortKeys[j-1];
-		m_queryResults[j]  = m_queryResults[j-1];
-	}
-	m_querySortKeys[i] = key;
-	m_queryResults[i] = proxyId;
-	m_queryResultCount++;
-}
\ No newline at end of file
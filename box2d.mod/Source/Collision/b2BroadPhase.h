@@ -41,6 +41,7 @@ Bullet (http:/www.bulletphysics.com).
 const uint16 b2_invalid = B2BROADPHASE_MAX;
 const uint16 b2_nullEdge = B2BROADPHASE_MAX;
 struct b2BoundValues;
+class b2SpatialHash;
 
 struct b2Bound
 {
@@ -64,12 +65,40 @@ struct b2Proxy
 	void* userData;
 };
 
-typedef float32 (*SortKeyFunc)(void* shape);
+typedef float32 (*SortKeyFunc)(void* context, void* userData);
+
+// Gathers query results straight into the caller's buffer. With a sort key the
+// results are kept sorted on it and proxies with a negative key are dropped.
+struct b2QueryResults
+{
+	b2QueryResults(void** userData, int32 maxCount, SortKeyFunc sortKey, void* context);
+	~b2QueryResults();
+
+	void Add(void* userData);
+	bool IsFull() const { return sortKey == NULL && count == maxCount; }
+
+	enum { e_stackKeyCount = 32 };
+
+	void** results;
+	float32* sortKeys;
+	int32 count;
+	int32 maxCount;
+	SortKeyFunc sortKey;
+	void* context;
+
+	// Short result lists keep their sort keys here instead of on the heap.
+	float32 stackKeys[e_stackKeyCount];
+};
 
 class b2BroadPhase
 {
 public:
 	b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback);
+
+	// Use a uniform grid with the given cell size instead of sweep and prune.
+	// The grid is not limited to b2_maxProxies proxies.
+	b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback, float32 cellSize);
+
 	~b2BroadPhase();
 
 	// Use this to see if your proxy is in range. If it is not in range,
@@ -86,12 +115,27 @@ public:
 	void MoveProxy(int32 proxyId, const b2AABB& aabb);
 	void Commit();
 
-	// Get a single proxy. Returns NULL if the id is invalid.
+	// Get a single proxy. Returns NULL if the id is invalid. This is only
+	// used by sweep and prune.
 	b2Proxy* GetProxy(int32 proxyId);
 
+	// Proxy access that works with either algorithm. Proxy ids are below
+	// the capacity.
+	bool IsProxyValid(int32 proxyId) const;
+	void* GetUserData(int32 proxyId) const;
+	void SetUserData(int32 proxyId, void* userData);
+	b2AABB GetProxyAABB(int32 proxyId) const;
+	int32 GetProxyCount() const;
+	int32 GetProxyCapacity() const;
+
+	// Do the bounds of two proxies overlap? This is only used for validation.
+	bool TestOverlap(int32 proxyId1, int32 proxyId2);
+
 	// Query an AABB for overlapping proxies, returns the user data and
 	// the count, up to the supplied maximum count.
-	int32 Query(const b2AABB& aabb, void** userData, int32 maxCount);
+	// Queries do not modify the broad-phase, so several threads may query
+	// at once as long as no proxies are created, destroyed or moved.
+	int32 Query(const b2AABB& aabb, void** userData, int32 maxCount) const;
 
 	// Query a segment for overlapping proxies, returns the user data and
 	// the count, up to the supplied maximum count.
@@ -99,35 +143,47 @@ public:
 	// Then the returned proxies are sorted on that, before being truncated to maxCount
 	// The sortKey of a proxy is assumed to be larger than the closest point inside the proxy along the segment, this allows for early exits
 	// Proxies with a negative sortKey are discarded
-	int32 QuerySegment(const b2Segment& segment, void** userData, int32 maxCount, SortKeyFunc sortKey);
+	// The context is passed through to sortKey.
+	int32 QuerySegment(const b2Segment& segment, void** userData, int32 maxCount, SortKeyFunc sortKey, void* context) const;
+
+	// Copy the proxies and bounds used by queries from another broad-phase. The copy
+	// can be queried while the other broad-phase is being updated. Pairs are not copied.
+	void CopyQueryState(const b2BroadPhase* other);
 
 	void Validate();
 	void ValidatePairs();
 
 private:
-	void ComputeBounds(uint16* lowerValues, uint16* upperValues, const b2AABB& aabb);
+	void Initialize(const b2AABB& worldAABB, b2PairCallback* callback);
+
+	void ComputeBounds(uint16* lowerValues, uint16* upperValues, const b2AABB& aabb) const;
 
 	bool TestOverlap(b2Proxy* p1, b2Proxy* p2);
-	bool TestOverlap(const b2BoundValues& b, b2Proxy* p);
+	bool TestOverlap(const b2BoundValues& b, const b2Proxy* p) const;
+
+	// Read-only overlap query used by the public queries.
+	void QueryBounds(const b2BoundValues& b, b2QueryResults* query) const;
 
 	void Query(int32* lowerIndex, int32* upperIndex, uint16 lowerValue, uint16 upperValue,
 				b2Bound* bounds, int32 boundCount, int32 axis);
 	void IncrementOverlapCount(int32 proxyId);
 	void IncrementTimeStamp();
-	void AddProxyResult(uint16 proxyId, b2Proxy* proxy, int32 maxCount, SortKeyFunc sortKey);
 
 public:
 	friend class b2PairManager;
 
 	b2PairManager m_pairManager;
 
+	// The grid, if the broad-phase uses one.
+	b2SpatialHash* m_spatialHash;
+
 	b2Proxy m_proxyPool[b2_maxProxies];
 	uint16 m_freeProxy;
 
 	b2Bound m_bounds[2][2*b2_maxProxies];
 
+	// Scratch space for proxy creation and destruction.
 	uint16 m_queryResults[b2_maxProxies];
-	float32 m_querySortKeys[b2_maxProxies];
 	int32 m_queryResultCount;
 
 	b2AABB m_worldAABB;
@@ -77,18 +77,7 @@ static float32 EdgeSeparation(const b2PolygonShape* poly1, const b2XForm& xf1, i
 	b2Vec2 normal1 = b2MulT(xf2.R, normal1World);
 
 	// Find support vertex on poly2 for -normal.
-	int32 index = 0;
-	float32 minDot = B2_FLT_MAX;
-
-	for (int32 i = 0; i < count2; ++i)
-	{
-		float32 dot = b2Dot(vertices2[i], normal1);
-		if (dot < minDot)
-		{
-			minDot = dot;
-			index = i;
-		}
-	}
+	int32 index = b2FindMinDot(poly2->GetVertices(), count2, normal1);
 
 	b2Vec2 v1 = b2Mul(xf1, vertices1[edge1]);
 	b2Vec2 v2 = b2Mul(xf2, vertices2[index]);
@@ -102,24 +91,13 @@ static float32 FindMaxSeparation(int32* edgeIndex,
 								 const b2PolygonShape* poly2, const b2XForm& xf2)
 {
 	int32 count1 = poly1->GetVertexCount();
-	const b2Vec2* normals1 = poly1->GetNormals();
 
 	// Vector pointing from the centroid of poly1 to the centroid of poly2.
 	b2Vec2 d = b2Mul(xf2, poly2->GetCentroid()) - b2Mul(xf1, poly1->GetCentroid());
 	b2Vec2 dLocal1 = b2MulT(xf1.R, d);
 
 	// Find edge normal on poly1 that has the largest projection onto d.
-	int32 edge = 0;
-	float32 maxDot = -B2_FLT_MAX;
-	for (int32 i = 0; i < count1; ++i)
-	{
-		float32 dot = b2Dot(normals1[i], dLocal1);
-		if (dot > maxDot)
-		{
-			maxDot = dot;
-			edge = i;
-		}
-	}
+	int32 edge = b2FindMaxDot(poly1->GetNormals(), count1, dLocal1);
 
 	// Get the separation for the edge normal.
 	float32 s = EdgeSeparation(poly1, xf1, edge, poly2, xf2);
@@ -204,7 +182,6 @@ static void FindIncidentEdge(ClipVertex c[2],
 
 	int32 count2 = poly2->GetVertexCount();
 	const b2Vec2* vertices2 = poly2->GetVertices();
-	const b2Vec2* normals2 = poly2->GetNormals();
 
 	b2Assert(0 <= edge1 && edge1 < count1);
 
@@ -212,17 +189,7 @@ static void FindIncidentEdge(ClipVertex c[2],
 	b2Vec2 normal1 = b2MulT(xf2.R, b2Mul(xf1.R, normals1[edge1]));
 
 	// Find the incident edge on poly2.
-	int32 index = 0;
-	float32 minDot = B2_FLT_MAX;
-	for (int32 i = 0; i < count2; ++i)
-	{
-		float32 dot = b2Dot(normal1, normals2[i]);
-		if (dot < minDot)
-		{
-			minDot = dot;
-			index = i;
-		}
-	}
+	int32 index = b2FindMinDot(poly2->GetNormals(), count2, normal1);
 
 	// Build the clip vertices for the incident edge.
 	int32 i1 = index;
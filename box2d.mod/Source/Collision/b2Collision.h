@@ -119,6 +119,21 @@ float32 b2Distance(b2Vec2* x1, b2Vec2* x2,
 				   const b2Shape* shape1, const b2XForm& xf1,
 				   const b2Shape* shape2, const b2XForm& xf2);
 
+/// Test if two shapes overlap. Concave shapes are tested piece by piece.
+/// This is cheaper than computing a manifold and is used for sensors.
+/// @return false if both shapes are concave.
+bool b2TestOverlap(const b2Shape* shape1, const b2XForm& xf1,
+				   const b2Shape* shape2, const b2XForm& xf2);
+
+/// The number of GJK iterations run by the last b2Distance call between two convex
+/// shapes. Circle distances do not touch it. Use this for profiling only, it is not
+/// thread safe.
+extern int32 g_GJK_Iterations;
+
+/// The number of conservative advancement iterations run by the last b2TimeOfImpact
+/// call. Use this for profiling only, it is not thread safe.
+extern int32 g_TOI_Iterations;
+
 /// Compute the time when two shapes begin to touch or touch at a closer distance.
 /// @warning the sweeps must have the same time interval.
 /// @return the fraction between [0,1] in which the shapes first touch.
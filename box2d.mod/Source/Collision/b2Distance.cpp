@@ -20,6 +20,8 @@
 #include "Shapes/b2CircleShape.h"
 #include "Shapes/b2PolygonShape.h"
 #include "Shapes/b2EdgeShape.h"
+#include "Shapes/b2MeshShape.h"
+#include "Shapes/b2TileGridShape.h"
 
 int32 g_GJK_Iterations = 0;
 
@@ -435,3 +437,106 @@ float32 b2Distance(b2Vec2* x1, b2Vec2* x2,
 
 	return 0.0f;
 }
+
+static bool IsConcave(b2ShapeType type)
+{
+	return type == e_meshShape || type == e_tileGridShape || type == e_heightfieldShape;
+}
+
+static bool TestConvexOverlap(const b2Shape* shape1, const b2XForm& xf1,
+							  const b2Shape* shape2, const b2XForm& xf2)
+{
+	// The distance is measured between the core shapes, which are inset by b2_toiSlop.
+	b2Vec2 x1, x2;
+	float32 distance = b2Distance(&x1, &x2, shape1, xf1, shape2, xf2);
+	return distance < 2.0f * b2_toiSlop;
+}
+
+static bool TestConcaveOverlap(const b2Shape* concave, const b2XForm& xf1,
+							   const b2Shape* shape, const b2XForm& xf2)
+{
+	// Bound the convex shape in the concave shape's frame.
+	b2XForm relXF;
+	relXF.R = b2MulT(xf1.R, xf2.R);
+	relXF.position = b2MulT(xf1, xf2.position);
+	b2AABB aabb;
+	shape->ComputeAABB(&aabb, relXF);
+
+	if (concave->GetType() == e_tileGridShape)
+	{
+		const b2TileGridShape* grid = (const b2TileGridShape*)concave;
+		int32 lowerX, lowerY, upperX, upperY;
+		if (grid->GetCellRange(aabb, &lowerX, &lowerY, &upperX, &upperY) == false)
+		{
+			return false;
+		}
+
+		for (int32 y = lowerY; y <= upperY; ++y)
+		{
+			for (int32 x = lowerX; x <= upperX; ++x)
+			{
+				const b2PolygonShape* polygon = grid->GetTilePolygon(grid->GetTile(x, y));
+				if (polygon == NULL)
+				{
+					continue;
+				}
+
+				b2XForm cellXF(b2Mul(xf1, grid->GetCellOffset(x, y)), xf1.R);
+				if (TestConvexOverlap(polygon, cellXF, shape, xf2))
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	const int32 k_stackCount = 64;
+	int32 stackIndices[k_stackCount];
+	int32* indices = stackIndices;
+
+	int32 count = b2QueryEdges(concave, aabb, indices, k_stackCount);
+	if (count > k_stackCount)
+	{
+		indices = (int32*)b2Alloc(count * sizeof(int32));
+		b2QueryEdges(concave, aabb, indices, count);
+	}
+
+	bool overlap = false;
+	for (int32 i = 0; i < count && overlap == false; ++i)
+	{
+		overlap = TestConvexOverlap(b2GetEdge(concave, indices[i]), xf1, shape, xf2);
+	}
+
+	if (indices != stackIndices)
+	{
+		b2Free(indices);
+	}
+
+	return overlap;
+}
+
+bool b2TestOverlap(const b2Shape* shape1, const b2XForm& xf1,
+				   const b2Shape* shape2, const b2XForm& xf2)
+{
+	bool concave1 = IsConcave(shape1->GetType());
+	bool concave2 = IsConcave(shape2->GetType());
+
+	if (concave1 && concave2)
+	{
+		return false;
+	}
+
+	if (concave1)
+	{
+		return TestConcaveOverlap(shape1, xf1, shape2, xf2);
+	}
+
+	if (concave2)
+	{
+		return TestConcaveOverlap(shape2, xf2, shape1, xf1);
+	}
+
+	return TestConvexOverlap(shape1, xf1, shape2, xf2);
+}
@@ -20,6 +20,13 @@
 #include "b2BroadPhase.h"
 
 #include <algorithm>
+#include <cstring>
+
+const int32 b2_pairTableInitialCapacity = 256;
+const int32 b2_pairBufferInitialCapacity = 64;
+
+// Below this size an insertion sort beats the radix passes.
+const int32 b2_radixSortThreshold = 32;
 
 // Thomas Wang's hash, see: http://www.concentric.net/~Ttwang/tech/inthash.htm
 // This assumes proxyId1 and proxyId2 are 16-bit.
@@ -45,43 +52,47 @@ inline bool Equals(const b2BufferedPair& pair1, const b2BufferedPair& pair2)
 	return pair1.proxyId1 == pair2.proxyId1 && pair1.proxyId2 == pair2.proxyId2;
 }
 
+// The sort key orders pairs by the first proxy, then the second.
+inline uint32 SortKey(const b2BufferedPair& pair)
+{
+	return ((uint32)pair.proxyId1 << 16) | (uint32)pair.proxyId2;
+}
+
 // For sorting.
 inline bool operator < (const b2BufferedPair& pair1, const b2BufferedPair& pair2)
 {
-	if (pair1.proxyId1 < pair2.proxyId1)
-	{
-		return true;
-	}
-
-	if (pair1.proxyId1 == pair2.proxyId1)
-	{
-		return pair1.proxyId2 < pair2.proxyId2;
-	}
-
-	return false;
+	return SortKey(pair1) < SortKey(pair2);
 }
 
-
 b2PairManager::b2PairManager()
 {
-	b2Assert(b2IsPowerOfTwo(b2_tableCapacity) == true);
-	b2Assert(b2_tableCapacity >= b2_maxPairs);
-	for (int32 i = 0; i < b2_tableCapacity; ++i)
-	{
-		m_hashTable[i] = b2_nullPair;
-	}
-	m_freePair = 0;
-	for (int32 i = 0; i < b2_maxPairs; ++i)
+	m_broadPhase = NULL;
+	m_callback = NULL;
+
+	m_pairCapacity = b2_pairTableInitialCapacity;
+	m_pairCount = 0;
+	m_pairs = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	for (int32 i = 0; i < m_pairCapacity; ++i)
 	{
 		m_pairs[i].proxyId1 = b2_nullProxy;
 		m_pairs[i].proxyId2 = b2_nullProxy;
 		m_pairs[i].userData = NULL;
 		m_pairs[i].status = 0;
-		m_pairs[i].next = uint16(i + 1);
 	}
-	m_pairs[b2_maxPairs-1].next = b2_nullPair;
-	m_pairCount = 0;
+
+	m_pairBufferCapacity = b2_pairBufferInitialCapacity;
 	m_pairBufferCount = 0;
+	m_pairBuffer = (b2BufferedPair*)b2Alloc(m_pairBufferCapacity * sizeof(b2BufferedPair));
+	m_sortBuffer = (b2BufferedPair*)b2Alloc(m_pairBufferCapacity * sizeof(b2BufferedPair));
+
+	ResetCounters();
+}
+
+b2PairManager::~b2PairManager()
+{
+	b2Free(m_pairs);
+	b2Free(m_pairBuffer);
+	b2Free(m_sortBuffer);
 }
 
 void b2PairManager::Initialize(b2BroadPhase* broadPhase, b2PairCallback* callback)
@@ -90,32 +101,87 @@ void b2PairManager::Initialize(b2BroadPhase* broadPhase, b2PairCallback* callbac
 	m_callback = callback;
 }
 
-b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2, uint32 hash)
+void b2PairManager::ResetCounters()
 {
-	int32 index = m_hashTable[hash];
+	m_addedCount = 0;
+	m_removedCount = 0;
+	m_cancelledCount = 0;
+}
 
-	while (index != b2_nullPair && Equals(m_pairs[index], proxyId1, proxyId2) == false)
+// Returns the slot holding the pair, or the empty slot that ends its probe sequence.
+// The ids must be ordered.
+int32 b2PairManager::FindSlot(int32 proxyId1, int32 proxyId2) const
+{
+	int32 mask = m_pairCapacity - 1;
+	int32 slot = Hash(proxyId1, proxyId2) & mask;
+	while (m_pairs[slot].proxyId1 != b2_nullProxy && Equals(m_pairs[slot], proxyId1, proxyId2) == false)
 	{
-		index = m_pairs[index].next;
+		slot = (slot + 1) & mask;
 	}
 
-	if (index == b2_nullPair)
+	return slot;
+}
+
+bool b2PairManager::HasPair(int32 proxyId1, int32 proxyId2) const
+{
+	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
+
+	return m_pairs[FindSlot(proxyId1, proxyId2)].proxyId1 != b2_nullProxy;
+}
+
+b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2)
+{
+	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
+
+	b2Pair* pair = m_pairs + FindSlot(proxyId1, proxyId2);
+	if (pair->proxyId1 == b2_nullProxy)
 	{
 		return NULL;
 	}
 
-	b2Assert(index < b2_maxPairs);
+	return pair;
+}
+
+void b2PairManager::GrowTable()
+{
+	b2Pair* oldPairs = m_pairs;
+	int32 oldCapacity = m_pairCapacity;
+
+	m_pairCapacity = 2 * oldCapacity;
+	m_pairs = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	for (int32 i = 0; i < m_pairCapacity; ++i)
+	{
+		m_pairs[i].proxyId1 = b2_nullProxy;
+		m_pairs[i].proxyId2 = b2_nullProxy;
+		m_pairs[i].userData = NULL;
+		m_pairs[i].status = 0;
+	}
+
+	for (int32 i = 0; i < oldCapacity; ++i)
+	{
+		if (oldPairs[i].proxyId1 != b2_nullProxy)
+		{
+			m_pairs[FindSlot(oldPairs[i].proxyId1, oldPairs[i].proxyId2)] = oldPairs[i];
+		}
+	}
 
-	return m_pairs + index;
+	b2Free(oldPairs);
 }
 
-b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2)
+void b2PairManager::GrowBuffer()
 {
-	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
+	int32 capacity = 2 * m_pairBufferCapacity;
+
+	b2BufferedPair* buffer = (b2BufferedPair*)b2Alloc(capacity * sizeof(b2BufferedPair));
+	memcpy(buffer, m_pairBuffer, m_pairBufferCount * sizeof(b2BufferedPair));
+	b2Free(m_pairBuffer);
+	m_pairBuffer = buffer;
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	// The scratch buffer holds nothing between sorts.
+	b2Free(m_sortBuffer);
+	m_sortBuffer = (b2BufferedPair*)b2Alloc(capacity * sizeof(b2BufferedPair));
 
-	return Find(proxyId1, proxyId2, hash);
+	m_pairBufferCapacity = capacity;
 }
 
 // Returns existing pair or creates a new one.
@@ -123,27 +189,24 @@ b2Pair* b2PairManager::AddPair(int32 proxyId1, int32 proxyId2)
 {
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
-
-	b2Pair* pair = Find(proxyId1, proxyId2, hash);
-	if (pair != NULL)
+	int32 slot = FindSlot(proxyId1, proxyId2);
+	if (m_pairs[slot].proxyId1 != b2_nullProxy)
 	{
-		return pair;
+		return m_pairs + slot;
 	}
 
-	b2Assert(m_pairCount < b2_maxPairs && m_freePair != b2_nullPair);
-
-	uint16 pairIndex = m_freePair;
-	pair = m_pairs + pairIndex;
-	m_freePair = pair->next;
+	// Keep the load factor at or below one half so probe sequences stay short.
+	if (2 * (m_pairCount + 1) > m_pairCapacity)
+	{
+		GrowTable();
+		slot = FindSlot(proxyId1, proxyId2);
+	}
 
+	b2Pair* pair = m_pairs + slot;
 	pair->proxyId1 = (uint16)proxyId1;
 	pair->proxyId2 = (uint16)proxyId2;
 	pair->status = 0;
 	pair->userData = NULL;
-	pair->next = m_hashTable[hash];
-
-	m_hashTable[hash] = pairIndex;
 
 	++m_pairCount;
 
@@ -157,38 +220,34 @@ void* b2PairManager::RemovePair(int32 proxyId1, int32 proxyId2)
 
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	int32 slot = FindSlot(proxyId1, proxyId2);
+	b2Assert(m_pairs[slot].proxyId1 != b2_nullProxy);
 
-	uint16* node = &m_hashTable[hash];
-	while (*node != b2_nullPair)
+	void* userData = m_pairs[slot].userData;
+
+	// Shift the following entries back so probing never sees a hole.
+	int32 mask = m_pairCapacity - 1;
+	int32 hole = slot;
+	int32 i = (slot + 1) & mask;
+	while (m_pairs[i].proxyId1 != b2_nullProxy)
 	{
-		if (Equals(m_pairs[*node], proxyId1, proxyId2))
+		int32 home = Hash(m_pairs[i].proxyId1, m_pairs[i].proxyId2) & mask;
+		if (((i - home) & mask) >= ((i - hole) & mask))
 		{
-			uint16 index = *node;
-			*node = m_pairs[*node].next;
-			
-			b2Pair* pair = m_pairs + index;
-			void* userData = pair->userData;
-
-			// Scrub
-			pair->next = m_freePair;
-			pair->proxyId1 = b2_nullProxy;
-			pair->proxyId2 = b2_nullProxy;
-			pair->userData = NULL;
-			pair->status = 0;
-
-			m_freePair = index;
-			--m_pairCount;
-			return userData;
-		}
-		else
-		{
-			node = &m_pairs[*node].next;
+			m_pairs[hole] = m_pairs[i];
+			hole = i;
 		}
+		i = (i + 1) & mask;
 	}
 
-	b2Assert(false);
-	return NULL;
+	// Scrub
+	m_pairs[hole].proxyId1 = b2_nullProxy;
+	m_pairs[hole].proxyId2 = b2_nullProxy;
+	m_pairs[hole].userData = NULL;
+	m_pairs[hole].status = 0;
+
+	--m_pairCount;
+	return userData;
 }
 
 /*
@@ -210,7 +269,6 @@ If the added pair is not a new pair, then it must be in the pair buffer (because
 void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 {
 	b2Assert(id1 != b2_nullProxy && id2 != b2_nullProxy);
-	b2Assert(m_pairBufferCount < b2_maxPairs);
 
 	b2Pair* pair = AddPair(id1, id2);
 
@@ -221,6 +279,11 @@ void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 		b2Assert(pair->IsFinal() == false);
 
 		// Add it to the pair buffer.
+		if (m_pairBufferCount == m_pairBufferCapacity)
+		{
+			GrowBuffer();
+		}
+
 		pair->SetBuffered();
 		m_pairBuffer[m_pairBufferCount].proxyId1 = pair->proxyId1;
 		m_pairBuffer[m_pairBufferCount].proxyId2 = pair->proxyId2;
@@ -242,7 +305,6 @@ void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 void b2PairManager::RemoveBufferedPair(int32 id1, int32 id2)
 {
 	b2Assert(id1 != b2_nullProxy && id2 != b2_nullProxy);
-	b2Assert(m_pairBufferCount < b2_maxPairs);
 
 	b2Pair* pair = Find(id1, id2);
 
@@ -258,6 +320,11 @@ void b2PairManager::RemoveBufferedPair(int32 id1, int32 id2)
 		// This must be an old pair.
 		b2Assert(pair->IsFinal() == true);
 
+		if (m_pairBufferCount == m_pairBufferCapacity)
+		{
+			GrowBuffer();
+		}
+
 		pair->SetBuffered();
 		m_pairBuffer[m_pairBufferCount].proxyId1 = pair->proxyId1;
 		m_pairBuffer[m_pairBufferCount].proxyId2 = pair->proxyId2;
@@ -274,11 +341,88 @@ void b2PairManager::RemoveBufferedPair(int32 id1, int32 id2)
 	}
 }
 
+// Sort the buffered pairs by proxy ids. This makes the order of the pair callbacks,
+// and so of contact creation, independent of the order the pairs were found in, and
+// it visits the proxies in memory order. Keys are unique so stability doesn't matter,
+// but the radix passes are stable anyway.
+void b2PairManager::SortBuffer()
+{
+	int32 count = m_pairBufferCount;
+
+	if (count < b2_radixSortThreshold)
+	{
+		for (int32 i = 1; i < count; ++i)
+		{
+			b2BufferedPair pair = m_pairBuffer[i];
+			uint32 key = SortKey(pair);
+			int32 j = i;
+			while (j > 0 && SortKey(m_pairBuffer[j - 1]) > key)
+			{
+				m_pairBuffer[j] = m_pairBuffer[j - 1];
+				--j;
+			}
+			m_pairBuffer[j] = pair;
+		}
+		return;
+	}
+
+	// Least significant digit radix sort, one byte per pass. All four histograms
+	// are built in a single sweep.
+	int32 histograms[4][256];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		uint32 key = SortKey(m_pairBuffer[i]);
+		++histograms[0][key & 0xFF];
+		++histograms[1][(key >> 8) & 0xFF];
+		++histograms[2][(key >> 16) & 0xFF];
+		++histograms[3][key >> 24];
+	}
+
+	b2BufferedPair* source = m_pairBuffer;
+	b2BufferedPair* target = m_sortBuffer;
+
+	for (int32 pass = 0; pass < 4; ++pass)
+	{
+		int32* histogram = histograms[pass];
+		int32 shift = 8 * pass;
+
+		// Proxy ids are small, so the high bytes are often all the same.
+		uint32 digit = (SortKey(source[0]) >> shift) & 0xFF;
+		if (histogram[digit] == count)
+		{
+			continue;
+		}
+
+		int32 offset = 0;
+		for (int32 i = 0; i < 256; ++i)
+		{
+			int32 n = histogram[i];
+			histogram[i] = offset;
+			offset += n;
+		}
+
+		for (int32 i = 0; i < count; ++i)
+		{
+			uint32 d = (SortKey(source[i]) >> shift) & 0xFF;
+			target[histogram[d]++] = source[i];
+		}
+
+		b2Swap(source, target);
+	}
+
+	if (source != m_pairBuffer)
+	{
+		memcpy(m_pairBuffer, source, count * sizeof(b2BufferedPair));
+	}
+}
+
 void b2PairManager::Commit()
 {
 	int32 removeCount = 0;
 
-	b2Proxy* proxies = m_broadPhase->m_proxyPool;
+	SortBuffer();
 
 	for (int32 i = 0; i < m_pairBufferCount; ++i)
 	{
@@ -286,13 +430,8 @@ void b2PairManager::Commit()
 		b2Assert(pair->IsBuffered());
 		pair->ClearBuffered();
 
-		b2Assert(pair->proxyId1 < b2_maxProxies && pair->proxyId2 < b2_maxProxies);
-
-		b2Proxy* proxy1 = proxies + pair->proxyId1;
-		b2Proxy* proxy2 = proxies + pair->proxyId2;
-
-		b2Assert(proxy1->IsValid());
-		b2Assert(proxy2->IsValid());
+		void* userData1 = m_broadPhase->GetUserData(pair->proxyId1);
+		void* userData2 = m_broadPhase->GetUserData(pair->proxyId2);
 
 		if (pair->IsRemoved())
 		{
@@ -301,7 +440,12 @@ void b2PairManager::Commit()
 			// the user didn't receive a matching add.
 			if (pair->IsFinal() == true)
 			{
-				m_callback->PairRemoved(proxy1->userData, proxy2->userData, pair->userData);
+				m_callback->PairRemoved(userData1, userData2, pair->userData);
+				++m_removedCount;
+			}
+			else
+			{
+				++m_cancelledCount;
 			}
 
 			// Store the ids so we can actually remove the pair below.
@@ -311,16 +455,18 @@ void b2PairManager::Commit()
 		}
 		else
 		{
-			b2Assert(m_broadPhase->TestOverlap(proxy1, proxy2) == true);
+			b2Assert(m_broadPhase->TestOverlap(pair->proxyId1, pair->proxyId2) == true);
 
 			if (pair->IsFinal() == false)
 			{
-				pair->userData = m_callback->PairAdded(proxy1->userData, proxy2->userData);
+				pair->userData = m_callback->PairAdded(userData1, userData2);
 				pair->SetFinal();
+				++m_addedCount;
 			}
 		}
 	}
 
+	// Removing shifts other pairs in the table, so it waits until the callbacks are done.
 	for (int32 i = 0; i < removeCount; ++i)
 	{
 		RemovePair(m_pairBuffer[i].proxyId1, m_pairBuffer[i].proxyId2);
@@ -352,14 +498,8 @@ void b2PairManager::ValidateBuffer()
 		b2Assert(pair->IsBuffered());
 
 		b2Assert(pair->proxyId1 != pair->proxyId2);
-		b2Assert(pair->proxyId1 < b2_maxProxies);
-		b2Assert(pair->proxyId2 < b2_maxProxies);
-
-		b2Proxy* proxy1 = m_broadPhase->m_proxyPool + pair->proxyId1;
-		b2Proxy* proxy2 = m_broadPhase->m_proxyPool + pair->proxyId2;
-
-		b2Assert(proxy1->IsValid() == true);
-		b2Assert(proxy2->IsValid() == true);
+		b2Assert(m_broadPhase->IsProxyValid(pair->proxyId1) == true);
+		b2Assert(m_broadPhase->IsProxyValid(pair->proxyId2) == true);
 	}
 #endif
 }
@@ -367,30 +507,33 @@ void b2PairManager::ValidateBuffer()
 void b2PairManager::ValidateTable()
 {
 #ifdef _DEBUG
-	for (int32 i = 0; i < b2_tableCapacity; ++i)
+	b2Assert(2 * m_pairCount <= m_pairCapacity);
+
+	int32 count = 0;
+	for (int32 i = 0; i < m_pairCapacity; ++i)
 	{
-		uint16 index = m_hashTable[i];
-		while (index != b2_nullPair)
+		b2Pair* pair = m_pairs + i;
+		if (pair->proxyId1 == b2_nullProxy)
 		{
-			b2Pair* pair = m_pairs + index;
-			b2Assert(pair->IsBuffered() == false);
-			b2Assert(pair->IsFinal() == true);
-			b2Assert(pair->IsRemoved() == false);
+			continue;
+		}
 
-			b2Assert(pair->proxyId1 != pair->proxyId2);
-			b2Assert(pair->proxyId1 < b2_maxProxies);
-			b2Assert(pair->proxyId2 < b2_maxProxies);
+		++count;
 
-			b2Proxy* proxy1 = m_broadPhase->m_proxyPool + pair->proxyId1;
-			b2Proxy* proxy2 = m_broadPhase->m_proxyPool + pair->proxyId2;
+		// The pair must be reachable from its home slot.
+		b2Assert(FindSlot(pair->proxyId1, pair->proxyId2) == i);
 
-			b2Assert(proxy1->IsValid() == true);
-			b2Assert(proxy2->IsValid() == true);
+		b2Assert(pair->IsBuffered() == false);
+		b2Assert(pair->IsFinal() == true);
+		b2Assert(pair->IsRemoved() == false);
 
-			b2Assert(m_broadPhase->TestOverlap(proxy1, proxy2) == true);
+		b2Assert(pair->proxyId1 < pair->proxyId2);
+		b2Assert(m_broadPhase->IsProxyValid(pair->proxyId1) == true);
+		b2Assert(m_broadPhase->IsProxyValid(pair->proxyId2) == true);
 
-			index = pair->next;
-		}
+		b2Assert(m_broadPhase->TestOverlap(pair->proxyId1, pair->proxyId2) == true);
 	}
+
+	b2Assert(count == m_pairCount);
 #endif
 }
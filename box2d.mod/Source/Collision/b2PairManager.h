@@ -31,10 +31,7 @@
 class b2BroadPhase;
 struct b2Proxy;
 
-const uint16 b2_nullPair = USHRT_MAX;
 const uint16 b2_nullProxy = USHRT_MAX;
-const int32 b2_tableCapacity = b2_maxPairs;	// must be a power of two
-const int32 b2_tableMask = b2_tableCapacity - 1;
 
 struct b2Pair
 {
@@ -57,9 +54,8 @@ struct b2Pair
 	bool IsFinal()		{ return (status & e_pairFinal) == e_pairFinal; }
 
 	void* userData;
-	uint16 proxyId1;
+	uint16 proxyId1;	// b2_nullProxy marks an empty slot
 	uint16 proxyId2;
-	uint16 next;
 	uint16 status;
 };
 
@@ -87,6 +83,7 @@ class b2PairManager
 {
 public:
 	b2PairManager();
+	~b2PairManager();
 
 	void Initialize(b2BroadPhase* broadPhase, b2PairCallback* callback);
 
@@ -95,27 +92,46 @@ public:
 
 	void Commit();
 
+	// Zero the churn counters.
+	void ResetCounters();
+
+	// Is there a pair between these proxies?
+	bool HasPair(int32 proxyId1, int32 proxyId2) const;
+
 private:
+	int32 FindSlot(int32 proxyId1, int32 proxyId2) const;
 	b2Pair* Find(int32 proxyId1, int32 proxyId2);
-	b2Pair* Find(int32 proxyId1, int32 proxyId2, uint32 hashValue);
 
 	b2Pair* AddPair(int32 proxyId1, int32 proxyId2);
 	void* RemovePair(int32 proxyId1, int32 proxyId2);
 
+	void GrowTable();
+	void GrowBuffer();
+	void SortBuffer();
+
 	void ValidateBuffer();
 	void ValidateTable();
 
 public:
 	b2BroadPhase *m_broadPhase;
 	b2PairCallback *m_callback;
-	b2Pair m_pairs[b2_maxPairs];
-	uint16 m_freePair;
+
+	// Pairs live directly in an open addressing table with linear probing.
+	// The capacity is a power of two and the load is kept at or below one half.
+	b2Pair* m_pairs;
+	int32 m_pairCapacity;
 	int32 m_pairCount;
 
-	b2BufferedPair m_pairBuffer[b2_maxPairs];
+	b2BufferedPair* m_pairBuffer;
+	b2BufferedPair* m_sortBuffer;
+	int32 m_pairBufferCapacity;
 	int32 m_pairBufferCount;
 
-	uint16 m_hashTable[b2_tableCapacity];
+	// Pair churn since the last ResetCounters. Cancelled pairs were added and
+	// removed between two commits, so the callback never saw them.
+	int32 m_addedCount;
+	int32 m_removedCount;
+	int32 m_cancelledCount;
 };
 
 #endif
@@ -0,0 +1,853 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2SpatialHash.h"
+
+#include <cstring>
+
+// Notes:
+// - a proxy is put in every cell its AABB touches, so a query only has to look
+//   at the cells its own AABB touches.
+// - cells are hashed into buckets, so the grid is unbounded in memory and only
+//   cells that hold proxies cost anything.
+// - a proxy seen in several cells is reported from the first cell it shares with
+//   the query, which avoids time stamps and keeps queries read-only.
+// - moving a proxy only touches the cells it enters or leaves, and only tests the
+//   proxies near its old and new bounds for pair changes.
+
+const int32 b2_gridInitialProxies = 256;
+const int32 b2_gridInitialEntries = 1024;
+const int32 b2_gridInitialBuckets = 1024;
+const int32 b2_gridInitialLargeProxies = 16;
+
+static inline bool b2IsLargeRange(const b2CellRange& range)
+{
+	int32 width = range.upperX - range.lowerX + 1;
+	int32 height = range.upperY - range.lowerY + 1;
+	return width > b2_gridLargeProxyCells / height;
+}
+
+static inline bool b2RangeContains(const b2CellRange& range, int32 x, int32 y)
+{
+	return range.lowerX <= x && x <= range.upperX && range.lowerY <= y && y <= range.upperY;
+}
+
+static inline bool b2RangeEquals(const b2CellRange& a, const b2CellRange& b)
+{
+	return a.lowerX == b.lowerX && a.lowerY == b.lowerY && a.upperX == b.upperX && a.upperY == b.upperY;
+}
+
+// Clip the segment p + t * d to a box, narrowing [lower, upper]. Returns false
+// if the segment misses the box.
+static bool b2ClipSegment(const b2Vec2& p, const b2Vec2& d, const b2AABB& aabb, float32* lower, float32* upper)
+{
+	float32 tmin = *lower;
+	float32 tmax = *upper;
+
+	float32 ps[2] = {p.x, p.y};
+	float32 ds[2] = {d.x, d.y};
+	float32 lows[2] = {aabb.lowerBound.x, aabb.lowerBound.y};
+	float32 highs[2] = {aabb.upperBound.x, aabb.upperBound.y};
+
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		if (b2Abs(ds[axis]) < B2_FLT_EPSILON)
+		{
+			if (ps[axis] < lows[axis] || highs[axis] < ps[axis])
+			{
+				return false;
+			}
+		}
+		else
+		{
+			float32 inv = 1.0f / ds[axis];
+			float32 t1 = (lows[axis] - ps[axis]) * inv;
+			float32 t2 = (highs[axis] - ps[axis]) * inv;
+			if (t1 > t2)
+			{
+				b2Swap(t1, t2);
+			}
+
+			tmin = b2Max(tmin, t1);
+			tmax = b2Min(tmax, t2);
+			if (tmin > tmax)
+			{
+				return false;
+			}
+		}
+	}
+
+	*lower = tmin;
+	*upper = tmax;
+	return true;
+}
+
+b2SpatialHash::b2SpatialHash(const b2AABB& worldAABB, float32 cellSize, b2PairManager* pairManager)
+{
+	b2Assert(worldAABB.IsValid());
+	b2Assert(cellSize > 0.0f);
+
+	m_pairManager = pairManager;
+
+	m_worldAABB = worldAABB;
+	m_cellSize = cellSize;
+	m_invCellSize = 1.0f / cellSize;
+
+	b2Vec2 d = worldAABB.upperBound - worldAABB.lowerBound;
+	m_cellCountX = (int32)(d.x * m_invCellSize) + 1;
+	m_cellCountY = (int32)(d.y * m_invCellSize) + 1;
+
+	m_proxyCapacity = b2_gridInitialProxies;
+	m_proxyCount = 0;
+	m_proxies = (b2GridProxy*)b2Alloc(m_proxyCapacity * sizeof(b2GridProxy));
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		m_proxies[i].userData = NULL;
+		m_proxies[i].flags = 0;
+		m_proxies[i].next = (uint16)(i + 1);
+	}
+	m_proxies[m_proxyCapacity - 1].next = b2_nullProxy;
+	m_freeProxy = 0;
+
+	m_entryCapacity = b2_gridInitialEntries;
+	m_entryCount = 0;
+	m_entries = (b2GridEntry*)b2Alloc(m_entryCapacity * sizeof(b2GridEntry));
+	for (int32 i = 0; i < m_entryCapacity; ++i)
+	{
+		m_entries[i].proxyId = b2_nullProxy;
+		m_entries[i].next = i + 1;
+	}
+	m_entries[m_entryCapacity - 1].next = -1;
+	m_freeEntry = 0;
+
+	m_bucketCount = b2_gridInitialBuckets;
+	m_buckets = (int32*)b2Alloc(m_bucketCount * sizeof(int32));
+	for (int32 i = 0; i < m_bucketCount; ++i)
+	{
+		m_buckets[i] = -1;
+	}
+
+	m_largeCapacity = b2_gridInitialLargeProxies;
+	m_largeCount = 0;
+	m_largeProxies = (uint16*)b2Alloc(m_largeCapacity * sizeof(uint16));
+
+	m_candidates = (uint16*)b2Alloc(m_proxyCapacity * sizeof(uint16));
+}
+
+b2SpatialHash::~b2SpatialHash()
+{
+	b2Free(m_proxies);
+	b2Free(m_entries);
+	b2Free(m_buckets);
+	b2Free(m_largeProxies);
+	b2Free(m_candidates);
+}
+
+void b2SpatialHash::ComputeRange(b2CellRange* range, const b2AABB& aabb) const
+{
+	b2Assert(aabb.upperBound.x >= aabb.lowerBound.x);
+	b2Assert(aabb.upperBound.y >= aabb.lowerBound.y);
+
+	b2Vec2 lower = b2Clamp(aabb.lowerBound, m_worldAABB.lowerBound, m_worldAABB.upperBound) - m_worldAABB.lowerBound;
+	b2Vec2 upper = b2Clamp(aabb.upperBound, m_worldAABB.lowerBound, m_worldAABB.upperBound) - m_worldAABB.lowerBound;
+
+	// The values are not negative, so truncation rounds down.
+	range->lowerX = b2Min((int32)(m_invCellSize * lower.x), m_cellCountX - 1);
+	range->lowerY = b2Min((int32)(m_invCellSize * lower.y), m_cellCountY - 1);
+	range->upperX = b2Min((int32)(m_invCellSize * upper.x), m_cellCountX - 1);
+	range->upperY = b2Min((int32)(m_invCellSize * upper.y), m_cellCountY - 1);
+}
+
+uint32 b2SpatialHash::HashCell(int32 x, int32 y) const
+{
+	uint32 h = ((uint32)x * 73856093u) ^ ((uint32)y * 19349663u);
+	h ^= h >> 16;
+	return h & (m_bucketCount - 1);
+}
+
+void b2SpatialHash::GrowProxies()
+{
+	b2Assert(m_proxyCapacity < b2_nullProxy);
+
+	int32 oldCapacity = m_proxyCapacity;
+	m_proxyCapacity = b2Min(2 * oldCapacity, (int32)b2_nullProxy);
+
+	b2GridProxy* proxies = (b2GridProxy*)b2Alloc(m_proxyCapacity * sizeof(b2GridProxy));
+	memcpy(proxies, m_proxies, oldCapacity * sizeof(b2GridProxy));
+	b2Free(m_proxies);
+	m_proxies = proxies;
+
+	for (int32 i = oldCapacity; i < m_proxyCapacity; ++i)
+	{
+		m_proxies[i].userData = NULL;
+		m_proxies[i].flags = 0;
+		m_proxies[i].next = (uint16)(i + 1);
+	}
+	m_proxies[m_proxyCapacity - 1].next = m_freeProxy;
+	m_freeProxy = (uint16)oldCapacity;
+
+	b2Free(m_candidates);
+	m_candidates = (uint16*)b2Alloc(m_proxyCapacity * sizeof(uint16));
+}
+
+void b2SpatialHash::GrowEntries()
+{
+	int32 oldCapacity = m_entryCapacity;
+	m_entryCapacity = 2 * oldCapacity;
+
+	b2GridEntry* entries = (b2GridEntry*)b2Alloc(m_entryCapacity * sizeof(b2GridEntry));
+	memcpy(entries, m_entries, oldCapacity * sizeof(b2GridEntry));
+	b2Free(m_entries);
+	m_entries = entries;
+
+	for (int32 i = oldCapacity; i < m_entryCapacity; ++i)
+	{
+		m_entries[i].proxyId = b2_nullProxy;
+		m_entries[i].next = i + 1;
+	}
+	m_entries[m_entryCapacity - 1].next = m_freeEntry;
+	m_freeEntry = oldCapacity;
+}
+
+void b2SpatialHash::GrowBuckets()
+{
+	b2Free(m_buckets);
+	m_bucketCount *= 2;
+	m_buckets = (int32*)b2Alloc(m_bucketCount * sizeof(int32));
+	for (int32 i = 0; i < m_bucketCount; ++i)
+	{
+		m_buckets[i] = -1;
+	}
+
+	// Entries keep their cell, so the lists can be rebuilt in place.
+	for (int32 i = 0; i < m_entryCapacity; ++i)
+	{
+		b2GridEntry* entry = m_entries + i;
+		if (entry->proxyId == b2_nullProxy)
+		{
+			continue;
+		}
+
+		uint32 bucket = HashCell(entry->x, entry->y);
+		entry->next = m_buckets[bucket];
+		m_buckets[bucket] = i;
+	}
+}
+
+void b2SpatialHash::InsertCell(int32 x, int32 y, uint16 proxyId)
+{
+	if (m_freeEntry == -1)
+	{
+		GrowEntries();
+	}
+
+	// Keep about one entry per bucket.
+	if (m_entryCount == m_bucketCount)
+	{
+		GrowBuckets();
+	}
+
+	int32 index = m_freeEntry;
+	b2GridEntry* entry = m_entries + index;
+	m_freeEntry = entry->next;
+
+	uint32 bucket = HashCell(x, y);
+	entry->x = x;
+	entry->y = y;
+	entry->proxyId = proxyId;
+	entry->next = m_buckets[bucket];
+	m_buckets[bucket] = index;
+
+	++m_entryCount;
+}
+
+void b2SpatialHash::RemoveCell(int32 x, int32 y, uint16 proxyId)
+{
+	int32* node = m_buckets + HashCell(x, y);
+	while (*node != -1)
+	{
+		b2GridEntry* entry = m_entries + *node;
+		if (entry->proxyId == proxyId && entry->x == x && entry->y == y)
+		{
+			int32 index = *node;
+			*node = entry->next;
+
+			entry->proxyId = b2_nullProxy;
+			entry->next = m_freeEntry;
+			m_freeEntry = index;
+
+			--m_entryCount;
+			return;
+		}
+
+		node = &entry->next;
+	}
+
+	b2Assert(false);
+}
+
+void b2SpatialHash::InsertProxy(uint16 proxyId)
+{
+	b2GridProxy* proxy = m_proxies + proxyId;
+	const b2CellRange& range = proxy->range;
+
+	if (b2IsLargeRange(range))
+	{
+		if (m_largeCount == m_largeCapacity)
+		{
+			m_largeCapacity *= 2;
+			uint16* largeProxies = (uint16*)b2Alloc(m_largeCapacity * sizeof(uint16));
+			memcpy(largeProxies, m_largeProxies, m_largeCount * sizeof(uint16));
+			b2Free(m_largeProxies);
+			m_largeProxies = largeProxies;
+		}
+
+		proxy->flags |= b2GridProxy::e_largeFlag;
+		m_largeProxies[m_largeCount++] = proxyId;
+		return;
+	}
+
+	for (int32 y = range.lowerY; y <= range.upperY; ++y)
+	{
+		for (int32 x = range.lowerX; x <= range.upperX; ++x)
+		{
+			InsertCell(x, y, proxyId);
+		}
+	}
+}
+
+void b2SpatialHash::RemoveProxy(uint16 proxyId)
+{
+	b2GridProxy* proxy = m_proxies + proxyId;
+	const b2CellRange& range = proxy->range;
+
+	if (proxy->IsLarge())
+	{
+		for (int32 i = 0; i < m_largeCount; ++i)
+		{
+			if (m_largeProxies[i] == proxyId)
+			{
+				m_largeProxies[i] = m_largeProxies[--m_largeCount];
+				break;
+			}
+		}
+
+		proxy->flags &= ~b2GridProxy::e_largeFlag;
+		return;
+	}
+
+	for (int32 y = range.lowerY; y <= range.upperY; ++y)
+	{
+		for (int32 x = range.lowerX; x <= range.upperX; ++x)
+		{
+			RemoveCell(x, y, proxyId);
+		}
+	}
+}
+
+inline void b2SpatialHash::Report(int32 count, uint16 proxyId, uint16* proxyIds, void** userData) const
+{
+	if (proxyIds)
+	{
+		proxyIds[count] = proxyId;
+	}
+	else
+	{
+		userData[count] = m_proxies[proxyId].userData;
+	}
+}
+
+int32 b2SpatialHash::Collect(const b2CellRange& range, const b2AABB& aabb, uint16* proxyIds, void** userData, int32 maxCount) const
+{
+	int32 count = 0;
+
+	int32 width = range.upperX - range.lowerX + 1;
+	int32 height = range.upperY - range.lowerY + 1;
+
+	// Scanning the proxies is cheaper than visiting more cells than there are proxies.
+	if (width > m_proxyCount / height)
+	{
+		for (int32 i = 0; i < m_proxyCapacity && count < maxCount; ++i)
+		{
+			const b2GridProxy* proxy = m_proxies + i;
+			if (proxy->IsValid() && b2TestOverlap(proxy->aabb, aabb))
+			{
+				Report(count++, (uint16)i, proxyIds, userData);
+			}
+		}
+
+		return count;
+	}
+
+	for (int32 y = range.lowerY; y <= range.upperY; ++y)
+	{
+		for (int32 x = range.lowerX; x <= range.upperX; ++x)
+		{
+			for (int32 index = m_buckets[HashCell(x, y)]; index != -1; index = m_entries[index].next)
+			{
+				const b2GridEntry* entry = m_entries + index;
+				if (entry->x != x || entry->y != y)
+				{
+					continue;
+				}
+
+				// Report the proxy from the first cell it shares with the range.
+				const b2GridProxy* proxy = m_proxies + entry->proxyId;
+				if (x != b2Max(range.lowerX, proxy->range.lowerX) || y != b2Max(range.lowerY, proxy->range.lowerY))
+				{
+					continue;
+				}
+
+				if (b2TestOverlap(proxy->aabb, aabb))
+				{
+					if (count == maxCount)
+					{
+						return count;
+					}
+
+					Report(count++, entry->proxyId, proxyIds, userData);
+				}
+			}
+		}
+	}
+
+	for (int32 i = 0; i < m_largeCount && count < maxCount; ++i)
+	{
+		const b2GridProxy* proxy = m_proxies + m_largeProxies[i];
+		if (b2TestOverlap(proxy->aabb, aabb))
+		{
+			Report(count++, m_largeProxies[i], proxyIds, userData);
+		}
+	}
+
+	return count;
+}
+
+uint16 b2SpatialHash::CreateProxy(const b2AABB& aabb, void* userData)
+{
+	if (m_freeProxy == b2_nullProxy)
+	{
+		GrowProxies();
+	}
+
+	uint16 proxyId = m_freeProxy;
+	b2GridProxy* proxy = m_proxies + proxyId;
+	m_freeProxy = proxy->next;
+
+	proxy->aabb = aabb;
+	proxy->userData = userData;
+	proxy->flags = b2GridProxy::e_validFlag;
+	proxy->next = b2_nullProxy;
+	ComputeRange(&proxy->range, aabb);
+
+	++m_proxyCount;
+
+	InsertProxy(proxyId);
+
+	int32 count = Collect(proxy->range, aabb, m_candidates, NULL, m_proxyCount);
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (m_candidates[i] != proxyId)
+		{
+			m_pairManager->AddBufferedPair(proxyId, m_candidates[i]);
+		}
+	}
+
+	m_pairManager->Commit();
+
+	if (b2BroadPhase::s_validate)
+	{
+		Validate();
+	}
+
+	return proxyId;
+}
+
+void b2SpatialHash::DestroyProxy(int32 proxyId)
+{
+	b2Assert(IsProxyValid(proxyId));
+	b2GridProxy* proxy = m_proxies + proxyId;
+
+	int32 count = Collect(proxy->range, proxy->aabb, m_candidates, NULL, m_proxyCount);
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (m_candidates[i] != proxyId)
+		{
+			m_pairManager->RemoveBufferedPair(proxyId, m_candidates[i]);
+		}
+	}
+
+	m_pairManager->Commit();
+
+	RemoveProxy((uint16)proxyId);
+
+	// Return the proxy to the pool.
+	proxy->userData = NULL;
+	proxy->flags = 0;
+	proxy->next = m_freeProxy;
+	m_freeProxy = (uint16)proxyId;
+	--m_proxyCount;
+
+	if (b2BroadPhase::s_validate)
+	{
+		Validate();
+	}
+}
+
+void b2SpatialHash::MoveProxy(int32 proxyId, const b2AABB& aabb)
+{
+	if (IsProxyValid(proxyId) == false)
+	{
+		b2Assert(false);
+		return;
+	}
+
+	if (aabb.IsValid() == false)
+	{
+		b2Assert(false);
+		return;
+	}
+
+	b2GridProxy* proxy = m_proxies + proxyId;
+
+	b2AABB oldAABB = proxy->aabb;
+	b2CellRange oldRange = proxy->range;
+
+	b2CellRange newRange;
+	ComputeRange(&newRange, aabb);
+
+	proxy->aabb = aabb;
+
+	bool wasLarge = proxy->IsLarge();
+	bool isLarge = b2IsLargeRange(newRange);
+
+	if (wasLarge != isLarge)
+	{
+		RemoveProxy((uint16)proxyId);
+		proxy->range = newRange;
+		InsertProxy((uint16)proxyId);
+	}
+	else if (isLarge)
+	{
+		proxy->range = newRange;
+	}
+	else if (b2RangeEquals(oldRange, newRange) == false)
+	{
+		// Only touch the cells that were left or entered.
+		for (int32 y = oldRange.lowerY; y <= oldRange.upperY; ++y)
+		{
+			for (int32 x = oldRange.lowerX; x <= oldRange.upperX; ++x)
+			{
+				if (b2RangeContains(newRange, x, y) == false)
+				{
+					RemoveCell(x, y, (uint16)proxyId);
+				}
+			}
+		}
+
+		for (int32 y = newRange.lowerY; y <= newRange.upperY; ++y)
+		{
+			for (int32 x = newRange.lowerX; x <= newRange.upperX; ++x)
+			{
+				if (b2RangeContains(oldRange, x, y) == false)
+				{
+					InsertCell(x, y, (uint16)proxyId);
+				}
+			}
+		}
+
+		proxy->range = newRange;
+	}
+
+	// Pairs can only change with proxies near the old or the new bounds.
+	b2CellRange range;
+	range.lowerX = b2Min(oldRange.lowerX, newRange.lowerX);
+	range.lowerY = b2Min(oldRange.lowerY, newRange.lowerY);
+	range.upperX = b2Max(oldRange.upperX, newRange.upperX);
+	range.upperY = b2Max(oldRange.upperY, newRange.upperY);
+
+	b2AABB bounds;
+	bounds.lowerBound = b2Min(oldAABB.lowerBound, aabb.lowerBound);
+	bounds.upperBound = b2Max(oldAABB.upperBound, aabb.upperBound);
+
+	int32 count = Collect(range, bounds, m_candidates, NULL, m_proxyCount);
+	for (int32 i = 0; i < count; ++i)
+	{
+		uint16 otherId = m_candidates[i];
+		if (otherId == proxyId)
+		{
+			continue;
+		}
+
+		const b2AABB& other = m_proxies[otherId].aabb;
+		bool before = b2TestOverlap(oldAABB, other);
+		bool after = b2TestOverlap(aabb, other);
+
+		if (after && before == false)
+		{
+			m_pairManager->AddBufferedPair(proxyId, otherId);
+		}
+		else if (before && after == false)
+		{
+			m_pairManager->RemoveBufferedPair(proxyId, otherId);
+		}
+	}
+
+	if (b2BroadPhase::s_validate)
+	{
+		Validate();
+	}
+}
+
+int32 b2SpatialHash::Query(const b2AABB& aabb, void** userData, int32 maxCount) const
+{
+	b2CellRange range;
+	ComputeRange(&range, aabb);
+
+	// Results go straight into the caller's buffer, which keeps the query reentrant.
+	return Collect(range, aabb, NULL, userData, maxCount);
+}
+
+// This walks the cells along the segment in order, like a line rasterizer. A proxy
+// is tested in the first cell of the walk that it covers.
+int32 b2SpatialHash::QuerySegment(const b2Segment& segment, void** userData, int32 maxCount, SortKeyFunc sortKey, void* context) const
+{
+	b2Vec2 p1 = segment.p1;
+	b2Vec2 d = segment.p2 - segment.p1;
+
+	float32 t0 = 0.0f;
+	float32 t1 = 1.0f;
+	if (b2ClipSegment(p1, d, m_worldAABB, &t0, &t1) == false)
+	{
+		return 0;
+	}
+
+	// Results go straight into the caller's buffer, which keeps the query reentrant.
+	b2QueryResults query(userData, b2Min(maxCount, m_proxyCount), sortKey, context);
+
+	// Large proxies are not in the cells.
+	for (int32 i = 0; i < m_largeCount && query.IsFull() == false; ++i)
+	{
+		const b2GridProxy* proxy = m_proxies + m_largeProxies[i];
+		float32 lower = 0.0f, upper = 1.0f;
+		if (b2ClipSegment(p1, d, proxy->aabb, &lower, &upper))
+		{
+			query.Add(proxy->userData);
+		}
+	}
+
+	b2Vec2 start = p1 + t0 * d - m_worldAABB.lowerBound;
+	int32 x = b2Clamp((int32)(m_invCellSize * start.x), 0, m_cellCountX - 1);
+	int32 y = b2Clamp((int32)(m_invCellSize * start.y), 0, m_cellCountY - 1);
+
+	int32 stepX = d.x > 0.0f ? 1 : (d.x < 0.0f ? -1 : 0);
+	int32 stepY = d.y > 0.0f ? 1 : (d.y < 0.0f ? -1 : 0);
+
+	// The segment parameter at the next vertical and horizontal cell boundaries.
+	float32 tMaxX = B2_FLT_MAX, tDeltaX = B2_FLT_MAX;
+	if (stepX != 0)
+	{
+		float32 boundary = m_worldAABB.lowerBound.x + m_cellSize * (stepX > 0 ? x + 1 : x);
+		tMaxX = (boundary - p1.x) / d.x;
+		tDeltaX = m_cellSize / b2Abs(d.x);
+	}
+
+	float32 tMaxY = B2_FLT_MAX, tDeltaY = B2_FLT_MAX;
+	if (stepY != 0)
+	{
+		float32 boundary = m_worldAABB.lowerBound.y + m_cellSize * (stepY > 0 ? y + 1 : y);
+		tMaxY = (boundary - p1.y) / d.y;
+		tDeltaY = m_cellSize / b2Abs(d.y);
+	}
+
+	float32 tEnter = t0;
+	int32 prevX = -1, prevY = -1;
+	bool first = true;
+
+	while (query.IsFull() == false)
+	{
+		// Sort keys are no less than where the segment enters the proxy, so nothing
+		// further along can beat a full result list.
+		if (sortKey && query.count == query.maxCount && query.count > 0 && tEnter > query.sortKeys[query.count - 1])
+		{
+			break;
+		}
+
+		for (int32 index = m_buckets[HashCell(x, y)]; index != -1; index = m_entries[index].next)
+		{
+			const b2GridEntry* entry = m_entries + index;
+			if (entry->x != x || entry->y != y)
+			{
+				continue;
+			}
+
+			// Only test the proxy in the first cell of the walk that it covers.
+			const b2GridProxy* proxy = m_proxies + entry->proxyId;
+			if (first == false && b2RangeContains(proxy->range, prevX, prevY))
+			{
+				continue;
+			}
+
+			float32 lower = 0.0f, upper = 1.0f;
+			if (b2ClipSegment(p1, d, proxy->aabb, &lower, &upper))
+			{
+				query.Add(proxy->userData);
+			}
+		}
+
+		prevX = x;
+		prevY = y;
+		first = false;
+
+		if (tMaxX < tMaxY)
+		{
+			if (tMaxX > t1)
+			{
+				break;
+			}
+
+			tEnter = tMaxX;
+			tMaxX += tDeltaX;
+			x += stepX;
+			if (x < 0 || x >= m_cellCountX)
+			{
+				break;
+			}
+		}
+		else
+		{
+			if (tMaxY > t1)
+			{
+				break;
+			}
+
+			tEnter = tMaxY;
+			tMaxY += tDeltaY;
+			y += stepY;
+			if (y < 0 || y >= m_cellCountY)
+			{
+				break;
+			}
+		}
+	}
+
+	return query.count;
+}
+
+void b2SpatialHash::CopyQueryState(const b2SpatialHash* other)
+{
+	m_worldAABB = other->m_worldAABB;
+	m_cellSize = other->m_cellSize;
+	m_invCellSize = other->m_invCellSize;
+	m_cellCountX = other->m_cellCountX;
+	m_cellCountY = other->m_cellCountY;
+
+	if (m_proxyCapacity != other->m_proxyCapacity)
+	{
+		b2Free(m_proxies);
+		b2Free(m_candidates);
+		m_proxyCapacity = other->m_proxyCapacity;
+		m_proxies = (b2GridProxy*)b2Alloc(m_proxyCapacity * sizeof(b2GridProxy));
+		m_candidates = (uint16*)b2Alloc(m_proxyCapacity * sizeof(uint16));
+	}
+	memcpy(m_proxies, other->m_proxies, m_proxyCapacity * sizeof(b2GridProxy));
+	m_proxyCount = other->m_proxyCount;
+	m_freeProxy = other->m_freeProxy;
+
+	if (m_entryCapacity != other->m_entryCapacity)
+	{
+		b2Free(m_entries);
+		m_entryCapacity = other->m_entryCapacity;
+		m_entries = (b2GridEntry*)b2Alloc(m_entryCapacity * sizeof(b2GridEntry));
+	}
+	memcpy(m_entries, other->m_entries, m_entryCapacity * sizeof(b2GridEntry));
+	m_entryCount = other->m_entryCount;
+	m_freeEntry = other->m_freeEntry;
+
+	if (m_bucketCount != other->m_bucketCount)
+	{
+		b2Free(m_buckets);
+		m_bucketCount = other->m_bucketCount;
+		m_buckets = (int32*)b2Alloc(m_bucketCount * sizeof(int32));
+	}
+	memcpy(m_buckets, other->m_buckets, m_bucketCount * sizeof(int32));
+
+	if (m_largeCapacity != other->m_largeCapacity)
+	{
+		b2Free(m_largeProxies);
+		m_largeCapacity = other->m_largeCapacity;
+		m_largeProxies = (uint16*)b2Alloc(m_largeCapacity * sizeof(uint16));
+	}
+	m_largeCount = other->m_largeCount;
+	memcpy(m_largeProxies, other->m_largeProxies, m_largeCount * sizeof(uint16));
+}
+
+void b2SpatialHash::Validate() const
+{
+#ifdef _DEBUG
+	int32 proxyCount = 0;
+	int32 entryCount = 0;
+	int32 largeCount = 0;
+
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		const b2GridProxy* proxy = m_proxies + i;
+		if (proxy->IsValid() == false)
+		{
+			continue;
+		}
+
+		++proxyCount;
+
+		b2CellRange range;
+		ComputeRange(&range, proxy->aabb);
+		b2Assert(b2RangeEquals(range, proxy->range));
+		b2Assert(proxy->IsLarge() == b2IsLargeRange(range));
+
+		if (proxy->IsLarge())
+		{
+			++largeCount;
+			continue;
+		}
+
+		for (int32 y = range.lowerY; y <= range.upperY; ++y)
+		{
+			for (int32 x = range.lowerX; x <= range.upperX; ++x)
+			{
+				bool found = false;
+				for (int32 index = m_buckets[HashCell(x, y)]; index != -1; index = m_entries[index].next)
+				{
+					const b2GridEntry* entry = m_entries + index;
+					if (entry->proxyId == i && entry->x == x && entry->y == y)
+					{
+						found = true;
+						break;
+					}
+				}
+
+				b2Assert(found);
+				++entryCount;
+			}
+		}
+	}
+
+	b2Assert(proxyCount == m_proxyCount);
+	b2Assert(entryCount == m_entryCount);
+	b2Assert(largeCount == m_largeCount);
+#endif
+}
@@ -0,0 +1,182 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SPATIAL_HASH_H
+#define B2_SPATIAL_HASH_H
+
+/*
+This broad phase hashes proxies into a uniform grid of square cells. Unlike sweep
+and prune its cost does not depend on how the bounds interleave, so it suits scenes
+made of many shapes of about the same size, such as debris or granular material.
+*/
+
+#include "b2BroadPhase.h"
+
+// Proxies that cover more cells than this are kept in a separate list that
+// every query tests, instead of being put in each cell.
+const int32 b2_gridLargeProxyCells = 64;
+
+struct b2CellRange
+{
+	int32 lowerX, lowerY;
+	int32 upperX, upperY;
+};
+
+struct b2GridProxy
+{
+	enum
+	{
+		e_validFlag	= 0x0001,
+		e_largeFlag	= 0x0002,
+	};
+
+	bool IsValid() const { return (flags & e_validFlag) == e_validFlag; }
+	bool IsLarge() const { return (flags & e_largeFlag) == e_largeFlag; }
+
+	b2AABB aabb;
+	b2CellRange range;
+	void* userData;
+	uint16 next;
+	uint16 flags;
+};
+
+// A proxy in a cell. Entries of cells that hash to the same bucket share a list.
+struct b2GridEntry
+{
+	int32 x, y;
+	int32 next;
+	uint16 proxyId;
+};
+
+class b2SpatialHash
+{
+public:
+	b2SpatialHash(const b2AABB& worldAABB, float32 cellSize, b2PairManager* pairManager);
+	~b2SpatialHash();
+
+	// These have the same contract as the b2BroadPhase functions, except that
+	// the number of proxies is only limited by the 16-bit proxy ids.
+	uint16 CreateProxy(const b2AABB& aabb, void* userData);
+	void DestroyProxy(int32 proxyId);
+
+	// Only the cells the proxy enters or leaves are updated.
+	void MoveProxy(int32 proxyId, const b2AABB& aabb);
+
+	int32 Query(const b2AABB& aabb, void** userData, int32 maxCount) const;
+	int32 QuerySegment(const b2Segment& segment, void** userData, int32 maxCount, SortKeyFunc sortKey, void* context) const;
+
+	void CopyQueryState(const b2SpatialHash* other);
+
+	bool IsProxyValid(int32 proxyId) const;
+	void* GetUserData(int32 proxyId) const;
+	void SetUserData(int32 proxyId, void* userData);
+	const b2AABB& GetAABB(int32 proxyId) const;
+
+	int32 GetProxyCount() const;
+	int32 GetProxyCapacity() const;
+	float32 GetCellSize() const;
+
+	void Validate() const;
+
+private:
+	void ComputeRange(b2CellRange* range, const b2AABB& aabb) const;
+	uint32 HashCell(int32 x, int32 y) const;
+
+	void InsertCell(int32 x, int32 y, uint16 proxyId);
+	void RemoveCell(int32 x, int32 y, uint16 proxyId);
+	void InsertProxy(uint16 proxyId);
+	void RemoveProxy(uint16 proxyId);
+
+	// Gather the proxies whose cells touch the range and whose AABB overlaps
+	// the given AABB. Each proxy is reported once, as its id in proxyIds or,
+	// when proxyIds is NULL, as its user data in userData.
+	int32 Collect(const b2CellRange& range, const b2AABB& aabb, uint16* proxyIds, void** userData, int32 maxCount) const;
+	void Report(int32 count, uint16 proxyId, uint16* proxyIds, void** userData) const;
+
+	void GrowProxies();
+	void GrowEntries();
+	void GrowBuckets();
+
+	b2PairManager* m_pairManager;
+
+	b2AABB m_worldAABB;
+	float32 m_cellSize;
+	float32 m_invCellSize;
+	int32 m_cellCountX;
+	int32 m_cellCountY;
+
+	b2GridProxy* m_proxies;
+	int32 m_proxyCapacity;
+	int32 m_proxyCount;
+	uint16 m_freeProxy;
+
+	b2GridEntry* m_entries;
+	int32 m_entryCapacity;
+	int32 m_entryCount;
+	int32 m_freeEntry;
+
+	int32* m_buckets;
+	int32 m_bucketCount;
+
+	uint16* m_largeProxies;
+	int32 m_largeCount;
+	int32 m_largeCapacity;
+
+	// Scratch space for pair updates, large enough for every proxy.
+	uint16* m_candidates;
+};
+
+inline bool b2SpatialHash::IsProxyValid(int32 proxyId) const
+{
+	return 0 <= proxyId && proxyId < m_proxyCapacity && m_proxies[proxyId].IsValid();
+}
+
+inline void* b2SpatialHash::GetUserData(int32 proxyId) const
+{
+	b2Assert(IsProxyValid(proxyId));
+	return m_proxies[proxyId].userData;
+}
+
+inline void b2SpatialHash::SetUserData(int32 proxyId, void* userData)
+{
+	b2Assert(IsProxyValid(proxyId));
+	m_proxies[proxyId].userData = userData;
+}
+
+inline const b2AABB& b2SpatialHash::GetAABB(int32 proxyId) const
+{
+	b2Assert(IsProxyValid(proxyId));
+	return m_proxies[proxyId].aabb;
+}
+
+inline int32 b2SpatialHash::GetProxyCount() const
+{
+	return m_proxyCount;
+}
+
+inline int32 b2SpatialHash::GetProxyCapacity() const
+{
+	return m_proxyCapacity;
+}
+
+inline float32 b2SpatialHash::GetCellSize() const
+{
+	return m_cellSize;
+}
+
+#endif
@@ -18,6 +18,106 @@
 
 #include "b2Collision.h"
 #include "Shapes/b2Shape.h"
+#include "Shapes/b2MeshShape.h"
+#include "Shapes/b2TileGridShape.h"
+#include "Shapes/b2PolygonShape.h"
+#include "Shapes/b2EdgeShape.h"
+
+int32 g_TOI_Iterations = 0;
+
+const int32 b2_meshTOICandidates = 64;
+
+// The TOI against a mesh or heightfield is the earliest TOI against the edges
+// near the swept shape.
+static float32 b2TimeOfImpactMesh(const b2Shape* shape, const b2Sweep& sweep,
+								  const b2Shape* mesh, const b2Sweep& meshSweep)
+{
+	// Bound the shape's motion relative to the mesh.
+	b2XForm xf1, xf2, meshXF1, meshXF2;
+	sweep.GetXForm(&xf1, sweep.t0);
+	sweep.GetXForm(&xf2, 1.0f);
+	meshSweep.GetXForm(&meshXF1, meshSweep.t0);
+	meshSweep.GetXForm(&meshXF2, 1.0f);
+
+	b2XForm rel1, rel2;
+	rel1.R = b2MulT(meshXF1.R, xf1.R);
+	rel1.position = b2MulT(meshXF1, xf1.position);
+	rel2.R = b2MulT(meshXF2.R, xf2.R);
+	rel2.position = b2MulT(meshXF2, xf2.position);
+
+	b2AABB aabb;
+	shape->ComputeSweptAABB(&aabb, rel1, rel2);
+
+	int32 buffer[b2_meshTOICandidates];
+	int32* candidates = buffer;
+	int32 count = b2QueryEdges(mesh, aabb, candidates, b2_meshTOICandidates);
+	if (count > b2_meshTOICandidates)
+	{
+		candidates = (int32*)b2Alloc(count * sizeof(int32));
+		b2QueryEdges(mesh, aabb, candidates, count);
+	}
+
+	float32 toi = 1.0f;
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2EdgeShape* edge = b2GetEdge(mesh, candidates[i]);
+		toi = b2Min(toi, b2TimeOfImpact(shape, sweep, edge, meshSweep));
+	}
+
+	if (candidates != buffer)
+	{
+		b2Free(candidates);
+	}
+
+	return toi;
+}
+
+// The TOI against a tile grid is the earliest TOI against the tiles under the swept shape.
+static float32 b2TimeOfImpactTileGrid(const b2Shape* shape, const b2Sweep& sweep,
+									  const b2TileGridShape* grid, const b2Sweep& gridSweep)
+{
+	// Bound the shape's motion relative to the grid.
+	b2XForm xf1, xf2, gridXF1, gridXF2;
+	sweep.GetXForm(&xf1, sweep.t0);
+	sweep.GetXForm(&xf2, 1.0f);
+	gridSweep.GetXForm(&gridXF1, gridSweep.t0);
+	gridSweep.GetXForm(&gridXF2, 1.0f);
+
+	b2XForm rel1, rel2;
+	rel1.R = b2MulT(gridXF1.R, xf1.R);
+	rel1.position = b2MulT(gridXF1, xf1.position);
+	rel2.R = b2MulT(gridXF2.R, xf2.R);
+	rel2.position = b2MulT(gridXF2, xf2.position);
+
+	b2AABB aabb;
+	shape->ComputeSweptAABB(&aabb, rel1, rel2);
+
+	float32 toi = 1.0f;
+	int32 lowerX, lowerY, upperX, upperY;
+	if (grid->GetCellRange(aabb, &lowerX, &lowerY, &upperX, &upperY) == false)
+	{
+		return toi;
+	}
+
+	for (int32 y = lowerY; y <= upperY; ++y)
+	{
+		for (int32 x = lowerX; x <= upperX; ++x)
+		{
+			const b2PolygonShape* polygon = grid->GetTilePolygon(grid->GetTile(x, y));
+			if (polygon == NULL)
+			{
+				continue;
+			}
+
+			// Shifting the local center moves the tile polygon into its cell.
+			b2Sweep cellSweep = gridSweep;
+			cellSweep.localCenter -= grid->GetCellOffset(x, y);
+			toi = b2Min(toi, b2TimeOfImpact(shape, sweep, polygon, cellSweep));
+		}
+	}
+
+	return toi;
+}
 
 // This algorithm uses conservative advancement to compute the time of
 // impact (TOI) of two shapes.
@@ -25,6 +125,26 @@
 float32 b2TimeOfImpact(const b2Shape* shape1, const b2Sweep& sweep1,
 					   const b2Shape* shape2, const b2Sweep& sweep2)
 {
+	if (shape2->GetType() == e_meshShape || shape2->GetType() == e_heightfieldShape)
+	{
+		return b2TimeOfImpactMesh(shape1, sweep1, shape2, sweep2);
+	}
+
+	if (shape1->GetType() == e_meshShape || shape1->GetType() == e_heightfieldShape)
+	{
+		return b2TimeOfImpactMesh(shape2, sweep2, shape1, sweep1);
+	}
+
+	if (shape2->GetType() == e_tileGridShape)
+	{
+		return b2TimeOfImpactTileGrid(shape1, sweep1, (const b2TileGridShape*)shape2, sweep2);
+	}
+
+	if (shape1->GetType() == e_tileGridShape)
+	{
+		return b2TimeOfImpactTileGrid(shape2, sweep2, (const b2TileGridShape*)shape1, sweep1);
+	}
+
 	float32 r1 = shape1->GetSweepRadius();
 	float32 r2 = shape2->GetSweepRadius();
 
@@ -108,5 +228,6 @@ float32 b2TimeOfImpact(const b2Shape* shape1, const b2Sweep& sweep1,
 		++iter;
 	}
 
+	g_TOI_Iterations = iter;
 	return alpha;
 }
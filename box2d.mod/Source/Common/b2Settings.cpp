@@ -19,17 +19,40 @@
 #include "b2Settings.h"
 #include <cstdlib>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 b2Version b2_version = {2, 0, 2};
 
 int32 b2_byteCount = 0;
+int32 b2_allocCount = 0;
 
+// The counters are shared by worlds stepping on other threads.
+static inline void b2AddByteCount(int32 size)
+{
+#if defined(_MSC_VER)
+	_InterlockedExchangeAdd((long volatile*)&b2_byteCount, size);
+#else
+	__sync_fetch_and_add(&b2_byteCount, size);
+#endif
+}
 
+static inline void b2AddAllocCount()
+{
+#if defined(_MSC_VER)
+	_InterlockedIncrement((long volatile*)&b2_allocCount);
+#else
+	__sync_fetch_and_add(&b2_allocCount, 1);
+#endif
+}
 
 // Memory allocators. Modify these to use your own allocator.
 void* b2Alloc(int32 size)
 {
 	size += 4;
-	b2_byteCount += size;
+	b2AddByteCount(size);
+	b2AddAllocCount();
 	char* bytes = (char*)malloc(size);
 	*(int32*)bytes = size;
 	return bytes + 4;
@@ -46,6 +69,6 @@ void b2Free(void* mem)
 	bytes -= 4;
 	int32 size = *(int32*)bytes;
 	b2Assert(b2_byteCount >= size);
-	b2_byteCount -= size;
+	b2AddByteCount(-size);
 	free(bytes);
 }
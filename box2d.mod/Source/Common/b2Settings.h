@@ -72,8 +72,10 @@ const float32 b2_pi = 3.14159265359f;
 // Collision
 const int32 b2_maxManifoldPoints = 2;
 const int32 b2_maxPolygonVertices = 8;
-const int32 b2_maxProxies = 512;				// this must be a power of two
-const int32 b2_maxPairs = 8 * b2_maxProxies;	// this must be a power of two
+#ifndef B2_MAX_PROXIES
+#define B2_MAX_PROXIES 512
+#endif
+const int32 b2_maxProxies = B2_MAX_PROXIES;	// this must be a power of two, at most 16384
 
 // Dynamics
 
@@ -129,6 +131,15 @@ const float32 b2_maxAngularVelocitySquared = b2_maxAngularVelocity * b2_maxAngul
 /// to overshoot.
 const float32 b2_contactBaumgarte = 0.2f;
 
+/// The minimum number of velocity iterations run before an island may stop early
+/// (see b2World::SetVelocityTolerance). Stacks converge slowly, so a single small
+/// iteration doesn't mean the island is solved.
+const int32 b2_minVelocityIterations = 4;
+
+/// How quickly the step budget governor follows changes in measured solver cost.
+/// Each new measurement moves the estimate this fraction of the way.
+const float32 b2_budgetSmoothing = 0.2f;
+
 // Sleep
 
 /// The time that a body must be still before it will go to sleep.
@@ -145,6 +156,10 @@ const float32 b2_angularSleepTolerance = 2.0f / 180.0f;		// 2 degrees/s
 /// The current number of bytes allocated through b2Alloc.
 extern int32 b2_byteCount;
 
+/// The number of calls to b2Alloc since startup. Benchmarks read the change
+/// across a step to count allocations.
+extern int32 b2_allocCount;
+
 /// Implement this function to use your own memory allocator.
 void* b2Alloc(int32 size);
 
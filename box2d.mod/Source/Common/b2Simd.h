@@ -0,0 +1,118 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_SIMD_H
+#define B2_SIMD_H
+
+#include "b2Math.h"
+
+// Define B2_NO_SIMD to build the scalar searches on any target, for example to
+// compare them with benchmark/kernels.cpp.
+#if !defined(TARGET_FLOAT32_IS_FIXED) && !defined(B2_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define B2_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+// Polygon point arrays searched by the SIMD kernels hold a whole number of 4 wide
+// lanes. The entries past the vertex count are copies of the first point.
+const int32 b2_polygonLaneCount = (b2_maxPolygonVertices + 3) & ~3;
+
+// Copy the first point into the padding after count.
+inline void b2PadPolygonLanes(b2Vec2* points, int32 count)
+{
+	b2Assert(0 < count && count <= b2_polygonLaneCount);
+	for (int32 i = count; i < b2_polygonLaneCount; ++i)
+	{
+		points[i] = points[0];
+	}
+}
+
+#ifdef B2_SIMD_SSE2
+// The dot products of four points with d, splitting the x and y of the points.
+inline __m128 b2Dot4(const b2Vec2* points, __m128 dx, __m128 dy)
+{
+	__m128 a = _mm_loadu_ps(&points[0].x);
+	__m128 b = _mm_loadu_ps(&points[2].x);
+	__m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+	return _mm_add_ps(_mm_mul_ps(x, dx), _mm_mul_ps(y, dy));
+}
+#endif
+
+// Find the first index with the largest dot product of the point and d. The points
+// must be padded with b2PadPolygonLanes. This matches a scalar search with a strict
+// comparison, so the result does not depend on the path. The SIMD version tracks the
+// best value and index per lane without branching, then reduces the lanes, taking
+// the lowest index among equal values.
+inline int32 b2FindMaxDot(const b2Vec2* points, int32 count, const b2Vec2& d)
+{
+#if defined(B2_SIMD_SSE2)
+	__m128 dx = _mm_set1_ps(d.x);
+	__m128 dy = _mm_set1_ps(d.y);
+	__m128 laneIndex = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+
+	__m128 value = b2Dot4(points, dx, dy);
+	__m128 index = laneIndex;
+
+	int32 blockCount = (count + 3) >> 2;
+	for (int32 i = 1; i < blockCount; ++i)
+	{
+		__m128 v = b2Dot4(points + 4 * i, dx, dy);
+		__m128 greater = _mm_cmpgt_ps(v, value);
+		value = _mm_max_ps(value, v);
+		__m128 blockIndex = _mm_add_ps(laneIndex, _mm_set1_ps(4.0f * i));
+		index = _mm_or_ps(_mm_and_ps(greater, blockIndex), _mm_andnot_ps(greater, index));
+	}
+
+	// Broadcast the largest value.
+	__m128 best = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+	best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	// Take the lowest index holding it.
+	__m128 equal = _mm_cmpeq_ps(value, best);
+	index = _mm_or_ps(_mm_and_ps(equal, index), _mm_andnot_ps(equal, _mm_set1_ps((float32)b2_polygonLaneCount)));
+	index = _mm_min_ps(index, _mm_shuffle_ps(index, index, _MM_SHUFFLE(1, 0, 3, 2)));
+	index = _mm_min_ps(index, _mm_shuffle_ps(index, index, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (int32)_mm_cvtss_f32(index);
+#else
+	int32 bestIndex = 0;
+	float32 bestValue = b2Dot(points[0], d);
+	for (int32 i = 1; i < count; ++i)
+	{
+		float32 value = b2Dot(points[i], d);
+		if (value > bestValue)
+		{
+			bestIndex = i;
+			bestValue = value;
+		}
+	}
+	return bestIndex;
+#endif
+}
+
+// Find the first index with the smallest dot product of the point and d.
+inline int32 b2FindMinDot(const b2Vec2* points, int32 count, const b2Vec2& d)
+{
+	// Negating d negates every product exactly.
+	return b2FindMaxDot(points, count, -d);
+}
+
+#endif
@@ -0,0 +1,138 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2Thread.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+// The b2Thread whose function the calling thread is running, if any.
+#if defined(_MSC_VER)
+static __declspec(thread) b2Thread* s_current = NULL;
+#else
+static __thread b2Thread* s_current = NULL;
+#endif
+
+b2Thread::b2Thread()
+{
+#if defined(_WIN32)
+	m_handle = NULL;
+#endif
+	m_fcn = NULL;
+	m_arg = NULL;
+	m_running = false;
+	m_started = false;
+}
+
+void b2Thread::Execute()
+{
+	b2Thread* previous = s_current;
+	s_current = this;
+	m_fcn(m_arg);
+	s_current = previous;
+}
+
+#if defined(_WIN32)
+
+unsigned long __stdcall b2Thread::Run(void* thread)
+{
+	((b2Thread*)thread)->Execute();
+	return 0;
+}
+
+void b2Thread::Start(Function fcn, void* arg)
+{
+	b2Assert(m_running == false);
+	m_fcn = fcn;
+	m_arg = arg;
+	m_running = true;
+
+	m_handle = CreateThread(NULL, 0, &b2Thread::Run, this, 0, NULL);
+	m_started = m_handle != NULL;
+	if (m_started == false)
+	{
+		// Fall back to running on the caller.
+		Execute();
+	}
+}
+
+void b2Thread::Join()
+{
+	if (m_running == false)
+	{
+		return;
+	}
+
+	if (m_started)
+	{
+		WaitForSingleObject(m_handle, INFINITE);
+		CloseHandle(m_handle);
+		m_handle = NULL;
+	}
+
+	m_running = false;
+}
+
+#else
+
+void* b2Thread::Run(void* thread)
+{
+	((b2Thread*)thread)->Execute();
+	return NULL;
+}
+
+void b2Thread::Start(Function fcn, void* arg)
+{
+	b2Assert(m_running == false);
+	m_fcn = fcn;
+	m_arg = arg;
+	m_running = true;
+
+	m_started = pthread_create(&m_thread, NULL, &b2Thread::Run, this) == 0;
+	if (m_started == false)
+	{
+		// Fall back to running on the caller.
+		Execute();
+	}
+}
+
+void b2Thread::Join()
+{
+	if (m_running == false)
+	{
+		return;
+	}
+
+	if (m_started)
+	{
+		pthread_join(m_thread, NULL);
+	}
+
+	m_running = false;
+}
+
+#endif
+
+bool b2Thread::IsCurrent() const
+{
+	return s_current == this;
+}
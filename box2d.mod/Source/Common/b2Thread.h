@@ -0,0 +1,67 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_THREAD_H
+#define B2_THREAD_H
+
+#include "b2Settings.h"
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+/// A minimal worker thread. This has platform specific code and may
+/// not work on every platform.
+class b2Thread
+{
+public:
+	typedef void (*Function)(void* arg);
+
+	b2Thread();
+
+	/// Run fcn(arg) on a new thread. The previous run must have been joined.
+	void Start(Function fcn, void* arg);
+
+	/// Wait for the thread to finish. If the thread could not be created,
+	/// Start ran the function on the caller and this returns immediately.
+	void Join();
+
+	/// Is the caller running the function passed to Start?
+	bool IsCurrent() const;
+
+private:
+
+	void Execute();
+
+#if defined(_WIN32)
+	static unsigned long __stdcall Run(void* thread);
+
+	void* m_handle;
+#else
+	static void* Run(void* thread);
+
+	pthread_t m_thread;
+#endif
+
+	Function m_fcn;
+	void* m_arg;
+	bool m_running;
+	bool m_started;
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2Timer.h"
+
+#if defined(_WIN32)
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+double b2Timer::s_invFrequency = 0.0;
+
+b2Timer::b2Timer()
+{
+	if (s_invFrequency == 0.0)
+	{
+		LARGE_INTEGER largeInteger;
+		QueryPerformanceFrequency(&largeInteger);
+		s_invFrequency = double(largeInteger.QuadPart);
+		if (s_invFrequency > 0.0)
+		{
+			s_invFrequency = 1000.0 / s_invFrequency;
+		}
+	}
+
+	m_start = 0.0;
+}
+
+void b2Timer::Reset()
+{
+	LARGE_INTEGER largeInteger;
+	QueryPerformanceCounter(&largeInteger);
+	m_start = double(largeInteger.QuadPart);
+}
+
+float32 b2Timer::GetMilliseconds() const
+{
+	LARGE_INTEGER largeInteger;
+	QueryPerformanceCounter(&largeInteger);
+	double count = double(largeInteger.QuadPart);
+	return float32(s_invFrequency * (count - m_start));
+}
+
+#else
+
+#include <time.h>
+
+b2Timer::b2Timer()
+{
+	m_start_sec = 0;
+	m_start_nsec = 0;
+}
+
+void b2Timer::Reset()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	m_start_sec = t.tv_sec;
+	m_start_nsec = t.tv_nsec;
+}
+
+float32 b2Timer::GetMilliseconds() const
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	double ms = 1000.0 * (double(t.tv_sec) - double(m_start_sec)) + 0.000001 * (double(t.tv_nsec) - double(m_start_nsec));
+	return float32(ms);
+}
+
+#endif
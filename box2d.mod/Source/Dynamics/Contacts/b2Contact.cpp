@@ -22,6 +22,8 @@
 #include "b2PolyContact.h"
 #include "b2EdgeAndCircleContact.h"
 #include "b2PolyAndEdgeContact.h"
+#include "b2MeshContact.h"
+#include "b2TileGridContact.h"
 #include "b2ContactSolver.h"
 #include "../../Collision/b2Collision.h"
 #include "../../Collision/Shapes/b2Shape.h"
@@ -40,6 +42,14 @@ void b2Contact::InitializeRegisters()
 	
 	AddType(b2EdgeAndCircleContact::Create, b2EdgeAndCircleContact::Destroy, e_edgeShape, e_circleShape);
 	AddType(b2PolyAndEdgeContact::Create, b2PolyAndEdgeContact::Destroy, e_polygonShape, e_edgeShape);
+
+	AddType(b2MeshContact::Create, b2MeshContact::Destroy, e_polygonShape, e_meshShape);
+	AddType(b2MeshContact::Create, b2MeshContact::Destroy, e_meshShape, e_circleShape);
+	AddType(b2MeshContact::Create, b2MeshContact::Destroy, e_polygonShape, e_heightfieldShape);
+	AddType(b2MeshContact::Create, b2MeshContact::Destroy, e_heightfieldShape, e_circleShape);
+
+	AddType(b2TileGridContact::Create, b2TileGridContact::Destroy, e_tileGridShape, e_polygonShape);
+	AddType(b2TileGridContact::Create, b2TileGridContact::Destroy, e_tileGridShape, e_circleShape);
 }
 
 void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
@@ -144,6 +154,10 @@ b2Contact::b2Contact(b2Shape* s1, b2Shape* s2)
 	m_node2.prev = NULL;
 	m_node2.next = NULL;
 	m_node2.other = NULL;
+
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
 }
 
 void b2Contact::Update(b2ContactListener* listener)
@@ -163,6 +177,19 @@ void b2Contact::Update(b2ContactListener* listener)
 		body2->WakeUp();
 	}
 
+	// Keep the island graph in sync with the touching state.
+	if ((m_flags & e_nonSolidFlag) == 0)
+	{
+		if (newCount > 0 && m_island == NULL)
+		{
+			body1->GetWorld()->m_islandManager.LinkContact(this);
+		}
+		else if (newCount == 0 && m_island != NULL)
+		{
+			body1->GetWorld()->m_islandManager.UnlinkContact(this);
+		}
+	}
+
 	// Slow contacts don't generate TOI events.
 	if (body1->IsStatic() || body1->IsBullet() || body2->IsStatic() || body2->IsBullet())
 	{
@@ -22,6 +22,7 @@
 #include "../../Common/b2Math.h"
 #include "../../Collision/b2Collision.h"
 #include "../../Collision/Shapes/b2Shape.h"
+#include "../b2IslandManager.h"
 
 class b2Body;
 class b2Contact;
@@ -125,7 +126,7 @@ public:
 	static b2Contact* Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
 
-	b2Contact() : m_shape1(NULL), m_shape2(NULL) {}
+	b2Contact() : m_shape1(NULL), m_shape2(NULL), m_index(-1), m_island(NULL), m_islandPrev(NULL), m_islandNext(NULL) {}
 	b2Contact(b2Shape* shape1, b2Shape* shape2);
 	virtual ~b2Contact() {}
 
@@ -134,9 +135,18 @@ public:
 	static b2ContactRegister s_registers[e_shapeTypeCount][e_shapeTypeCount];
 	static bool s_initialized;
 
+	// Hot data: read by Collide and SolveTOI every step.
 	uint32 m_flags;
 	int32 m_manifoldCount;
 
+	b2Shape* m_shape1;
+	b2Shape* m_shape2;
+
+	float32 m_toi;
+
+	// Index in the contact manager's dense contact array.
+	int32 m_index;
+
 	// World pool and list pointers.
 	b2Contact* m_prev;
 	b2Contact* m_next;
@@ -145,10 +155,10 @@ public:
 	b2ContactEdge m_node1;
 	b2ContactEdge m_node2;
 
-	b2Shape* m_shape1;
-	b2Shape* m_shape2;
-
-	float32 m_toi;
+	// Persistent island list pointers. Only touching solid contacts are linked.
+	b2PersistentIsland* m_island;
+	b2Contact* m_islandPrev;
+	b2Contact* m_islandNext;
 };
 
 inline int32 b2Contact::GetManifoldCount() const
@@ -37,7 +37,7 @@ public:
 	~b2EdgeAndCircleContact() {}
 
 	void Evaluate(b2ContactListener* listener);
-	void b2CollideEdgeAndCircle(b2Manifold* manifold,
+	static void b2CollideEdgeAndCircle(b2Manifold* manifold,
 									  const b2EdgeShape* edge, const b2XForm& xf1,
 									  const b2CircleShape* circle, const b2XForm& xf2);
 	b2Manifold* GetManifolds()
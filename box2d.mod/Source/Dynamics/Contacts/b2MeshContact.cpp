@@ -0,0 +1,279 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2MeshContact.h"
+#include "b2PolyAndEdgeContact.h"
+#include "b2EdgeAndCircleContact.h"
+#include "../b2Body.h"
+#include "../b2WorldCallbacks.h"
+#include "../../Common/b2BlockAllocator.h"
+#include "../../Collision/Shapes/b2MeshShape.h"
+
+#include <new>
+#include <cstring>
+
+const int32 b2_meshContactCapacity = 4;
+
+b2Contact* b2MeshContact::Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator)
+{
+	void* mem = allocator->Allocate(sizeof(b2MeshContact));
+	return new (mem) b2MeshContact(shape1, shape2);
+}
+
+void b2MeshContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+{
+	((b2MeshContact*)contact)->~b2MeshContact();
+	allocator->Free(contact, sizeof(b2MeshContact));
+}
+
+b2MeshContact::b2MeshContact(b2Shape* s1, b2Shape* s2)
+: b2Contact(s1, s2)
+{
+	b2Assert((m_shape1->GetType() == e_polygonShape &&
+			(m_shape2->GetType() == e_meshShape || m_shape2->GetType() == e_heightfieldShape)) ||
+			((m_shape1->GetType() == e_meshShape || m_shape1->GetType() == e_heightfieldShape) &&
+			m_shape2->GetType() == e_circleShape));
+
+	m_manifolds = NULL;
+	m_edges = NULL;
+	m_manifolds0 = NULL;
+	m_edges0 = NULL;
+	m_candidates = NULL;
+	m_capacity = 0;
+	Reserve(b2_meshContactCapacity);
+}
+
+b2MeshContact::~b2MeshContact()
+{
+	b2Free(m_manifolds);
+	b2Free(m_edges);
+	b2Free(m_manifolds0);
+	b2Free(m_edges0);
+	b2Free(m_candidates);
+}
+
+// Grow the buffers, keeping the current and previous manifolds.
+void b2MeshContact::Reserve(int32 capacity)
+{
+	if (capacity <= m_capacity)
+	{
+		return;
+	}
+
+	b2Manifold* manifolds = (b2Manifold*)b2Alloc(capacity * sizeof(b2Manifold));
+	int32* edges = (int32*)b2Alloc(capacity * sizeof(int32));
+	b2Manifold* manifolds0 = (b2Manifold*)b2Alloc(capacity * sizeof(b2Manifold));
+	int32* edges0 = (int32*)b2Alloc(capacity * sizeof(int32));
+	int32* candidates = (int32*)b2Alloc(capacity * sizeof(int32));
+
+	if (m_capacity > 0)
+	{
+		memcpy(manifolds, m_manifolds, m_capacity * sizeof(b2Manifold));
+		memcpy(edges, m_edges, m_capacity * sizeof(int32));
+		memcpy(manifolds0, m_manifolds0, m_capacity * sizeof(b2Manifold));
+		memcpy(edges0, m_edges0, m_capacity * sizeof(int32));
+		b2Free(m_manifolds);
+		b2Free(m_edges);
+		b2Free(m_manifolds0);
+		b2Free(m_edges0);
+		b2Free(m_candidates);
+	}
+
+	m_manifolds = manifolds;
+	m_edges = edges;
+	m_manifolds0 = manifolds0;
+	m_edges0 = edges0;
+	m_candidates = candidates;
+	m_capacity = capacity;
+}
+
+void b2MeshContact::Evaluate(b2ContactListener* listener)
+{
+	b2Body* b1 = m_shape1->GetBody();
+	b2Body* b2 = m_shape2->GetBody();
+	const b2XForm& xf1 = b1->GetXForm();
+	const b2XForm& xf2 = b2->GetXForm();
+
+	bool circle = m_shape2->GetType() == e_circleShape;
+	const b2Shape* mesh = circle ? m_shape1 : m_shape2;
+	const b2Shape* other = circle ? m_shape2 : m_shape1;
+	const b2XForm& meshXF = circle ? xf1 : xf2;
+	const b2XForm& otherXF = circle ? xf2 : xf1;
+
+	// Keep the old manifolds for warm starting.
+	int32 manifoldCount0 = m_manifoldCount;
+	b2Manifold* tmpManifolds = m_manifolds;
+	m_manifolds = m_manifolds0;
+	m_manifolds0 = tmpManifolds;
+	int32* tmpEdges = m_edges;
+	m_edges = m_edges0;
+	m_edges0 = tmpEdges;
+
+	// Find the edges near the other shape in the mesh frame.
+	b2XForm relXF;
+	relXF.R = b2MulT(meshXF.R, otherXF.R);
+	relXF.position = b2MulT(meshXF, otherXF.position);
+	b2AABB aabb;
+	other->ComputeAABB(&aabb, relXF);
+
+	int32 candidateCount = b2QueryEdges(mesh, aabb, m_candidates, m_capacity);
+	if (candidateCount > m_capacity)
+	{
+		Reserve(2 * candidateCount);
+		b2QueryEdges(mesh, aabb, m_candidates, m_capacity);
+	}
+
+	// Collide each candidate edge.
+	m_manifoldCount = 0;
+	for (int32 i = 0; i < candidateCount; ++i)
+	{
+		int32 edgeIndex = m_candidates[i];
+		const b2EdgeShape* edge = b2GetEdge(mesh, edgeIndex);
+		b2Manifold* manifold = m_manifolds + m_manifoldCount;
+
+		if (circle)
+		{
+			b2EdgeAndCircleContact::b2CollideEdgeAndCircle(manifold, edge, xf1, (const b2CircleShape*)other, xf2);
+		}
+		else
+		{
+			b2PolyAndEdgeContact::b2CollidePolyAndEdge(manifold, (const b2PolygonShape*)other, xf1, edge, xf2);
+		}
+
+		if (manifold->pointCount > 0)
+		{
+			m_edges[m_manifoldCount] = edgeIndex;
+			++m_manifoldCount;
+		}
+	}
+
+	b2ContactPoint cp;
+	cp.shape1 = m_shape1;
+	cp.shape2 = m_shape2;
+	cp.friction = b2MixFriction(m_shape1->GetFriction(), m_shape2->GetFriction());
+	cp.restitution = b2MixRestitution(m_shape1->GetRestitution(), m_shape2->GetRestitution());
+
+	// Match contact ids on the same edge to warm start the solver.
+	for (int32 i = 0; i < m_manifoldCount; ++i)
+	{
+		b2Manifold* manifold = m_manifolds + i;
+
+		b2Manifold* m0 = NULL;
+		for (int32 j = 0; j < manifoldCount0; ++j)
+		{
+			if (m_edges0[j] == m_edges[i])
+			{
+				m0 = m_manifolds0 + j;
+				m_edges0[j] = -1;
+				break;
+			}
+		}
+
+		bool persisted[b2_maxManifoldPoints] = {false, false};
+
+		for (int32 k = 0; k < manifold->pointCount; ++k)
+		{
+			b2ManifoldPoint* mp = manifold->points + k;
+			mp->normalImpulse = 0.0f;
+			mp->tangentImpulse = 0.0f;
+			bool found = false;
+
+			for (int32 j = 0; m0 != NULL && j < m0->pointCount; ++j)
+			{
+				b2ManifoldPoint* mp0 = m0->points + j;
+				if (persisted[j] == false && mp0->id.key == mp->id.key)
+				{
+					persisted[j] = true;
+					mp->normalImpulse = mp0->normalImpulse;
+					mp->tangentImpulse = mp0->tangentImpulse;
+					found = true;
+					break;
+				}
+			}
+
+			if (listener != NULL)
+			{
+				cp.position = b1->GetWorldPoint(mp->localPoint1);
+				b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp->localPoint1);
+				b2Vec2 v2 = b2->GetLinearVelocityFromLocalPoint(mp->localPoint2);
+				cp.velocity = v2 - v1;
+				cp.normal = manifold->normal;
+				cp.separation = mp->separation;
+				cp.id = mp->id;
+				if (found)
+				{
+					listener->Persist(&cp);
+				}
+				else
+				{
+					listener->Add(&cp);
+				}
+			}
+		}
+
+		if (m0 != NULL && listener != NULL)
+		{
+			ReportRemoved(listener, m0, persisted);
+		}
+	}
+
+	if (listener == NULL)
+	{
+		return;
+	}
+
+	// Report the points of edges no longer touching.
+	for (int32 j = 0; j < manifoldCount0; ++j)
+	{
+		if (m_edges0[j] != -1)
+		{
+			bool persisted[b2_maxManifoldPoints] = {false, false};
+			ReportRemoved(listener, m_manifolds0 + j, persisted);
+		}
+	}
+}
+
+void b2MeshContact::ReportRemoved(b2ContactListener* listener, const b2Manifold* manifold, const bool* persisted)
+{
+	b2Body* b1 = m_shape1->GetBody();
+	b2Body* b2 = m_shape2->GetBody();
+
+	b2ContactPoint cp;
+	cp.shape1 = m_shape1;
+	cp.shape2 = m_shape2;
+	cp.friction = b2MixFriction(m_shape1->GetFriction(), m_shape2->GetFriction());
+	cp.restitution = b2MixRestitution(m_shape1->GetRestitution(), m_shape2->GetRestitution());
+
+	for (int32 i = 0; i < manifold->pointCount; ++i)
+	{
+		if (persisted[i])
+		{
+			continue;
+		}
+
+		const b2ManifoldPoint* mp0 = manifold->points + i;
+		cp.position = b1->GetWorldPoint(mp0->localPoint1);
+		b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp0->localPoint1);
+		b2Vec2 v2 = b2->GetLinearVelocityFromLocalPoint(mp0->localPoint2);
+		cp.velocity = v2 - v1;
+		cp.normal = manifold->normal;
+		cp.separation = mp0->separation;
+		cp.id = mp0->id;
+		listener->Remove(&cp);
+	}
+}
@@ -33,7 +33,7 @@ public:
 	~b2PolyAndEdgeContact() {}
 
 	void Evaluate(b2ContactListener* listener);
-	void b2CollidePolyAndEdge(b2Manifold* manifold,
+	static void b2CollidePolyAndEdge(b2Manifold* manifold,
 									const b2PolygonShape* poly, const b2XForm& xf1,
 									const b2EdgeShape* edge, const b2XForm& xf2);
 	b2Manifold* GetManifolds()
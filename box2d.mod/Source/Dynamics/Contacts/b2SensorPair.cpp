@@ -0,0 +1,152 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2SensorPair.h"
+#include "../b2Body.h"
+#include "../b2WorldCallbacks.h"
+#include "../../Collision/b2Collision.h"
+#include "../../Collision/Shapes/b2Shape.h"
+#include "../../Common/b2BlockAllocator.h"
+
+#include <new>
+
+void b2SensorPair::LinkOverlap(b2Shape* sensor, b2SensorEdge* edge)
+{
+	edge->prev = NULL;
+	edge->next = sensor->m_overlapList;
+	if (sensor->m_overlapList != NULL)
+	{
+		sensor->m_overlapList->prev = edge;
+	}
+	sensor->m_overlapList = edge;
+	++sensor->m_overlapCount;
+}
+
+void b2SensorPair::UnlinkOverlap(b2Shape* sensor, b2SensorEdge* edge)
+{
+	if (edge->prev)
+	{
+		edge->prev->next = edge->next;
+	}
+
+	if (edge->next)
+	{
+		edge->next->prev = edge->prev;
+	}
+
+	if (edge == sensor->m_overlapList)
+	{
+		sensor->m_overlapList = edge->next;
+	}
+	--sensor->m_overlapCount;
+}
+
+b2SensorPair* b2SensorPair::Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator)
+{
+	// Keep the sensor first.
+	if (shape1->IsSensor() == false)
+	{
+		b2Swap(shape1, shape2);
+	}
+
+	void* mem = allocator->Allocate(sizeof(b2SensorPair));
+	return new (mem) b2SensorPair(shape1, shape2);
+}
+
+void b2SensorPair::Destroy(b2SensorPair* pair, b2BlockAllocator* allocator)
+{
+	b2Assert(pair->IsTouching() == false);
+	pair->~b2SensorPair();
+	allocator->Free(pair, sizeof(b2SensorPair));
+}
+
+b2SensorPair::b2SensorPair(b2Shape* s1, b2Shape* s2)
+{
+	b2Assert(s1->IsSensor());
+
+	// New pairs are tested on the next collide even if both bodies sleep.
+	m_flags = e_dirtyFlag;
+	m_shape1 = s1;
+	m_shape2 = s2;
+	m_index = -1;
+
+	m_node1.other = s2;
+	m_node1.pair = this;
+	m_node1.prev = NULL;
+	m_node1.next = NULL;
+
+	m_node2.other = s1;
+	m_node2.pair = this;
+	m_node2.prev = NULL;
+	m_node2.next = NULL;
+}
+
+void b2SensorPair::SetTouching(bool flag)
+{
+	if (flag == IsTouching())
+	{
+		return;
+	}
+
+	if (flag)
+	{
+		m_flags |= e_touchingFlag;
+		LinkOverlap(m_shape1, &m_node1);
+		if (m_shape2->IsSensor())
+		{
+			LinkOverlap(m_shape2, &m_node2);
+		}
+	}
+	else
+	{
+		m_flags &= ~e_touchingFlag;
+		UnlinkOverlap(m_shape1, &m_node1);
+		if (m_shape2->IsSensor())
+		{
+			UnlinkOverlap(m_shape2, &m_node2);
+		}
+	}
+}
+
+void b2SensorPair::Update(b2SensorListener* listener)
+{
+	m_flags &= ~e_dirtyFlag;
+
+	b2Body* body1 = m_shape1->GetBody();
+	b2Body* body2 = m_shape2->GetBody();
+
+	bool touching = b2TestOverlap(m_shape1, body1->GetXForm(), m_shape2, body2->GetXForm());
+	if (touching == IsTouching())
+	{
+		return;
+	}
+
+	SetTouching(touching);
+
+	if (listener)
+	{
+		if (touching)
+		{
+			listener->BeginOverlap(m_shape1, m_shape2);
+		}
+		else
+		{
+			listener->EndOverlap(m_shape1, m_shape2);
+		}
+	}
+}
@@ -0,0 +1,108 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SENSOR_PAIR_H
+#define B2_SENSOR_PAIR_H
+
+#include "../../Common/b2Settings.h"
+
+class b2Shape;
+class b2SensorPair;
+class b2SensorListener;
+class b2BlockAllocator;
+
+/// A sensor edge connects a sensor shape to a shape it currently overlaps.
+/// Sensor edges belong to a doubly linked list maintained in each sensor
+/// shape, so the list is exactly the set of overlapping shapes.
+struct b2SensorEdge
+{
+	b2Shape* other;			///< the overlapping shape
+	b2SensorPair* pair;		///< the sensor pair
+	b2SensorEdge* prev;		///< the previous edge in the sensor's overlap list
+	b2SensorEdge* next;		///< the next edge in the sensor's overlap list
+};
+
+/// A sensor pair tracks a broad-phase pair that involves at least one sensor.
+/// Unlike a contact it computes no manifold, it only runs a boolean overlap
+/// test and reports when the overlap begins and ends. Shape1 is always a sensor.
+class b2SensorPair
+{
+public:
+
+	/// Get the sensor shape.
+	b2Shape* GetShape1();
+
+	/// Get the other shape. This may be a sensor too.
+	b2Shape* GetShape2();
+
+	/// Are the shapes overlapping?
+	bool IsTouching() const;
+
+	//--------------- Internals Below -------------------
+
+	// m_flags
+	enum
+	{
+		e_touchingFlag	= 0x0001,
+		e_dirtyFlag		= 0x0002,
+	};
+
+	static b2SensorPair* Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator);
+	static void Destroy(b2SensorPair* pair, b2BlockAllocator* allocator);
+
+	b2SensorPair(b2Shape* shape1, b2Shape* shape2);
+
+	// Test the shapes and report a change of overlap.
+	void Update(b2SensorListener* listener);
+
+	// Set the overlap state, maintaining the overlap lists of the sensors.
+	void SetTouching(bool flag);
+
+	static void LinkOverlap(b2Shape* sensor, b2SensorEdge* edge);
+	static void UnlinkOverlap(b2Shape* sensor, b2SensorEdge* edge);
+
+	uint32 m_flags;
+
+	b2Shape* m_shape1;
+	b2Shape* m_shape2;
+
+	// Index in the contact manager's dense sensor pair array.
+	int32 m_index;
+
+	// Nodes for the overlap lists. The second node is only used when
+	// both shapes are sensors.
+	b2SensorEdge m_node1;
+	b2SensorEdge m_node2;
+};
+
+inline b2Shape* b2SensorPair::GetShape1()
+{
+	return m_shape1;
+}
+
+inline b2Shape* b2SensorPair::GetShape2()
+{
+	return m_shape2;
+}
+
+inline bool b2SensorPair::IsTouching() const
+{
+	return (m_flags & e_touchingFlag) != 0;
+}
+
+#endif
@@ -0,0 +1,289 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2TileGridContact.h"
+#include "../b2Body.h"
+#include "../b2WorldCallbacks.h"
+#include "../../Common/b2BlockAllocator.h"
+#include "../../Collision/Shapes/b2TileGridShape.h"
+#include "../../Collision/Shapes/b2PolygonShape.h"
+#include "../../Collision/Shapes/b2CircleShape.h"
+
+#include <new>
+#include <cstring>
+
+const int32 b2_tileGridContactCapacity = 4;
+
+b2Contact* b2TileGridContact::Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator)
+{
+	void* mem = allocator->Allocate(sizeof(b2TileGridContact));
+	return new (mem) b2TileGridContact(shape1, shape2);
+}
+
+void b2TileGridContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+{
+	((b2TileGridContact*)contact)->~b2TileGridContact();
+	allocator->Free(contact, sizeof(b2TileGridContact));
+}
+
+b2TileGridContact::b2TileGridContact(b2Shape* s1, b2Shape* s2)
+: b2Contact(s1, s2)
+{
+	b2Assert(m_shape1->GetType() == e_tileGridShape);
+	b2Assert(m_shape2->GetType() == e_polygonShape || m_shape2->GetType() == e_circleShape);
+
+	m_manifolds = NULL;
+	m_cells = NULL;
+	m_manifolds0 = NULL;
+	m_cells0 = NULL;
+	m_capacity = 0;
+	Reserve(b2_tileGridContactCapacity);
+}
+
+b2TileGridContact::~b2TileGridContact()
+{
+	b2Free(m_manifolds);
+	b2Free(m_cells);
+	b2Free(m_manifolds0);
+	b2Free(m_cells0);
+}
+
+// Grow the buffers, keeping the current and previous manifolds.
+void b2TileGridContact::Reserve(int32 capacity)
+{
+	if (capacity <= m_capacity)
+	{
+		return;
+	}
+
+	b2Manifold* manifolds = (b2Manifold*)b2Alloc(capacity * sizeof(b2Manifold));
+	int32* cells = (int32*)b2Alloc(capacity * sizeof(int32));
+	b2Manifold* manifolds0 = (b2Manifold*)b2Alloc(capacity * sizeof(b2Manifold));
+	int32* cells0 = (int32*)b2Alloc(capacity * sizeof(int32));
+
+	if (m_capacity > 0)
+	{
+		memcpy(manifolds, m_manifolds, m_capacity * sizeof(b2Manifold));
+		memcpy(cells, m_cells, m_capacity * sizeof(int32));
+		memcpy(manifolds0, m_manifolds0, m_capacity * sizeof(b2Manifold));
+		memcpy(cells0, m_cells0, m_capacity * sizeof(int32));
+		b2Free(m_manifolds);
+		b2Free(m_cells);
+		b2Free(m_manifolds0);
+		b2Free(m_cells0);
+	}
+
+	m_manifolds = manifolds;
+	m_cells = cells;
+	m_manifolds0 = manifolds0;
+	m_cells0 = cells0;
+	m_capacity = capacity;
+}
+
+void b2TileGridContact::Evaluate(b2ContactListener* listener)
+{
+	b2Body* b1 = m_shape1->GetBody();
+	b2Body* b2 = m_shape2->GetBody();
+	const b2XForm& xf1 = b1->GetXForm();
+	const b2XForm& xf2 = b2->GetXForm();
+
+	const b2TileGridShape* grid = (const b2TileGridShape*)m_shape1;
+	bool circle = m_shape2->GetType() == e_circleShape;
+
+	// Keep the old manifolds for warm starting.
+	int32 manifoldCount0 = m_manifoldCount;
+	b2Manifold* tmpManifolds = m_manifolds;
+	m_manifolds = m_manifolds0;
+	m_manifolds0 = tmpManifolds;
+	int32* tmpCells = m_cells;
+	m_cells = m_cells0;
+	m_cells0 = tmpCells;
+
+	// Find the cells under the other shape in the grid frame.
+	b2XForm relXF;
+	relXF.R = b2MulT(xf1.R, xf2.R);
+	relXF.position = b2MulT(xf1, xf2.position);
+	b2AABB aabb;
+	m_shape2->ComputeAABB(&aabb, relXF);
+
+	m_manifoldCount = 0;
+	int32 lowerX, lowerY, upperX, upperY;
+	if (grid->GetCellRange(aabb, &lowerX, &lowerY, &upperX, &upperY))
+	{
+		for (int32 y = lowerY; y <= upperY; ++y)
+		{
+			for (int32 x = lowerX; x <= upperX; ++x)
+			{
+				const b2PolygonShape* polygon = grid->GetTilePolygon(grid->GetTile(x, y));
+				if (polygon == NULL)
+				{
+					continue;
+				}
+
+				b2Vec2 offset = grid->GetCellOffset(x, y);
+				b2XForm cellXF(b2Mul(xf1, offset), xf1.R);
+
+				b2Manifold manifold;
+				if (circle)
+				{
+					b2CollidePolygonAndCircle(&manifold, polygon, cellXF, (const b2CircleShape*)m_shape2, xf2);
+				}
+				else
+				{
+					b2CollidePolygons(&manifold, polygon, cellXF, (const b2PolygonShape*)m_shape2, xf2);
+				}
+
+				// Drop contacts on the seams between tiles.
+				if (manifold.pointCount == 0 || grid->IsInternalNormal(x, y, b2MulT(xf1.R, manifold.normal)))
+				{
+					continue;
+				}
+
+				// Move the points from the cell frame to the body frame.
+				for (int32 i = 0; i < manifold.pointCount; ++i)
+				{
+					manifold.points[i].localPoint1 += offset;
+				}
+
+				if (m_manifoldCount == m_capacity)
+				{
+					Reserve(2 * m_capacity);
+				}
+
+				m_manifolds[m_manifoldCount] = manifold;
+				m_cells[m_manifoldCount] = y * grid->GetWidth() + x;
+				++m_manifoldCount;
+			}
+		}
+	}
+
+	b2ContactPoint cp;
+	cp.shape1 = m_shape1;
+	cp.shape2 = m_shape2;
+	cp.friction = b2MixFriction(m_shape1->GetFriction(), m_shape2->GetFriction());
+	cp.restitution = b2MixRestitution(m_shape1->GetRestitution(), m_shape2->GetRestitution());
+
+	// Match contact ids on the same cell to warm start the solver.
+	for (int32 i = 0; i < m_manifoldCount; ++i)
+	{
+		b2Manifold* manifold = m_manifolds + i;
+
+		b2Manifold* m0 = NULL;
+		for (int32 j = 0; j < manifoldCount0; ++j)
+		{
+			if (m_cells0[j] == m_cells[i])
+			{
+				m0 = m_manifolds0 + j;
+				m_cells0[j] = -1;
+				break;
+			}
+		}
+
+		bool persisted[b2_maxManifoldPoints] = {false, false};
+
+		for (int32 k = 0; k < manifold->pointCount; ++k)
+		{
+			b2ManifoldPoint* mp = manifold->points + k;
+			mp->normalImpulse = 0.0f;
+			mp->tangentImpulse = 0.0f;
+			bool found = false;
+
+			for (int32 j = 0; m0 != NULL && j < m0->pointCount; ++j)
+			{
+				b2ManifoldPoint* mp0 = m0->points + j;
+				if (persisted[j] == false && mp0->id.key == mp->id.key)
+				{
+					persisted[j] = true;
+					mp->normalImpulse = mp0->normalImpulse;
+					mp->tangentImpulse = mp0->tangentImpulse;
+					found = true;
+					break;
+				}
+			}
+
+			if (listener != NULL)
+			{
+				cp.position = b1->GetWorldPoint(mp->localPoint1);
+				b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp->localPoint1);
+				b2Vec2 v2 = b2->GetLinearVelocityFromLocalPoint(mp->localPoint2);
+				cp.velocity = v2 - v1;
+				cp.normal = manifold->normal;
+				cp.separation = mp->separation;
+				cp.id = mp->id;
+				if (found)
+				{
+					listener->Persist(&cp);
+				}
+				else
+				{
+					listener->Add(&cp);
+				}
+			}
+		}
+
+		if (m0 != NULL && listener != NULL)
+		{
+			ReportRemoved(listener, m0, persisted);
+		}
+	}
+
+	if (listener == NULL)
+	{
+		return;
+	}
+
+	// Report the points of tiles no longer touching.
+	for (int32 j = 0; j < manifoldCount0; ++j)
+	{
+		if (m_cells0[j] != -1)
+		{
+			bool persisted[b2_maxManifoldPoints] = {false, false};
+			ReportRemoved(listener, m_manifolds0 + j, persisted);
+		}
+	}
+}
+
+void b2TileGridContact::ReportRemoved(b2ContactListener* listener, const b2Manifold* manifold, const bool* persisted)
+{
+	b2Body* b1 = m_shape1->GetBody();
+	b2Body* b2 = m_shape2->GetBody();
+
+	b2ContactPoint cp;
+	cp.shape1 = m_shape1;
+	cp.shape2 = m_shape2;
+	cp.friction = b2MixFriction(m_shape1->GetFriction(), m_shape2->GetFriction());
+	cp.restitution = b2MixRestitution(m_shape1->GetRestitution(), m_shape2->GetRestitution());
+
+	for (int32 i = 0; i < manifold->pointCount; ++i)
+	{
+		if (persisted[i])
+		{
+			continue;
+		}
+
+		const b2ManifoldPoint* mp0 = manifold->points + i;
+		cp.position = b1->GetWorldPoint(mp0->localPoint1);
+		b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp0->localPoint1);
+		b2Vec2 v2 = b2->GetLinearVelocityFromLocalPoint(mp0->localPoint2);
+		cp.velocity = v2 - v1;
+		cp.normal = manifold->normal;
+		cp.separation = mp0->separation;
+		cp.id = mp0->id;
+		listener->Remove(&cp);
+	}
+}
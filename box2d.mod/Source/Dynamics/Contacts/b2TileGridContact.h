@@ -0,0 +1,57 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef TILE_GRID_CONTACT_H
+#define TILE_GRID_CONTACT_H
+
+#include "b2Contact.h"
+
+class b2BlockAllocator;
+
+/// Contact between a tile grid and a polygon or circle. Each touching tile
+/// gets its own manifold. The grid is always shape1.
+class b2TileGridContact : public b2Contact
+{
+public:
+	static b2Contact* Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator);
+	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
+
+	b2TileGridContact(b2Shape* shape1, b2Shape* shape2);
+	~b2TileGridContact();
+
+	void Evaluate(b2ContactListener* listener);
+	b2Manifold* GetManifolds()
+	{
+		return m_manifolds;
+	}
+
+	void Reserve(int32 capacity);
+	void ReportRemoved(b2ContactListener* listener, const b2Manifold* manifold, const bool* persisted);
+
+	// One manifold per touching tile, with the cell index in m_cells.
+	b2Manifold* m_manifolds;
+	int32* m_cells;
+
+	// The previous step's manifolds, kept for warm starting.
+	b2Manifold* m_manifolds0;
+	int32* m_cells0;
+
+	int32 m_capacity;
+};
+
+#endif
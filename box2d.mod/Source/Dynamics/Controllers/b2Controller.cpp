@@ -28,6 +28,8 @@ b2Controller::~b2Controller()
 
 void b2Controller::AddBody(b2Body* body)
 {
+	m_world->Wait();
+
 	void* mem = m_world->m_blockAllocator.Allocate(sizeof(b2ControllerEdge));
 	b2ControllerEdge* edge = new (mem) b2ControllerEdge;
 	
@@ -52,6 +54,8 @@ void b2Controller::AddBody(b2Body* body)
 
 void b2Controller::RemoveBody(b2Body* body)
 {
+	m_world->Wait();
+
 	//Assert that the controller is not empty
 	b2Assert(m_bodyCount>0);
 
@@ -85,6 +89,7 @@ void b2Controller::RemoveBody(b2Body* body)
 }
 
 void b2Controller::Clear(){
+	m_world->Wait();
 
 	while(m_bodyList)
 	{
@@ -33,7 +33,7 @@ void b2TensorDampingController::Step(const b2TimeStep& step)
 		timestep = maxTimestep;
 	for(b2ControllerEdge *i=m_bodyList;i;i=i->nextBody){
 		b2Body* body = i->body;
-		if(body->IsSleeping())
+		if(body->IsSleeping() || body->IsActive() == false)
 			continue;
 		b2Vec2 damping = body->GetWorldVector(
 							b2Mul(T,
@@ -141,6 +141,10 @@ b2Joint::b2Joint(const b2JointDef* def)
 	m_body1 = def->body1;
 	m_body2 = def->body2;
 	m_collideConnected = def->collideConnected;
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
 	m_islandFlag = false;
+	m_id = 0;
 	m_userData = def->userData;
 }
@@ -25,6 +25,7 @@ class b2Body;
 class b2Joint;
 struct b2TimeStep;
 class b2BlockAllocator;
+struct b2PersistentIsland;
 
 enum b2JointType
 {
@@ -140,6 +141,10 @@ protected:
 	friend class b2World;
 	friend class b2Body;
 	friend class b2Island;
+	friend class b2IslandManager;
+	friend class b2JointTreeSolver;
+	friend class b2WorldRecorder;
+	friend class b2WorldPlayer;
 
 	static b2Joint* Create(const b2JointDef* def, b2BlockAllocator* allocator);
 	static void Destroy(b2Joint* joint, b2BlockAllocator* allocator);
@@ -163,9 +168,17 @@ protected:
 	b2Body* m_body1;
 	b2Body* m_body2;
 
+	// Persistent island list pointers.
+	b2PersistentIsland* m_island;
+	b2Joint* m_islandPrev;
+	b2Joint* m_islandNext;
+
 	bool m_islandFlag;
 	bool m_collideConnected;
 
+	// Assigned by the world in creation order, used to record and replay the world.
+	uint32 m_id;
+
 	void* m_userData;
 
 	// Cache here per time step to reduce cache misses.
@@ -0,0 +1,705 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2JointTreeSolver.h"
+#include "b2RevoluteJoint.h"
+#include "b2DistanceJoint.h"
+#include "../b2Body.h"
+#include "../b2World.h"
+#include "../../Common/b2StackAllocator.h"
+
+// The joint graph is handled as the sparse system
+// [M  J'] [dv]   [ 0]
+// [J  0 ] [mu] = [-b]
+// where the block graph is the body-joint tree. Eliminating children before parents
+// gives H = L * D * L' without fill. A joint attached to a static body is the root
+// of its tree, so no joint is ever a leaf and every D block is invertible.
+// The applied impulse is lambda = -mu.
+
+static inline b2Mat33 b2MulMM(const b2Mat33& A, const b2Mat33& B)
+{
+	return b2Mat33(b2Mul(A, B.col1), b2Mul(A, B.col2), b2Mul(A, B.col3));
+}
+
+static inline b2Vec3 b2MulTMV(const b2Mat33& A, const b2Vec3& v)
+{
+	return b2Vec3(b2Dot(A.col1, v), b2Dot(A.col2, v), b2Dot(A.col3, v));
+}
+
+static inline b2Mat33 b2MulTMM(const b2Mat33& A, const b2Mat33& B)
+{
+	return b2Mat33(b2MulTMV(A, B.col1), b2MulTMV(A, B.col2), b2MulTMV(A, B.col3));
+}
+
+static inline b2Mat33 b2Transpose(const b2Mat33& A)
+{
+	return b2Mat33(	b2Vec3(A.col1.x, A.col2.x, A.col3.x),
+					b2Vec3(A.col1.y, A.col2.y, A.col3.y),
+					b2Vec3(A.col1.z, A.col2.z, A.col3.z));
+}
+
+// Invert the leading dim-by-dim block of a symmetric matrix. A singular block,
+// such as a distance joint of zero length, yields zero.
+static void b2InvertBlock(b2Mat33* A, int32 dim)
+{
+	b2Mat33 B = *A;
+	A->SetZero();
+
+	if (dim == 1)
+	{
+		if (B.col1.x != 0.0f)
+		{
+			A->col1.x = 1.0f / B.col1.x;
+		}
+	}
+	else if (dim == 2)
+	{
+		float32 a11 = B.col1.x, a12 = B.col2.x, a21 = B.col1.y, a22 = B.col2.y;
+		float32 det = a11 * a22 - a12 * a21;
+		if (det != 0.0f)
+		{
+			det = 1.0f / det;
+			A->col1.x = det * a22;	A->col2.x = -det * a12;
+			A->col1.y = -det * a21;	A->col2.y = det * a11;
+		}
+	}
+	else
+	{
+		float32 det = b2Dot(B.col1, b2Cross(B.col2, B.col3));
+		if (det != 0.0f)
+		{
+			det = 1.0f / det;
+			A->col1 = det * b2Cross(B.col2, B.col3);
+			A->col2 = det * b2Cross(B.col3, B.col1);
+			A->col3 = det * b2Cross(B.col1, B.col2);
+		}
+	}
+}
+
+static int32 b2FindSet(int32* sets, int32 i)
+{
+	while (sets[i] != i)
+	{
+		sets[i] = sets[sets[i]];
+		i = sets[i];
+	}
+	return i;
+}
+
+int32 b2JointTreeSolver::GetSetIndex(b2Body* body, int32 groundIndex)
+{
+	return body->IsStatic() ? groundIndex : body->m_islandIndex;
+}
+
+b2JointTreeSolver::b2JointTreeSolver(const b2TimeStep& step, int32 bodyCount, b2Joint** joints, int32 jointCount,
+										b2StackAllocator* allocator)
+{
+	m_allocator = allocator;
+	m_dt = step.dt;
+	m_nodes = NULL;
+	m_order = NULL;
+	m_nodeCount = 0;
+	m_jointCount = 0;
+
+	if (step.directJoints == false || jointCount == 0)
+	{
+		return;
+	}
+
+	// Pick a spanning forest. All static bodies are one ground set, so a second
+	// path to the ground closes a loop.
+	int32 groundIndex = bodyCount;
+	int32* sets = (int32*)m_allocator->Allocate((bodyCount + 1) * sizeof(int32));
+	for (int32 i = 0; i <= bodyCount; ++i)
+	{
+		sets[i] = i;
+	}
+
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		b2Joint* j = joints[i];
+		if (IsTreeJoint(j) == false)
+		{
+			continue;
+		}
+
+		int32 set1 = b2FindSet(sets, GetSetIndex(j->m_body1, groundIndex));
+		int32 set2 = b2FindSet(sets, GetSetIndex(j->m_body2, groundIndex));
+		if (set1 == set2)
+		{
+			continue;
+		}
+
+		sets[set1] = set2;
+		joints[i] = joints[m_jointCount];
+		joints[m_jointCount] = j;
+		++m_jointCount;
+	}
+
+	m_allocator->Free(sets);
+
+	if (m_jointCount == 0)
+	{
+		return;
+	}
+
+	int32 nodeCapacity = m_jointCount + b2Min(bodyCount, 2 * m_jointCount);
+	m_nodes = (b2JointTreeNode*)m_allocator->Allocate(nodeCapacity * sizeof(b2JointTreeNode));
+	m_order = (int32*)m_allocator->Allocate(nodeCapacity * sizeof(int32));
+
+	// Joint nodes come first, then the bodies they touch.
+	int32* bodyNodes = (int32*)m_allocator->Allocate(bodyCount * sizeof(int32));
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		bodyNodes[i] = -1;
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		node->body = NULL;
+		node->joint = joints[i];
+		node->parent = -2;
+		node->dim = joints[i]->GetType() == e_revoluteJoint ? 2 : 1;
+	}
+
+	m_nodeCount = m_jointCount;
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2Body* jointBodies[2] = {joints[i]->m_body1, joints[i]->m_body2};
+		for (int32 k = 0; k < 2; ++k)
+		{
+			b2Body* b = jointBodies[k];
+			if (b->IsStatic() || bodyNodes[b->m_islandIndex] != -1)
+			{
+				continue;
+			}
+
+			bodyNodes[b->m_islandIndex] = m_nodeCount;
+			b2JointTreeNode* node = m_nodes + m_nodeCount;
+			node->body = b;
+			node->joint = NULL;
+			node->parent = -2;
+			node->dim = 3;
+			++m_nodeCount;
+		}
+	}
+
+	// The body nodes each joint acts on, for the geometric stiffness.
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		node->node1 = joints[i]->m_body1->IsStatic() ? -1 : bodyNodes[joints[i]->m_body1->m_islandIndex];
+		node->node2 = joints[i]->m_body2->IsStatic() ? -1 : bodyNodes[joints[i]->m_body2->m_islandIndex];
+	}
+
+	// Body to joint adjacency, in compressed rows.
+	int32 bodyNodeCount = m_nodeCount - m_jointCount;
+	int32* offsets = (int32*)m_allocator->Allocate((bodyNodeCount + 1) * sizeof(int32));
+	int32* adjacent = (int32*)m_allocator->Allocate(2 * m_jointCount * sizeof(int32));
+	for (int32 i = 0; i <= bodyNodeCount; ++i)
+	{
+		offsets[i] = 0;
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2Joint* j = joints[i];
+		if (j->m_body1->IsStatic() == false)
+		{
+			++offsets[bodyNodes[j->m_body1->m_islandIndex] - m_jointCount + 1];
+		}
+		if (j->m_body2->IsStatic() == false)
+		{
+			++offsets[bodyNodes[j->m_body2->m_islandIndex] - m_jointCount + 1];
+		}
+	}
+
+	for (int32 i = 0; i < bodyNodeCount; ++i)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2Joint* j = joints[i];
+		if (j->m_body1->IsStatic() == false)
+		{
+			int32 b = bodyNodes[j->m_body1->m_islandIndex] - m_jointCount;
+			adjacent[offsets[b]++] = i;
+		}
+		if (j->m_body2->IsStatic() == false)
+		{
+			int32 b = bodyNodes[j->m_body2->m_islandIndex] - m_jointCount;
+			adjacent[offsets[b]++] = i;
+		}
+	}
+
+	// The fill pass advanced each offset to the start of the next row.
+	for (int32 i = bodyNodeCount; i > 0; --i)
+	{
+		offsets[i] = offsets[i - 1];
+	}
+	offsets[0] = 0;
+
+	// Breadth first order from the roots. Joints to the ground are the roots of
+	// their trees, trees without one are rooted at a body.
+	int32 orderCount = 0;
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2Joint* j = joints[i];
+		if (j->m_body1->IsStatic() || j->m_body2->IsStatic())
+		{
+			m_nodes[i].parent = -1;
+			m_order[orderCount++] = i;
+		}
+	}
+
+	int32 head = 0;
+	int32 root = m_jointCount;
+	for (;;)
+	{
+		while (head < orderCount)
+		{
+			int32 i = m_order[head++];
+			b2JointTreeNode* node = m_nodes + i;
+			if (node->joint)
+			{
+				b2Body* jointBodies[2] = {node->joint->m_body1, node->joint->m_body2};
+				for (int32 k = 0; k < 2; ++k)
+				{
+					b2Body* b = jointBodies[k];
+					if (b->IsStatic())
+					{
+						continue;
+					}
+
+					int32 child = bodyNodes[b->m_islandIndex];
+					if (m_nodes[child].parent == -2)
+					{
+						m_nodes[child].parent = i;
+						m_order[orderCount++] = child;
+					}
+				}
+			}
+			else
+			{
+				int32 b = i - m_jointCount;
+				for (int32 k = offsets[b]; k < offsets[b + 1]; ++k)
+				{
+					int32 child = adjacent[k];
+					if (m_nodes[child].parent == -2)
+					{
+						m_nodes[child].parent = i;
+						m_order[orderCount++] = child;
+					}
+				}
+			}
+		}
+
+		while (root < m_nodeCount && m_nodes[root].parent != -2)
+		{
+			++root;
+		}
+
+		if (root == m_nodeCount)
+		{
+			break;
+		}
+
+		m_nodes[root].parent = -1;
+		m_order[orderCount++] = root;
+	}
+
+	b2Assert(orderCount == m_nodeCount);
+
+	m_allocator->Free(adjacent);
+	m_allocator->Free(offsets);
+	m_allocator->Free(bodyNodes);
+
+	Factor();
+}
+
+b2JointTreeSolver::~b2JointTreeSolver()
+{
+	if (m_nodes)
+	{
+		m_allocator->Free(m_order);
+		m_allocator->Free(m_nodes);
+	}
+}
+
+bool b2JointTreeSolver::IsTreeJoint(b2Joint* joint)
+{
+	switch (joint->GetType())
+	{
+	case e_revoluteJoint:
+		{
+			b2RevoluteJoint* j = (b2RevoluteJoint*)joint;
+			if (j->m_enableLimit || j->m_enableMotor)
+			{
+				return false;
+			}
+		}
+		break;
+
+	case e_distanceJoint:
+		if (((b2DistanceJoint*)joint)->m_frequencyHz > 0.0f)
+		{
+			return false;
+		}
+		break;
+
+	default:
+		return false;
+	}
+
+	// The bodies need finite mass and rotational inertia. Fixed rotation
+	// bodies are left to the iterative solver.
+	b2Body* b1 = joint->m_body1;
+	b2Body* b2 = joint->m_body2;
+	if (b1->IsStatic() == false && (b1->m_invMass == 0.0f || b1->m_invI == 0.0f))
+	{
+		return false;
+	}
+	if (b2->IsStatic() == false && (b2->m_invMass == 0.0f || b2->m_invI == 0.0f))
+	{
+		return false;
+	}
+
+	return b1->IsStatic() == false || b2->IsStatic() == false;
+}
+
+void b2JointTreeSolver::ComputeJacobian(const b2JointTreeNode* node, const b2Body* body, b2Mat33* J) const
+{
+	float32 sign;
+	b2Vec2 r;
+	if (body == node->joint->m_body1)
+	{
+		sign = -1.0f;
+		r = node->r1;
+	}
+	else
+	{
+		sign = 1.0f;
+		r = node->r2;
+	}
+
+	if (node->dim == 2)
+	{
+		// Point-to-point: J = [-I -r1_skew I r2_skew]
+		J->col1.Set(sign, 0.0f, 0.0f);
+		J->col2.Set(0.0f, sign, 0.0f);
+		J->col3.Set(-sign * r.y, sign * r.x, 0.0f);
+	}
+	else
+	{
+		// Distance: J = [-u -cross(r1, u) u cross(r2, u)]
+		J->col1.Set(sign * node->u.x, 0.0f, 0.0f);
+		J->col2.Set(sign * node->u.y, 0.0f, 0.0f);
+		J->col3.Set(sign * b2Cross(r, node->u), 0.0f, 0.0f);
+	}
+}
+
+void b2JointTreeSolver::Factor()
+{
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		if (node->body)
+		{
+			b2Body* b = node->body;
+			node->invD.col1.Set(b->m_mass, 0.0f, 0.0f);
+			node->invD.col2.Set(0.0f, b->m_mass, 0.0f);
+			node->invD.col3.Set(0.0f, 0.0f, b->m_I);
+			continue;
+		}
+
+		node->invD.SetZero();
+
+		b2Joint* joint = node->joint;
+		b2Body* b1 = joint->m_body1;
+		b2Body* b2 = joint->m_body2;
+
+		b2Vec2 localAnchor1, localAnchor2;
+		if (node->dim == 2)
+		{
+			b2RevoluteJoint* j = (b2RevoluteJoint*)joint;
+			localAnchor1 = j->m_localAnchor1;
+			localAnchor2 = j->m_localAnchor2;
+		}
+		else
+		{
+			b2DistanceJoint* j = (b2DistanceJoint*)joint;
+			localAnchor1 = j->m_localAnchor1;
+			localAnchor2 = j->m_localAnchor2;
+		}
+
+		node->r1 = b2Mul(b1->GetXForm().R, localAnchor1 - b1->GetLocalCenter());
+		node->r2 = b2Mul(b2->GetXForm().R, localAnchor2 - b2->GetLocalCenter());
+
+		node->u = b2->m_sweep.c + node->r2 - b1->m_sweep.c - node->r1;
+		float32 length = node->u.Length();
+		if (length > b2_linearSlop)
+		{
+			node->u *= 1.0f / length;
+		}
+		else
+		{
+			node->u.SetZero();
+		}
+	}
+
+	// An exact solve treats the joint forces as if their directions stay fixed over the
+	// step. Under tension a rope with a heavy end then overshoots back and forth every
+	// step, so add the diagonal of the geometric stiffness of the last impulses to the
+	// rotational inertia (Tournier et al., "Stable Constrained Dynamics").
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+
+		b2Vec2 P;
+		if (node->dim == 2)
+		{
+			b2RevoluteJoint* j = (b2RevoluteJoint*)node->joint;
+			P.Set(j->m_impulse.x, j->m_impulse.y);
+		}
+		else
+		{
+			b2DistanceJoint* j = (b2DistanceJoint*)node->joint;
+			P = j->m_impulse * node->u;
+		}
+
+		if (node->node1 != -1)
+		{
+			m_nodes[node->node1].invD.col3.z += m_dt * b2Abs(b2Dot(P, node->r1));
+		}
+		if (node->node2 != -1)
+		{
+			m_nodes[node->node2].invD.col3.z += m_dt * b2Abs(b2Dot(P, node->r2));
+		}
+	}
+
+	// Eliminate children before their parents.
+	for (int32 k = m_nodeCount - 1; k >= 0; --k)
+	{
+		b2JointTreeNode* node = m_nodes + m_order[k];
+		b2InvertBlock(&node->invD, node->dim);
+
+		if (node->parent < 0)
+		{
+			continue;
+		}
+
+		b2JointTreeNode* parent = m_nodes + node->parent;
+		if (node->joint)
+		{
+			ComputeJacobian(node, parent->body, &node->H);
+		}
+		else
+		{
+			b2Mat33 J;
+			ComputeJacobian(parent, node->body, &J);
+			node->H = b2Transpose(J);
+		}
+
+		node->W = b2MulMM(node->invD, node->H);
+
+		b2Mat33 S = b2MulTMM(node->H, node->W);
+		parent->invD.col1 -= S.col1;
+		parent->invD.col2 -= S.col2;
+		parent->invD.col3 -= S.col3;
+	}
+}
+
+void b2JointTreeSolver::Solve()
+{
+	// L * z = b
+	for (int32 k = m_nodeCount - 1; k >= 0; --k)
+	{
+		b2JointTreeNode* node = m_nodes + m_order[k];
+		if (node->parent >= 0)
+		{
+			m_nodes[node->parent].x -= b2MulTMV(node->W, node->x);
+		}
+	}
+
+	// D * L' * x = z
+	for (int32 k = 0; k < m_nodeCount; ++k)
+	{
+		b2JointTreeNode* node = m_nodes + m_order[k];
+		node->x = b2Mul(node->invD, node->x);
+		if (node->parent >= 0)
+		{
+			node->x -= b2Mul(node->W, m_nodes[node->parent].x);
+		}
+	}
+}
+
+// The solve is exact, so the joints are not warm started. Their impulses were
+// already used for the geometric stiffness by Factor.
+void b2JointTreeSolver::InitVelocityConstraints()
+{
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		if (node->dim == 2)
+		{
+			b2RevoluteJoint* j = (b2RevoluteJoint*)node->joint;
+			j->m_impulse.SetZero();
+			j->m_motorImpulse = 0.0f;
+		}
+		else
+		{
+			b2DistanceJoint* j = (b2DistanceJoint*)node->joint;
+			j->m_impulse = 0.0f;
+		}
+	}
+}
+
+void b2JointTreeSolver::SolveVelocityConstraints()
+{
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		if (node->body)
+		{
+			node->x.SetZero();
+			continue;
+		}
+
+		b2Body* b1 = node->joint->m_body1;
+		b2Body* b2 = node->joint->m_body2;
+		b2Vec2 Cdot = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, node->r2) - b1->m_linearVelocity - b2Cross(b1->m_angularVelocity, node->r1);
+
+		if (node->dim == 2)
+		{
+			node->x.Set(-Cdot.x, -Cdot.y, 0.0f);
+		}
+		else
+		{
+			node->x.Set(-b2Dot(node->u, Cdot), 0.0f, 0.0f);
+		}
+	}
+
+	Solve();
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		if (node->body)
+		{
+			b2Body* b = node->body;
+			b->m_linearVelocity.x += node->x.x;
+			b->m_linearVelocity.y += node->x.y;
+			b->m_angularVelocity += node->x.z;
+		}
+		else if (node->dim == 2)
+		{
+			b2RevoluteJoint* j = (b2RevoluteJoint*)node->joint;
+			j->m_impulse.x -= node->x.x;
+			j->m_impulse.y -= node->x.y;
+		}
+		else
+		{
+			b2DistanceJoint* j = (b2DistanceJoint*)node->joint;
+			j->m_impulse -= node->x.x;
+		}
+	}
+}
+
+bool b2JointTreeSolver::SolvePositionConstraints()
+{
+	// Refactor at the current positions.
+	Factor();
+
+	float32 linearError = 0.0f;
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		if (node->body)
+		{
+			node->x.SetZero();
+			continue;
+		}
+
+		b2Body* b1 = node->joint->m_body1;
+		b2Body* b2 = node->joint->m_body2;
+		b2Vec2 d = b2->m_sweep.c + node->r2 - b1->m_sweep.c - node->r1;
+
+		if (node->dim == 2)
+		{
+			float32 length = d.Length();
+			linearError = b2Max(linearError, length);
+
+			// Clamp the correction so that fast spinning bodies do not overshoot.
+			if (length > b2_maxLinearCorrection)
+			{
+				d *= b2_maxLinearCorrection / length;
+			}
+
+			node->x.Set(-d.x, -d.y, 0.0f);
+		}
+		else
+		{
+			float32 C = b2Dot(node->u, d) - ((b2DistanceJoint*)node->joint)->m_length;
+			linearError = b2Max(linearError, b2Abs(C));
+
+			C = b2Clamp(C, -b2_maxLinearCorrection, b2_maxLinearCorrection);
+			node->x.Set(-C, 0.0f, 0.0f);
+		}
+	}
+
+	Solve();
+
+	// The projection is linearized, so scale the whole step down when it would move or
+	// turn a body further than the iterative solver is allowed to in one go.
+	float32 scale = 1.0f;
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		if (node->body)
+		{
+			float32 linear = b2Sqrt(node->x.x * node->x.x + node->x.y * node->x.y);
+			float32 angular = b2Abs(node->x.z);
+			if (linear * scale > b2_maxLinearCorrection)
+			{
+				scale = b2_maxLinearCorrection / linear;
+			}
+			if (angular * scale > b2_maxAngularCorrection)
+			{
+				scale = b2_maxAngularCorrection / angular;
+			}
+		}
+	}
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		if (node->body)
+		{
+			b2Body* b = node->body;
+			b->m_sweep.c.x += scale * node->x.x;
+			b->m_sweep.c.y += scale * node->x.y;
+			b->m_sweep.a += scale * node->x.z;
+			b->SynchronizeTransform();
+		}
+	}
+
+	return linearError < b2_linearSlop;
+}
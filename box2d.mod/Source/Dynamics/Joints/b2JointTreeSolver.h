@@ -0,0 +1,82 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_JOINT_TREE_SOLVER_H
+#define B2_JOINT_TREE_SOLVER_H
+
+#include "../../Common/b2Math.h"
+
+class b2Body;
+class b2Joint;
+class b2StackAllocator;
+struct b2TimeStep;
+
+// A body or a joint in a joint tree. Blocks are padded to 3-by-3, only the
+// leading dim rows (and parent dim columns) are used.
+struct b2JointTreeNode
+{
+	b2Mat33 H;		// coupling block to the parent: rows this node, columns the parent
+	b2Mat33 W;		// inv(D) * H
+	b2Mat33 invD;	// inverse of the eliminated diagonal block
+	b2Vec3 x;		// right hand side, then solution
+	b2Vec2 r1, r2;	// joint anchors relative to the body centers
+	b2Vec2 u;		// distance joint axis
+	b2Body* body;	// NULL for joint nodes
+	b2Joint* joint;	// NULL for body nodes
+	int32 parent;	// -1 for roots
+	int32 node1;	// body nodes of a joint node, -1 for static bodies
+	int32 node2;
+	int32 dim;
+};
+
+// Solves the rigid point and distance joints of an island directly, in time linear in
+// the number of joints (Baraff, "Linear-Time Dynamics using Lagrange Multipliers").
+// The joints must form a forest. Joints that would close a loop, including a second
+// path to the static bodies, are left to the iterative solver along with limits,
+// motors, springs and the other joint types. Position errors are projected out over
+// the same tree, with each projection scaled down to the usual correction limits.
+class b2JointTreeSolver
+{
+public:
+	// Moves the joints solved by this to the front of the joint array.
+	b2JointTreeSolver(const b2TimeStep& step, int32 bodyCount, b2Joint** joints, int32 jointCount,
+						b2StackAllocator* allocator);
+	~b2JointTreeSolver();
+
+	void InitVelocityConstraints();
+	void SolveVelocityConstraints();
+	bool SolvePositionConstraints();
+
+	b2StackAllocator* m_allocator;
+	float32 m_dt;
+	b2JointTreeNode* m_nodes;
+	int32* m_order;			// parents before children
+	int32 m_nodeCount;
+	int32 m_jointCount;		// the number of joints solved by this
+
+private:
+
+	static bool IsTreeJoint(b2Joint* joint);
+	static int32 GetSetIndex(b2Body* body, int32 groundIndex);
+
+	void Factor();
+	void Solve();
+	void ComputeJacobian(const b2JointTreeNode* node, const b2Body* body, b2Mat33* J) const;
+};
+
+#endif
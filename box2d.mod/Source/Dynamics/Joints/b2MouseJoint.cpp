@@ -19,6 +19,7 @@
 #include "b2MouseJoint.h"
 #include "../b2Body.h"
 #include "../b2World.h"
+#include "../b2WorldRecorder.h"
 
 // p = attached point, m = mouse point
 // C = p - m
@@ -46,6 +47,12 @@ b2MouseJoint::b2MouseJoint(const b2MouseJointDef* def)
 
 void b2MouseJoint::SetTarget(const b2Vec2& target)
 {
+	b2RecordScope scope(m_body2->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJoint(e_recordSetTarget, this, target.x, target.y);
+	}
+
 	if (m_body2->IsSleeping())
 	{
 		m_body2->WakeUp();
@@ -19,6 +19,7 @@
 #include "b2PrismaticJoint.h"
 #include "../b2Body.h"
 #include "../b2World.h"
+#include "../b2WorldRecorder.h"
 
 // Linear constraint (point-to-line)
 // d = p2 - p1 = x2 + r2 - x1 - r1
@@ -531,6 +532,12 @@ bool b2PrismaticJoint::IsLimitEnabled() const
 
 void b2PrismaticJoint::EnableLimit(bool flag)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJointFlag(e_recordEnableLimit, this, flag);
+	}
+
 	m_body1->WakeUp();
 	m_body2->WakeUp();
 	m_enableLimit = flag;
@@ -548,6 +555,12 @@ float32 b2PrismaticJoint::GetUpperLimit() const
 
 void b2PrismaticJoint::SetLimits(float32 lower, float32 upper)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJoint(e_recordSetLimits, this, lower, upper);
+	}
+
 	b2Assert(lower <= upper);
 	m_body1->WakeUp();
 	m_body2->WakeUp();
@@ -562,6 +575,12 @@ bool b2PrismaticJoint::IsMotorEnabled() const
 
 void b2PrismaticJoint::EnableMotor(bool flag)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJointFlag(e_recordEnableMotor, this, flag);
+	}
+
 	m_body1->WakeUp();
 	m_body2->WakeUp();
 	m_enableMotor = flag;
@@ -569,6 +588,12 @@ void b2PrismaticJoint::EnableMotor(bool flag)
 
 void b2PrismaticJoint::SetMotorSpeed(float32 speed)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJoint(e_recordSetMotorSpeed, this, speed);
+	}
+
 	m_body1->WakeUp();
 	m_body2->WakeUp();
 	m_motorSpeed = speed;
@@ -576,6 +601,12 @@ void b2PrismaticJoint::SetMotorSpeed(float32 speed)
 
 void b2PrismaticJoint::SetMaxMotorForce(float32 force)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJoint(e_recordSetMaxMotorForce, this, force);
+	}
+
 	m_body1->WakeUp();
 	m_body2->WakeUp();
 	m_maxMotorForce = B2FORCE_SCALE(float32(1.0))*force;
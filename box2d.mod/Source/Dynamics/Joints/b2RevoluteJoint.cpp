@@ -19,6 +19,7 @@
 #include "b2RevoluteJoint.h"
 #include "../b2Body.h"
 #include "../b2World.h"
+#include "../b2WorldRecorder.h"
 
 #include "../b2Island.h"
 
@@ -418,6 +419,12 @@ bool b2RevoluteJoint::IsMotorEnabled() const
 
 void b2RevoluteJoint::EnableMotor(bool flag)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJointFlag(e_recordEnableMotor, this, flag);
+	}
+
 	m_body1->WakeUp();
 	m_body2->WakeUp();
 	m_enableMotor = flag;
@@ -430,6 +437,12 @@ float32 b2RevoluteJoint::GetMotorTorque() const
 
 void b2RevoluteJoint::SetMotorSpeed(float32 speed)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJoint(e_recordSetMotorSpeed, this, speed);
+	}
+
 	m_body1->WakeUp();
 	m_body2->WakeUp();
 	m_motorSpeed = speed;
@@ -437,6 +450,12 @@ void b2RevoluteJoint::SetMotorSpeed(float32 speed)
 
 void b2RevoluteJoint::SetMaxMotorTorque(float32 torque)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJoint(e_recordSetMaxMotorForce, this, torque);
+	}
+
 	m_body1->WakeUp();
 	m_body2->WakeUp();
 	m_maxMotorTorque = torque;
@@ -449,6 +468,12 @@ bool b2RevoluteJoint::IsLimitEnabled() const
 
 void b2RevoluteJoint::EnableLimit(bool flag)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJointFlag(e_recordEnableLimit, this, flag);
+	}
+
 	m_body1->WakeUp();
 	m_body2->WakeUp();
 	m_enableLimit = flag;
@@ -466,6 +491,12 @@ float32 b2RevoluteJoint::GetUpperLimit() const
 
 void b2RevoluteJoint::SetLimits(float32 lower, float32 upper)
 {
+	b2RecordScope scope(m_body1->GetWorld());
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJoint(e_recordSetLimits, this, lower, upper);
+	}
+
 	b2Assert(lower <= upper);
 	m_body1->WakeUp();
 	m_body2->WakeUp();
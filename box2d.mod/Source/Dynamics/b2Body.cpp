@@ -18,6 +18,7 @@
 
 #include "b2Body.h"
 #include "b2World.h"
+#include "b2WorldRecorder.h"
 #include "Joints/b2Joint.h"
 #include "../Collision/Shapes/b2Shape.h"
 #include "../Collision/Shapes/b2EdgeShape.h"
@@ -44,6 +45,10 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	{
 		m_flags |= e_sleepFlag;
 	}
+	if (bd->isActive == false)
+	{
+		m_flags |= e_inactiveFlag;
+	}
 
 	m_world = world;
 
@@ -55,12 +60,19 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	m_sweep.a0 = m_sweep.a = bd->angle;
 	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
 
+	m_position0 = m_xf.position;
+	m_angle0 = bd->angle;
+
 	m_jointList = NULL;
 	m_contactList = NULL;
 	m_controllerList = NULL;
 	m_prev = NULL;
 	m_next = NULL;
 
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
+
 	m_linearDamping = bd->linearDamping;
 	m_angularDamping = bd->angularDamping;
 
@@ -114,28 +126,21 @@ b2Body::~b2Body()
 	// shapes and joints are destroyed in b2World::Destroy
 }
 
-
-float32 connectEdges(b2EdgeShape * const & s1, b2EdgeShape * const & s2, float32 angle1)
-{
-	float32 angle2 = b2Atan2(s2->GetDirectionVector().y, s2->GetDirectionVector().x);
-	b2Vec2 core = tanf((angle2 - angle1) * 0.5f) * s2->GetDirectionVector();
-	core = b2_toiSlop * (core - s2->GetNormalVector()) + s2->GetVertex1();
-	b2Vec2 cornerDir = s1->GetDirectionVector() + s2->GetDirectionVector();
-	cornerDir.Normalize();
-	bool convex = b2Dot(s1->GetDirectionVector(), s2->GetNormalVector()) > 0.0f;
-	s1->SetNextEdge(s2, core, cornerDir, convex);
-	s2->SetPrevEdge(s1, core, cornerDir, convex);
-	return angle2;
-}
-
 b2Shape* b2Body::CreateShape(b2ShapeDef* def)
 {
+	m_world->BeginEdit();
+
 	b2Assert(m_world->m_lock == false);
 	if (m_world->m_lock == true)
 	{
 		return NULL;
 	}
-	
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordCreateShape(this, def);
+	}
 	
 	// TODO: Decide on a better place to initialize edgeShapes. (b2Shape::Create() can't
 	//       return more than one shape to add to parent body... maybe it should add
@@ -163,27 +168,32 @@ b2Shape* b2Body::CreateShape(b2ShapeDef* def)
 			
 			void* mem = m_world->m_blockAllocator.Allocate(sizeof(b2EdgeShape));
 			s2 = new (mem) b2EdgeShape(v1, v2, def);
+			s2->m_id = ++m_world->m_shapeIdCounter;
 			s2->m_next = m_shapeList;
 			m_shapeList = s2;
 			++m_shapeCount;
 			s2->m_body = this;
-			s2->CreateProxy(m_world->m_broadPhase, m_xf);
+			if (IsActive())
+			{
+				s2->CreateProxy(m_world->m_broadPhase, m_xf);
+			}
 			s2->UpdateSweepRadius(m_sweep.localCenter);
 			
 			if (s1 == NULL) {
 				s0 = s2;
 				angle = b2Atan2(s2->GetDirectionVector().y, s2->GetDirectionVector().x);
 			} else {
-				angle = connectEdges(s1, s2, angle);
+				angle = b2ConnectEdges(s1, s2, angle);
 			}
 			s1 = s2;
 			v1 = v2;
 		}
-		if (edgeDef->isALoop) connectEdges(s1, s0, angle);
+		if (edgeDef->isALoop) b2ConnectEdges(s1, s0, angle);
 		return s0;
 	}
 	
 	b2Shape* s = b2Shape::Create(def, &m_world->m_blockAllocator);
+	s->m_id = ++m_world->m_shapeIdCounter;
 
 	s->m_next = m_shapeList;
 	m_shapeList = s;
@@ -192,7 +202,10 @@ b2Shape* b2Body::CreateShape(b2ShapeDef* def)
 	s->m_body = this;
 
 	// Add the shape to the world's broad-phase.
-	s->CreateProxy(m_world->m_broadPhase, m_xf);
+	if (IsActive())
+	{
+		s->CreateProxy(m_world->m_broadPhase, m_xf);
+	}
 
 	// Compute the sweep radius for CCD.
 	s->UpdateSweepRadius(m_sweep.localCenter);
@@ -202,6 +215,8 @@ b2Shape* b2Body::CreateShape(b2ShapeDef* def)
 
 void b2Body::DestroyShape(b2Shape* s)
 {
+	m_world->BeginEdit();
+
 	b2Assert(m_world->m_lock == false);
 	if (m_world->m_lock == true)
 	{
@@ -209,6 +224,13 @@ void b2Body::DestroyShape(b2Shape* s)
 	}
 
 	b2Assert(s->GetBody() == this);
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordShape(e_recordDestroyShape, s);
+	}
+
 	s->DestroyProxy(m_world->m_broadPhase);
 
 	b2Assert(m_shapeCount > 0);
@@ -240,12 +262,20 @@ void b2Body::DestroyShape(b2Shape* s)
 // TODO_ERIN adjust linear velocity and torque to account for movement of center.
 void b2Body::SetMass(const b2MassData* massData)
 {
+	m_world->BeginEdit();
+
 	b2Assert(m_world->m_lock == false);
 	if (m_world->m_lock == true)
 	{
 		return;
 	}
 
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordSetMass(this, massData);
+	}
+
 	m_invMass = 0.0f;
 	m_I = 0.0f;
 	m_invI = 0.0f;
@@ -290,6 +320,16 @@ void b2Body::SetMass(const b2MassData* massData)
 	// If the body type changed, we need to refilter the broad-phase proxies.
 	if (oldType != m_type)
 	{
+		// Only active non-static bodies belong to islands.
+		if (m_type == e_staticType)
+		{
+			m_world->m_islandManager.RemoveBody(this);
+		}
+		else if (IsActive())
+		{
+			m_world->m_islandManager.AddBody(this);
+		}
+
 		for (b2Shape* s = m_shapeList; s; s = s->m_next)
 		{
 			s->RefilterProxy(m_world->m_broadPhase, m_xf);
@@ -300,12 +340,20 @@ void b2Body::SetMass(const b2MassData* massData)
 // TODO_ERIN adjust linear velocity and torque to account for movement of center.
 void b2Body::SetMassFromShapes()
 {
+	m_world->BeginEdit();
+
 	b2Assert(m_world->m_lock == false);
 	if (m_world->m_lock == true)
 	{
 		return;
 	}
 
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBody(e_recordSetMassFromShapes, this);
+	}
+
 	// Compute mass data from shapes. Each shape has its own density.
 	m_mass = 0.0f;
 	m_invMass = 0.0f;
@@ -365,6 +413,16 @@ void b2Body::SetMassFromShapes()
 	// If the body type changed, we need to refilter the broad-phase proxies.
 	if (oldType != m_type)
 	{
+		// Only active non-static bodies belong to islands.
+		if (m_type == e_staticType)
+		{
+			m_world->m_islandManager.RemoveBody(this);
+		}
+		else if (IsActive())
+		{
+			m_world->m_islandManager.AddBody(this);
+		}
+
 		for (b2Shape* s = m_shapeList; s; s = s->m_next)
 		{
 			s->RefilterProxy(m_world->m_broadPhase, m_xf);
@@ -372,25 +430,335 @@ void b2Body::SetMassFromShapes()
 	}
 }
 
+void b2Body::SetLinearVelocity(const b2Vec2& v)
+{
+	if (m_world->IsDeferring())
+	{
+		m_world->Defer(b2BodyCommand::e_setLinearVelocity, this, v, b2Vec2_zero, 0.0f);
+		return;
+	}
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBody(e_recordSetLinearVelocity, this, v);
+	}
+
+	m_linearVelocity = v;
+}
+
+void b2Body::SetAngularVelocity(float32 w)
+{
+	if (m_world->IsDeferring())
+	{
+		m_world->Defer(b2BodyCommand::e_setAngularVelocity, this, b2Vec2_zero, b2Vec2_zero, w);
+		return;
+	}
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBody(e_recordSetAngularVelocity, this, w);
+	}
+
+	m_angularVelocity = w;
+}
+
+void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point)
+{
+	if (m_world->IsDeferring())
+	{
+		m_world->Defer(b2BodyCommand::e_applyForce, this, force, point, 0.0f);
+		return;
+	}
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBody(e_recordApplyForce, this, force, point);
+	}
+
+	if (IsSleeping())
+	{
+		WakeUp();
+	}
+	m_force += force;
+	m_torque += b2Cross(point - m_sweep.c, force);
+}
+
+void b2Body::ApplyTorque(float32 torque)
+{
+	if (m_world->IsDeferring())
+	{
+		m_world->Defer(b2BodyCommand::e_applyTorque, this, b2Vec2_zero, b2Vec2_zero, torque);
+		return;
+	}
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBody(e_recordApplyTorque, this, torque);
+	}
+
+	if (IsSleeping())
+	{
+		WakeUp();
+	}
+	m_torque += torque;
+}
+
+void b2Body::ApplyImpulse(const b2Vec2& impulse, const b2Vec2& point)
+{
+	if (m_world->IsDeferring())
+	{
+		m_world->Defer(b2BodyCommand::e_applyImpulse, this, impulse, point, 0.0f);
+		return;
+	}
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBody(e_recordApplyImpulse, this, impulse, point);
+	}
+
+	if (IsSleeping())
+	{
+		WakeUp();
+	}
+	m_linearVelocity += m_invMass * impulse;
+	m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
+}
+
+void b2Body::SetBullet(bool flag)
+{
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBodyFlag(e_recordSetBullet, this, flag);
+	}
+
+	if (flag)
+	{
+		m_flags |= e_bulletFlag;
+	}
+	else
+	{
+		m_flags &= ~e_bulletFlag;
+	}
+}
+
+void b2Body::AllowSleeping(bool flag)
+{
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBodyFlag(e_recordAllowSleeping, this, flag);
+	}
+
+	if (flag)
+	{
+		m_flags |= e_allowSleepFlag;
+	}
+	else
+	{
+		m_flags &= ~e_allowSleepFlag;
+		WakeUp();
+	}
+}
+
+void b2Body::PutToSleep()
+{
+	if (m_world->IsDeferring())
+	{
+		m_world->Defer(b2BodyCommand::e_putToSleep, this, b2Vec2_zero, b2Vec2_zero, 0.0f);
+		return;
+	}
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBody(e_recordPutToSleep, this);
+	}
+
+	m_flags |= e_sleepFlag;
+	m_sleepTime = 0.0f;
+	m_linearVelocity.SetZero();
+	m_angularVelocity = 0.0f;
+	m_force.SetZero();
+	m_torque = 0.0f;
+}
+
+void b2Body::WakeUp()
+{
+	if (m_world->IsDeferring())
+	{
+		m_world->Defer(b2BodyCommand::e_wakeUp, this, b2Vec2_zero, b2Vec2_zero, 0.0f);
+		return;
+	}
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBody(e_recordWakeUp, this);
+	}
+
+	m_flags &= ~e_sleepFlag;
+	m_sleepTime = 0.0f;
+
+	// The whole island is simulated again.
+	if (m_island)
+	{
+		m_world->m_islandManager.WakeIsland(m_island);
+	}
+}
+
+void b2Body::SetActive(bool flag)
+{
+	m_world->BeginEdit();
+
+	b2Assert(m_world->m_lock == false);
+	if (m_world->m_lock == true)
+	{
+		return;
+	}
+
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBodyFlag(e_recordSetActive, this, flag);
+	}
+
+	if (flag == IsActive())
+	{
+		return;
+	}
+
+	b2IslandManager& islandManager = m_world->m_islandManager;
+
+	if (flag)
+	{
+		m_flags &= ~e_inactiveFlag;
+
+		// Inactive bodies can be moved anywhere, so check that the shapes fit
+		// in the world before rejoining the broad-phase.
+		for (b2Shape* s = m_shapeList; s; s = s->m_next)
+		{
+			b2AABB aabb;
+			s->ComputeAABB(&aabb, m_xf);
+			if (m_world->m_broadPhase->InRange(aabb) == false)
+			{
+				// Freeze it as if it had left the world during a step, without
+				// proxies and outside the islands.
+				m_flags |= e_frozenFlag;
+				m_linearVelocity.SetZero();
+				m_angularVelocity = 0.0f;
+
+				if (m_world->m_boundaryListener)
+				{
+					m_world->m_boundaryListener->Violation(this);
+				}
+
+				return;
+			}
+		}
+
+		m_flags &= ~e_frozenFlag;
+
+		// Rejoin the broad-phase. Contacts are created on the next step.
+		for (b2Shape* s = m_shapeList; s; s = s->m_next)
+		{
+			s->CreateProxy(m_world->m_broadPhase, m_xf);
+		}
+
+		// Adding the body to an island picks up its joints.
+		if (IsStatic())
+		{
+			for (b2JointEdge* jn = m_jointList; jn; jn = jn->next)
+			{
+				if (jn->joint->m_island == NULL)
+				{
+					islandManager.LinkJoint(jn->joint);
+				}
+			}
+		}
+		else
+		{
+			islandManager.AddBody(this);
+		}
+	}
+	else
+	{
+		m_flags |= e_inactiveFlag;
+
+		// Stop solving the joints. Removing the body from its island doesn't
+		// relink them now that it is inactive.
+		if (m_island)
+		{
+			islandManager.RemoveBody(this);
+		}
+		else
+		{
+			for (b2JointEdge* jn = m_jointList; jn; jn = jn->next)
+			{
+				if (jn->joint->m_island)
+				{
+					islandManager.UnlinkJoint(jn->joint);
+				}
+			}
+		}
+
+		// Leaving the broad-phase destroys the contacts.
+		for (b2Shape* s = m_shapeList; s; s = s->m_next)
+		{
+			s->DestroyProxy(m_world->m_broadPhase);
+		}
+	}
+}
+
 bool b2Body::SetXForm(const b2Vec2& position, float32 angle)
 {
+	if (m_world->IsDeferring())
+	{
+		m_world->Defer(b2BodyCommand::e_setXForm, this, position, b2Vec2_zero, angle);
+		return true;
+	}
+
 	b2Assert(m_world->m_lock == false);
 	if (m_world->m_lock == true)
 	{
 		return true;
 	}
 
-	if (IsFrozen())
+	b2RecordScope scope(m_world);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordSetXForm(this, position, angle);
+	}
+
+	// Inactive bodies can be moved anywhere, they are thawed when activated.
+	if (IsFrozen() && IsActive())
 	{
 		return false;
 	}
 
+	m_world->m_snapshotDirty = true;
+
 	m_xf.R.Set(angle);
 	m_xf.position = position;
 
 	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
 	m_sweep.a0 = m_sweep.a = angle;
 
+	// Don't interpolate across a teleport.
+	m_position0 = position;
+	m_angle0 = angle;
+
+	// Inactive bodies have no proxies to move.
+	if (IsActive() == false)
+	{
+		return true;
+	}
+
 	bool freeze = false;
 	for (b2Shape* s = m_shapeList; s; s = s->m_next)
 	{
@@ -422,6 +790,12 @@ bool b2Body::SetXForm(const b2Vec2& position, float32 angle)
 	return true;
 }
 
+bool b2Body::IsReadable() const
+{
+	// The stepping thread itself and every thread between steps may read.
+	return m_world->IsDeferring() == false;
+}
+
 bool b2Body::SynchronizeShapes()
 {
 	b2XForm xf1;
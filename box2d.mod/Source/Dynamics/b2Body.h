@@ -23,6 +23,7 @@
 #include "../Collision/Shapes/b2Shape.h"
 #include "Joints/b2Joint.h"
 #include "Controllers/b2Controller.h"
+#include "b2IslandManager.h"
 
 #include <memory>
 
@@ -53,6 +54,7 @@ struct b2BodyDef
 		isSleeping = false;
 		fixedRotation = false;
 		isBullet = false;
+		isActive = true;
 	}
 
 	/// You can use this to initialized the mass properties of the body.
@@ -95,6 +97,9 @@ struct b2BodyDef
 	/// static bodies.
 	/// @warning You should use this flag sparingly since it increases processing time.
 	bool isBullet;
+
+	/// Does this body start out active?
+	bool isActive;
 };
 
 /// A rigid body.
@@ -130,7 +135,8 @@ public:
 	/// the center of mass).
 	/// @param angle the new world rotation angle of the body in radians.
 	/// @return false if the movement put a shape outside the world. In this case the
-	/// body is automatically frozen.
+	/// body is automatically frozen. While b2World::StepAsync is in progress the change
+	/// is queued and this returns true.
 	bool SetXForm(const b2Vec2& position, float32 angle);
 
 	/// Get the body transform for the body's origin.
@@ -243,6 +249,19 @@ public:
 	/// Is this body sleeping (not simulating).
 	bool IsSleeping() const;
 
+	/// Set the active state of the body. An inactive body is not simulated and
+	/// cannot be collided with: its shapes leave the broad-phase and its contacts
+	/// are destroyed, but its shapes, mass and joints are kept. Joints attached
+	/// to an inactive body are not solved. Activating a frozen body thaws it,
+	/// unless its shapes are outside the world, in which case it is frozen and
+	/// the boundary listener is told.
+	/// Use this to keep pooled bodies in the world instead of destroying them.
+	/// @warning This function is locked during callbacks.
+	void SetActive(bool flag);
+
+	/// Is this body active?
+	bool IsActive() const;
+
 	/// You can disable sleeping on this body.
 	void AllowSleeping(bool flag);
 
@@ -278,8 +297,13 @@ private:
 
 	friend class b2World;
 	friend class b2Island;
+	friend class b2IslandManager;
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
+	friend class b2JointTreeSolver;
+	friend class b2FilterTable;
+	friend class b2WorldRecorder;
+	friend class b2WorldPlayer;
 	
 	friend class b2DistanceJoint;
 	friend class b2GearJoint;
@@ -300,6 +324,8 @@ private:
 		e_allowSleepFlag	= 0x0010,
 		e_bulletFlag		= 0x0020,
 		e_fixedRotationFlag	= 0x0040,
+		e_inactiveFlag		= 0x0080,
+		e_debugDrawFlag		= 0x0100,
 	};
 
 	// m_type
@@ -317,12 +343,17 @@ private:
 
 	void SynchronizeTransform();
 
+	// Reading the pose or velocity races with a step started by b2World::StepAsync.
+	bool IsReadable() const;
+
 	// This is used to prevent connected bodies from colliding.
 	// It may lie, depending on the collideConnected flag.
 	bool IsConnected(const b2Body* other) const;
 
 	void Advance(float32 t);
 
+	// Hot data: touched by the solver, TOI and broad-phase synchronization
+	// every step. Keep these together at the front of the body.
 	uint16 m_flags;
 	int16 m_type;
 
@@ -337,46 +368,67 @@ private:
 	b2Vec2 m_force;
 	float32 m_torque;
 
+	float32 m_invMass;
+	float32 m_invI;
+
+	float32 m_linearDamping;
+	float32 m_angularDamping;
+
+	float32 m_sleepTime;
+
+	// The persistent island this body belongs to. NULL for static bodies.
+	b2PersistentIsland* m_island;
+	b2Body* m_islandPrev;
+	b2Body* m_islandNext;
+
+	b2Shape* m_shapeList;
+	b2ContactEdge* m_contactList;
+	b2JointEdge* m_jointList;
+
+	// Cold data: only used when the world is edited or queried.
 	b2World* m_world;
+
+	// Unique for the lifetime of the world, used to key the filter table and to
+	// record the world.
+	uint32 m_id;
 	b2Body* m_prev;
 	b2Body* m_next;
 
-	b2Shape* m_shapeList;
 	int32 m_shapeCount;
 
-	b2JointEdge* m_jointList;
-	b2ContactEdge* m_contactList;
-
 	b2ControllerEdge* m_controllerList;
 
-	float32 m_mass, m_invMass;
-	float32 m_I, m_invI;
-
-	float32 m_linearDamping;
-	float32 m_angularDamping;
+	float32 m_mass;
+	float32 m_I;
 
-	float32 m_sleepTime;
+	// The origin pose at the start of the last step taken by b2World::Advance.
+	b2Vec2 m_position0;
+	float32 m_angle0;
 
 	void* m_userData;
 };
 
 inline const b2XForm& b2Body::GetXForm() const
 {
+	b2Assert(IsReadable());
 	return m_xf;
 }
 
 inline const b2Vec2& b2Body::GetPosition() const
 {
+	b2Assert(IsReadable());
 	return m_xf.position;
 }
 
 inline float32 b2Body::GetAngle() const
 {
+	b2Assert(IsReadable());
 	return m_sweep.a;
 }
 
 inline const b2Vec2& b2Body::GetWorldCenter() const
 {
+	b2Assert(IsReadable());
 	return m_sweep.c;
 }
 
@@ -385,23 +437,15 @@ inline const b2Vec2& b2Body::GetLocalCenter() const
 	return m_sweep.localCenter;
 }
 
-inline void b2Body::SetLinearVelocity(const b2Vec2& v)
-{
-	m_linearVelocity = v;
-}
-
 inline b2Vec2 b2Body::GetLinearVelocity() const
 {
+	b2Assert(IsReadable());
 	return m_linearVelocity;
 }
 
-inline void b2Body::SetAngularVelocity(float32 w)
-{
-	m_angularVelocity = w;
-}
-
 inline float32 b2Body::GetAngularVelocity() const
 {
+	b2Assert(IsReadable());
 	return m_angularVelocity;
 }
 
@@ -417,26 +461,31 @@ inline float32 b2Body::GetInertia() const
 
 inline b2Vec2 b2Body::GetWorldPoint(const b2Vec2& localPoint) const
 {
+	b2Assert(IsReadable());
 	return b2Mul(m_xf, localPoint);
 }
 
 inline b2Vec2 b2Body::GetWorldVector(const b2Vec2& localVector) const
 {
+	b2Assert(IsReadable());
 	return b2Mul(m_xf.R, localVector);
 }
 
 inline b2Vec2 b2Body::GetLocalPoint(const b2Vec2& worldPoint) const
 {
+	b2Assert(IsReadable());
 	return b2MulT(m_xf, worldPoint);
 }
 
 inline b2Vec2 b2Body::GetLocalVector(const b2Vec2& worldVector) const
 {
+	b2Assert(IsReadable());
 	return b2MulT(m_xf.R, worldVector);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromWorldPoint(const b2Vec2& worldPoint) const
 {
+	b2Assert(IsReadable());
 	return m_linearVelocity + b2Cross(m_angularVelocity, worldPoint - m_sweep.c);
 }
 
@@ -450,18 +499,6 @@ inline bool b2Body::IsBullet() const
 	return (m_flags & e_bulletFlag) == e_bulletFlag;
 }
 
-inline void b2Body::SetBullet(bool flag)
-{
-	if (flag)
-	{
-		m_flags |= e_bulletFlag;
-	}
-	else
-	{
-		m_flags &= ~e_bulletFlag;
-	}
-}
-
 inline bool b2Body::IsStatic() const
 {
 	return m_type == e_staticType;
@@ -482,33 +519,9 @@ inline bool b2Body::IsSleeping() const
 	return (m_flags & e_sleepFlag) == e_sleepFlag;
 }
 
-inline void b2Body::AllowSleeping(bool flag)
-{
-	if (flag)
-	{
-		m_flags |= e_allowSleepFlag;
-	}
-	else
-	{
-		m_flags &= ~e_allowSleepFlag;
-		WakeUp();
-	}
-}
-
-inline void b2Body::WakeUp()
-{
-	m_flags &= ~e_sleepFlag;
-	m_sleepTime = 0.0f;
-}
-
-inline void b2Body::PutToSleep()
+inline bool b2Body::IsActive() const
 {
-	m_flags |= e_sleepFlag;
-	m_sleepTime = 0.0f;
-	m_linearVelocity.SetZero();
-	m_angularVelocity = 0.0f;
-	m_force.SetZero();
-	m_torque = 0.0f;
+	return (m_flags & e_inactiveFlag) == 0;
 }
 
 inline b2Shape* b2Body::GetShapeList()
@@ -552,35 +565,6 @@ inline bool b2Body::IsConnected(const b2Body* other) const
 	return false;
 }
 
-inline void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point)
-{
-	if (IsSleeping())
-	{
-		WakeUp();
-	}
-	m_force += force;
-	m_torque += b2Cross(point - m_sweep.c, force);
-}
-
-inline void b2Body::ApplyTorque(float32 torque)
-{
-	if (IsSleeping())
-	{
-		WakeUp();
-	}
-	m_torque += torque;
-}
-
-inline void b2Body::ApplyImpulse(const b2Vec2& impulse, const b2Vec2& point)
-{
-	if (IsSleeping())
-	{
-		WakeUp();
-	}
-	m_linearVelocity += m_invMass * impulse;
-	m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
-}
-
 inline void b2Body::SynchronizeTransform()
 {
 	m_xf.R.Set(m_sweep.a);
@@ -19,6 +19,31 @@
 #include "b2ContactManager.h"
 #include "b2World.h"
 #include "b2Body.h"
+#include "Contacts/b2SensorPair.h"
+
+#include <cstring>
+
+const int32 b2_contactArrayIncrement = 128;
+
+b2ContactManager::b2ContactManager()
+{
+	m_world = NULL;
+	m_destroyImmediate = false;
+
+	m_contactCapacity = b2_contactArrayIncrement;
+	m_contacts = (b2Contact**)b2Alloc(m_contactCapacity * sizeof(b2Contact*));
+	m_awakeContactCount = 0;
+
+	m_sensorPairCapacity = b2_contactArrayIncrement;
+	m_sensorPairs = (b2SensorPair**)b2Alloc(m_sensorPairCapacity * sizeof(b2SensorPair*));
+	m_sensorPairCount = 0;
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	b2Free(m_contacts);
+	b2Free(m_sensorPairs);
+}
 
 // This is a callback from the broadphase when two AABB proxies begin
 // to overlap. We create a b2Contact to manage the narrow phase.
@@ -40,6 +65,12 @@ void* b2ContactManager::PairAdded(void* proxyUserData1, void* proxyUserData2)
 		return &m_nullContact;
 	}
 
+	// The filter table is cheap and native, so try it before anything else.
+	if (m_world->m_filterTable.ShouldCollide(shape1, shape2) == false)
+	{
+		return &m_nullContact;
+	}
+
 	if (body2->IsConnected(body1))
 	{
 		return &m_nullContact;
@@ -50,6 +81,25 @@ void* b2ContactManager::PairAdded(void* proxyUserData1, void* proxyUserData2)
 		return &m_nullContact;
 	}
 
+	// Sensors only track overlap.
+	if (shape1->IsSensor() || shape2->IsSensor())
+	{
+		b2SensorPair* pair = b2SensorPair::Create(shape1, shape2, &m_world->m_blockAllocator);
+
+		if (m_sensorPairCount == m_sensorPairCapacity)
+		{
+			b2SensorPair** oldPairs = m_sensorPairs;
+			m_sensorPairCapacity *= 2;
+			m_sensorPairs = (b2SensorPair**)b2Alloc(m_sensorPairCapacity * sizeof(b2SensorPair*));
+			memcpy(m_sensorPairs, oldPairs, m_sensorPairCount * sizeof(b2SensorPair*));
+			b2Free(oldPairs);
+		}
+
+		pair->m_index = m_sensorPairCount;
+		m_sensorPairs[m_sensorPairCount++] = pair;
+		return pair;
+	}
+
 	// Call the factory.
 	b2Contact* c = b2Contact::Create(shape1, shape2, &m_world->m_blockAllocator);
 
@@ -73,6 +123,20 @@ void* b2ContactManager::PairAdded(void* proxyUserData1, void* proxyUserData2)
 	}
 	m_world->m_contactList = c;
 
+	// Append to the dense array.
+	if (m_world->m_contactCount == m_contactCapacity)
+	{
+		b2Contact** oldContacts = m_contacts;
+		m_contactCapacity *= 2;
+		m_contacts = (b2Contact**)b2Alloc(m_contactCapacity * sizeof(b2Contact*));
+		memcpy(m_contacts, oldContacts, m_world->m_contactCount * sizeof(b2Contact*));
+		b2Free(oldContacts);
+	}
+
+	// New contacts start in the sleeping set.
+	c->m_index = m_world->m_contactCount;
+	m_contacts[c->m_index] = c;
+
 	// Connect to island graph.
 
 	// Connect to body 1
@@ -100,6 +164,14 @@ void* b2ContactManager::PairAdded(void* proxyUserData1, void* proxyUserData2)
 	body2->m_contactList = &c->m_node2;
 
 	++m_world->m_contactCount;
+
+	b2PersistentIsland* island1 = body1->m_island;
+	b2PersistentIsland* island2 = body2->m_island;
+	if ((island1 && island1->awake) || (island2 && island2->awake))
+	{
+		SetAwake(c, true);
+	}
+
 	return c;
 }
 
@@ -107,20 +179,27 @@ void* b2ContactManager::PairAdded(void* proxyUserData1, void* proxyUserData2)
 // to overlap. We retire the b2Contact.
 void b2ContactManager::PairRemoved(void* proxyUserData1, void* proxyUserData2, void* pairUserData)
 {
-	B2_NOT_USED(proxyUserData1);
-	B2_NOT_USED(proxyUserData2);
-
 	if (pairUserData == NULL)
 	{
 		return;
 	}
 
-	b2Contact* c = (b2Contact*)pairUserData;
-	if (c == &m_nullContact)
+	if (pairUserData == &m_nullContact)
+	{
+		return;
+	}
+
+	// Sensor flags never change, so the shapes tell us what the pair holds.
+	b2Shape* shape1 = (b2Shape*)proxyUserData1;
+	b2Shape* shape2 = (b2Shape*)proxyUserData2;
+	if (shape1->IsSensor() || shape2->IsSensor())
 	{
+		Destroy((b2SensorPair*)pairUserData);
 		return;
 	}
 
+	b2Contact* c = (b2Contact*)pairUserData;
+
 	// An attached body is being destroyed, we must destroy this contact
 	// immediately to avoid orphaned shape pointers.
 	Destroy(c);
@@ -180,6 +259,13 @@ void b2ContactManager::Destroy(b2Contact* c)
 		m_world->m_contactList = c->m_next;
 	}
 
+	// Swap-remove from the dense array.
+	SetAwake(c, false);
+	b2Assert(m_contacts[c->m_index] == c);
+	b2Contact* last = m_contacts[m_world->m_contactCount - 1];
+	m_contacts[c->m_index] = last;
+	last->m_index = c->m_index;
+
 	// Remove from body 1
 	if (c->m_node1.prev)
 	{
@@ -212,19 +298,48 @@ void b2ContactManager::Destroy(b2Contact* c)
 		body2->m_contactList = c->m_node2.next;
 	}
 
+	// Remove from the island graph.
+	if (c->m_island)
+	{
+		m_world->m_islandManager.UnlinkContact(c);
+	}
+
 	// Call the factory.
 	b2Contact::Destroy(c, &m_world->m_blockAllocator);
 	--m_world->m_contactCount;
 }
 
+void b2ContactManager::Destroy(b2SensorPair* pair)
+{
+	// Inform the user that this overlap is ending.
+	if (pair->IsTouching())
+	{
+		pair->SetTouching(false);
+		if (m_world->m_sensorListener)
+		{
+			m_world->m_sensorListener->EndOverlap(pair->GetShape1(), pair->GetShape2());
+		}
+	}
+
+	// Swap-remove from the dense array.
+	b2Assert(m_sensorPairs[pair->m_index] == pair);
+	b2SensorPair* last = m_sensorPairs[m_sensorPairCount - 1];
+	m_sensorPairs[pair->m_index] = last;
+	last->m_index = pair->m_index;
+	--m_sensorPairCount;
+
+	b2SensorPair::Destroy(pair, &m_world->m_blockAllocator);
+}
+
 // This is the top level collision call for the time step. Here
 // all the narrow phase collision is processed for the world
 // contact list.
 void b2ContactManager::Collide()
 {
 	// Update awake contacts.
-	for (b2Contact* c = m_world->m_contactList; c; c = c->GetNext())
+	for (int32 i = 0; i < m_awakeContactCount; ++i)
 	{
+		b2Contact* c = m_contacts[i];
 		b2Body* body1 = c->GetShape1()->GetBody();
 		b2Body* body2 = c->GetShape2()->GetBody();
 		if (body1->IsSleeping() && body2->IsSleeping())
@@ -234,4 +349,51 @@ void b2ContactManager::Collide()
 
 		c->Update(m_world->m_contactListener);
 	}
+
+	// Test sensor overlaps. Resting pairs keep their state.
+	for (int32 i = 0; i < m_sensorPairCount; ++i)
+	{
+		b2SensorPair* pair = m_sensorPairs[i];
+		b2Body* body1 = pair->GetShape1()->GetBody();
+		b2Body* body2 = pair->GetShape2()->GetBody();
+		bool resting1 = body1->IsStatic() || body1->IsSleeping();
+		bool resting2 = body2->IsStatic() || body2->IsSleeping();
+		if (resting1 && resting2 && (pair->m_flags & b2SensorPair::e_dirtyFlag) == 0)
+		{
+			continue;
+		}
+
+		pair->Update(m_world->m_sensorListener);
+	}
+}
+
+void b2ContactManager::SetAwake(b2Contact* c, bool flag)
+{
+	int32 index = c->m_index;
+	if (flag == (index < m_awakeContactCount))
+	{
+		return;
+	}
+
+	// Swap with the first sleeping or the last awake contact.
+	int32 swapIndex;
+	if (flag)
+	{
+		swapIndex = m_awakeContactCount;
+		++m_awakeContactCount;
+	}
+	else
+	{
+		--m_awakeContactCount;
+		swapIndex = m_awakeContactCount;
+
+		// SolveTOI only resets awake contacts. Don't let stale flags survive.
+		c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+	}
+
+	b2Contact* other = m_contacts[swapIndex];
+	m_contacts[index] = other;
+	other->m_index = index;
+	m_contacts[swapIndex] = c;
+	c->m_index = swapIndex;
 }
@@ -24,13 +24,15 @@
 
 class b2World;
 class b2Contact;
+class b2SensorPair;
 struct b2TimeStep;
 
 // Delegate of b2World.
 class b2ContactManager : public b2PairCallback
 {
 public:
-	b2ContactManager() : m_world(NULL), m_destroyImmediate(false) {}
+	b2ContactManager();
+	~b2ContactManager();
 
 	// Implements PairCallback
 	void* PairAdded(void* proxyUserData1, void* proxyUserData2);
@@ -40,10 +42,29 @@ public:
 
 	void Destroy(b2Contact* c);
 
+	void Destroy(b2SensorPair* pair);
+
 	void Collide();
 
+	// Move a contact between the awake and sleeping sets.
+	void SetAwake(b2Contact* c, bool flag);
+
 	b2World* m_world;
 
+	// Dense array of all contacts, iterated linearly by Collide and SolveTOI.
+	// Contacts store their index so they can be swap-removed. The array is
+	// partitioned: contacts in [0, m_awakeContactCount) have at least one body
+	// in an awake island, the rest are asleep and are not visited each step.
+	b2Contact** m_contacts;
+	int32 m_contactCapacity;
+	int32 m_awakeContactCount;
+
+	// Dense array of sensor pairs. These only track overlap and are updated
+	// by Collide when either body is awake.
+	b2SensorPair** m_sensorPairs;
+	int32 m_sensorPairCount;
+	int32 m_sensorPairCapacity;
+
 	// This lets us provide broadphase proxy pair user data for
 	// contacts that shouldn't exist.
 	b2NullContact m_nullContact;
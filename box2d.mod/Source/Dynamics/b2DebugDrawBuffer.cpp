@@ -0,0 +1,277 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2DebugDrawBuffer.h"
+
+#include <string.h>
+
+const int32 b2_debugDrawInitialCapacity = 256;
+const int32 b2_debugDrawMaxCircleSegments = 64;
+
+// Grow a buffer to hold at least count + extra items, keeping its contents.
+template <typename T>
+static void b2ReserveBuffer(T** buffer, int32 count, int32* capacity, int32 extra)
+{
+	if (count + extra <= *capacity)
+	{
+		return;
+	}
+
+	int32 newCapacity = b2Max(*capacity, b2_debugDrawInitialCapacity);
+	while (newCapacity < count + extra)
+	{
+		newCapacity *= 2;
+	}
+
+	T* newBuffer = (T*)b2Alloc(newCapacity * sizeof(T));
+	if (*buffer)
+	{
+		memcpy(newBuffer, *buffer, count * sizeof(T));
+		b2Free(*buffer);
+	}
+	*buffer = newBuffer;
+	*capacity = newCapacity;
+}
+
+b2DebugDrawBuffer::b2DebugDrawBuffer()
+{
+	m_lineVertices = NULL;
+	m_lineVertexCount = 0;
+	m_lineVertexCapacity = 0;
+
+	m_triangleVertices = NULL;
+	m_triangleVertexCount = 0;
+	m_triangleVertexCapacity = 0;
+
+	m_triangleIndices = NULL;
+	m_triangleIndexCount = 0;
+	m_triangleIndexCapacity = 0;
+
+	m_circles = NULL;
+	m_circleCount = 0;
+	m_circleCapacity = 0;
+
+	m_fillAlpha = 0.5f;
+	m_axisScale = 0.4f;
+	m_circleSegments = 0;
+}
+
+b2DebugDrawBuffer::~b2DebugDrawBuffer()
+{
+	if (m_lineVertices)
+	{
+		b2Free(m_lineVertices);
+	}
+
+	if (m_triangleVertices)
+	{
+		b2Free(m_triangleVertices);
+	}
+
+	if (m_triangleIndices)
+	{
+		b2Free(m_triangleIndices);
+	}
+
+	if (m_circles)
+	{
+		b2Free(m_circles);
+	}
+}
+
+void b2DebugDrawBuffer::Clear()
+{
+	m_lineVertexCount = 0;
+	m_triangleVertexCount = 0;
+	m_triangleIndexCount = 0;
+	m_circleCount = 0;
+}
+
+void b2DebugDrawBuffer::SetFillAlpha(float32 alpha)
+{
+	m_fillAlpha = b2Clamp(alpha, 0.0f, 1.0f);
+}
+
+void b2DebugDrawBuffer::SetAxisScale(float32 scale)
+{
+	m_axisScale = scale;
+}
+
+void b2DebugDrawBuffer::SetCircleSegments(int32 segments)
+{
+	b2Assert(segments == 0 || segments >= 3);
+	m_circleSegments = b2Min(segments, b2_debugDrawMaxCircleSegments);
+}
+
+uint32 b2DebugDrawBuffer::PackColor(const b2Color& color, float32 alpha) const
+{
+	uint32 r = (uint32)(b2Clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+	uint32 g = (uint32)(b2Clamp(color.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+	uint32 b = (uint32)(b2Clamp(color.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+	uint32 a = (uint32)(alpha * 255.0f + 0.5f);
+	return (a << 24) | (b << 16) | (g << 8) | r;
+}
+
+void b2DebugDrawBuffer::AddLine(const b2Vec2& p1, const b2Vec2& p2, uint32 color)
+{
+	b2ReserveBuffer(&m_lineVertices, m_lineVertexCount, &m_lineVertexCapacity, 2);
+
+	b2DebugVertex* v = m_lineVertices + m_lineVertexCount;
+	v[0].x = p1.x;
+	v[0].y = p1.y;
+	v[0].color = color;
+	v[1].x = p2.x;
+	v[1].y = p2.y;
+	v[1].color = color;
+	m_lineVertexCount += 2;
+}
+
+void b2DebugDrawBuffer::AddLoop(const b2Vec2* vertices, int32 vertexCount, uint32 color)
+{
+	b2ReserveBuffer(&m_lineVertices, m_lineVertexCount, &m_lineVertexCapacity, 2 * vertexCount);
+
+	b2DebugVertex* v = m_lineVertices + m_lineVertexCount;
+	for (int32 i = 0; i < vertexCount; ++i)
+	{
+		int32 j = i + 1 < vertexCount ? i + 1 : 0;
+		v[0].x = vertices[i].x;
+		v[0].y = vertices[i].y;
+		v[0].color = color;
+		v[1].x = vertices[j].x;
+		v[1].y = vertices[j].y;
+		v[1].color = color;
+		v += 2;
+	}
+	m_lineVertexCount += 2 * vertexCount;
+}
+
+void b2DebugDrawBuffer::AddFan(const b2Vec2* vertices, int32 vertexCount, uint32 color)
+{
+	b2ReserveBuffer(&m_triangleVertices, m_triangleVertexCount, &m_triangleVertexCapacity, vertexCount);
+	b2ReserveBuffer(&m_triangleIndices, m_triangleIndexCount, &m_triangleIndexCapacity, 3 * (vertexCount - 2));
+
+	uint32 base = (uint32)m_triangleVertexCount;
+	b2DebugVertex* v = m_triangleVertices + m_triangleVertexCount;
+	for (int32 i = 0; i < vertexCount; ++i)
+	{
+		v[i].x = vertices[i].x;
+		v[i].y = vertices[i].y;
+		v[i].color = color;
+	}
+	m_triangleVertexCount += vertexCount;
+
+	// Polygons are convex, so a fan from the first vertex covers them.
+	uint32* index = m_triangleIndices + m_triangleIndexCount;
+	for (int32 i = 1; i < vertexCount - 1; ++i)
+	{
+		index[0] = base;
+		index[1] = base + i;
+		index[2] = base + i + 1;
+		index += 3;
+	}
+	m_triangleIndexCount += 3 * (vertexCount - 2);
+}
+
+void b2DebugDrawBuffer::TessellateCircle(const b2Vec2& center, float32 radius, b2Vec2* vertices) const
+{
+	// Rotate a radius vector by a fixed increment instead of calling sin and cos per vertex.
+	float32 angle = 2.0f * b2_pi / m_circleSegments;
+	float32 c = cosf(angle);
+	float32 s = sinf(angle);
+	b2Vec2 r(radius, 0.0f);
+	for (int32 i = 0; i < m_circleSegments; ++i)
+	{
+		vertices[i] = center + r;
+		r.Set(c * r.x - s * r.y, s * r.x + c * r.y);
+	}
+}
+
+void b2DebugDrawBuffer::BeginDraw()
+{
+	Clear();
+}
+
+void b2DebugDrawBuffer::DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color)
+{
+	AddLoop(vertices, vertexCount, PackColor(color, 1.0f));
+}
+
+void b2DebugDrawBuffer::DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color)
+{
+	if (vertexCount >= 3)
+	{
+		AddFan(vertices, vertexCount, PackColor(color, m_fillAlpha));
+	}
+	AddLoop(vertices, vertexCount, PackColor(color, 1.0f));
+}
+
+void b2DebugDrawBuffer::DrawCircle(const b2Vec2& center, float32 radius, const b2Color& color)
+{
+	if (m_circleSegments > 0)
+	{
+		b2Vec2 vertices[b2_debugDrawMaxCircleSegments];
+		TessellateCircle(center, radius, vertices);
+		AddLoop(vertices, m_circleSegments, PackColor(color, 1.0f));
+		return;
+	}
+
+	b2ReserveBuffer(&m_circles, m_circleCount, &m_circleCapacity, 1);
+	b2DebugCircle* circle = m_circles + m_circleCount++;
+	circle->x = center.x;
+	circle->y = center.y;
+	circle->radius = radius;
+	circle->color = PackColor(color, 1.0f);
+	circle->fillColor = 0;
+}
+
+void b2DebugDrawBuffer::DrawSolidCircle(const b2Vec2& center, float32 radius, const b2Vec2& axis, const b2Color& color)
+{
+	uint32 outline = PackColor(color, 1.0f);
+
+	if (m_circleSegments > 0)
+	{
+		b2Vec2 vertices[b2_debugDrawMaxCircleSegments];
+		TessellateCircle(center, radius, vertices);
+		AddFan(vertices, m_circleSegments, PackColor(color, m_fillAlpha));
+		AddLoop(vertices, m_circleSegments, outline);
+	}
+	else
+	{
+		b2ReserveBuffer(&m_circles, m_circleCount, &m_circleCapacity, 1);
+		b2DebugCircle* circle = m_circles + m_circleCount++;
+		circle->x = center.x;
+		circle->y = center.y;
+		circle->radius = radius;
+		circle->color = outline;
+		circle->fillColor = PackColor(color, m_fillAlpha);
+	}
+
+	AddLine(center, center + radius * axis, outline);
+}
+
+void b2DebugDrawBuffer::DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color)
+{
+	AddLine(p1, p2, PackColor(color, 1.0f));
+}
+
+void b2DebugDrawBuffer::DrawXForm(const b2XForm& xf)
+{
+	b2Vec2 p1 = xf.position;
+	AddLine(p1, p1 + m_axisScale * xf.R.col1, PackColor(b2Color(1.0f, 0.0f, 0.0f), 1.0f));
+	AddLine(p1, p1 + m_axisScale * xf.R.col2, PackColor(b2Color(0.0f, 1.0f, 0.0f), 1.0f));
+}
@@ -0,0 +1,162 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_DEBUG_DRAW_BUFFER_H
+#define B2_DEBUG_DRAW_BUFFER_H
+
+#include "b2WorldCallbacks.h"
+#include "../Common/b2Math.h"
+
+/// A vertex of the debug draw buffers. The color is packed as 0xAABBGGRR, which
+/// is RGBA byte order on little endian machines.
+struct b2DebugVertex
+{
+	float32 x, y;
+	uint32 color;
+};
+
+/// A circle of the debug draw buffers. A fill color with zero alpha means the
+/// circle is not filled.
+struct b2DebugCircle
+{
+	float32 x, y;
+	float32 radius;
+	uint32 color;
+	uint32 fillColor;
+};
+
+/// A debug draw that records the debug data of a step into flat buffers instead
+/// of drawing it. Lines are a list of vertex pairs. Filled polygons are indexed
+/// triangles, with their outlines added to the lines. Circles are kept as circles
+/// for hosts that draw them as instances, unless circle segments are set, in which
+/// case they are tessellated into lines and triangles.
+/// The buffers are cleared when b2World starts drawing, so they hold the last step
+/// drawn. Register this with b2World::SetDebugDraw and read the buffers after the step.
+class b2DebugDrawBuffer : public b2DebugDraw
+{
+public:
+	b2DebugDrawBuffer();
+	~b2DebugDrawBuffer();
+
+	/// Empty the buffers.
+	void Clear();
+
+	/// Set the alpha of filled polygons and circles, in the range [0,1]. The default is 0.5.
+	void SetFillAlpha(float32 alpha);
+
+	/// Set the length of the axes drawn for transforms. The default is 0.4.
+	void SetAxisScale(float32 scale);
+
+	/// Set the number of segments used to tessellate circles. Zero, the default, keeps circles
+	/// in the circle buffer.
+	void SetCircleSegments(int32 segments);
+
+	/// Get the line vertices, two per line.
+	const b2DebugVertex* GetLineVertices() const;
+	int32 GetLineVertexCount() const;
+
+	/// Get the triangle vertices.
+	const b2DebugVertex* GetTriangleVertices() const;
+	int32 GetTriangleVertexCount() const;
+
+	/// Get the triangle indices, three per triangle.
+	const uint32* GetTriangleIndices() const;
+	int32 GetTriangleIndexCount() const;
+
+	/// Get the circles.
+	const b2DebugCircle* GetCircles() const;
+	int32 GetCircleCount() const;
+
+	void BeginDraw();
+	void DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color);
+	void DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color);
+	void DrawCircle(const b2Vec2& center, float32 radius, const b2Color& color);
+	void DrawSolidCircle(const b2Vec2& center, float32 radius, const b2Vec2& axis, const b2Color& color);
+	void DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color);
+	void DrawXForm(const b2XForm& xf);
+
+private:
+
+	uint32 PackColor(const b2Color& color, float32 alpha) const;
+	void AddLine(const b2Vec2& p1, const b2Vec2& p2, uint32 color);
+	void AddLoop(const b2Vec2* vertices, int32 vertexCount, uint32 color);
+	void AddFan(const b2Vec2* vertices, int32 vertexCount, uint32 color);
+	void TessellateCircle(const b2Vec2& center, float32 radius, b2Vec2* vertices) const;
+
+	b2DebugVertex* m_lineVertices;
+	int32 m_lineVertexCount;
+	int32 m_lineVertexCapacity;
+
+	b2DebugVertex* m_triangleVertices;
+	int32 m_triangleVertexCount;
+	int32 m_triangleVertexCapacity;
+
+	uint32* m_triangleIndices;
+	int32 m_triangleIndexCount;
+	int32 m_triangleIndexCapacity;
+
+	b2DebugCircle* m_circles;
+	int32 m_circleCount;
+	int32 m_circleCapacity;
+
+	float32 m_fillAlpha;
+	float32 m_axisScale;
+	int32 m_circleSegments;
+};
+
+inline const b2DebugVertex* b2DebugDrawBuffer::GetLineVertices() const
+{
+	return m_lineVertices;
+}
+
+inline int32 b2DebugDrawBuffer::GetLineVertexCount() const
+{
+	return m_lineVertexCount;
+}
+
+inline const b2DebugVertex* b2DebugDrawBuffer::GetTriangleVertices() const
+{
+	return m_triangleVertices;
+}
+
+inline int32 b2DebugDrawBuffer::GetTriangleVertexCount() const
+{
+	return m_triangleVertexCount;
+}
+
+inline const uint32* b2DebugDrawBuffer::GetTriangleIndices() const
+{
+	return m_triangleIndices;
+}
+
+inline int32 b2DebugDrawBuffer::GetTriangleIndexCount() const
+{
+	return m_triangleIndexCount;
+}
+
+inline const b2DebugCircle* b2DebugDrawBuffer::GetCircles() const
+{
+	return m_circles;
+}
+
+inline int32 b2DebugDrawBuffer::GetCircleCount() const
+{
+	return m_circleCount;
+}
+
+#endif
@@ -0,0 +1,275 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2FilterTable.h"
+#include "b2Body.h"
+#include "../Collision/Shapes/b2Shape.h"
+
+#include <cstring>
+
+const int32 b2_filterPairInitialCapacity = 16;
+
+// Ids start at one, so a zero id marks an empty slot.
+static inline uint32 b2HashBodyPair(uint32 id1, uint32 id2)
+{
+	uint32 h = id1 * 0x9E3779B1u;
+	h ^= id2 + 0x7F4A7C15u + (h << 6) + (h >> 2);
+	h ^= h >> 15;
+	return h;
+}
+
+b2FilterTable::b2FilterTable()
+{
+	for (int32 i = 0; i < b2_categoryCount; ++i)
+	{
+		m_categoryMasks[i] = 0xFFFF;
+	}
+
+	for (int32 i = 0; i < b2_rayLayerCount; ++i)
+	{
+		m_rayMasks[i] = 0xFFFF;
+	}
+
+	m_categoryRules = false;
+
+	m_pairs = NULL;
+	m_pairCapacity = 0;
+	m_pairCount = 0;
+}
+
+b2FilterTable::~b2FilterTable()
+{
+	if (m_pairs)
+	{
+		b2Free(m_pairs);
+	}
+}
+
+void b2FilterTable::SetCategoryCollision(int32 category1, int32 category2, bool flag)
+{
+	b2Assert(0 <= category1 && category1 < b2_categoryCount);
+	b2Assert(0 <= category2 && category2 < b2_categoryCount);
+
+	if (flag)
+	{
+		m_categoryMasks[category1] |= (uint16)(1 << category2);
+		m_categoryMasks[category2] |= (uint16)(1 << category1);
+	}
+	else
+	{
+		m_categoryMasks[category1] &= (uint16)~(1 << category2);
+		m_categoryMasks[category2] &= (uint16)~(1 << category1);
+	}
+
+	m_categoryRules = false;
+	for (int32 i = 0; i < b2_categoryCount; ++i)
+	{
+		if (m_categoryMasks[i] != 0xFFFF)
+		{
+			m_categoryRules = true;
+			break;
+		}
+	}
+}
+
+bool b2FilterTable::GetCategoryCollision(int32 category1, int32 category2) const
+{
+	b2Assert(0 <= category1 && category1 < b2_categoryCount);
+	b2Assert(0 <= category2 && category2 < b2_categoryCount);
+	return (m_categoryMasks[category1] & (1 << category2)) != 0;
+}
+
+b2FilterTable::b2BodyPairKey b2FilterTable::MakeKey(const b2Body* body1, const b2Body* body2)
+{
+	b2BodyPairKey key;
+	key.id1 = b2Min(body1->m_id, body2->m_id);
+	key.id2 = b2Max(body1->m_id, body2->m_id);
+	return key;
+}
+
+int32 b2FilterTable::FindSlot(const b2BodyPairKey& key) const
+{
+	int32 mask = m_pairCapacity - 1;
+	int32 slot = b2HashBodyPair(key.id1, key.id2) & mask;
+	while (m_pairs[slot].id1 != 0)
+	{
+		if (m_pairs[slot].id1 == key.id1 && m_pairs[slot].id2 == key.id2)
+		{
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	return slot;
+}
+
+void b2FilterTable::RemoveSlot(int32 slot)
+{
+	// Shift the following entries back so probing never sees a hole.
+	int32 mask = m_pairCapacity - 1;
+	int32 hole = slot;
+	int32 i = (slot + 1) & mask;
+	while (m_pairs[i].id1 != 0)
+	{
+		int32 home = b2HashBodyPair(m_pairs[i].id1, m_pairs[i].id2) & mask;
+		if (((i - home) & mask) >= ((i - hole) & mask))
+		{
+			m_pairs[hole] = m_pairs[i];
+			hole = i;
+		}
+		i = (i + 1) & mask;
+	}
+
+	m_pairs[hole].id1 = 0;
+	m_pairs[hole].id2 = 0;
+	--m_pairCount;
+}
+
+void b2FilterTable::Grow()
+{
+	b2BodyPairKey* oldPairs = m_pairs;
+	int32 oldCapacity = m_pairCapacity;
+
+	m_pairCapacity = oldCapacity ? 2 * oldCapacity : b2_filterPairInitialCapacity;
+	m_pairs = (b2BodyPairKey*)b2Alloc(m_pairCapacity * sizeof(b2BodyPairKey));
+	memset(m_pairs, 0, m_pairCapacity * sizeof(b2BodyPairKey));
+
+	for (int32 i = 0; i < oldCapacity; ++i)
+	{
+		if (oldPairs[i].id1 != 0)
+		{
+			m_pairs[FindSlot(oldPairs[i])] = oldPairs[i];
+		}
+	}
+
+	if (oldPairs)
+	{
+		b2Free(oldPairs);
+	}
+}
+
+void b2FilterTable::SetBodyPairExcluded(const b2Body* body1, const b2Body* body2, bool flag)
+{
+	b2Assert(body1 != body2);
+
+	b2BodyPairKey key = MakeKey(body1, body2);
+
+	if (flag)
+	{
+		// Keep the load factor at or below one half.
+		if (2 * (m_pairCount + 1) > m_pairCapacity)
+		{
+			Grow();
+		}
+
+		int32 slot = FindSlot(key);
+		if (m_pairs[slot].id1 == 0)
+		{
+			m_pairs[slot] = key;
+			++m_pairCount;
+		}
+	}
+	else if (m_pairCount > 0)
+	{
+		int32 slot = FindSlot(key);
+		if (m_pairs[slot].id1 != 0)
+		{
+			RemoveSlot(slot);
+		}
+	}
+}
+
+bool b2FilterTable::IsBodyPairExcluded(const b2Body* body1, const b2Body* body2) const
+{
+	if (m_pairCount == 0)
+	{
+		return false;
+	}
+
+	int32 slot = FindSlot(MakeKey(body1, body2));
+	return m_pairs[slot].id1 != 0;
+}
+
+void b2FilterTable::ClearExcludedPairs()
+{
+	if (m_pairs)
+	{
+		memset(m_pairs, 0, m_pairCapacity * sizeof(b2BodyPairKey));
+	}
+	m_pairCount = 0;
+}
+
+void b2FilterTable::RemoveBody(const b2Body* body)
+{
+	int32 i = 0;
+	while (m_pairCount > 0 && i < m_pairCapacity)
+	{
+		if (m_pairs[i].id1 == body->m_id || m_pairs[i].id2 == body->m_id)
+		{
+			// The slot is refilled by the shift, so look at it again.
+			RemoveSlot(i);
+			continue;
+		}
+		++i;
+	}
+}
+
+void b2FilterTable::SetRayMask(int32 layer, uint16 maskBits)
+{
+	b2Assert(0 <= layer && layer < b2_rayLayerCount);
+	m_rayMasks[layer] = maskBits;
+}
+
+bool b2FilterTable::ShouldCollide(b2Shape* shape1, b2Shape* shape2) const
+{
+	if (m_categoryRules)
+	{
+		uint16 categoryBits1 = shape1->GetFilterData().categoryBits;
+		uint16 categoryBits2 = shape2->GetFilterData().categoryBits;
+
+		uint16 maskBits = 0;
+		for (int32 i = 0; i < b2_categoryCount; ++i)
+		{
+			if (categoryBits1 & (1 << i))
+			{
+				maskBits |= m_categoryMasks[i];
+			}
+		}
+
+		if ((maskBits & categoryBits2) == 0)
+		{
+			return false;
+		}
+	}
+
+	if (m_pairCount > 0)
+	{
+		if (IsBodyPairExcluded(shape1->GetBody(), shape2->GetBody()))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool b2FilterTable::RayCollide(int32 layer, const b2Shape* shape) const
+{
+	b2Assert(0 <= layer && layer < b2_rayLayerCount);
+	return (m_rayMasks[layer] & shape->GetFilterData().categoryBits) != 0;
+}
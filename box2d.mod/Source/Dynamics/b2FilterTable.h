@@ -0,0 +1,120 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_FILTER_TABLE_H
+#define B2_FILTER_TABLE_H
+
+#include "../Common/b2Settings.h"
+
+class b2Body;
+class b2Shape;
+
+/// The number of collision categories, one per bit of b2FilterData::categoryBits.
+const int32 b2_categoryCount = 16;
+
+/// The number of ray layers in a filter table.
+const int32 b2_rayLayerCount = 16;
+
+/// A filter table holds collision rules that are evaluated natively by the
+/// world, before the contact filter is called. Use it instead of a custom
+/// b2ContactFilter when the rules can be expressed as a table, so that new
+/// broad-phase pairs and ray casts never call back into user code.
+/// Every world owns one, see b2World::GetFilterTable. By default it lets
+/// everything collide.
+class b2FilterTable
+{
+public:
+	b2FilterTable();
+	~b2FilterTable();
+
+	/// Set whether two categories collide. Categories are bit indices in the range
+	/// [0, b2_categoryCount). Shapes with several category bits collide if any of
+	/// their categories collide. This is applied on top of the shape filter data.
+	void SetCategoryCollision(int32 category1, int32 category2, bool flag);
+
+	/// Do two categories collide?
+	bool GetCategoryCollision(int32 category1, int32 category2) const;
+
+	/// Stop two bodies from colliding, or let them collide again. You must call
+	/// b2World::Refilter on their shapes to correct existing contacts.
+	void SetBodyPairExcluded(const b2Body* body1, const b2Body* body2, bool flag);
+
+	/// Are two bodies excluded from colliding with each other?
+	bool IsBodyPairExcluded(const b2Body* body1, const b2Body* body2) const;
+
+	/// Get the number of excluded body pairs.
+	int32 GetExcludedPairCount() const;
+
+	/// Remove all body pair exclusions.
+	void ClearExcludedPairs();
+
+	/// Set the categories that rays cast on a layer can hit. Layers are in the range
+	/// [0, b2_rayLayerCount). Layer 0 is used by ray casts that don't specify one.
+	void SetRayMask(int32 layer, uint16 maskBits);
+
+	/// Get the categories that rays cast on a layer can hit.
+	uint16 GetRayMask(int32 layer) const;
+
+	/// Should these two shapes collide? This only applies the table.
+	bool ShouldCollide(b2Shape* shape1, b2Shape* shape2) const;
+
+	/// Can a ray cast on a layer hit this shape?
+	bool RayCollide(int32 layer, const b2Shape* shape) const;
+
+	//--------------- Internals Below -------------------
+
+	// Remove the exclusions of a body that is being destroyed.
+	void RemoveBody(const b2Body* body);
+
+private:
+
+	// Excluded pairs are kept in an open addressing hash set keyed by body ids.
+	struct b2BodyPairKey
+	{
+		uint32 id1;
+		uint32 id2;
+	};
+
+	static b2BodyPairKey MakeKey(const b2Body* body1, const b2Body* body2);
+	int32 FindSlot(const b2BodyPairKey& key) const;
+	void RemoveSlot(int32 slot);
+	void Grow();
+
+	uint16 m_categoryMasks[b2_categoryCount];
+	uint16 m_rayMasks[b2_rayLayerCount];
+
+	// True while any category pair is disabled.
+	bool m_categoryRules;
+
+	b2BodyPairKey* m_pairs;
+	int32 m_pairCapacity;
+	int32 m_pairCount;
+};
+
+inline int32 b2FilterTable::GetExcludedPairCount() const
+{
+	return m_pairCount;
+}
+
+inline uint16 b2FilterTable::GetRayMask(int32 layer) const
+{
+	b2Assert(0 <= layer && layer < b2_rayLayerCount);
+	return m_rayMasks[layer];
+}
+
+#endif
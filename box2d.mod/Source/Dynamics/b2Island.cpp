@@ -22,7 +22,9 @@
 #include "Contacts/b2Contact.h"
 #include "Contacts/b2ContactSolver.h"
 #include "Joints/b2Joint.h"
+#include "Joints/b2JointTreeSolver.h"
 #include "../Common/b2StackAllocator.h"
+#include "../Common/b2Timer.h"
 
 /*
 Position Correction Notes
@@ -177,8 +179,14 @@ b2Island::~b2Island()
 	m_allocator->Free(m_bodies);
 }
 
-void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
+void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep, b2Profile* profile)
 {
+	b2Timer timer;
+	if (profile)
+	{
+		timer.Reset();
+	}
+
 	// Integrate velocities and apply damping.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
@@ -241,28 +249,87 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 
 	b2ContactSolver contactSolver(step, m_contacts, m_contactCount, m_allocator);
 
+	// Joints solved directly are moved to the front of m_joints.
+	b2JointTreeSolver treeSolver(step, m_bodyCount, m_joints, m_jointCount, m_allocator);
+	int32 treeJointCount = treeSolver.m_jointCount;
+
 	// Initialize velocity constraints.
 	contactSolver.InitVelocityConstraints(step);
 
-	for (int32 i = 0; i < m_jointCount; ++i)
+	if (treeJointCount > 0)
+	{
+		treeSolver.InitVelocityConstraints();
+	}
+
+	for (int32 i = treeJointCount; i < m_jointCount; ++i)
 	{
 		m_joints[i]->InitVelocityConstraints(step);
 	}
 
-	// Solve velocity constraints.
+	if (profile)
+	{
+		profile->solveInit += timer.GetMilliseconds();
+		timer.Reset();
+	}
+
+	// Solve velocity constraints. If a tolerance is given, stop as soon as an iteration
+	// changes no body velocity by more than the tolerance.
+	const float32 toleranceSqr = step.velocityTolerance * step.velocityTolerance;
+	int32 velocityIterations = 0;
 	for (int32 i = 0; i < step.velocityIterations; ++i)
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
+		++velocityIterations;
+		bool checkConvergence = toleranceSqr > 0.0f && velocityIterations >= b2_minVelocityIterations;
+
+		if (checkConvergence)
+		{
+			for (int32 j = 0; j < m_bodyCount; ++j)
+			{
+				m_velocities[j].v = m_bodies[j]->m_linearVelocity;
+				m_velocities[j].w = m_bodies[j]->m_angularVelocity;
+			}
+		}
+
+		if (treeJointCount > 0)
+		{
+			treeSolver.SolveVelocityConstraints();
+		}
+
+		for (int32 j = treeJointCount; j < m_jointCount; ++j)
 		{
 			m_joints[j]->SolveVelocityConstraints(step);
 		}
 
 		contactSolver.SolveVelocityConstraints();
+
+		if (checkConvergence)
+		{
+			float32 maxDeltaSqr = 0.0f;
+			for (int32 j = 0; j < m_bodyCount; ++j)
+			{
+				b2Body* b = m_bodies[j];
+				b2Vec2 dv = b->m_linearVelocity - m_velocities[j].v;
+				float32 dw = b->m_angularVelocity - m_velocities[j].w;
+				maxDeltaSqr = b2Max(maxDeltaSqr, b2Max(b2Dot(dv, dv), dw * dw));
+			}
+
+			if (maxDeltaSqr < toleranceSqr)
+			{
+				break;
+			}
+		}
 	}
 
 	// Post-solve (store impulses for warm starting).
 	contactSolver.FinalizeVelocityConstraints();
 
+	if (profile)
+	{
+		profile->solveVelocity += timer.GetMilliseconds();
+		profile->velocityIterations += velocityIterations;
+		timer.Reset();
+	}
+
 	// Integrate positions.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
@@ -286,12 +353,20 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 	}
 
 	// Iterate over constraints.
+	int32 positionIterations = 0;
 	for (int32 i = 0; i < step.positionIterations; ++i)
 	{
+		++positionIterations;
+
 		bool contactsOkay = contactSolver.SolvePositionConstraints(b2_contactBaumgarte);
 
 		bool jointsOkay = true;
-		for (int32 i = 0; i < m_jointCount; ++i)
+		if (treeJointCount > 0)
+		{
+			jointsOkay = treeSolver.SolvePositionConstraints();
+		}
+
+		for (int32 i = treeJointCount; i < m_jointCount; ++i)
 		{
 			bool jointOkay = m_joints[i]->SolvePositionConstraints(b2_contactBaumgarte);
 			jointsOkay = jointsOkay && jointOkay;
@@ -304,6 +379,12 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 		}
 	}
 
+	if (profile)
+	{
+		profile->solvePosition += timer.GetMilliseconds();
+		profile->positionIterations += positionIterations;
+	}
+
 	Report(contactSolver.m_constraints);
 
 	if (allowSleep)
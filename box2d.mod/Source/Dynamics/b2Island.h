@@ -28,6 +28,7 @@ class b2StackAllocator;
 class b2ContactListener;
 struct b2ContactConstraint;
 struct b2TimeStep;
+struct b2Profile;
 
 struct b2Position
 {
@@ -55,7 +56,8 @@ public:
 		m_jointCount = 0;
 	}
 
-	void Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
+	// The profile may be NULL, in which case no timings are taken.
+	void Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep, b2Profile* profile);
 
 	void SolveTOI(b2TimeStep& subStep);
 
@@ -0,0 +1,714 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2IslandManager.h"
+#include "b2World.h"
+#include "b2Body.h"
+#include "Contacts/b2Contact.h"
+#include "Joints/b2Joint.h"
+#include <new>
+
+b2IslandManager::b2IslandManager()
+{
+	m_world = NULL;
+	m_awakeList = NULL;
+	m_sleepList = NULL;
+	m_islandCount = 0;
+}
+
+b2PersistentIsland* b2IslandManager::Create(bool awake)
+{
+	void* mem = m_world->m_blockAllocator.Allocate(sizeof(b2PersistentIsland));
+	b2PersistentIsland* island = (b2PersistentIsland*)mem;
+
+	island->bodyList = NULL;
+	island->bodyTail = NULL;
+	island->contactList = NULL;
+	island->contactTail = NULL;
+	island->jointList = NULL;
+	island->jointTail = NULL;
+	island->bodyCount = 0;
+	island->contactCount = 0;
+	island->jointCount = 0;
+	island->constraintRemoveCount = 0;
+	island->awake = awake;
+
+	InsertIsland(awake ? &m_awakeList : &m_sleepList, island);
+	++m_islandCount;
+
+	return island;
+}
+
+void b2IslandManager::Destroy(b2PersistentIsland* island)
+{
+	RemoveIsland(island->awake ? &m_awakeList : &m_sleepList, island);
+	--m_islandCount;
+
+	m_world->m_blockAllocator.Free(island, sizeof(b2PersistentIsland));
+}
+
+void b2IslandManager::InsertIsland(b2PersistentIsland** list, b2PersistentIsland* island)
+{
+	island->prev = NULL;
+	island->next = *list;
+	if (*list)
+	{
+		(*list)->prev = island;
+	}
+	*list = island;
+}
+
+void b2IslandManager::RemoveIsland(b2PersistentIsland** list, b2PersistentIsland* island)
+{
+	if (island->prev)
+	{
+		island->prev->next = island->next;
+	}
+
+	if (island->next)
+	{
+		island->next->prev = island->prev;
+	}
+
+	if (island == *list)
+	{
+		*list = island->next;
+	}
+
+	island->prev = NULL;
+	island->next = NULL;
+}
+
+void b2IslandManager::WakeIsland(b2PersistentIsland* island)
+{
+	if (island->awake)
+	{
+		return;
+	}
+
+	RemoveIsland(&m_sleepList, island);
+	InsertIsland(&m_awakeList, island);
+	island->awake = true;
+
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		UpdateContacts(b);
+	}
+}
+
+void b2IslandManager::SleepIsland(b2PersistentIsland* island)
+{
+	if (island->awake == false)
+	{
+		return;
+	}
+
+	RemoveIsland(&m_awakeList, island);
+	InsertIsland(&m_sleepList, island);
+	island->awake = false;
+
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		UpdateContacts(b);
+	}
+}
+
+// Contacts are awake while either body is in an awake island.
+void b2IslandManager::UpdateContacts(b2Body* body)
+{
+	for (b2ContactEdge* cn = body->m_contactList; cn; cn = cn->next)
+	{
+		b2PersistentIsland* island1 = body->m_island;
+		b2PersistentIsland* island2 = cn->other->m_island;
+		bool awake = (island1 && island1->awake) || (island2 && island2->awake);
+		m_world->m_contactManager.SetAwake(cn->contact, awake);
+	}
+}
+
+void b2IslandManager::AddBody(b2PersistentIsland* island, b2Body* body)
+{
+	body->m_island = island;
+	body->m_islandPrev = island->bodyTail;
+	body->m_islandNext = NULL;
+	if (island->bodyTail)
+	{
+		island->bodyTail->m_islandNext = body;
+	}
+	else
+	{
+		island->bodyList = body;
+	}
+	island->bodyTail = body;
+	++island->bodyCount;
+}
+
+void b2IslandManager::AddContact(b2PersistentIsland* island, b2Contact* contact)
+{
+	contact->m_island = island;
+	contact->m_islandPrev = island->contactTail;
+	contact->m_islandNext = NULL;
+	if (island->contactTail)
+	{
+		island->contactTail->m_islandNext = contact;
+	}
+	else
+	{
+		island->contactList = contact;
+	}
+	island->contactTail = contact;
+	++island->contactCount;
+}
+
+void b2IslandManager::AddJoint(b2PersistentIsland* island, b2Joint* joint)
+{
+	joint->m_island = island;
+	joint->m_islandPrev = island->jointTail;
+	joint->m_islandNext = NULL;
+	if (island->jointTail)
+	{
+		island->jointTail->m_islandNext = joint;
+	}
+	else
+	{
+		island->jointList = joint;
+	}
+	island->jointTail = joint;
+	++island->jointCount;
+}
+
+// Move the smaller island into the larger one. The cost is proportional to the
+// size of the smaller island.
+b2PersistentIsland* b2IslandManager::Merge(b2PersistentIsland* island1, b2PersistentIsland* island2)
+{
+	b2Assert(island1 != island2);
+
+	b2PersistentIsland* big = island1;
+	b2PersistentIsland* small = island2;
+	if (big->bodyCount < small->bodyCount)
+	{
+		big = island2;
+		small = island1;
+	}
+
+	// Relabel the smaller island, then splice its lists onto the larger one.
+	for (b2Body* b = small->bodyList; b; b = b->m_islandNext)
+	{
+		b->m_island = big;
+	}
+
+	for (b2Contact* c = small->contactList; c; c = c->m_islandNext)
+	{
+		c->m_island = big;
+	}
+
+	for (b2Joint* j = small->jointList; j; j = j->m_islandNext)
+	{
+		j->m_island = big;
+	}
+
+	// The bodies of the smaller island end up at the tail of the larger one.
+	b2Body* smallBodies = small->bodyList;
+	bool smallAwake = small->awake;
+
+	if (small->bodyList)
+	{
+		small->bodyList->m_islandPrev = big->bodyTail;
+		big->bodyTail->m_islandNext = small->bodyList;
+		big->bodyTail = small->bodyTail;
+		big->bodyCount += small->bodyCount;
+	}
+
+	if (small->contactList)
+	{
+		if (big->contactTail)
+		{
+			small->contactList->m_islandPrev = big->contactTail;
+			big->contactTail->m_islandNext = small->contactList;
+		}
+		else
+		{
+			big->contactList = small->contactList;
+		}
+		big->contactTail = small->contactTail;
+		big->contactCount += small->contactCount;
+	}
+
+	if (small->jointList)
+	{
+		if (big->jointTail)
+		{
+			small->jointList->m_islandPrev = big->jointTail;
+			big->jointTail->m_islandNext = small->jointList;
+		}
+		else
+		{
+			big->jointList = small->jointList;
+		}
+		big->jointTail = small->jointTail;
+		big->jointCount += small->jointCount;
+	}
+
+	big->constraintRemoveCount += small->constraintRemoveCount;
+
+	Destroy(small);
+
+	if (smallAwake)
+	{
+		WakeIsland(big);
+	}
+	else if (big->awake)
+	{
+		for (b2Body* b = smallBodies; b; b = b->m_islandNext)
+		{
+			UpdateContacts(b);
+		}
+	}
+
+	return big;
+}
+
+void b2IslandManager::AddBody(b2Body* body)
+{
+	b2Assert(body->m_island == NULL);
+	b2Assert(body->IsStatic() == false);
+
+	b2PersistentIsland* island = Create(body->IsSleeping() == false);
+	AddBody(island, body);
+
+	// Pick up constraints that already exist, for example when a static body
+	// is given mass.
+	for (b2JointEdge* jn = body->m_jointList; jn; jn = jn->next)
+	{
+		if (jn->joint->m_island)
+		{
+			if (jn->joint->m_island != body->m_island)
+			{
+				Merge(jn->joint->m_island, body->m_island);
+			}
+		}
+		else
+		{
+			LinkJoint(jn->joint);
+		}
+	}
+
+	for (b2ContactEdge* cn = body->m_contactList; cn; cn = cn->next)
+	{
+		b2Contact* c = cn->contact;
+		if (c->m_island)
+		{
+			if (c->m_island != body->m_island)
+			{
+				Merge(c->m_island, body->m_island);
+			}
+		}
+		else if (c->IsSolid() && c->GetManifoldCount() > 0)
+		{
+			LinkContact(c);
+		}
+	}
+
+	UpdateContacts(body);
+}
+
+void b2IslandManager::RemoveBody(b2Body* body)
+{
+	b2PersistentIsland* island = body->m_island;
+	if (island == NULL)
+	{
+		return;
+	}
+
+	// Detach all constraints touching this body.
+	for (b2JointEdge* jn = body->m_jointList; jn; jn = jn->next)
+	{
+		if (jn->joint->m_island)
+		{
+			UnlinkJoint(jn->joint);
+		}
+	}
+
+	for (b2ContactEdge* cn = body->m_contactList; cn; cn = cn->next)
+	{
+		if (cn->contact->m_island)
+		{
+			UnlinkContact(cn->contact);
+		}
+	}
+
+	if (body->m_islandPrev)
+	{
+		body->m_islandPrev->m_islandNext = body->m_islandNext;
+	}
+
+	if (body->m_islandNext)
+	{
+		body->m_islandNext->m_islandPrev = body->m_islandPrev;
+	}
+
+	if (body == island->bodyList)
+	{
+		island->bodyList = body->m_islandNext;
+	}
+
+	if (body == island->bodyTail)
+	{
+		island->bodyTail = body->m_islandPrev;
+	}
+
+	body->m_island = NULL;
+	body->m_islandPrev = NULL;
+	body->m_islandNext = NULL;
+
+	b2Assert(island->bodyCount > 0);
+	--island->bodyCount;
+
+	// The body may have been the only connection between other bodies.
+	++island->constraintRemoveCount;
+
+	if (island->bodyCount == 0)
+	{
+		b2Assert(island->contactCount == 0 && island->jointCount == 0);
+		Destroy(island);
+	}
+
+	// A body that became static still anchors constraints to other non-static bodies.
+	for (b2JointEdge* jn = body->m_jointList; jn; jn = jn->next)
+	{
+		LinkJoint(jn->joint);
+	}
+
+	for (b2ContactEdge* cn = body->m_contactList; cn; cn = cn->next)
+	{
+		b2Contact* c = cn->contact;
+		if (c->IsSolid() && c->GetManifoldCount() > 0)
+		{
+			LinkContact(c);
+		}
+	}
+
+	UpdateContacts(body);
+}
+
+void b2IslandManager::LinkContact(b2Contact* contact)
+{
+	b2Assert(contact->m_island == NULL);
+	b2Assert(contact->IsSolid());
+
+	b2PersistentIsland* island1 = contact->GetShape1()->GetBody()->m_island;
+	b2PersistentIsland* island2 = contact->GetShape2()->GetBody()->m_island;
+
+	b2PersistentIsland* island = island1 ? island1 : island2;
+	if (island == NULL)
+	{
+		// Both bodies are static.
+		return;
+	}
+
+	if (island1 && island2 && island1 != island2)
+	{
+		island = Merge(island1, island2);
+	}
+
+	AddContact(island, contact);
+}
+
+void b2IslandManager::UnlinkContact(b2Contact* contact)
+{
+	b2PersistentIsland* island = contact->m_island;
+	b2Assert(island != NULL);
+
+	if (contact->m_islandPrev)
+	{
+		contact->m_islandPrev->m_islandNext = contact->m_islandNext;
+	}
+
+	if (contact->m_islandNext)
+	{
+		contact->m_islandNext->m_islandPrev = contact->m_islandPrev;
+	}
+
+	if (contact == island->contactList)
+	{
+		island->contactList = contact->m_islandNext;
+	}
+
+	if (contact == island->contactTail)
+	{
+		island->contactTail = contact->m_islandPrev;
+	}
+
+	contact->m_island = NULL;
+	contact->m_islandPrev = NULL;
+	contact->m_islandNext = NULL;
+
+	b2Assert(island->contactCount > 0);
+	--island->contactCount;
+	++island->constraintRemoveCount;
+}
+
+void b2IslandManager::LinkJoint(b2Joint* joint)
+{
+	b2Assert(joint->m_island == NULL);
+
+	// Joints on inactive bodies are not solved.
+	if (joint->m_body1->IsActive() == false || joint->m_body2->IsActive() == false)
+	{
+		return;
+	}
+
+	b2PersistentIsland* island1 = joint->m_body1->m_island;
+	b2PersistentIsland* island2 = joint->m_body2->m_island;
+
+	b2PersistentIsland* island = island1 ? island1 : island2;
+	if (island == NULL)
+	{
+		// Both bodies are static.
+		return;
+	}
+
+	if (island1 && island2 && island1 != island2)
+	{
+		island = Merge(island1, island2);
+	}
+
+	AddJoint(island, joint);
+}
+
+void b2IslandManager::UnlinkJoint(b2Joint* joint)
+{
+	b2PersistentIsland* island = joint->m_island;
+	b2Assert(island != NULL);
+
+	if (joint->m_islandPrev)
+	{
+		joint->m_islandPrev->m_islandNext = joint->m_islandNext;
+	}
+
+	if (joint->m_islandNext)
+	{
+		joint->m_islandNext->m_islandPrev = joint->m_islandPrev;
+	}
+
+	if (joint == island->jointList)
+	{
+		island->jointList = joint->m_islandNext;
+	}
+
+	if (joint == island->jointTail)
+	{
+		island->jointTail = joint->m_islandPrev;
+	}
+
+	joint->m_island = NULL;
+	joint->m_islandPrev = NULL;
+	joint->m_islandNext = NULL;
+
+	b2Assert(island->jointCount > 0);
+	--island->jointCount;
+	++island->constraintRemoveCount;
+}
+
+// Perform a depth first search (DFS) on the constraint graph of a single island.
+// Only the bodies and constraints of this island are visited.
+void b2IslandManager::Split(b2PersistentIsland* island)
+{
+	b2StackAllocator* allocator = &m_world->m_stackAllocator;
+
+	int32 bodyCount = island->bodyCount;
+	b2Body** bodies = (b2Body**)allocator->Allocate(bodyCount * sizeof(b2Body*));
+	b2Body** stack = (b2Body**)allocator->Allocate(bodyCount * sizeof(b2Body*));
+
+	int32 index = 0;
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		b->m_flags &= ~b2Body::e_islandFlag;
+		bodies[index++] = b;
+	}
+	b2Assert(index == bodyCount);
+
+	for (b2Contact* c = island->contactList; c; c = c->m_islandNext)
+	{
+		c->m_flags &= ~b2Contact::e_islandFlag;
+	}
+
+	for (b2Joint* j = island->jointList; j; j = j->m_islandNext)
+	{
+		j->m_islandFlag = false;
+	}
+
+	bool awake = island->awake;
+
+	// The old island is released up front, its bodies and constraints are
+	// relinked into the new islands below.
+	Destroy(island);
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* seed = bodies[i];
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
+
+		b2PersistentIsland* newIsland = Create(awake);
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		seed->m_flags |= b2Body::e_islandFlag;
+
+		while (stackCount > 0)
+		{
+			b2Body* b = stack[--stackCount];
+			AddBody(newIsland, b);
+
+			for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
+			{
+				b2Contact* c = cn->contact;
+
+				// Skip contacts that are not part of the island graph.
+				if (c->m_island == NULL || (c->m_flags & b2Contact::e_islandFlag))
+				{
+					continue;
+				}
+
+				c->m_flags |= b2Contact::e_islandFlag;
+				AddContact(newIsland, c);
+
+				b2Body* other = cn->other;
+				if (other->IsStatic() || (other->m_flags & b2Body::e_islandFlag))
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < bodyCount);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+
+			for (b2JointEdge* jn = b->m_jointList; jn; jn = jn->next)
+			{
+				b2Joint* j = jn->joint;
+				if (j->m_island == NULL || j->m_islandFlag == true)
+				{
+					continue;
+				}
+
+				j->m_islandFlag = true;
+				AddJoint(newIsland, j);
+
+				b2Body* other = jn->other;
+				if (other->IsStatic() || (other->m_flags & b2Body::e_islandFlag))
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < bodyCount);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+		}
+	}
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		bodies[i]->m_flags &= ~b2Body::e_islandFlag;
+	}
+
+	allocator->Free(stack);
+	allocator->Free(bodies);
+}
+
+void b2IslandManager::Validate()
+{
+	int32 islandCount = 0;
+	for (int32 pass = 0; pass < 2; ++pass)
+	{
+		b2PersistentIsland* list = pass == 0 ? m_awakeList : m_sleepList;
+		for (b2PersistentIsland* island = list; island; island = island->next)
+		{
+			b2Assert(island->awake == (pass == 0));
+			b2Assert(island->bodyCount > 0);
+			++islandCount;
+
+			int32 count = 0;
+			for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+			{
+				b2Assert(b->m_island == island);
+				b2Assert(b->IsStatic() == false);
+				b2Assert(b->m_islandNext != NULL || b == island->bodyTail);
+				++count;
+			}
+			b2Assert(count == island->bodyCount);
+
+			count = 0;
+			for (b2Contact* c = island->contactList; c; c = c->m_islandNext)
+			{
+				b2Assert(c->m_island == island);
+				b2Assert(c->IsSolid() && c->GetManifoldCount() > 0);
+				b2Assert(c->m_islandNext != NULL || c == island->contactTail);
+				b2PersistentIsland* island1 = c->GetShape1()->GetBody()->m_island;
+				b2PersistentIsland* island2 = c->GetShape2()->GetBody()->m_island;
+				b2Assert(island1 == island || island2 == island);
+				b2Assert(island1 == NULL || island1 == island);
+				b2Assert(island2 == NULL || island2 == island);
+				++count;
+			}
+			b2Assert(count == island->contactCount);
+
+			count = 0;
+			for (b2Joint* j = island->jointList; j; j = j->m_islandNext)
+			{
+				b2Assert(j->m_island == island);
+				b2Assert(j->m_islandNext != NULL || j == island->jointTail);
+				b2PersistentIsland* island1 = j->m_body1->m_island;
+				b2PersistentIsland* island2 = j->m_body2->m_island;
+				b2Assert(island1 == island || island2 == island);
+				b2Assert(island1 == NULL || island1 == island);
+				b2Assert(island2 == NULL || island2 == island);
+				++count;
+			}
+			b2Assert(count == island->jointCount);
+		}
+	}
+	b2Assert(islandCount == m_islandCount);
+
+	for (b2Body* b = m_world->m_bodyList; b; b = b->m_next)
+	{
+		b2Assert((b->IsStatic() || b->IsActive() == false) == (b->m_island == NULL));
+		if (b->m_island && b->IsSleeping() == false && b->IsFrozen() == false)
+		{
+			// Awake bodies must be reachable by the solver.
+			b2Assert(b->m_island->awake);
+		}
+	}
+
+	for (b2Contact* c = m_world->m_contactList; c; c = c->m_next)
+	{
+		bool linked = c->IsSolid() && c->GetManifoldCount() > 0 &&
+			(c->GetShape1()->GetBody()->IsStatic() == false || c->GetShape2()->GetBody()->IsStatic() == false);
+		b2Assert(linked == (c->m_island != NULL));
+		B2_NOT_USED(linked);
+
+		b2PersistentIsland* island1 = c->GetShape1()->GetBody()->m_island;
+		b2PersistentIsland* island2 = c->GetShape2()->GetBody()->m_island;
+		bool awake = (island1 && island1->awake) || (island2 && island2->awake);
+		b2Assert(awake == (c->m_index < m_world->m_contactManager.m_awakeContactCount));
+		B2_NOT_USED(awake);
+	}
+}
@@ -0,0 +1,114 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ISLAND_MANAGER_H
+#define B2_ISLAND_MANAGER_H
+
+#include "../Common/b2Settings.h"
+
+class b2Body;
+class b2Contact;
+class b2Joint;
+class b2World;
+
+/// A persistent island is a set of non-static bodies connected by touching solid
+/// contacts and joints. Static bodies never belong to an island, so islands do not
+/// propagate across them. Constraints attached to a static body live in the island
+/// of the other body.
+struct b2PersistentIsland
+{
+	b2PersistentIsland* prev;
+	b2PersistentIsland* next;
+
+	// Elements are appended, so a split island keeps the depth first order.
+	b2Body* bodyList;
+	b2Body* bodyTail;
+	b2Contact* contactList;
+	b2Contact* contactTail;
+	b2Joint* jointList;
+	b2Joint* jointTail;
+
+	int32 bodyCount;
+	int32 contactCount;
+	int32 jointCount;
+
+	// The number of constraints removed since the island was built. If this is
+	// non-zero the island may have come apart and is a candidate for splitting.
+	int32 constraintRemoveCount;
+
+	// Awake islands are solved every step, sleeping islands are not visited.
+	bool awake;
+};
+
+// Delegate of b2World. Islands are merged as soon as a contact starts touching or
+// a joint is created. Removing constraints only marks the island, it is split
+// lazily once it is about to fall asleep. This avoids rebuilding every island each step.
+class b2IslandManager
+{
+public:
+	b2IslandManager();
+
+	// Create an island for a body that became non-static.
+	void AddBody(b2Body* body);
+
+	// Remove a body that is being destroyed or became static.
+	void RemoveBody(b2Body* body);
+
+	// A contact started touching.
+	void LinkContact(b2Contact* contact);
+
+	// A contact stopped touching or is being destroyed.
+	void UnlinkContact(b2Contact* contact);
+
+	void LinkJoint(b2Joint* joint);
+	void UnlinkJoint(b2Joint* joint);
+
+	// Move an island between the awake and sleeping lists. This also moves the
+	// contacts of its bodies between the awake and sleeping contact sets.
+	void WakeIsland(b2PersistentIsland* island);
+	void SleepIsland(b2PersistentIsland* island);
+
+	// Rebuild an island into its connected components. The new islands
+	// keep the awake state of the original.
+	void Split(b2PersistentIsland* island);
+
+	void Validate();
+
+	b2World* m_world;
+
+	b2PersistentIsland* m_awakeList;
+	b2PersistentIsland* m_sleepList;
+	int32 m_islandCount;
+
+private:
+	b2PersistentIsland* Create(bool awake);
+	void Destroy(b2PersistentIsland* island);
+
+	b2PersistentIsland* Merge(b2PersistentIsland* island1, b2PersistentIsland* island2);
+
+	void AddBody(b2PersistentIsland* island, b2Body* body);
+	void AddContact(b2PersistentIsland* island, b2Contact* contact);
+	void AddJoint(b2PersistentIsland* island, b2Joint* joint);
+
+	void UpdateContacts(b2Body* body);
+
+	void InsertIsland(b2PersistentIsland** list, b2PersistentIsland* island);
+	void RemoveIsland(b2PersistentIsland** list, b2PersistentIsland* island);
+};
+
+#endif
@@ -0,0 +1,1107 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2ParticleSystem.h"
+#include "b2World.h"
+#include "b2Body.h"
+#include "../Collision/b2BroadPhase.h"
+#include "../Collision/Shapes/b2CircleShape.h"
+#include "../Collision/Shapes/b2PolygonShape.h"
+#include "../Collision/Shapes/b2EdgeShape.h"
+#include "../Collision/Shapes/b2MeshShape.h"
+#include "../Collision/Shapes/b2TileGridShape.h"
+
+#include <cstring>
+
+const int32 b2_particleInitialCapacity = 256;
+const int32 b2_particleInitialContacts = 1024;
+const int32 b2_particleInitialShapes = 32;
+
+// Fluid particles start to push each other once their summed contact weights
+// exceed the minimum. The maximum keeps the pressure bounded when crushed.
+const float32 b2_particleMinWeight = 1.0f;
+const float32 b2_particleMaxWeight = 5.0f;
+
+// The fraction of the overlap between particles removed by a position iteration.
+const float32 b2_particleBaumgarte = 0.2f;
+
+// Fluid particles settle this fraction of a diameter apart before they collide.
+const float32 b2_particleFluidSpacing = 0.75f;
+
+// Grid cells are kept inside [1, 0xFFFE] so that neighbouring keys never wrap.
+const float32 b2_particleMaxCell = 65533.0f;
+
+static bool b2CollideParticleSegment(const b2Vec2& v1, const b2Vec2& v2, const b2Vec2& edgeNormal,
+									 const b2Vec2& p, float32 radius, b2Vec2* normal, float32* depth)
+{
+	b2Vec2 e = v2 - v1;
+	float32 t = b2Dot(p - v1, e);
+	float32 ee = b2Dot(e, e);
+	if (ee > 0.0f)
+	{
+		t = b2Clamp(t / ee, 0.0f, 1.0f);
+	}
+	else
+	{
+		t = 0.0f;
+	}
+
+	b2Vec2 d = p - (v1 + t * e);
+	float32 distSq = d.LengthSquared();
+	if (distSq >= radius * radius)
+	{
+		return false;
+	}
+
+	float32 dist = b2Sqrt(distSq);
+	*normal = dist > B2_FLT_EPSILON ? (1.0f / dist) * d : edgeNormal;
+	*depth = radius - dist;
+	return true;
+}
+
+static bool b2CollideParticleCircle(const b2CircleShape* circle, const b2Vec2& p, float32 radius,
+									b2Vec2* normal, float32* depth)
+{
+	b2Vec2 d = p - circle->GetLocalPosition();
+	float32 r = radius + circle->GetRadius();
+	float32 distSq = d.LengthSquared();
+	if (distSq >= r * r)
+	{
+		return false;
+	}
+
+	float32 dist = b2Sqrt(distSq);
+	*normal = dist > B2_FLT_EPSILON ? (1.0f / dist) * d : b2Vec2(0.0f, 1.0f);
+	*depth = r - dist;
+	return true;
+}
+
+static bool b2CollideParticlePolygon(const b2PolygonShape* polygon, const b2Vec2& p, float32 radius,
+									 b2Vec2* normal, float32* depth)
+{
+	int32 count = polygon->GetVertexCount();
+	const b2Vec2* vertices = polygon->GetVertices();
+	const b2Vec2* normals = polygon->GetNormals();
+
+	float32 maxSeparation = -B2_FLT_MAX;
+	int32 bestIndex = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 s = b2Dot(normals[i], p - vertices[i]);
+		if (s >= radius)
+		{
+			return false;
+		}
+
+		if (s > maxSeparation)
+		{
+			maxSeparation = s;
+			bestIndex = i;
+		}
+	}
+
+	if (maxSeparation <= 0.0f)
+	{
+		// The center is inside, leave through the nearest face.
+		*normal = normals[bestIndex];
+		*depth = radius - maxSeparation;
+		return true;
+	}
+
+	// The closest point is on one of the faces that see the center.
+	float32 minDistSq = B2_FLT_MAX;
+	b2Vec2 closest = p;
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (b2Dot(normals[i], p - vertices[i]) <= 0.0f)
+		{
+			continue;
+		}
+
+		b2Vec2 v1 = vertices[i];
+		b2Vec2 e = vertices[i + 1 < count ? i + 1 : 0] - v1;
+		float32 t = b2Clamp(b2Dot(p - v1, e) / b2Dot(e, e), 0.0f, 1.0f);
+		b2Vec2 q = v1 + t * e;
+		float32 distSq = b2DistanceSquared(p, q);
+		if (distSq < minDistSq)
+		{
+			minDistSq = distSq;
+			closest = q;
+		}
+	}
+
+	if (minDistSq >= radius * radius)
+	{
+		return false;
+	}
+
+	float32 dist = b2Sqrt(minDistSq);
+	*normal = dist > B2_FLT_EPSILON ? (1.0f / dist) * (p - closest) : normals[bestIndex];
+	*depth = radius - dist;
+	return true;
+}
+
+// Find the deepest contact between a particle and a shape. Concave shapes are
+// tested piece by piece. The point and normal are in world coordinates.
+static bool b2CollideParticle(const b2Shape* shape, const b2XForm& xf, const b2Vec2& point, float32 radius,
+							  b2Vec2* normal, float32* depth)
+{
+	b2Vec2 p = b2MulT(xf, point);
+	b2Vec2 localNormal;
+	bool hit = false;
+
+	switch (shape->GetType())
+	{
+	case e_circleShape:
+		hit = b2CollideParticleCircle((const b2CircleShape*)shape, p, radius, &localNormal, depth);
+		break;
+
+	case e_polygonShape:
+		hit = b2CollideParticlePolygon((const b2PolygonShape*)shape, p, radius, &localNormal, depth);
+		break;
+
+	case e_edgeShape:
+		{
+			const b2EdgeShape* edge = (const b2EdgeShape*)shape;
+			hit = b2CollideParticleSegment(edge->GetVertex1(), edge->GetVertex2(), edge->GetNormalVector(),
+										   p, radius, &localNormal, depth);
+		}
+		break;
+
+	case e_tileGridShape:
+		{
+			const b2TileGridShape* grid = (const b2TileGridShape*)shape;
+			b2AABB aabb;
+			aabb.lowerBound.Set(p.x - radius, p.y - radius);
+			aabb.upperBound.Set(p.x + radius, p.y + radius);
+
+			int32 lowerX, lowerY, upperX, upperY;
+			if (grid->GetCellRange(aabb, &lowerX, &lowerY, &upperX, &upperY) == false)
+			{
+				return false;
+			}
+
+			*depth = 0.0f;
+			for (int32 y = lowerY; y <= upperY; ++y)
+			{
+				for (int32 x = lowerX; x <= upperX; ++x)
+				{
+					const b2PolygonShape* polygon = grid->GetTilePolygon(grid->GetTile(x, y));
+					if (polygon == NULL)
+					{
+						continue;
+					}
+
+					b2Vec2 n;
+					float32 d;
+					if (b2CollideParticlePolygon(polygon, p - grid->GetCellOffset(x, y), radius, &n, &d) && d > *depth)
+					{
+						localNormal = n;
+						*depth = d;
+						hit = true;
+					}
+				}
+			}
+		}
+		break;
+
+	case e_meshShape:
+	case e_heightfieldShape:
+		{
+			b2AABB aabb;
+			aabb.lowerBound.Set(p.x - radius, p.y - radius);
+			aabb.upperBound.Set(p.x + radius, p.y + radius);
+
+			const int32 k_stackCount = 16;
+			int32 stackIndices[k_stackCount];
+			int32* indices = stackIndices;
+
+			int32 count = b2QueryEdges(shape, aabb, indices, k_stackCount);
+			if (count > k_stackCount)
+			{
+				indices = (int32*)b2Alloc(count * sizeof(int32));
+				b2QueryEdges(shape, aabb, indices, count);
+			}
+
+			*depth = 0.0f;
+			for (int32 i = 0; i < count; ++i)
+			{
+				const b2EdgeShape* edge = b2GetEdge(shape, indices[i]);
+
+				b2Vec2 n;
+				float32 d;
+				if (b2CollideParticleSegment(edge->GetVertex1(), edge->GetVertex2(), edge->GetNormalVector(),
+											 p, radius, &n, &d) && d > *depth)
+				{
+					localNormal = n;
+					*depth = d;
+					hit = true;
+				}
+			}
+
+			if (indices != stackIndices)
+			{
+				b2Free(indices);
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	if (hit)
+	{
+		*normal = b2Mul(xf.R, localNormal);
+	}
+
+	return hit;
+}
+
+b2ParticleSystem::b2ParticleSystem(const b2ParticleSystemDef* def, b2World* world)
+{
+	b2Assert(def->density > 0.0f);
+	b2Assert(def->maxCount >= 0);
+
+	m_world = world;
+	m_prev = NULL;
+	m_next = NULL;
+
+	m_count = 0;
+	m_capacity = 0;
+	m_maxCount = def->maxCount;
+
+	m_positions = NULL;
+	m_velocities = NULL;
+	m_radii = NULL;
+	m_flags = NULL;
+	m_lifetimes = NULL;
+	m_weights = NULL;
+	m_proxies = NULL;
+	m_proxyBuffer = NULL;
+
+	m_allFlags = 0;
+	m_gridOrigin.SetZero();
+	m_invCellSize = 0.0f;
+	m_maxRadius = 0.0f;
+
+	m_contactCapacity = b2_particleInitialContacts;
+	m_contactCount = 0;
+	m_contacts = (b2ParticleContact*)b2Alloc(m_contactCapacity * sizeof(b2ParticleContact));
+
+	m_shapeCapacity = b2_particleInitialShapes;
+	m_shapeCount = 0;
+	m_shapes = (b2ParticleShape*)b2Alloc(m_shapeCapacity * sizeof(b2ParticleShape));
+	m_shapeContactCapacity = b2_particleInitialContacts;
+	m_shapeContactCount = 0;
+	m_shapeContacts = (b2ParticleShapeContact*)b2Alloc(m_shapeContactCapacity * sizeof(b2ParticleShapeContact));
+
+	m_density = def->density;
+	m_gravityScale = def->gravityScale;
+	m_damping = def->damping;
+	m_friction = def->friction;
+	m_restitution = def->restitution;
+	m_pressureStrength = def->pressureStrength;
+	m_viscousStrength = def->viscousStrength;
+	m_filter = def->filter;
+
+	m_userData = def->userData;
+}
+
+b2ParticleSystem::~b2ParticleSystem()
+{
+	if (m_capacity > 0)
+	{
+		b2Free(m_positions);
+		b2Free(m_velocities);
+		b2Free(m_radii);
+		b2Free(m_flags);
+		b2Free(m_lifetimes);
+		b2Free(m_weights);
+		b2Free(m_proxies);
+		b2Free(m_proxyBuffer);
+	}
+
+	b2Free(m_contacts);
+	b2Free(m_shapes);
+	b2Free(m_shapeContacts);
+}
+
+template <typename T>
+static void b2ReallocateBuffer(T** buffer, int32 count, int32 capacity)
+{
+	T* newBuffer = (T*)b2Alloc(capacity * sizeof(T));
+	if (*buffer)
+	{
+		memcpy(newBuffer, *buffer, count * sizeof(T));
+		b2Free(*buffer);
+	}
+	*buffer = newBuffer;
+}
+
+void b2ParticleSystem::ReserveCapacity(int32 capacity)
+{
+	if (capacity <= m_capacity)
+	{
+		return;
+	}
+
+	b2ReallocateBuffer(&m_positions, m_count, capacity);
+	b2ReallocateBuffer(&m_velocities, m_count, capacity);
+	b2ReallocateBuffer(&m_radii, m_count, capacity);
+	b2ReallocateBuffer(&m_flags, m_count, capacity);
+	b2ReallocateBuffer(&m_lifetimes, m_count, capacity);
+
+	// Scratch buffers are rebuilt every step.
+	b2ReallocateBuffer(&m_weights, 0, capacity);
+	b2ReallocateBuffer(&m_proxies, 0, capacity);
+	b2ReallocateBuffer(&m_proxyBuffer, 0, capacity);
+
+	m_capacity = capacity;
+}
+
+int32 b2ParticleSystem::CreateParticle(const b2ParticleDef& def)
+{
+	m_world->BeginEdit();
+
+	b2Assert(m_world->m_lock == false);
+	b2Assert(def.radius > 0.0f);
+
+	if (m_maxCount > 0 && m_count == m_maxCount)
+	{
+		return -1;
+	}
+
+	if (m_count == m_capacity)
+	{
+		int32 capacity = m_capacity ? 2 * m_capacity : b2_particleInitialCapacity;
+		if (m_maxCount > 0)
+		{
+			capacity = b2Min(capacity, m_maxCount);
+		}
+		ReserveCapacity(capacity);
+	}
+
+	int32 index = m_count++;
+	m_positions[index] = def.position;
+	m_velocities[index] = def.velocity;
+	m_radii[index] = def.radius;
+	m_flags[index] = def.flags & ~e_zombieParticle;
+	m_lifetimes[index] = def.lifetime;
+	return index;
+}
+
+void b2ParticleSystem::DestroyParticle(int32 index)
+{
+	m_world->BeginEdit();
+
+	b2Assert(0 <= index && index < m_count);
+	m_flags[index] |= e_zombieParticle;
+}
+
+bool b2ParticleSystem::ShouldCollide(const b2Shape* shape) const
+{
+	if (shape->IsSensor())
+	{
+		return false;
+	}
+
+	const b2FilterData& filter = shape->GetFilterData();
+	if (filter.groupIndex == m_filter.groupIndex && filter.groupIndex != 0)
+	{
+		return filter.groupIndex > 0;
+	}
+
+	return (filter.maskBits & m_filter.categoryBits) != 0 && (filter.categoryBits & m_filter.maskBits) != 0;
+}
+
+uint32 b2ParticleSystem::ComputeKey(const b2Vec2& p) const
+{
+	float32 x = b2Clamp((p.x - m_gridOrigin.x) * m_invCellSize, 0.0f, b2_particleMaxCell);
+	float32 y = b2Clamp((p.y - m_gridOrigin.y) * m_invCellSize, 0.0f, b2_particleMaxCell);
+	return ((uint32)(y + 1.0f) << 16) | (uint32)(x + 1.0f);
+}
+
+int32 b2ParticleSystem::FindProxy(int32 first, uint32 key) const
+{
+	// The first proxy with a key not less than the given one.
+	int32 last = m_count;
+	while (first < last)
+	{
+		int32 mid = (first + last) >> 1;
+		if (m_proxies[mid].key < key)
+		{
+			first = mid + 1;
+		}
+		else
+		{
+			last = mid;
+		}
+	}
+
+	return first;
+}
+
+void b2ParticleSystem::UpdateProxies()
+{
+	// Cells are one particle diameter wide, so touching particles are in the
+	// same or neighbouring cells.
+	m_gridOrigin = m_world->m_broadPhase->m_worldAABB.lowerBound;
+	m_invCellSize = 0.5f / m_maxRadius;
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_proxies[i].key = ComputeKey(m_positions[i]);
+		m_proxies[i].index = i;
+	}
+
+	// Least significant digit radix sort, skipping digits that are all the same.
+	b2ParticleProxy* source = m_proxies;
+	b2ParticleProxy* target = m_proxyBuffer;
+	for (int32 shift = 0; shift < 32; shift += 8)
+	{
+		int32 counts[256];
+		memset(counts, 0, sizeof(counts));
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			++counts[(source[i].key >> shift) & 0xFF];
+		}
+
+		if (counts[(source[0].key >> shift) & 0xFF] == m_count)
+		{
+			continue;
+		}
+
+		int32 offset = 0;
+		for (int32 i = 0; i < 256; ++i)
+		{
+			int32 count = counts[i];
+			counts[i] = offset;
+			offset += count;
+		}
+
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			target[counts[(source[i].key >> shift) & 0xFF]++] = source[i];
+		}
+
+		b2Swap(source, target);
+	}
+
+	if (source != m_proxies)
+	{
+		m_proxies = source;
+		m_proxyBuffer = target;
+	}
+}
+
+void b2ParticleSystem::AddContact(int32 a, int32 b, float32 inv_dt)
+{
+	if ((m_flags[a] | m_flags[b]) & e_zombieParticle)
+	{
+		return;
+	}
+
+	b2Vec2 d = m_positions[b] - m_positions[a];
+	float32 r = m_radii[a] + m_radii[b];
+	float32 distSq = d.LengthSquared();
+	if (distSq >= r * r)
+	{
+		return;
+	}
+
+	if (m_contactCount == m_contactCapacity)
+	{
+		m_contactCapacity *= 2;
+		b2ReallocateBuffer(&m_contacts, m_contactCount, m_contactCapacity);
+	}
+
+	float32 dist = b2Sqrt(distSq);
+
+	b2ParticleContact* c = m_contacts + m_contactCount++;
+	c->indexA = a;
+	c->indexB = b;
+	c->weight = 1.0f - dist / r;
+	c->normal = dist > B2_FLT_EPSILON ? (1.0f / dist) * d : b2Vec2(0.0f, 1.0f);
+	c->flags = m_flags[a] & m_flags[b];
+
+	// Masses are proportional to the area, the density cancels.
+	float32 invMassA = 1.0f / (m_radii[a] * m_radii[a]);
+	float32 invMassB = 1.0f / (m_radii[b] * m_radii[b]);
+	c->shareA = invMassA / (invMassA + invMassB);
+
+	// Fluid particles may overlap up to the fluid spacing.
+	float32 separation = dist - r;
+	if (c->flags & e_fluidParticle)
+	{
+		separation = dist - b2_particleFluidSpacing * r;
+	}
+	c->velocityBias = b2_contactBaumgarte * inv_dt * b2Clamp(-separation - b2_linearSlop, 0.0f, b2_maxLinearCorrection);
+
+	c->normalImpulse = 0.0f;
+	c->tangentImpulse = 0.0f;
+}
+
+void b2ParticleSystem::UpdateContacts(const b2TimeStep& step)
+{
+	m_contactCount = 0;
+
+	// Keys are ordered by row, then column. Each cell is paired with itself, the
+	// next cell in its row and the three cells of the next row.
+	int32 nextRow = 0;
+	for (int32 a = 0; a < m_count; ++a)
+	{
+		uint32 key = m_proxies[a].key;
+		int32 indexA = m_proxies[a].index;
+
+		uint32 rightKey = key + 1;
+		for (int32 b = a + 1; b < m_count && m_proxies[b].key <= rightKey; ++b)
+		{
+			AddContact(indexA, m_proxies[b].index, step.inv_dt);
+		}
+
+		uint32 lowerKey = key + 0x10000 - 1;
+		uint32 upperKey = key + 0x10000 + 1;
+		while (nextRow < m_count && m_proxies[nextRow].key < lowerKey)
+		{
+			++nextRow;
+		}
+
+		for (int32 b = nextRow; b < m_count && m_proxies[b].key <= upperKey; ++b)
+		{
+			AddContact(indexA, m_proxies[b].index, step.inv_dt);
+		}
+	}
+}
+
+void b2ParticleSystem::SolvePressure(const b2TimeStep& step)
+{
+	// Sum the contact weights of each fluid particle.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_weights[i] = 0.0f;
+	}
+
+	for (int32 k = 0; k < m_contactCount; ++k)
+	{
+		const b2ParticleContact& c = m_contacts[k];
+		if (c.flags & e_fluidParticle)
+		{
+			m_weights[c.indexA] += c.weight;
+			m_weights[c.indexB] += c.weight;
+		}
+	}
+
+	// Turn the weights into pressures that scale with the speed needed to
+	// cross one particle diameter in a step.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		float32 w = b2Min(m_weights[i], b2_particleMaxWeight) - b2_particleMinWeight;
+		float32 criticalVelocity = 2.0f * m_radii[i] * step.inv_dt;
+		m_weights[i] = m_pressureStrength * criticalVelocity * criticalVelocity * b2Max(w, 0.0f);
+	}
+
+	for (int32 k = 0; k < m_contactCount; ++k)
+	{
+		const b2ParticleContact& c = m_contacts[k];
+		if ((c.flags & e_fluidParticle) == 0)
+		{
+			continue;
+		}
+
+		int32 a = c.indexA;
+		int32 b = c.indexB;
+		float32 diameter = m_radii[a] + m_radii[b];
+		float32 h = m_weights[a] + m_weights[b];
+		b2Vec2 f = (step.dt / (m_density * diameter) * c.weight * h) * c.normal;
+		m_velocities[a] -= f;
+		m_velocities[b] += f;
+	}
+}
+
+void b2ParticleSystem::SolveViscous()
+{
+	for (int32 k = 0; k < m_contactCount; ++k)
+	{
+		const b2ParticleContact& c = m_contacts[k];
+		if ((c.flags & e_fluidParticle) == 0)
+		{
+			continue;
+		}
+
+		int32 a = c.indexA;
+		int32 b = c.indexB;
+		b2Vec2 dv = (m_viscousStrength * c.weight) * (m_velocities[b] - m_velocities[a]);
+		m_velocities[a] += (1.0f - c.shareA) * dv;
+		m_velocities[b] -= c.shareA * dv;
+	}
+}
+
+void b2ParticleSystem::QueryShapes(const b2TimeStep& step)
+{
+	m_shapeCount = 0;
+
+	// Bound the particles over the whole step.
+	b2AABB aabb;
+	aabb.lowerBound.Set(B2_FLT_MAX, B2_FLT_MAX);
+	aabb.upperBound.Set(-B2_FLT_MAX, -B2_FLT_MAX);
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		if (m_flags[i] & (e_noShapeParticle | e_zombieParticle))
+		{
+			continue;
+		}
+
+		b2Vec2 p1 = m_positions[i];
+		b2Vec2 p2 = p1 + step.dt * m_velocities[i];
+		aabb.lowerBound = b2Min(aabb.lowerBound, b2Min(p1, p2));
+		aabb.upperBound = b2Max(aabb.upperBound, b2Max(p1, p2));
+	}
+
+	if (aabb.lowerBound.x > aabb.upperBound.x)
+	{
+		return;
+	}
+
+	b2Vec2 r(m_maxRadius, m_maxRadius);
+	aabb.lowerBound -= r;
+	aabb.upperBound += r;
+
+	b2BroadPhase* broadPhase = m_world->m_broadPhase;
+	b2StackAllocator* allocator = &m_world->m_stackAllocator;
+
+	// The query stops when the buffer is full, so grow it until it is not.
+	int32 capacity = m_shapeCapacity;
+	void** results = (void**)allocator->Allocate(capacity * sizeof(void*));
+	int32 count = broadPhase->Query(aabb, results, capacity);
+	while (count == capacity && capacity < broadPhase->GetProxyCount())
+	{
+		allocator->Free(results);
+		capacity *= 2;
+		results = (void**)allocator->Allocate(capacity * sizeof(void*));
+		count = broadPhase->Query(aabb, results, capacity);
+	}
+
+	if (capacity > m_shapeCapacity)
+	{
+		b2Free(m_shapes);
+		m_shapeCapacity = capacity;
+		m_shapes = (b2ParticleShape*)b2Alloc(m_shapeCapacity * sizeof(b2ParticleShape));
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Shape* shape = (b2Shape*)results[i];
+		if (ShouldCollide(shape) == false)
+		{
+			continue;
+		}
+
+		b2ParticleShape* ps = m_shapes + m_shapeCount++;
+		ps->shape = shape;
+		ps->body = shape->GetBody();
+		ps->xf = ps->body->GetXForm();
+		shape->ComputeAABB(&ps->aabb, ps->xf);
+
+		// Sleeping bodies are treated as static so that resting particles do not keep them awake.
+		ps->dynamic = ps->body->IsStatic() == false && ps->body->IsSleeping() == false;
+	}
+
+	allocator->Free(results);
+}
+
+void b2ParticleSystem::AddShapeContact(int32 shapeIndex, int32 index)
+{
+	if (m_flags[index] & (e_noShapeParticle | e_zombieParticle))
+	{
+		return;
+	}
+
+	const b2ParticleShape& ps = m_shapes[shapeIndex];
+	b2Vec2 p = m_positions[index];
+	float32 radius = m_radii[index];
+	if (p.x + radius < ps.aabb.lowerBound.x || p.x - radius > ps.aabb.upperBound.x ||
+		p.y + radius < ps.aabb.lowerBound.y || p.y - radius > ps.aabb.upperBound.y)
+	{
+		return;
+	}
+
+	b2Vec2 normal;
+	float32 depth;
+	if (b2CollideParticle(ps.shape, ps.xf, p, radius, &normal, &depth) == false)
+	{
+		return;
+	}
+
+	// Shapes do not give way, so move the particle out right away.
+	m_positions[index] = p + depth * normal;
+
+	if (m_shapeContactCount == m_shapeContactCapacity)
+	{
+		m_shapeContactCapacity *= 2;
+		b2ReallocateBuffer(&m_shapeContacts, m_shapeContactCount, m_shapeContactCapacity);
+	}
+
+	b2ParticleShapeContact* c = m_shapeContacts + m_shapeContactCount++;
+	c->index = index;
+	c->shapeIndex = shapeIndex;
+	c->normal = normal;
+	c->point = p - radius * normal;
+	c->bodyVelocity = ps.body->GetLinearVelocityFromWorldPoint(p);
+	c->normalImpulse = 0.0f;
+	c->tangentImpulse = 0.0f;
+
+	c->velocityBias = 0.0f;
+	float32 vn = b2Dot(m_velocities[index] - c->bodyVelocity, normal);
+	if (vn < -b2_velocityThreshold)
+	{
+		c->velocityBias = -m_restitution * vn;
+	}
+}
+
+void b2ParticleSystem::UpdateShapeContacts()
+{
+	m_shapeContactCount = 0;
+
+	for (int32 k = 0; k < m_shapeCount; ++k)
+	{
+		const b2ParticleShape& ps = m_shapes[k];
+
+		// Particles reach a radius beyond their cell.
+		b2Vec2 r(m_maxRadius, m_maxRadius);
+		uint32 lowerKey = ComputeKey(ps.aabb.lowerBound - r);
+		uint32 upperKey = ComputeKey(ps.aabb.upperBound + r);
+		uint32 lowerX = lowerKey & 0xFFFF;
+		uint32 upperX = upperKey & 0xFFFF;
+		uint32 lowerY = lowerKey >> 16;
+		uint32 upperY = upperKey >> 16;
+
+		if ((upperX - lowerX + 1) * (upperY - lowerY + 1) > (uint32)m_count)
+		{
+			// Testing every particle is cheaper than visiting the cells.
+			for (int32 i = 0; i < m_count; ++i)
+			{
+				AddShapeContact(k, i);
+			}
+			continue;
+		}
+
+		int32 first = 0;
+		for (uint32 y = lowerY; y <= upperY; ++y)
+		{
+			uint32 rowKey = y << 16;
+			first = FindProxy(first, rowKey | lowerX);
+			for (int32 j = first; j < m_count && m_proxies[j].key <= (rowKey | upperX); ++j)
+			{
+				AddShapeContact(k, m_proxies[j].index);
+			}
+		}
+	}
+}
+
+void b2ParticleSystem::SolveVelocityConstraints()
+{
+	// Sequential impulses, with the impulses measured as changes of relative velocity.
+	for (int32 k = 0; k < m_contactCount; ++k)
+	{
+		b2ParticleContact& c = m_contacts[k];
+		int32 a = c.indexA;
+		int32 b = c.indexB;
+		float32 shareB = 1.0f - c.shareA;
+
+		b2Vec2 vr = m_velocities[b] - m_velocities[a];
+		float32 lambda = c.velocityBias - b2Dot(vr, c.normal);
+		float32 newImpulse = b2Max(c.normalImpulse + lambda, 0.0f);
+		lambda = newImpulse - c.normalImpulse;
+		c.normalImpulse = newImpulse;
+
+		b2Vec2 dv = lambda * c.normal;
+
+		// Solid particles resist sliding, so piles of debris come to rest.
+		if ((c.flags & e_fluidParticle) == 0)
+		{
+			b2Vec2 tangent = b2Cross(c.normal, 1.0f);
+			float32 lambdaT = -b2Dot(vr + dv, tangent);
+			float32 maxFriction = m_friction * c.normalImpulse;
+			newImpulse = b2Clamp(c.tangentImpulse + lambdaT, -maxFriction, maxFriction);
+			lambdaT = newImpulse - c.tangentImpulse;
+			c.tangentImpulse = newImpulse;
+			dv += lambdaT * tangent;
+		}
+
+		m_velocities[a] -= c.shareA * dv;
+		m_velocities[b] += shareB * dv;
+	}
+
+	for (int32 k = 0; k < m_shapeContactCount; ++k)
+	{
+		b2ParticleShapeContact& c = m_shapeContacts[k];
+		b2Vec2 v = m_velocities[c.index];
+
+		b2Vec2 vr = v - c.bodyVelocity;
+		float32 lambda = c.velocityBias - b2Dot(vr, c.normal);
+		float32 newImpulse = b2Max(c.normalImpulse + lambda, 0.0f);
+		lambda = newImpulse - c.normalImpulse;
+		c.normalImpulse = newImpulse;
+
+		b2Vec2 dv = lambda * c.normal;
+
+		b2Vec2 tangent = b2Cross(c.normal, 1.0f);
+		float32 lambdaT = -b2Dot(vr + dv, tangent);
+		float32 maxFriction = m_friction * c.normalImpulse;
+		newImpulse = b2Clamp(c.tangentImpulse + lambdaT, -maxFriction, maxFriction);
+		lambdaT = newImpulse - c.tangentImpulse;
+		c.tangentImpulse = newImpulse;
+		dv += lambdaT * tangent;
+
+		m_velocities[c.index] = v + dv;
+	}
+}
+
+void b2ParticleSystem::ApplyShapeImpulses()
+{
+	// Bodies are treated as immovable while solving, then take the reaction.
+	for (int32 k = 0; k < m_shapeContactCount; ++k)
+	{
+		const b2ParticleShapeContact& c = m_shapeContacts[k];
+		const b2ParticleShape& ps = m_shapes[c.shapeIndex];
+		if (ps.dynamic == false)
+		{
+			continue;
+		}
+
+		float32 radius = m_radii[c.index];
+		float32 mass = m_density * b2_pi * radius * radius;
+		b2Vec2 dv = c.normalImpulse * c.normal + c.tangentImpulse * b2Cross(c.normal, 1.0f);
+		ps.body->ApplyImpulse(-mass * dv, c.point);
+	}
+}
+
+void b2ParticleSystem::SolvePositionConstraints()
+{
+	// The contacts are ordered from the bottom row of the grid up, so a single
+	// pass carries the support of the ground through a pile.
+	for (int32 k = 0; k < m_contactCount; ++k)
+	{
+		const b2ParticleContact& c = m_contacts[k];
+		int32 a = c.indexA;
+		int32 b = c.indexB;
+
+		b2Vec2 d = m_positions[b] - m_positions[a];
+		float32 dist = d.Length();
+		if (dist < B2_FLT_EPSILON)
+		{
+			continue;
+		}
+
+		// Fluid particles may overlap up to the fluid spacing.
+		float32 r = m_radii[a] + m_radii[b];
+		if (c.flags & e_fluidParticle)
+		{
+			r *= b2_particleFluidSpacing;
+		}
+
+		float32 C = b2Clamp(b2_particleBaumgarte * (dist - r + b2_linearSlop), -b2_maxLinearCorrection, 0.0f);
+		if (C == 0.0f)
+		{
+			continue;
+		}
+
+		b2Vec2 n = (1.0f / dist) * d;
+		m_positions[a] += (c.shareA * C) * n;
+		m_positions[b] -= ((1.0f - c.shareA) * C) * n;
+	}
+
+	// Keep the particles out of the shapes they touched.
+	for (int32 k = 0; k < m_shapeContactCount; ++k)
+	{
+		const b2ParticleShapeContact& c = m_shapeContacts[k];
+		b2Vec2& p = m_positions[c.index];
+		float32 separation = b2Dot(p - c.point, c.normal) - m_radii[c.index];
+		if (separation < 0.0f)
+		{
+			p -= b2Max(separation, -b2_maxLinearCorrection) * c.normal;
+		}
+	}
+}
+
+void b2ParticleSystem::SolveTunneling(const b2TimeStep& step)
+{
+	// Particles that move further than their radius in a step could pass
+	// through thin shapes, so stop them where their path meets a shape.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		if (m_flags[i] & (e_noShapeParticle | e_zombieParticle))
+		{
+			continue;
+		}
+
+		b2Vec2 d = step.dt * m_velocities[i];
+		float32 radius = m_radii[i];
+		if (d.LengthSquared() <= radius * radius)
+		{
+			continue;
+		}
+
+		b2Segment segment;
+		segment.p1 = m_positions[i];
+		segment.p2 = segment.p1 + d;
+		b2Vec2 lower = b2Min(segment.p1, segment.p2);
+		b2Vec2 upper = b2Max(segment.p1, segment.p2);
+
+		float32 bestLambda = 1.0f;
+		b2Vec2 bestNormal;
+		bestNormal.SetZero();
+		const b2ParticleShape* bestShape = NULL;
+		for (int32 k = 0; k < m_shapeCount; ++k)
+		{
+			const b2ParticleShape& ps = m_shapes[k];
+			if (upper.x < ps.aabb.lowerBound.x || lower.x > ps.aabb.upperBound.x ||
+				upper.y < ps.aabb.lowerBound.y || lower.y > ps.aabb.upperBound.y)
+			{
+				continue;
+			}
+
+			float32 lambda;
+			b2Vec2 normal;
+			if (ps.shape->TestSegment(ps.xf, &lambda, &normal, segment, bestLambda) == e_hitCollide)
+			{
+				bestLambda = lambda;
+				bestNormal = normal;
+				bestShape = &ps;
+			}
+		}
+
+		if (bestShape == NULL)
+		{
+			continue;
+		}
+
+		// Stop at the surface. The contact on the next step pushes the particle out.
+		b2Vec2 target = segment.p1 + bestLambda * d + b2_linearSlop * bestNormal;
+		b2Vec2 v = step.inv_dt * (target - segment.p1);
+
+		if (bestShape->dynamic)
+		{
+			float32 mass = m_density * b2_pi * radius * radius;
+			bestShape->body->ApplyImpulse(mass * (m_velocities[i] - v), target);
+		}
+
+		m_velocities[i] = v;
+	}
+}
+
+void b2ParticleSystem::RemoveZombies()
+{
+	// Particles that leave the world are removed, like bodies are frozen.
+	const b2AABB& worldAABB = m_world->m_broadPhase->m_worldAABB;
+
+	int32 count = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Vec2 p = m_positions[i];
+		if ((m_flags[i] & e_zombieParticle) ||
+			p.x < worldAABB.lowerBound.x || p.x > worldAABB.upperBound.x ||
+			p.y < worldAABB.lowerBound.y || p.y > worldAABB.upperBound.y)
+		{
+			continue;
+		}
+
+		if (count != i)
+		{
+			m_positions[count] = p;
+			m_velocities[count] = m_velocities[i];
+			m_radii[count] = m_radii[i];
+			m_flags[count] = m_flags[i];
+			m_lifetimes[count] = m_lifetimes[i];
+		}
+		++count;
+	}
+
+	m_count = count;
+}
+
+void b2ParticleSystem::Solve(const b2TimeStep& step)
+{
+	m_contactCount = 0;
+	m_shapeCount = 0;
+	m_shapeContactCount = 0;
+
+	if (m_count == 0)
+	{
+		return;
+	}
+
+	b2Vec2 gravity = (step.dt * m_gravityScale) * m_world->m_gravity;
+	float32 damping = b2Clamp(1.0f - step.dt * m_damping, 0.0f, 1.0f);
+
+	m_allFlags = 0;
+	m_maxRadius = 0.0f;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		if (m_lifetimes[i] > 0.0f)
+		{
+			m_lifetimes[i] -= step.dt;
+			if (m_lifetimes[i] <= 0.0f)
+			{
+				m_flags[i] |= e_zombieParticle;
+			}
+		}
+
+		m_allFlags |= m_flags[i];
+		m_maxRadius = b2Max(m_maxRadius, m_radii[i]);
+		m_velocities[i] = damping * (m_velocities[i] + gravity);
+	}
+
+	UpdateProxies();
+	UpdateContacts(step);
+
+	if (m_allFlags & e_fluidParticle)
+	{
+		SolvePressure(step);
+		SolveViscous();
+	}
+
+	QueryShapes(step);
+	UpdateShapeContacts();
+
+	// Particles share the iteration counts of the world step.
+	for (int32 i = 0; i < step.velocityIterations; ++i)
+	{
+		SolveVelocityConstraints();
+	}
+
+	ApplyShapeImpulses();
+
+	if (m_shapeCount > 0)
+	{
+		SolveTunneling(step);
+	}
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_positions[i] += step.dt * m_velocities[i];
+	}
+
+	for (int32 i = 0; i < step.positionIterations; ++i)
+	{
+		SolvePositionConstraints();
+	}
+
+	RemoveZombies();
+}
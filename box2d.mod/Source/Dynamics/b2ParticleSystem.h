@@ -0,0 +1,392 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_PARTICLE_SYSTEM_H
+#define B2_PARTICLE_SYSTEM_H
+
+#include "../Common/b2Math.h"
+#include "../Collision/Shapes/b2Shape.h"
+
+class b2World;
+class b2Body;
+struct b2TimeStep;
+
+/// Particle flags.
+enum b2ParticleFlag
+{
+	e_fluidParticle		= 0x0001,	///< feels pressure and viscosity from other fluid particles
+	e_noShapeParticle	= 0x0002,	///< does not collide with shapes
+	e_zombieParticle	= 0x0004,	///< removed at the end of the next step
+};
+
+/// A particle definition holds the data needed to create a particle.
+struct b2ParticleDef
+{
+	/// The constructor sets the default particle definition values.
+	b2ParticleDef()
+	{
+		flags = 0;
+		position.Set(0.0f, 0.0f);
+		velocity.Set(0.0f, 0.0f);
+		radius = 0.05f;
+		lifetime = 0.0f;
+	}
+
+	/// A combination of b2ParticleFlag values.
+	uint32 flags;
+
+	/// The world position of the particle.
+	b2Vec2 position;
+
+	/// The linear velocity of the particle in world co-ordinates.
+	b2Vec2 velocity;
+
+	/// The particle radius.
+	float32 radius;
+
+	/// The time in seconds before the particle is removed. Zero means forever.
+	float32 lifetime;
+};
+
+/// A particle system definition holds the settings shared by its particles.
+struct b2ParticleSystemDef
+{
+	/// The constructor sets the default particle system definition values.
+	b2ParticleSystemDef()
+	{
+		density = 1.0f;
+		gravityScale = 1.0f;
+		damping = 0.0f;
+		friction = 0.2f;
+		restitution = 0.0f;
+		pressureStrength = 0.05f;
+		viscousStrength = 0.25f;
+		maxCount = 0;
+		filter.categoryBits = 0x0001;
+		filter.maskBits = 0xFFFF;
+		filter.groupIndex = 0;
+		userData = NULL;
+	}
+
+	/// The particle density, used for the impulses exchanged with bodies.
+	float32 density;
+
+	/// Scales the world gravity for the particles.
+	float32 gravityScale;
+
+	/// Linear damping of the particle velocities.
+	float32 damping;
+
+	/// The friction between particles and shapes.
+	float32 friction;
+
+	/// How much particles bounce off shapes, usually in the range [0,1].
+	float32 restitution;
+
+	/// How strongly crowded fluid particles push each other apart.
+	float32 pressureStrength;
+
+	/// How strongly neighbouring fluid particles match their velocities.
+	float32 viscousStrength;
+
+	/// The most particles the system may hold. Zero means no limit.
+	int32 maxCount;
+
+	/// Filtering against shapes. Particles of a system never filter each other.
+	b2FilterData filter;
+
+	/// Use this to store application specific particle system data.
+	void* userData;
+};
+
+/// A particle system simulates many small circular particles without the cost of
+/// a body, a shape and a broad-phase proxy each. Particles are stored in arrays
+/// that can be read in bulk for rendering. They collide with each other through a
+/// grid rebuilt every step, and with the shapes of the world through a single
+/// broad-phase query. Particles push dynamic bodies that are awake, but do not
+/// wake sleeping bodies, which act as static ones.
+/// Particle systems are created and destroyed by b2World.
+class b2ParticleSystem
+{
+public:
+
+	/// Create a particle.
+	/// @return the particle index, or -1 if the system is full.
+	/// @warning This function is locked during callbacks.
+	int32 CreateParticle(const b2ParticleDef& def);
+
+	/// Mark a particle for removal at the end of the next step.
+	/// @warning removing particles changes the indices of the particles after them.
+	void DestroyParticle(int32 index);
+
+	/// Get the number of particles, including those marked for removal.
+	int32 GetParticleCount() const;
+
+	/// Get the most particles the system may hold, zero if there is no limit.
+	int32 GetMaxParticleCount() const;
+
+	/// Get the particle positions. The array holds GetParticleCount entries and may
+	/// move when particles are created.
+	b2Vec2* GetPositionBuffer();
+	const b2Vec2* GetPositionBuffer() const;
+
+	/// Get the particle velocities.
+	b2Vec2* GetVelocityBuffer();
+	const b2Vec2* GetVelocityBuffer() const;
+
+	/// Get the particle radii.
+	float32* GetRadiusBuffer();
+	const float32* GetRadiusBuffer() const;
+
+	/// Get the particle flags.
+	uint32* GetFlagsBuffer();
+	const uint32* GetFlagsBuffer() const;
+
+	/// Get the remaining lifetimes, zero for particles that live forever.
+	float32* GetLifetimeBuffer();
+	const float32* GetLifetimeBuffer() const;
+
+	/// Get the number of touching particle pairs found by the last step.
+	int32 GetContactCount() const;
+
+	/// Get the number of particles touching shapes in the last step.
+	int32 GetShapeContactCount() const;
+
+	/// Get the next particle system in the world's list.
+	b2ParticleSystem* GetNext();
+
+	/// Get the parent world of this particle system.
+	b2World* GetWorld();
+
+	/// Get the user data pointer that was provided in the particle system definition.
+	void* GetUserData();
+
+	/// Set the user data. Use this to store your application specific data.
+	void SetUserData(void* data);
+
+	//--------------- Internals Below -------------------
+
+	b2ParticleSystem(const b2ParticleSystemDef* def, b2World* world);
+	~b2ParticleSystem();
+
+	// Move the particles and collide them with each other and the world shapes.
+	void Solve(const b2TimeStep& step);
+
+	// Particles are sorted by the grid cell they are in.
+	struct b2ParticleProxy
+	{
+		uint32 key;
+		int32 index;
+	};
+
+	// A pair of touching particles. The normal points from A to B.
+	struct b2ParticleContact
+	{
+		int32 indexA;
+		int32 indexB;
+		float32 weight;
+		b2Vec2 normal;
+		uint32 flags;			// flags shared by both particles
+		float32 shareA;			// the part of a relative velocity change taken by A
+		float32 velocityBias;
+		float32 normalImpulse;
+		float32 tangentImpulse;
+	};
+
+	// A shape near the particles, gathered once per step.
+	struct b2ParticleShape
+	{
+		b2Shape* shape;
+		b2Body* body;
+		b2XForm xf;
+		b2AABB aabb;
+		bool dynamic;
+	};
+
+	// A particle touching a shape. The normal points from the shape to the particle
+	// and the point is on the surface of the shape.
+	struct b2ParticleShapeContact
+	{
+		int32 index;
+		int32 shapeIndex;
+		b2Vec2 normal;
+		b2Vec2 point;
+		b2Vec2 bodyVelocity;
+		float32 velocityBias;
+		float32 normalImpulse;
+		float32 tangentImpulse;
+	};
+
+	void ReserveCapacity(int32 capacity);
+	void UpdateProxies();
+	void UpdateContacts(const b2TimeStep& step);
+	void AddContact(int32 a, int32 b, float32 inv_dt);
+	void SolvePressure(const b2TimeStep& step);
+	void SolveViscous();
+	void QueryShapes(const b2TimeStep& step);
+	void UpdateShapeContacts();
+	void AddShapeContact(int32 shapeIndex, int32 index);
+	void SolveVelocityConstraints();
+	void ApplyShapeImpulses();
+	void SolvePositionConstraints();
+	void SolveTunneling(const b2TimeStep& step);
+	void RemoveZombies();
+	uint32 ComputeKey(const b2Vec2& p) const;
+	int32 FindProxy(int32 first, uint32 key) const;
+	bool ShouldCollide(const b2Shape* shape) const;
+
+	b2World* m_world;
+	b2ParticleSystem* m_prev;
+	b2ParticleSystem* m_next;
+
+	int32 m_count;
+	int32 m_capacity;
+	int32 m_maxCount;
+
+	b2Vec2* m_positions;
+	b2Vec2* m_velocities;
+	float32* m_radii;
+	uint32* m_flags;
+	float32* m_lifetimes;
+	float32* m_weights;
+
+	// Union of the flags of all particles, refreshed every step.
+	uint32 m_allFlags;
+
+	// The grid, rebuilt every step with cells one particle diameter wide.
+	b2ParticleProxy* m_proxies;
+	b2ParticleProxy* m_proxyBuffer;
+	b2Vec2 m_gridOrigin;
+	float32 m_invCellSize;
+	float32 m_maxRadius;
+
+	b2ParticleContact* m_contacts;
+	int32 m_contactCount;
+	int32 m_contactCapacity;
+
+	b2ParticleShape* m_shapes;
+	int32 m_shapeCount;
+	int32 m_shapeCapacity;
+
+	b2ParticleShapeContact* m_shapeContacts;
+	int32 m_shapeContactCount;
+	int32 m_shapeContactCapacity;
+
+	float32 m_density;
+	float32 m_gravityScale;
+	float32 m_damping;
+	float32 m_friction;
+	float32 m_restitution;
+	float32 m_pressureStrength;
+	float32 m_viscousStrength;
+	b2FilterData m_filter;
+
+	void* m_userData;
+};
+
+inline int32 b2ParticleSystem::GetParticleCount() const
+{
+	return m_count;
+}
+
+inline int32 b2ParticleSystem::GetMaxParticleCount() const
+{
+	return m_maxCount;
+}
+
+inline b2Vec2* b2ParticleSystem::GetPositionBuffer()
+{
+	return m_positions;
+}
+
+inline const b2Vec2* b2ParticleSystem::GetPositionBuffer() const
+{
+	return m_positions;
+}
+
+inline b2Vec2* b2ParticleSystem::GetVelocityBuffer()
+{
+	return m_velocities;
+}
+
+inline const b2Vec2* b2ParticleSystem::GetVelocityBuffer() const
+{
+	return m_velocities;
+}
+
+inline float32* b2ParticleSystem::GetRadiusBuffer()
+{
+	return m_radii;
+}
+
+inline const float32* b2ParticleSystem::GetRadiusBuffer() const
+{
+	return m_radii;
+}
+
+inline uint32* b2ParticleSystem::GetFlagsBuffer()
+{
+	return m_flags;
+}
+
+inline const uint32* b2ParticleSystem::GetFlagsBuffer() const
+{
+	return m_flags;
+}
+
+inline float32* b2ParticleSystem::GetLifetimeBuffer()
+{
+	return m_lifetimes;
+}
+
+inline const float32* b2ParticleSystem::GetLifetimeBuffer() const
+{
+	return m_lifetimes;
+}
+
+inline int32 b2ParticleSystem::GetContactCount() const
+{
+	return m_contactCount;
+}
+
+inline int32 b2ParticleSystem::GetShapeContactCount() const
+{
+	return m_shapeContactCount;
+}
+
+inline b2ParticleSystem* b2ParticleSystem::GetNext()
+{
+	return m_next;
+}
+
+inline b2World* b2ParticleSystem::GetWorld()
+{
+	return m_world;
+}
+
+inline void* b2ParticleSystem::GetUserData()
+{
+	return m_userData;
+}
+
+inline void b2ParticleSystem::SetUserData(void* data)
+{
+	m_userData = data;
+}
+
+#endif
@@ -26,28 +26,55 @@
 #include "../Collision/Shapes/b2CircleShape.h"
 #include "../Collision/Shapes/b2PolygonShape.h"
 #include "../Collision/Shapes/b2EdgeShape.h"
+#include "../Collision/Shapes/b2MeshShape.h"
+#include "../Collision/Shapes/b2TileGridShape.h"
+#include "../Collision/Shapes/b2HeightfieldShape.h"
+#include "../Common/b2Timer.h"
+#include "b2WorldSnapshot.h"
+#include "b2ParticleSystem.h"
+#include "b2WorldRecorder.h"
 #include <new>
+#include <cstring>
 
 b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
+{
+	Initialize(worldAABB, gravity, doSleep, 0.0f);
+}
+
+b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, float32 cellSize)
+{
+	Initialize(worldAABB, gravity, doSleep, cellSize);
+}
+
+void b2World::Initialize(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, float32 cellSize)
 {
 	m_destructionListener = NULL;
 	m_boundaryListener = NULL;
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = NULL;
+	m_sensorListener = NULL;
 	m_debugDraw = NULL;
+	m_debugDrawViewSet = false;
 
 	m_bodyList = NULL;
 	m_contactList = NULL;
 	m_jointList = NULL;
 	m_controllerList = NULL;
+	m_particleSystemList = NULL;
 
 	m_bodyCount = 0;
+	m_bodyIdCounter = 0;
+	m_shapeIdCounter = 0;
+	m_jointIdCounter = 0;
 	m_contactCount = 0;
 	m_jointCount = 0;
 	m_controllerCount = 0;
+	m_particleSystemCount = 0;
 
 	m_warmStarting = true;
 	m_continuousPhysics = true;
+	m_velocityTolerance = 0.0f;
+	m_directJoints = false;
 
 	m_allowSleep = doSleep;
 	m_gravity = gravity;
@@ -56,9 +83,43 @@ b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
 
 	m_inv_dt0 = 0.0f;
 
+	m_profiling = false;
+	m_profile = b2Profile();
+
+	m_accumulator = 0.0f;
+	m_interpolationAlpha = 0.0f;
+
+	m_stepBudget = 0.0f;
+	m_iterationCost = 0.0f;
+	m_budgetReserve = 0.0f;
+	m_budgetMark = 0.0f;
+	m_degraded = false;
+
+	m_stepping = false;
+	m_asyncTimeStep = 0.0f;
+	m_asyncVelocityIterations = 0;
+	m_asyncPositionIterations = 0;
+	m_frontSnapshot = NULL;
+	m_backSnapshot = NULL;
+	m_snapshotDirty = true;
+
+	m_commands = NULL;
+	m_commandCount = 0;
+	m_commandCapacity = 0;
+
+	m_recorder = NULL;
+
 	m_contactManager.m_world = this;
+	m_islandManager.m_world = this;
 	void* mem = b2Alloc(sizeof(b2BroadPhase));
-	m_broadPhase = new (mem) b2BroadPhase(worldAABB, &m_contactManager);
+	if (cellSize > 0.0f)
+	{
+		m_broadPhase = new (mem) b2BroadPhase(worldAABB, &m_contactManager, cellSize);
+	}
+	else
+	{
+		m_broadPhase = new (mem) b2BroadPhase(worldAABB, &m_contactManager);
+	}
 
 	b2BodyDef bd;
 	m_groundBody = CreateBody(&bd);
@@ -66,7 +127,35 @@ b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
 
 b2World::~b2World()
 {
-	DestroyBody(m_groundBody);
+	Wait();
+
+	if (m_frontSnapshot)
+	{
+		m_frontSnapshot->~b2WorldSnapshot();
+		b2Free(m_frontSnapshot);
+		m_backSnapshot->~b2WorldSnapshot();
+		b2Free(m_backSnapshot);
+	}
+
+	if (m_commands)
+	{
+		b2Free(m_commands);
+	}
+
+	// Mesh shapes and their contacts own heap memory, so destroy every body
+	// rather than dropping the block allocator. Nobody is listening anymore.
+	m_recorder = NULL;
+	m_destructionListener = NULL;
+	m_contactListener = NULL;
+	m_sensorListener = NULL;
+	while (m_particleSystemList)
+	{
+		DestroyParticleSystem(m_particleSystemList);
+	}
+	while (m_bodyList)
+	{
+		DestroyBody(m_bodyList);
+	}
 	m_broadPhase->~b2BroadPhase();
 	b2Free(m_broadPhase);
 }
@@ -91,21 +180,75 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactListener = listener;
 }
 
+void b2World::SetSensorListener(b2SensorListener* listener)
+{
+	m_sensorListener = listener;
+}
+
 void b2World::SetDebugDraw(b2DebugDraw* debugDraw)
 {
 	m_debugDraw = debugDraw;
 }
 
+void b2World::SetDebugDrawView(const b2AABB& view)
+{
+	b2Assert(view.IsValid());
+	m_debugDrawView = view;
+	m_debugDrawViewSet = true;
+}
+
+void b2World::ClearDebugDrawView()
+{
+	m_debugDrawViewSet = false;
+}
+
+void b2World::SetStepBudget(float32 milliseconds)
+{
+	m_stepBudget = milliseconds;
+	m_iterationCost = 0.0f;
+	m_budgetReserve = 0.0f;
+	m_degraded = false;
+}
+
+void b2World::SetProfiling(bool flag)
+{
+	m_profiling = flag;
+	m_profile = b2Profile();
+}
+
+void b2World::SetRecorder(b2WorldRecorder* recorder)
+{
+	BeginEdit();
+
+	// Only the ground body may exist, so that the replay creates the same objects.
+	b2Assert(recorder == NULL || (m_bodyIdCounter == 1 && m_shapeIdCounter == 0 && m_jointIdCounter == 0));
+
+	m_recorder = recorder;
+	if (m_recorder)
+	{
+		m_recorder->Begin(this);
+	}
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
+	BeginEdit();
+
 	b2Assert(m_lock == false);
 	if (m_lock == true)
 	{
 		return NULL;
 	}
 
+	b2RecordScope scope(this);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordCreateBody(def);
+	}
+
 	void* mem = m_blockAllocator.Allocate(sizeof(b2Body));
 	b2Body* b = new (mem) b2Body(def, this);
+	b->m_id = ++m_bodyIdCounter;
 
 	// Add to world doubly linked list.
 	b->m_prev = NULL;
@@ -117,11 +260,19 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	m_bodyList = b;
 	++m_bodyCount;
 
+	// Static and inactive bodies do not belong to islands.
+	if (b->IsStatic() == false && b->IsActive())
+	{
+		m_islandManager.AddBody(b);
+	}
+
 	return b;
 }
 
 void b2World::DestroyBody(b2Body* b)
 {
+	BeginEdit();
+
 	b2Assert(m_bodyCount > 0);
 	b2Assert(m_lock == false);
 	if (m_lock == true)
@@ -129,6 +280,12 @@ void b2World::DestroyBody(b2Body* b)
 		return;
 	}
 
+	b2RecordScope scope(this);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordBody(e_recordDestroyBody, b);
+	}
+
 	// Delete the attached joints.
 	b2JointEdge* jn = b->m_jointList;
 	while (jn)
@@ -171,6 +328,12 @@ void b2World::DestroyBody(b2Body* b)
 		b2Shape::Destroy(s0, &m_blockAllocator);
 	}
 
+	// Leave the island graph. All constraints are gone by now.
+	m_islandManager.RemoveBody(b);
+
+	// Forget the body's pair exclusions.
+	m_filterTable.RemoveBody(b);
+
 	// Remove world body list.
 	if (b->m_prev)
 	{
@@ -194,9 +357,18 @@ void b2World::DestroyBody(b2Body* b)
 
 b2Joint* b2World::CreateJoint(const b2JointDef* def)
 {
+	BeginEdit();
+
 	b2Assert(m_lock == false);
 
+	b2RecordScope scope(this);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordCreateJoint(def);
+	}
+
 	b2Joint* j = b2Joint::Create(def, &m_blockAllocator);
+	j->m_id = ++m_jointIdCounter;
 
 	// Connect to the world list.
 	j->m_prev = NULL;
@@ -223,6 +395,9 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	if (j->m_body2->m_jointList) j->m_body2->m_jointList->prev = &j->m_node2;
 	j->m_body2->m_jointList = &j->m_node2;
 
+	// Merge the islands of the connected bodies.
+	m_islandManager.LinkJoint(j);
+
 	// If the joint prevents collisions, then reset collision filtering.
 	if (def->collideConnected == false)
 	{
@@ -239,8 +414,16 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 
 void b2World::DestroyJoint(b2Joint* j)
 {
+	BeginEdit();
+
 	b2Assert(m_lock == false);
 
+	b2RecordScope scope(this);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordJoint(e_recordDestroyJoint, j);
+	}
+
 	bool collideConnected = j->m_collideConnected;
 
 	// Remove from the doubly linked list.
@@ -267,6 +450,11 @@ void b2World::DestroyJoint(b2Joint* j)
 	body1->WakeUp();
 	body2->WakeUp();
 
+	if (j->m_island)
+	{
+		m_islandManager.UnlinkJoint(j);
+	}
+
 	// Remove from body 1.
 	if (j->m_node1.prev)
 	{
@@ -324,6 +512,8 @@ void b2World::DestroyJoint(b2Joint* j)
 
 b2Controller* b2World::CreateController(b2ControllerDef* def)
 {
+	BeginEdit();
+
 	b2Controller* controller = def->Create(&m_blockAllocator);
 
 	controller->m_next = m_controllerList;
@@ -340,6 +530,8 @@ b2Controller* b2World::CreateController(b2ControllerDef* def)
 
 void b2World::DestroyController(b2Controller* controller)
 {
+	BeginEdit();
+
 	b2Assert(m_controllerCount>0);
 	if(controller->m_next)
 		controller->m_next->m_prev = controller->m_prev;
@@ -352,10 +544,75 @@ void b2World::DestroyController(b2Controller* controller)
 	b2Controller::Destroy(controller, &m_blockAllocator);
 }
 
+b2ParticleSystem* b2World::CreateParticleSystem(const b2ParticleSystemDef* def)
+{
+	BeginEdit();
+
+	b2Assert(m_lock == false);
+	if (m_lock == true)
+	{
+		return NULL;
+	}
+
+	void* mem = m_blockAllocator.Allocate(sizeof(b2ParticleSystem));
+	b2ParticleSystem* system = new (mem) b2ParticleSystem(def, this);
+
+	system->m_prev = NULL;
+	system->m_next = m_particleSystemList;
+	if (m_particleSystemList)
+	{
+		m_particleSystemList->m_prev = system;
+	}
+	m_particleSystemList = system;
+	++m_particleSystemCount;
+
+	return system;
+}
+
+void b2World::DestroyParticleSystem(b2ParticleSystem* system)
+{
+	BeginEdit();
+
+	b2Assert(m_particleSystemCount > 0);
+	b2Assert(m_lock == false);
+	if (m_lock == true)
+	{
+		return;
+	}
+
+	if (system->m_prev)
+	{
+		system->m_prev->m_next = system->m_next;
+	}
+
+	if (system->m_next)
+	{
+		system->m_next->m_prev = system->m_prev;
+	}
+
+	if (system == m_particleSystemList)
+	{
+		m_particleSystemList = system->m_next;
+	}
+
+	--m_particleSystemCount;
+
+	system->~b2ParticleSystem();
+	m_blockAllocator.Free(system, sizeof(b2ParticleSystem));
+}
+
 void b2World::Refilter(b2Shape* shape)
 {
+	BeginEdit();
+
 	b2Assert(m_lock == false);
 
+	b2RecordScope scope(this);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordShape(e_recordRefilter, shape);
+	}
+
 	shape->RefilterProxy(m_broadPhase, shape->GetBody()->GetXForm());
 }
 
@@ -368,159 +625,215 @@ void b2World::Solve(const b2TimeStep& step)
 		controller->Step(step);
 	}
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount, m_contactCount, m_jointCount, &m_stackAllocator, m_contactListener);
-
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
-	{
-		b->m_flags &= ~b2Body::e_islandFlag;
-	}
-	for (b2Contact* c = m_contactList; c; c = c->m_next)
+	b2Profile* profile = m_profiling ? &m_profile : NULL;
+	b2Timer timer;
+	if (profile)
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
+		timer.Reset();
 	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
+
+	// Size the island for the largest awake island.
+	int32 bodyCapacity = 0;
+	int32 contactCapacity = 0;
+	int32 jointCapacity = 0;
+	int32 remainingSize = 0;
+	for (b2PersistentIsland* pi = m_islandManager.m_awakeList; pi; pi = pi->next)
 	{
-		j->m_islandFlag = false;
+		bodyCapacity = b2Max(bodyCapacity, pi->bodyCount);
+		contactCapacity = b2Max(contactCapacity, pi->contactCount);
+		jointCapacity = b2Max(jointCapacity, pi->jointCount);
+		remainingSize += pi->bodyCount + pi->contactCount + pi->jointCount;
 	}
 
-	// Build and simulate all awake islands.
-	int32 stackSize = m_bodyCount;
-	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	bool budget = m_stepBudget > 0.0f;
+	b2TimeStep islandStep = step;
+	b2Timer islandTimer;
+	float32 solveTime = 0.0f;
+	int32 solveWork = 0;
+
+	b2Island island(bodyCapacity, contactCapacity, jointCapacity, &m_stackAllocator, m_contactListener);
+
+	// Islands that lost constraints may have come apart. Splitting is deferred
+	// until part of such an island is resting, and only the sleepiest one is split
+	// each step.
+	b2PersistentIsland* splitIsland = NULL;
+	float32 splitSleepTime = 0.5f * b2_timeToSleep;
+
+	// Simulate all awake islands.
+	b2PersistentIsland* pi = m_islandManager.m_awakeList;
+	while (pi)
 	{
-		if (seed->m_flags & (b2Body::e_islandFlag | b2Body::e_sleepFlag | b2Body::e_frozenFlag))
+		b2PersistentIsland* next = pi->next;
+		int32 size = pi->bodyCount + pi->contactCount + pi->jointCount;
+
+		// An island stays awake as long as one of its bodies is awake.
+		bool awake = false;
+		for (b2Body* b = pi->bodyList; b; b = b->m_islandNext)
 		{
-			continue;
+			if ((b->m_flags & (b2Body::e_sleepFlag | b2Body::e_frozenFlag)) == 0)
+			{
+				awake = true;
+				break;
+			}
 		}
 
-		if (seed->IsStatic())
+		if (awake == false)
 		{
+			m_islandManager.SleepIsland(pi);
+			remainingSize -= size;
+			pi = next;
 			continue;
 		}
 
-		// Reset island and stack.
+		if (profile)
+		{
+			++profile->islandCount;
+			profile->bodyCount += pi->bodyCount;
+			profile->jointCount += pi->jointCount;
+		}
+
 		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
 
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
+		for (b2Body* b = pi->bodyList; b; b = b->m_islandNext)
 		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
-			island.Add(b);
-
 			// Make sure the body is awake.
 			b->m_flags &= ~b2Body::e_sleepFlag;
+			island.Add(b);
+		}
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
-			if (b->IsStatic())
-			{
-				continue;
-			}
+		for (b2Contact* c = pi->contactList; c; c = c->m_islandNext)
+		{
+			island.Add(c);
+		}
 
-			// Search all contacts connected to this body.
-			for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
+		for (b2Joint* j = pi->jointList; j; j = j->m_islandNext)
+		{
+			island.Add(j);
+		}
+
+		if (profile)
+		{
+			profile->islandBuild += timer.GetMilliseconds();
+		}
+
+		if (budget)
+		{
+			// Share the time left among the remaining islands by size. Cut iterations
+			// if the estimated cost of this island doesn't fit its share.
+			islandStep = step;
+			float32 cost = m_iterationCost * size * (step.velocityIterations + step.positionIterations);
+			float32 share = (m_stepBudget - m_budgetReserve - m_stepTimer.GetMilliseconds()) * size / b2Max(remainingSize, size);
+			if (share < cost)
 			{
-				// Has this contact already been added to an island?
-				if (cn->contact->m_flags & (b2Contact::e_islandFlag | b2Contact::e_nonSolidFlag))
+				float32 scale = b2Max(share, 0.0f) / cost;
+				islandStep.velocityIterations = b2Max(1, int32(scale * step.velocityIterations));
+				islandStep.positionIterations = b2Max(1, int32(scale * step.positionIterations));
+				if (islandStep.velocityIterations < step.velocityIterations || islandStep.positionIterations < step.positionIterations)
 				{
-					continue;
+					m_degraded = true;
 				}
+			}
 
-				// Is this contact touching?
-				if (cn->contact->GetManifoldCount() == 0)
-				{
-					continue;
-				}
+			islandTimer.Reset();
+		}
 
-				island.Add(cn->contact);
-				cn->contact->m_flags |= b2Contact::e_islandFlag;
+		island.Solve(islandStep, m_gravity, m_allowSleep, profile);
 
-				b2Body* other = cn->other;
+		if (budget)
+		{
+			solveTime += islandTimer.GetMilliseconds();
+			solveWork += size * (islandStep.velocityIterations + islandStep.positionIterations);
+		}
 
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+		remainingSize -= size;
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+		if (profile)
+		{
+			timer.Reset();
+		}
 
-			// Search all joints connect to this body.
-			for (b2JointEdge* jn = b->m_jointList; jn; jn = jn->next)
+		if (pi->constraintRemoveCount > 0)
+		{
+			for (b2Body* b = pi->bodyList; b; b = b->m_islandNext)
 			{
-				if (jn->joint->m_islandFlag == true)
+				if (b->m_sleepTime > splitSleepTime)
 				{
-					continue;
+					splitIsland = pi;
+					splitSleepTime = b->m_sleepTime;
 				}
+			}
+		}
 
-				island.Add(jn->joint);
-				jn->joint->m_islandFlag = true;
+		// The island solver puts all bodies to sleep together.
+		if (pi->bodyList->m_flags & b2Body::e_sleepFlag)
+		{
+			m_islandManager.SleepIsland(pi);
+		}
 
-				b2Body* other = jn->other;
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+		pi = next;
+	}
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
-		}
+	if (splitIsland)
+	{
+		m_islandManager.Split(splitIsland);
+	}
 
-		island.Solve(step, m_gravity, m_allowSleep);
+	if (budget)
+	{
+		m_budgetMark = m_stepTimer.GetMilliseconds();
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		if (solveWork > 0)
 		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
-			if (b->IsStatic())
+			float32 sample = solveTime / solveWork;
+			if (m_iterationCost > 0.0f)
 			{
-				b->m_flags &= ~b2Body::e_islandFlag;
+				m_iterationCost += b2_budgetSmoothing * (sample - m_iterationCost);
+			}
+			else
+			{
+				m_iterationCost = sample;
 			}
 		}
 	}
 
-	m_stackAllocator.Free(stack);
+	if (profile)
+	{
+		profile->islandBuild += timer.GetMilliseconds();
+		timer.Reset();
+	}
 
-	// Synchronize shapes, check for out of range bodies.
-	for (b2Body* b = m_bodyList; b; b = b->GetNext())
+	// Synchronize shapes, check for out of range bodies. Static bodies and
+	// sleeping islands never move.
+	for (pi = m_islandManager.m_awakeList; pi; pi = pi->next)
 	{
-		if (b->m_flags & (b2Body::e_sleepFlag | b2Body::e_frozenFlag))
+		for (b2Body* b = pi->bodyList; b; b = b->m_islandNext)
 		{
-			continue;
-		}
+			if (b->m_flags & (b2Body::e_sleepFlag | b2Body::e_frozenFlag))
+			{
+				continue;
+			}
 
-		if (b->IsStatic())
-		{
-			continue;
-		}
-		
-		// Update shapes (for broad-phase). If the shapes go out of
-		// the world AABB then shapes and contacts may be destroyed,
-		// including contacts that are
-		bool inRange = b->SynchronizeShapes();
+			// Update shapes (for broad-phase). If the shapes go out of
+			// the world AABB then shapes and contacts may be destroyed,
+			// including contacts that are
+			bool inRange = b->SynchronizeShapes();
 
-		// Did the body's shapes leave the world?
-		if (inRange == false && m_boundaryListener != NULL)
-		{
-			m_boundaryListener->Violation(b);
+			// Did the body's shapes leave the world?
+			if (inRange == false && m_boundaryListener != NULL)
+			{
+				m_boundaryListener->Violation(b);
+			}
 		}
 	}
 
 	// Commit shape proxy movements to the broad-phase so that new contacts are created.
 	// Also, some contacts can be destroyed.
 	m_broadPhase->Commit();
+
+	if (profile)
+	{
+		profile->broadphase += timer.GetMilliseconds();
+	}
 }
 
 // Find TOI contacts and solve them.
@@ -546,10 +859,12 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		b->m_sweep.t0 = 0.0f;
 	}
 
-	for (b2Contact* c = m_contactList; c; c = c->m_next)
+	// Sleeping contacts have no TOI state, see b2ContactManager::SetAwake.
+	b2Contact** contacts = m_contactManager.m_contacts;
+	for (int32 i = 0; i < m_contactManager.m_awakeContactCount; ++i)
 	{
 		// Invalidate TOI
-		c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+		contacts[i]->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
 	}
 
 	for (b2Joint* j = m_jointList; j; j = j->m_next)
@@ -564,8 +879,11 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		b2Contact* minContact = NULL;
 		float32 minTOI = 1.0f;
 
-		for (b2Contact* c = m_contactList; c; c = c->m_next)
+		// The array may be reallocated or repartitioned by the previous TOI island.
+		contacts = m_contactManager.m_contacts;
+		for (int32 i = 0; i < m_contactManager.m_awakeContactCount; ++i)
 		{
+			b2Contact* c = contacts[i];
 			if (c->m_flags & (b2Contact::e_slowFlag | b2Contact::e_nonSolidFlag))
 			{
 				continue;
@@ -639,6 +957,13 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			break;
 		}
 
+		// Out of time? Leave the remaining events unsolved.
+		if (m_stepBudget > 0.0f && m_stepTimer.GetMilliseconds() > m_stepBudget)
+		{
+			m_degraded = true;
+			break;
+		}
+
 		// Advance the bodies to the TOI.
 		b2Shape* s1 = minContact->GetShape1();
 		b2Shape* s2 = minContact->GetShape2();
@@ -684,6 +1009,10 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 			// Make sure the body is awake.
 			b->m_flags &= ~b2Body::e_sleepFlag;
+			if (b->m_island)
+			{
+				m_islandManager.WakeIsland(b->m_island);
+			}
 
 			// To keep islands as small as possible, we don't
 			// propagate islands across static bodies.
@@ -781,9 +1110,16 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.dtRatio = 0.0f;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.positionIterations = step.positionIterations;
+		subStep.velocityTolerance = step.velocityTolerance;
+		subStep.directJoints = false;
 
 		island.SolveTOI(subStep);
 
+		if (m_profiling)
+		{
+			++m_profile.toiCount;
+		}
+
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
 		{
@@ -836,95 +1172,500 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		
 		// Commit shape proxy movements to the broad-phase so that new contacts are created.
 		// Also, some contacts can be destroyed.
+		b2Timer timer;
+		if (m_profiling)
+		{
+			timer.Reset();
+		}
+
 		m_broadPhase->Commit();
+
+		if (m_profiling)
+		{
+			m_profile.broadphase += timer.GetMilliseconds();
+		}
 	}
 
 	m_stackAllocator.Free(queue);
 }
 
-void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
+// Forwards contact callbacks to the user listener and measures the time spent in them.
+class b2ProfileListener : public b2ContactListener
 {
-	m_lock = true;
+public:
+	void Add(const b2ContactPoint* point)
+	{
+		m_timer.Reset();
+		m_listener->Add(point);
+		Stop();
+	}
 
-	b2TimeStep step;
-	step.dt = dt;
-	step.velocityIterations	= velocityIterations;
-	step.positionIterations = positionIterations;
-	if (dt > 0.0f)
+	void Persist(const b2ContactPoint* point)
 	{
-		step.inv_dt = 1.0f / dt;
+		m_timer.Reset();
+		m_listener->Persist(point);
+		Stop();
 	}
-	else
+
+	void Remove(const b2ContactPoint* point)
 	{
-		step.inv_dt = 0.0f;
+		m_timer.Reset();
+		m_listener->Remove(point);
+		Stop();
 	}
 
-	step.dtRatio = m_inv_dt0 * dt;
+	void Result(const b2ContactResult* point)
+	{
+		m_timer.Reset();
+		m_listener->Result(point);
+		Stop();
+	}
 
+	void Stop()
+	{
+		m_profile->listeners += m_timer.GetMilliseconds();
+		++m_profile->listenerCalls;
+	}
+
+	b2ContactListener* m_listener;
+	b2Profile* m_profile;
+	b2Timer m_timer;
+};
+
+void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
+{
+	BeginEdit();
+
+	// Calls made during the step are not recorded.
+	b2RecordScope scope(this);
+	if (scope.m_recorder)
+	{
+		scope.m_recorder->RecordStep(this, dt, velocityIterations, positionIterations);
+	}
+
+	b2Timer timer;
+	b2ProfileListener profileListener;
+	b2ContactListener* listener = m_contactListener;
+	bool budget = m_stepBudget > 0.0f;
+	if (m_profiling || budget)
+	{
+		m_stepTimer.Reset();
+	}
+
+	m_degraded = false;
+	m_budgetMark = 0.0f;
+
+	if (m_profiling)
+	{
+		m_profile = b2Profile();
+		m_broadPhase->m_pairManager.ResetCounters();
+
+		// Route listener callbacks through the timer for this step.
+		if (listener)
+		{
+			profileListener.m_listener = listener;
+			profileListener.m_profile = &m_profile;
+			m_contactListener = &profileListener;
+		}
+	}
+
+	m_lock = true;
+
+	b2TimeStep step;
+	step.dt = dt;
+	step.velocityIterations	= velocityIterations;
+	step.positionIterations = positionIterations;
+	if (dt > 0.0f)
+	{
+		step.inv_dt = 1.0f / dt;
+	}
+	else
+	{
+		step.inv_dt = 0.0f;
+	}
+
+	step.dtRatio = m_inv_dt0 * dt;
+
+	step.velocityTolerance = m_velocityTolerance;
 	step.warmStarting = m_warmStarting;
+	step.directJoints = m_directJoints;
 	
 	// Update contacts.
+	if (m_profiling)
+	{
+		m_profile.contactCount = m_contactManager.m_awakeContactCount;
+		timer.Reset();
+	}
+
 	m_contactManager.Collide();
 
+	if (m_profiling)
+	{
+		m_profile.collide = timer.GetMilliseconds();
+	}
+
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	if (step.dt > 0.0f)
 	{
+		if (m_profiling)
+		{
+			timer.Reset();
+		}
+
 		Solve(step);
+
+		if (m_profiling)
+		{
+			m_profile.solve = timer.GetMilliseconds();
+		}
 	}
 
 	// Handle TOI events.
 	if (m_continuousPhysics && step.dt > 0.0f)
 	{
+		if (m_profiling)
+		{
+			timer.Reset();
+		}
+
 		SolveTOI(step);
+
+		if (m_profiling)
+		{
+			m_profile.solveTOI = timer.GetMilliseconds();
+		}
 	}
 
-	// Draw debug information.
-	DrawDebugData();
+	// Move the particles against the final body poses.
+	if (m_particleSystemList && step.dt > 0.0f)
+	{
+		if (m_profiling)
+		{
+			timer.Reset();
+		}
+
+		for (b2ParticleSystem* ps = m_particleSystemList; ps; ps = ps->m_next)
+		{
+			ps->Solve(step);
+		}
+
+		if (m_profiling)
+		{
+			m_profile.particles = timer.GetMilliseconds();
+			for (b2ParticleSystem* ps = m_particleSystemList; ps; ps = ps->m_next)
+			{
+				m_profile.particleCount += ps->GetParticleCount();
+			}
+		}
+	}
+
+	// The user may have replaced the listener from inside a callback.
+	if (m_contactListener == &profileListener)
+	{
+		m_contactListener = listener;
+	}
+
+	// Draw debug information. An asynchronous step draws when it is waited on.
+	if (m_stepping == false)
+	{
+		DrawDebugData();
+	}
+
+	if (m_profiling)
+	{
+		b2PairManager* pm = &m_broadPhase->m_pairManager;
+		m_profile.pairsAdded = pm->m_addedCount;
+		m_profile.pairsRemoved = pm->m_removedCount;
+		m_profile.pairsCancelled = pm->m_cancelledCount;
+		m_profile.step = m_stepTimer.GetMilliseconds();
+	}
+
+	if (budget && m_budgetMark > 0.0f)
+	{
+		float32 sample = m_stepTimer.GetMilliseconds() - m_budgetMark;
+		m_budgetReserve += b2_budgetSmoothing * (sample - m_budgetReserve);
+	}
 
 	m_inv_dt0 = step.inv_dt;
 	m_lock = false;
 }
 
-int32 b2World::Query(const b2AABB& aabb, b2Shape** shapes, int32 maxCount)
+int32 b2World::Advance(float32 elapsed, float32 timeStep, int32 velocityIterations, int32 positionIterations, int32 maxSteps)
 {
-	void** results = (void**)m_stackAllocator.Allocate(maxCount * sizeof(void*));
+	b2Assert(timeStep > 0.0f);
+
+	Wait();
+
+	m_accumulator += elapsed;
+
+	int32 stepCount = 0;
+	while (m_accumulator >= timeStep && stepCount < maxSteps)
+	{
+		// Remember where the moving bodies start this step. Static bodies never move and
+		// sleeping bodies are reported at their current pose.
+		for (b2PersistentIsland* pi = m_islandManager.m_awakeList; pi; pi = pi->next)
+		{
+			for (b2Body* b = pi->bodyList; b; b = b->m_islandNext)
+			{
+				b->m_position0 = b->m_xf.position;
+				b->m_angle0 = b->m_sweep.a;
+			}
+		}
+
+		Step(timeStep, velocityIterations, positionIterations);
 
-	int32 count = m_broadPhase->Query(aabb, results, maxCount);
+		m_accumulator -= timeStep;
+		++stepCount;
+	}
 
-	for (int32 i = 0; i < count; ++i)
+	if (m_accumulator >= timeStep)
 	{
-		shapes[i] = (b2Shape*)results[i];
+		// Fell behind. Drop the backlog.
+		m_accumulator = 0.0f;
+	}
+
+	m_interpolationAlpha = m_accumulator / timeStep;
+
+	return stepCount;
+}
+
+int32 b2World::GetInterpolatedTransforms(b2Body** bodies, b2Vec2* positions, float32* angles, int32 maxCount) const
+{
+	float32 alpha = m_interpolationAlpha;
+	float32 alpha0 = 1.0f - alpha;
+
+	int32 count = 0;
+	for (b2Body* b = m_bodyList; b && count < maxCount; b = b->m_next)
+	{
+		if (b->IsStatic())
+		{
+			continue;
+		}
+
+		bodies[count] = b;
+		if (b->IsSleeping() || b->IsActive() == false)
+		{
+			positions[count] = b->m_xf.position;
+			angles[count] = b->m_sweep.a;
+		}
+		else
+		{
+			positions[count] = alpha0 * b->m_position0 + alpha * b->m_xf.position;
+			angles[count] = alpha0 * b->m_angle0 + alpha * b->m_sweep.a;
+		}
+		++count;
 	}
 
-	m_stackAllocator.Free(results);
 	return count;
 }
 
-int32 b2World::Raycast(const b2Segment& segment, b2Shape** shapes, int32 maxCount, bool solidShapes, void* userData)
+void b2World::StepAsync(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
-	m_raycastSegment = &segment;
-	m_raycastUserData = userData;
-	m_raycastSolidShape = solidShapes;
+	Wait();
 
-	void** results = (void**)m_stackAllocator.Allocate(maxCount * sizeof(void*));
+	ReserveSnapshots();
 
-	int32 count = m_broadPhase->QuerySegment(segment,results,maxCount, &RaycastSortKey);
+	// The host reads the front snapshot during the step. It is still current
+	// unless the world was changed since the last step completed.
+	if (m_snapshotDirty)
+	{
+		m_frontSnapshot->Capture(this);
+		m_snapshotDirty = false;
+	}
+
+	m_asyncTimeStep = dt;
+	m_asyncVelocityIterations = velocityIterations;
+	m_asyncPositionIterations = positionIterations;
+	m_stepping = true;
+
+	m_thread.Start(&StepThread, this);
+}
+
+void b2World::StepThread(void* world)
+{
+	b2World* w = (b2World*)world;
+	w->Step(w->m_asyncTimeStep, w->m_asyncVelocityIterations, w->m_asyncPositionIterations);
+	w->m_backSnapshot->Capture(w);
+}
 
-	for (int32 i = 0; i < count; ++i)
+void b2World::Wait()
+{
+	if (m_stepping == false || m_thread.IsCurrent())
 	{
-		shapes[i] = (b2Shape*)results[i];
+		return;
 	}
 
-	m_stackAllocator.Free(results);
-	return count;
+	m_thread.Join();
+	m_stepping = false;
+
+	b2WorldSnapshot* snapshot = m_frontSnapshot;
+	m_frontSnapshot = m_backSnapshot;
+	m_backSnapshot = snapshot;
+	m_snapshotDirty = false;
+
+	FlushCommands();
+
+	DrawDebugData();
+}
+
+int32 b2World::GetTransforms(b2Body** bodies, b2Vec2* positions, float32* angles, int32 maxCount)
+{
+	if (m_stepping == false && m_snapshotDirty)
+	{
+		ReserveSnapshots();
+		m_frontSnapshot->Capture(this);
+		m_snapshotDirty = false;
+	}
+
+	return m_frontSnapshot->GetTransforms(bodies, positions, angles, maxCount);
+}
+
+void b2World::BeginEdit()
+{
+	Wait();
+	m_snapshotDirty = true;
+}
+
+void b2World::ReserveSnapshots()
+{
+	if (m_frontSnapshot == NULL)
+	{
+		void* mem = b2Alloc(sizeof(b2WorldSnapshot));
+		m_frontSnapshot = new (mem) b2WorldSnapshot;
+		mem = b2Alloc(sizeof(b2WorldSnapshot));
+		m_backSnapshot = new (mem) b2WorldSnapshot;
+	}
+}
+
+void b2World::Defer(b2BodyCommand::Type type, b2Body* body, const b2Vec2& vector, const b2Vec2& point, float32 scalar)
+{
+	if (m_commandCount == m_commandCapacity)
+	{
+		b2BodyCommand* oldCommands = m_commands;
+		m_commandCapacity = b2Max(2 * m_commandCapacity, 64);
+		m_commands = (b2BodyCommand*)b2Alloc(m_commandCapacity * sizeof(b2BodyCommand));
+
+		if (oldCommands)
+		{
+			memcpy(m_commands, oldCommands, m_commandCount * sizeof(b2BodyCommand));
+			b2Free(oldCommands);
+		}
+	}
+
+	b2BodyCommand* command = m_commands + m_commandCount;
+	command->type = type;
+	command->body = body;
+	command->vector = vector;
+	command->point = point;
+	command->scalar = scalar;
+	++m_commandCount;
+}
+
+void b2World::FlushCommands()
+{
+	for (int32 i = 0; i < m_commandCount; ++i)
+	{
+		b2BodyCommand* command = m_commands + i;
+		b2Body* b = command->body;
+		switch (command->type)
+		{
+		case b2BodyCommand::e_applyForce:
+			b->ApplyForce(command->vector, command->point);
+			break;
+
+		case b2BodyCommand::e_applyTorque:
+			b->ApplyTorque(command->scalar);
+			break;
+
+		case b2BodyCommand::e_applyImpulse:
+			b->ApplyImpulse(command->vector, command->point);
+			break;
+
+		case b2BodyCommand::e_setLinearVelocity:
+			b->SetLinearVelocity(command->vector);
+			break;
+
+		case b2BodyCommand::e_setAngularVelocity:
+			b->SetAngularVelocity(command->scalar);
+			break;
+
+		case b2BodyCommand::e_setXForm:
+			b->SetXForm(command->vector, command->scalar);
+			break;
+
+		case b2BodyCommand::e_wakeUp:
+			b->WakeUp();
+			break;
+
+		case b2BodyCommand::e_putToSleep:
+			b->PutToSleep();
+			break;
+		}
+	}
+
+	m_commandCount = 0;
+}
+
+int32 b2World::Query(const b2AABB& aabb, b2Shape** shapes, int32 maxCount)
+{
+	if (IsDeferring())
+	{
+		return m_frontSnapshot->Query(aabb, shapes, maxCount);
+	}
+
+	// Results go straight into the caller's buffer rather than m_stackAllocator
+	// so that queries can run concurrently between steps.
+	return m_broadPhase->Query(aabb, (void**)shapes, maxCount);
+}
+
+// Per-call raycast state handed to RaycastSortKey.
+struct b2RaycastInput
+{
+	b2World* world;
+	const b2Segment* segment;
+	void* userData;
+	int32 layer;
+	bool solidShapes;
+};
+
+int32 b2World::Raycast(const b2Segment& segment, b2Shape** shapes, int32 maxCount, bool solidShapes, void* userData)
+{
+	return Raycast(segment, shapes, maxCount, solidShapes, userData, 0);
+}
+
+int32 b2World::Raycast(const b2Segment& segment, b2Shape** shapes, int32 maxCount, bool solidShapes, void* userData, int32 layer)
+{
+	if (IsDeferring())
+	{
+		return m_frontSnapshot->Raycast(segment, shapes, maxCount, solidShapes, userData, layer);
+	}
+
+	b2RaycastInput input;
+	input.world = this;
+	input.segment = &segment;
+	input.userData = userData;
+	input.layer = layer;
+	input.solidShapes = solidShapes;
+
+	return m_broadPhase->QuerySegment(segment, (void**)shapes, maxCount, &RaycastSortKey, &input);
 }
 
 b2Shape* b2World::RaycastOne(const b2Segment& segment, float32* lambda, b2Vec2* normal, bool solidShapes, void* userData)
 {
+	return RaycastOne(segment, lambda, normal, solidShapes, userData, 0);
+}
+
+b2Shape* b2World::RaycastOne(const b2Segment& segment, float32* lambda, b2Vec2* normal, bool solidShapes, void* userData, int32 layer)
+{
+	if (IsDeferring())
+	{
+		return m_frontSnapshot->RaycastOne(segment, lambda, normal, solidShapes, userData, layer);
+	}
+
 	int32 maxCount = 1;
 	b2Shape* shape;
 
-	int32 count = Raycast(segment, &shape, maxCount, solidShapes, userData);
+	int32 count = Raycast(segment, &shape, maxCount, solidShapes, userData, layer);
 
 	if(count==0)
 		return NULL;
@@ -1002,6 +1743,69 @@ void b2World::DrawShape(b2Shape* shape, const b2XForm& xf, const b2Color& color,
 			}
 		}
 		break;
+
+	case e_meshShape:
+		{
+			b2MeshShape* mesh = (b2MeshShape*)shape;
+
+			for (int32 i = 0; i < mesh->GetEdgeCount(); ++i)
+			{
+				const b2EdgeShape* edge = mesh->GetEdge(i);
+				m_debugDraw->DrawSegment(b2Mul(xf, edge->GetVertex1()), b2Mul(xf, edge->GetVertex2()), color);
+
+				if (core)
+				{
+					m_debugDraw->DrawSegment(b2Mul(xf, edge->GetCoreVertex1()), b2Mul(xf, edge->GetCoreVertex2()), coreColor);
+				}
+			}
+		}
+		break;
+
+	case e_tileGridShape:
+		{
+			b2TileGridShape* grid = (b2TileGridShape*)shape;
+			b2Vec2 vertices[b2_maxPolygonVertices];
+
+			for (int32 y = 0; y < grid->GetHeight(); ++y)
+			{
+				for (int32 x = 0; x < grid->GetWidth(); ++x)
+				{
+					const b2PolygonShape* poly = grid->GetTilePolygon(grid->GetTile(x, y));
+					if (poly == NULL)
+					{
+						continue;
+					}
+
+					b2Vec2 offset = grid->GetCellOffset(x, y);
+					int32 vertexCount = poly->GetVertexCount();
+					const b2Vec2* localVertices = poly->GetVertices();
+					for (int32 i = 0; i < vertexCount; ++i)
+					{
+						vertices[i] = b2Mul(xf, localVertices[i] + offset);
+					}
+
+					m_debugDraw->DrawSolidPolygon(vertices, vertexCount, color);
+				}
+			}
+		}
+		break;
+
+	case e_heightfieldShape:
+		{
+			b2HeightfieldShape* field = (b2HeightfieldShape*)shape;
+
+			for (int32 i = 0; i < field->GetEdgeCount(); ++i)
+			{
+				const b2EdgeShape* edge = field->GetEdge(i);
+				m_debugDraw->DrawSegment(b2Mul(xf, edge->GetVertex1()), b2Mul(xf, edge->GetVertex2()), color);
+
+				if (core)
+				{
+					m_debugDraw->DrawSegment(b2Mul(xf, edge->GetCoreVertex1()), b2Mul(xf, edge->GetCoreVertex2()), coreColor);
+				}
+			}
+		}
+		break;
 	}
 }
 
@@ -1046,6 +1850,16 @@ void b2World::DrawJoint(b2Joint* joint)
 	}
 }
 
+static void b2DrawAABB(b2DebugDraw* debugDraw, const b2AABB& b, const b2Color& color)
+{
+	b2Vec2 vs[4];
+	vs[0].Set(b.lowerBound.x, b.lowerBound.y);
+	vs[1].Set(b.upperBound.x, b.lowerBound.y);
+	vs[2].Set(b.upperBound.x, b.upperBound.y);
+	vs[3].Set(b.lowerBound.x, b.upperBound.y);
+	debugDraw->DrawPolygon(vs, 4, color);
+}
+
 void b2World::DrawDebugData()
 {
 	if (m_debugDraw == NULL)
@@ -1053,8 +1867,16 @@ void b2World::DrawDebugData()
 		return;
 	}
 
+	m_debugDraw->BeginDraw();
+
 	uint32 flags = m_debugDraw->GetFlags();
 
+	if (m_debugDrawViewSet)
+	{
+		DrawDebugView(flags);
+		return;
+	}
+
 	if (flags & b2DebugDraw::e_shapeBit)
 	{
 		bool core = (flags & b2DebugDraw::e_coreShapeBit) == b2DebugDraw::e_coreShapeBit;
@@ -1062,20 +1884,10 @@ void b2World::DrawDebugData()
 		for (b2Body* b = m_bodyList; b; b = b->GetNext())
 		{
 			const b2XForm& xf = b->GetXForm();
+			b2Color color = GetDebugColor(b);
 			for (b2Shape* s = b->GetShapeList(); s; s = s->GetNext())
 			{
-				if (b->IsStatic())
-				{
-					DrawShape(s, xf, b2Color(0.5f, 0.9f, 0.5f), core);
-				}
-				else if (b->IsSleeping())
-				{
-					DrawShape(s, xf, b2Color(0.5f, 0.5f, 0.9f), core);
-				}
-				else
-				{
-					DrawShape(s, xf, b2Color(0.9f, 0.9f, 0.9f), core);
-				}
+				DrawShape(s, xf, color, core);
 			}
 		}
 	}
@@ -1099,38 +1911,46 @@ void b2World::DrawDebugData()
 		}
 	}
 
+	if (flags & b2DebugDraw::e_particleBit)
+	{
+		for (b2ParticleSystem* ps = m_particleSystemList; ps; ps = ps->m_next)
+		{
+			const b2Vec2* positions = ps->GetPositionBuffer();
+			const float32* radii = ps->GetRadiusBuffer();
+			const uint32* particleFlags = ps->GetFlagsBuffer();
+			int32 count = ps->GetParticleCount();
+			for (int32 i = 0; i < count; ++i)
+			{
+				if (particleFlags[i] & e_fluidParticle)
+				{
+					m_debugDraw->DrawCircle(positions[i], radii[i], b2Color(0.3f, 0.5f, 0.9f));
+				}
+				else
+				{
+					m_debugDraw->DrawCircle(positions[i], radii[i], b2Color(0.8f, 0.7f, 0.5f));
+				}
+			}
+		}
+	}
+
 	if (flags & b2DebugDraw::e_pairBit)
 	{
 		b2BroadPhase* bp = m_broadPhase;
-		b2Vec2 invQ;
-		invQ.Set(1.0f / bp->m_quantizationFactor.x, 1.0f / bp->m_quantizationFactor.y);
 		b2Color color(0.9f, 0.9f, 0.3f);
 
-		for (int32 i = 0; i < b2_tableCapacity; ++i)
+		b2PairManager* pm = &bp->m_pairManager;
+		for (int32 i = 0; i < pm->m_pairCapacity; ++i)
 		{
-			uint16 index = bp->m_pairManager.m_hashTable[i];
-			while (index != b2_nullPair)
+			b2Pair* pair = pm->m_pairs + i;
+			if (pair->proxyId1 != b2_nullProxy)
 			{
-				b2Pair* pair = bp->m_pairManager.m_pairs + index;
-				b2Proxy* p1 = bp->m_proxyPool + pair->proxyId1;
-				b2Proxy* p2 = bp->m_proxyPool + pair->proxyId2;
-
-				b2AABB b1, b2;
-				b1.lowerBound.x = bp->m_worldAABB.lowerBound.x + invQ.x * bp->m_bounds[0][p1->lowerBounds[0]].value;
-				b1.lowerBound.y = bp->m_worldAABB.lowerBound.y + invQ.y * bp->m_bounds[1][p1->lowerBounds[1]].value;
-				b1.upperBound.x = bp->m_worldAABB.lowerBound.x + invQ.x * bp->m_bounds[0][p1->upperBounds[0]].value;
-				b1.upperBound.y = bp->m_worldAABB.lowerBound.y + invQ.y * bp->m_bounds[1][p1->upperBounds[1]].value;
-				b2.lowerBound.x = bp->m_worldAABB.lowerBound.x + invQ.x * bp->m_bounds[0][p2->lowerBounds[0]].value;
-				b2.lowerBound.y = bp->m_worldAABB.lowerBound.y + invQ.y * bp->m_bounds[1][p2->lowerBounds[1]].value;
-				b2.upperBound.x = bp->m_worldAABB.lowerBound.x + invQ.x * bp->m_bounds[0][p2->upperBounds[0]].value;
-				b2.upperBound.y = bp->m_worldAABB.lowerBound.y + invQ.y * bp->m_bounds[1][p2->upperBounds[1]].value;
+				b2AABB b1 = bp->GetProxyAABB(pair->proxyId1);
+				b2AABB b2 = bp->GetProxyAABB(pair->proxyId2);
 
 				b2Vec2 x1 = 0.5f * (b1.lowerBound + b1.upperBound);
 				b2Vec2 x2 = 0.5f * (b2.lowerBound + b2.upperBound);
 
 				m_debugDraw->DrawSegment(x1, x2, color);
-
-				index = pair->next;
 			}
 		}
 	}
@@ -1138,41 +1958,20 @@ void b2World::DrawDebugData()
 	if (flags & b2DebugDraw::e_aabbBit)
 	{
 		b2BroadPhase* bp = m_broadPhase;
-		b2Vec2 worldLower = bp->m_worldAABB.lowerBound;
-		b2Vec2 worldUpper = bp->m_worldAABB.upperBound;
 
-		b2Vec2 invQ;
-		invQ.Set(1.0f / bp->m_quantizationFactor.x, 1.0f / bp->m_quantizationFactor.y);
 		b2Color color(0.9f, 0.3f, 0.9f);
-		for (int32 i = 0; i < b2_maxProxies; ++i)
+		int32 proxyCapacity = bp->GetProxyCapacity();
+		for (int32 i = 0; i < proxyCapacity; ++i)
 		{
-			b2Proxy* p = bp->m_proxyPool + i;
-			if (p->IsValid() == false)
+			if (bp->IsProxyValid(i) == false)
 			{
 				continue;
 			}
 
-			b2AABB b;
-			b.lowerBound.x = worldLower.x + invQ.x * bp->m_bounds[0][p->lowerBounds[0]].value;
-			b.lowerBound.y = worldLower.y + invQ.y * bp->m_bounds[1][p->lowerBounds[1]].value;
-			b.upperBound.x = worldLower.x + invQ.x * bp->m_bounds[0][p->upperBounds[0]].value;
-			b.upperBound.y = worldLower.y + invQ.y * bp->m_bounds[1][p->upperBounds[1]].value;
-
-			b2Vec2 vs[4];
-			vs[0].Set(b.lowerBound.x, b.lowerBound.y);
-			vs[1].Set(b.upperBound.x, b.lowerBound.y);
-			vs[2].Set(b.upperBound.x, b.upperBound.y);
-			vs[3].Set(b.lowerBound.x, b.upperBound.y);
-
-			m_debugDraw->DrawPolygon(vs, 4, color);
+			b2DrawAABB(m_debugDraw, bp->GetProxyAABB(i), color);
 		}
 
-		b2Vec2 vs[4];
-		vs[0].Set(worldLower.x, worldLower.y);
-		vs[1].Set(worldUpper.x, worldLower.y);
-		vs[2].Set(worldUpper.x, worldUpper.y);
-		vs[3].Set(worldLower.x, worldUpper.y);
-		m_debugDraw->DrawPolygon(vs, 4, b2Color(0.3f, 0.9f, 0.9f));
+		b2DrawAABB(m_debugDraw, bp->m_worldAABB, b2Color(0.3f, 0.9f, 0.9f));
 	}
 
 	if (flags & b2DebugDraw::e_obbBit)
@@ -1220,14 +2019,223 @@ void b2World::DrawDebugData()
 	}
 }
 
+b2Color b2World::GetDebugColor(const b2Body* body) const
+{
+	if (body->IsActive() == false)
+	{
+		return b2Color(0.5f, 0.5f, 0.3f);
+	}
+	else if (body->IsStatic())
+	{
+		return b2Color(0.5f, 0.9f, 0.5f);
+	}
+	else if (body->IsSleeping())
+	{
+		return b2Color(0.5f, 0.5f, 0.9f);
+	}
+
+	return b2Color(0.9f, 0.9f, 0.9f);
+}
+
+void b2World::DrawDebugView(uint32 flags)
+{
+	const b2AABB& view = m_debugDrawView;
+	b2BroadPhase* bp = m_broadPhase;
+
+	// The broad-phase finds the visible shapes. Their bodies are gathered once each.
+	int32 capacity = b2Max(bp->GetProxyCount(), 1);
+	b2Shape** shapes = (b2Shape**)m_stackAllocator.Allocate(capacity * sizeof(b2Shape*));
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(capacity * sizeof(b2Body*));
+	int32 shapeCount = bp->Query(view, (void**)shapes, capacity);
+	int32 bodyCount = 0;
+
+	for (int32 i = 0; i < shapeCount; ++i)
+	{
+		b2Body* b = shapes[i]->GetBody();
+		if ((b->m_flags & b2Body::e_debugDrawFlag) == 0)
+		{
+			b->m_flags |= b2Body::e_debugDrawFlag;
+			bodies[bodyCount++] = b;
+		}
+	}
+
+	if (flags & b2DebugDraw::e_shapeBit)
+	{
+		bool core = (flags & b2DebugDraw::e_coreShapeBit) == b2DebugDraw::e_coreShapeBit;
+
+		for (int32 i = 0; i < shapeCount; ++i)
+		{
+			b2Body* b = shapes[i]->GetBody();
+			DrawShape(shapes[i], b->GetXForm(), GetDebugColor(b), core);
+		}
+	}
+
+	if (flags & b2DebugDraw::e_jointBit)
+	{
+		for (int32 i = 0; i < bodyCount; ++i)
+		{
+			b2Body* b = bodies[i];
+			for (b2JointEdge* jn = b->GetJointList(); jn; jn = jn->next)
+			{
+				// A joint between two visible bodies is drawn from its first body.
+				b2Joint* j = jn->joint;
+				if (j->GetType() == e_mouseJoint)
+				{
+					continue;
+				}
+
+				if (j->GetBody1() == b || (jn->other->m_flags & b2Body::e_debugDrawFlag) == 0)
+				{
+					DrawJoint(j);
+				}
+			}
+		}
+	}
+
+	if (flags & b2DebugDraw::e_controllerBit)
+	{
+		for (b2Controller* c = m_controllerList; c; c= c->GetNext())
+		{
+			c->Draw(m_debugDraw);
+		}
+	}
+
+	if (flags & b2DebugDraw::e_particleBit)
+	{
+		for (b2ParticleSystem* ps = m_particleSystemList; ps; ps = ps->m_next)
+		{
+			const b2Vec2* positions = ps->GetPositionBuffer();
+			const float32* radii = ps->GetRadiusBuffer();
+			const uint32* particleFlags = ps->GetFlagsBuffer();
+			int32 count = ps->GetParticleCount();
+			for (int32 i = 0; i < count; ++i)
+			{
+				b2Vec2 p = positions[i];
+				float32 r = radii[i];
+				if (p.x + r < view.lowerBound.x || p.x - r > view.upperBound.x ||
+					p.y + r < view.lowerBound.y || p.y - r > view.upperBound.y)
+				{
+					continue;
+				}
+
+				if (particleFlags[i] & e_fluidParticle)
+				{
+					m_debugDraw->DrawCircle(p, r, b2Color(0.3f, 0.5f, 0.9f));
+				}
+				else
+				{
+					m_debugDraw->DrawCircle(p, r, b2Color(0.8f, 0.7f, 0.5f));
+				}
+			}
+		}
+	}
+
+	if (flags & b2DebugDraw::e_pairBit)
+	{
+		// Pairs only exist between overlapping proxies, so the candidates of a visible
+		// proxy are found by querying its own bounds. A pair between two visible proxies
+		// is drawn from the lower proxy id.
+		b2Color color(0.9f, 0.9f, 0.3f);
+		b2Shape** others = (b2Shape**)m_stackAllocator.Allocate(capacity * sizeof(b2Shape*));
+
+		for (int32 i = 0; i < shapeCount; ++i)
+		{
+			int32 proxyId = shapes[i]->m_proxyId;
+			b2AABB b1 = bp->GetProxyAABB(proxyId);
+			b2Vec2 x1 = 0.5f * (b1.lowerBound + b1.upperBound);
+
+			int32 otherCount = bp->Query(b1, (void**)others, capacity);
+			for (int32 k = 0; k < otherCount; ++k)
+			{
+				int32 otherId = others[k]->m_proxyId;
+				if (otherId == proxyId || bp->m_pairManager.HasPair(proxyId, otherId) == false)
+				{
+					continue;
+				}
+
+				b2AABB b2 = bp->GetProxyAABB(otherId);
+				if (otherId < proxyId && b2TestOverlap(view, b2))
+				{
+					continue;
+				}
+
+				b2Vec2 x2 = 0.5f * (b2.lowerBound + b2.upperBound);
+				m_debugDraw->DrawSegment(x1, x2, color);
+			}
+		}
+
+		m_stackAllocator.Free(others);
+	}
+
+	if (flags & b2DebugDraw::e_aabbBit)
+	{
+		b2Color color(0.9f, 0.3f, 0.9f);
+		for (int32 i = 0; i < shapeCount; ++i)
+		{
+			b2DrawAABB(m_debugDraw, bp->GetProxyAABB(shapes[i]->m_proxyId), color);
+		}
+
+		b2DrawAABB(m_debugDraw, bp->m_worldAABB, b2Color(0.3f, 0.9f, 0.9f));
+	}
+
+	if (flags & b2DebugDraw::e_obbBit)
+	{
+		b2Color color(0.5f, 0.3f, 0.5f);
+
+		for (int32 i = 0; i < shapeCount; ++i)
+		{
+			b2Shape* s = shapes[i];
+			if (s->GetType() != e_polygonShape)
+			{
+				continue;
+			}
+
+			const b2XForm& xf = s->GetBody()->GetXForm();
+			b2PolygonShape* poly = (b2PolygonShape*)s;
+			const b2OBB& obb = poly->GetOBB();
+			b2Vec2 h = obb.extents;
+			b2Vec2 vs[4];
+			vs[0].Set(-h.x, -h.y);
+			vs[1].Set( h.x, -h.y);
+			vs[2].Set( h.x,  h.y);
+			vs[3].Set(-h.x,  h.y);
+
+			for (int32 k = 0; k < 4; ++k)
+			{
+				vs[k] = obb.center + b2Mul(obb.R, vs[k]);
+				vs[k] = b2Mul(xf, vs[k]);
+			}
+
+			m_debugDraw->DrawPolygon(vs, 4, color);
+		}
+	}
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* b = bodies[i];
+		b->m_flags &= ~b2Body::e_debugDrawFlag;
+
+		if (flags & b2DebugDraw::e_centerOfMassBit)
+		{
+			b2XForm xf = b->GetXForm();
+			xf.position = b->GetWorldCenter();
+			m_debugDraw->DrawXForm(xf);
+		}
+	}
+
+	m_stackAllocator.Free(bodies);
+	m_stackAllocator.Free(shapes);
+}
+
 void b2World::Validate()
 {
 	m_broadPhase->Validate();
+	m_islandManager.Validate();
 }
 
 int32 b2World::GetProxyCount() const
 {
-	return m_broadPhase->m_proxyCount;
+	return m_broadPhase->GetProxyCount();
 }
 
 int32 b2World::GetPairCount() const
@@ -1240,22 +2248,29 @@ bool b2World::InRange(const b2AABB& aabb) const
 	return m_broadPhase->InRange(aabb);
 }
 
-float32 b2World::RaycastSortKey(void* data)
+float32 b2World::RaycastSortKey(void* context, void* data)
 {
+	b2RaycastInput* input = (b2RaycastInput*)context;
 	b2Shape* shape = (b2Shape*)data;
 	b2Body* body = shape->GetBody();
-	b2World* world = body->GetWorld();
+	b2World* world = input->world;
 	const b2XForm xf = body->GetXForm();
 
-	if(world->m_contactFilter && !world->m_contactFilter->RayCollide(world->m_raycastUserData,shape))
+	if (world->m_filterTable.RayCollide(input->layer, shape) == false)
+	{
+		return -1;
+	}
+
+	if(world->m_contactFilter && !world->m_contactFilter->RayCollide(input->userData,shape))
 		return -1;
 
 	float32 lambda;
-	b2SegmentCollide collide = shape->TestSegment(xf, &lambda, &world->m_raycastNormal, *world->m_raycastSegment,1);
+	b2Vec2 normal;
+	b2SegmentCollide collide = shape->TestSegment(xf, &lambda, &normal, *input->segment,1);
 
-	if(world->m_raycastSolidShape && collide==e_missCollide)
+	if(input->solidShapes && collide==e_missCollide)
 		return -1;
-	if(!world->m_raycastSolidShape && collide!=e_hitCollide)
+	if(!input->solidShapes && collide!=e_hitCollide)
 		return -1;
 
 	return lambda;
@@ -22,8 +22,12 @@
 #include "../Common/b2Math.h"
 #include "../Common/b2BlockAllocator.h"
 #include "../Common/b2StackAllocator.h"
+#include "../Common/b2Timer.h"
+#include "../Common/b2Thread.h"
 #include "b2ContactManager.h"
+#include "b2IslandManager.h"
 #include "b2WorldCallbacks.h"
+#include "b2FilterTable.h"
 
 struct b2AABB;
 struct b2ShapeDef;
@@ -36,6 +40,10 @@ class b2Contact;
 class b2BroadPhase;
 class b2Controller;
 class b2ControllerDef;
+class b2ParticleSystem;
+struct b2ParticleSystemDef;
+class b2WorldSnapshot;
+class b2WorldRecorder;
 
 struct b2TimeStep
 {
@@ -44,7 +52,63 @@ struct b2TimeStep
 	float32 dtRatio;	// dt * inv_dt0
 	int32 velocityIterations;
 	int32 positionIterations;
+	float32 velocityTolerance;	// velocity iteration early exit tolerance (0 to disable)
 	bool warmStarting;
+	bool directJoints;			// solve joint trees with b2JointTreeSolver
+};
+
+// A body change made while the world is stepping asynchronously. These are
+// applied in order when the step completes.
+struct b2BodyCommand
+{
+	enum Type
+	{
+		e_applyForce,
+		e_applyTorque,
+		e_applyImpulse,
+		e_setLinearVelocity,
+		e_setAngularVelocity,
+		e_setXForm,
+		e_wakeUp,
+		e_putToSleep
+	};
+
+	Type type;
+	b2Body* body;
+	b2Vec2 vector;
+	b2Vec2 point;
+	float32 scalar;
+};
+
+/// Per-step profiling data. Times are in milliseconds and cover the last call
+/// to b2World::Step. Listener time is also included in the phase that made the
+/// callbacks.
+struct b2Profile
+{
+	float32 step;			///< the whole step
+	float32 collide;		///< narrow phase (b2ContactManager::Collide)
+	float32 solve;			///< island simulation, including broad-phase synchronization
+	float32 islandBuild;	///< gathering, sleeping and splitting persistent islands
+	float32 solveInit;		///< velocity integration and constraint initialization
+	float32 solveVelocity;	///< velocity iterations
+	float32 solvePosition;	///< position integration and position iterations
+	float32 solveTOI;		///< continuous collision, including its broad-phase commits
+	float32 broadphase;		///< shape synchronization and broad-phase commits
+	float32 listeners;		///< time spent in contact listener callbacks
+	float32 particles;		///< particle systems
+
+	int32 islandCount;			///< islands solved
+	int32 bodyCount;			///< bodies solved
+	int32 contactCount;			///< awake contacts updated by the narrow phase
+	int32 jointCount;			///< joints solved
+	int32 velocityIterations;	///< velocity iterations actually run, summed over islands
+	int32 positionIterations;	///< position iterations run, summed over islands
+	int32 toiCount;				///< time of impact events solved
+	int32 listenerCalls;		///< contact listener callbacks made
+	int32 pairsAdded;			///< broad-phase pairs reported to the contact manager
+	int32 pairsRemoved;			///< broad-phase pairs removed after being reported
+	int32 pairsCancelled;		///< broad-phase pairs added and removed between two commits
+	int32 particleCount;		///< particles simulated
 };
 
 /// The world class manages all physics entities, dynamic simulation,
@@ -59,6 +123,15 @@ public:
 	/// @param doSleep improve performance by not simulating inactive bodies.
 	b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep);
 
+	/// Construct a world object that uses a uniform grid broad-phase instead of
+	/// sweep and prune. This suits scenes made of many shapes of about the same
+	/// size and is not limited to b2_maxProxies shapes.
+	/// @param worldAABB a bounding box that completely encompasses all your shapes.
+	/// @param gravity the world gravity vector.
+	/// @param doSleep improve performance by not simulating inactive bodies.
+	/// @param cellSize the grid cell size, about the size of a typical shape.
+	b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, float32 cellSize);
+
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
 
@@ -75,11 +148,24 @@ public:
 	/// Register a contact event listener
 	void SetContactListener(b2ContactListener* listener);
 
+	/// Register a sensor overlap listener.
+	void SetSensorListener(b2SensorListener* listener);
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside the b2World::Step method, so make sure your renderer is ready to
 	/// consume draw commands when you call Step().
 	void SetDebugDraw(b2DebugDraw* debugDraw);
 
+	/// Limit debug drawing to the shapes, broad-phase pairs and proxies that overlap a view.
+	/// The visible shapes are found with the broad-phase, so the cost follows what is on
+	/// screen rather than the size of the world. Joints attached to visible bodies and
+	/// particles inside the view are drawn too. Inactive bodies have no proxies and are
+	/// not drawn while a view is set.
+	void SetDebugDrawView(const b2AABB& view);
+
+	/// Draw the whole world again.
+	void ClearDebugDrawView();
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
@@ -106,10 +192,22 @@ public:
 	/// Removes a controller from the world.
 	void DestroyController(b2Controller* controller);
 
+	/// Create a particle system. No reference to the definition is retained.
+	/// @warning This function is locked during callbacks.
+	b2ParticleSystem* CreateParticleSystem(const b2ParticleSystemDef* def);
+
+	/// Destroy a particle system and all of its particles.
+	/// @warning This function is locked during callbacks.
+	void DestroyParticleSystem(b2ParticleSystem* system);
+
 	/// The world provides a single static ground body with no collision shapes.
 	/// You can use this to simplify the creation of joints and static shapes.
 	b2Body* GetGroundBody();
 
+	/// Get the filter table. Its rules are applied natively to new broad-phase pairs
+	/// and ray casts before the contact filter is called.
+	b2FilterTable* GetFilterTable();
+
 	/// Take a time step. This performs collision detection, integration,
 	/// and constraint solution.
 	/// @param timeStep the amount of time to simulate, this should not vary.
@@ -117,6 +215,62 @@ public:
 	/// @param positionIterations for the position constraint solver.
 	void Step(float32 timeStep, int32 velocityIterations, int32 positionIterations);
 
+	/// Advance the world by a variable amount of real time using fixed time steps. Elapsed
+	/// time is accumulated and whole steps are taken until less than one step remains. The
+	/// remainder is used to interpolate body poses, see GetInterpolatedTransforms.
+	/// @param elapsed the real time since the last call, in seconds.
+	/// @param timeStep the fixed amount of time to simulate per step.
+	/// @param velocityIterations for the velocity constraint solver.
+	/// @param positionIterations for the position constraint solver.
+	/// @param maxSteps the maximum number of steps to take. Time beyond this is dropped
+	/// so that slow frames don't build up a growing backlog.
+	/// @return the number of steps taken.
+	int32 Advance(float32 elapsed, float32 timeStep, int32 velocityIterations, int32 positionIterations, int32 maxSteps);
+
+	/// Get the fraction of a fixed step accumulated by Advance but not yet simulated.
+	/// @return the interpolation factor in [0,1).
+	float32 GetInterpolationAlpha() const;
+
+	/// Get the poses of all non-static bodies, interpolated between the last two steps taken
+	/// by Advance. Sleeping bodies report their current pose.
+	/// @param bodies a user allocated body pointer array of size maxCount (or greater).
+	/// @param positions a user allocated array receiving the body origin positions.
+	/// @param angles a user allocated array receiving the body angles in radians.
+	/// @param maxCount the capacity of the arrays.
+	/// @return the number of bodies written.
+	int32 GetInterpolatedTransforms(b2Body** bodies, b2Vec2* positions, float32* angles, int32 maxCount) const;
+
+	/// Take a time step on a background thread and return immediately. Call Wait to
+	/// complete the step. Until then:
+	/// - GetTransforms, Query, Raycast and RaycastOne see the world as it was before the step.
+	/// - Forces, impulses, velocities, transforms and sleep changes made through b2Body
+	/// are queued and applied by Wait, in order.
+	/// - Creating or destroying bodies, shapes, joints and controllers, changing body mass
+	/// and refiltering first wait for the step to complete. Don't change joints or
+	/// controllers directly.
+	/// - Don't read body transforms or velocities, the step is writing them. Read the
+	/// poses through GetTransforms until Wait returns. Debug builds assert on this.
+	/// Debug drawing happens in Wait, on the calling thread.
+	/// @warning Contact listeners, filters and the boundary listener are called on the
+	/// background thread.
+	void StepAsync(float32 timeStep, int32 velocityIterations, int32 positionIterations);
+
+	/// Wait for the step started by StepAsync to complete and apply the queued body changes.
+	/// This does nothing if no step is in progress.
+	void Wait();
+
+	/// Is a step started by StepAsync still in progress?
+	bool IsStepping() const;
+
+	/// Get the poses of all non-static bodies at the end of the last completed step. This
+	/// may be called while StepAsync is in progress.
+	/// @param bodies a user allocated body pointer array of size maxCount (or greater).
+	/// @param positions a user allocated array receiving the body origin positions.
+	/// @param angles a user allocated array receiving the body angles in radians.
+	/// @param maxCount the capacity of the arrays.
+	/// @return the number of bodies written.
+	int32 GetTransforms(b2Body** bodies, b2Vec2* positions, float32* angles, int32 maxCount);
+
 	/// Query the world for all shapes that potentially overlap the
 	/// provided AABB. You provide a shape pointer buffer of specified
 	/// size. The number of shapes found is returned.
@@ -124,6 +278,9 @@ public:
 	/// @param shapes a user allocated shape pointer array of size maxCount (or greater).
 	/// @param maxCount the capacity of the shapes array.
 	/// @return the number of shapes found in aabb.
+	/// @note Query, Raycast and RaycastOne use no shared scratch memory. They may be
+	/// called from several threads at once, but not while the world is being modified.
+	/// While StepAsync is in progress they see the world as it was before the step.
 	int32 Query(const b2AABB& aabb, b2Shape** shapes, int32 maxCount);
 
 	/// Query the world for all shapes that intersect a given segment. You provide a shap
@@ -136,8 +293,14 @@ public:
 	/// @param solidShapes determines if shapes that the ray starts in are counted as hits.
 	/// @param userData passed through the worlds contact filter, with method RayCollide. This can be used to filter valid shapes
 	/// @returns the number of shapes found
+	/// @note When raycasting from several threads, RayCollide must be thread-safe.
 	int32 Raycast(const b2Segment& segment, b2Shape** shapes, int32 maxCount, bool solidShapes, void* userData);
 
+	/// Query the world for all shapes on a ray layer that intersect a given segment.
+	/// Only shapes whose categories are in the layer's ray mask are considered, see
+	/// b2FilterTable::SetRayMask. The other parameters are as for Raycast.
+	int32 Raycast(const b2Segment& segment, b2Shape** shapes, int32 maxCount, bool solidShapes, void* userData, int32 layer);
+
 	/// Performs a raycast as with Raycast, finding the first intersecting shape.
 	/// @param segment defines the begin and end point of the ray cast, from p1 to p2.
 	/// Use b2Segment.Extend to create (semi-)infinite rays	
@@ -149,6 +312,9 @@ public:
 	/// @returns the colliding shape shape, or null if not found
 	b2Shape* RaycastOne(const b2Segment& segment, float32* lambda, b2Vec2* normal, bool solidShapes, void* userData);
 
+	/// Performs a raycast on a ray layer as with Raycast, finding the first intersecting shape.
+	b2Shape* RaycastOne(const b2Segment& segment, float32* lambda, b2Vec2* normal, bool solidShapes, void* userData, int32 layer);
+
 	/// Check if the AABB is within the broadphase limits.
 	bool InRange(const b2AABB& aabb) const;
 
@@ -167,6 +333,11 @@ public:
 	/// @return the head of the world controller list.
 	b2Controller* GetControllerList();
 
+	/// Get the world particle system list. With the returned system, use b2ParticleSystem::GetNext
+	/// to get the next particle system in the world list.
+	/// @return the head of the world particle system list.
+	b2ParticleSystem* GetParticleSystemList();
+
 	/// Re-filter a shape. This re-runs contact filtering on a shape.
 	void Refilter(b2Shape* shape);
 
@@ -176,6 +347,44 @@ public:
 	/// Enable/disable continuous physics. For testing.
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 
+	/// Let islands stop iterating velocity constraints early. An island stops once an
+	/// iteration changes no body's linear (m/s) or angular (rad/s) velocity by more than
+	/// the tolerance. The velocity iteration count passed to Step remains the maximum.
+	/// Use zero, the default, to always run every iteration.
+	void SetVelocityTolerance(float32 tolerance) { m_velocityTolerance = tolerance; }
+
+	/// Solve chains and trees of revolute and rigid distance joints directly, in time linear
+	/// in the number of joints. Their velocities and positions then converge in one iteration,
+	/// so ropes and ragdolls with heavy ends stay together; benchmark/joints.cpp compares both
+	/// solvers. Fast rotation of bodies held by joints under high tension is damped slightly.
+	/// Joints with limits or motors, springs, other joint types and joints that close a loop
+	/// are still solved iteratively.
+	/// This is disabled by default.
+	void SetDirectJointSolver(bool flag) { m_directJoints = flag; }
+
+	/// Limit the time taken by Step. When a step would overrun the budget, islands
+	/// are solved with fewer iterations and remaining time of impact events are skipped.
+	/// The cost of solving is estimated from previous steps.
+	/// @param milliseconds the time budget for each step, zero (the default) to disable.
+	void SetStepBudget(float32 milliseconds);
+
+	/// Did the last step lower solver quality to stay within the step budget?
+	bool IsDegraded() const;
+
+	/// Enable/disable step profiling. This is disabled by default.
+	void SetProfiling(bool flag);
+
+	/// Get the profile of the last time step. This is cleared when profiling is disabled.
+	const b2Profile& GetProfile() const;
+
+	/// Record the calls that change this world, see b2WorldRecorder. Call this
+	/// right after creating the world. Pass NULL to stop recording. The recorder
+	/// is owned by you and must outlive the recording.
+	void SetRecorder(b2WorldRecorder* recorder);
+
+	/// Get the recorder, NULL if the world is not being recorded.
+	b2WorldRecorder* GetRecorder();
+
 	/// Perform validation of internal data structures.
 	void Validate();
 
@@ -197,6 +406,9 @@ public:
 	/// Get the number of controllers.
 	int32 GetControllerCount() const;
 
+	/// Get the number of particle systems.
+	int32 GetParticleSystemCount() const;
+
 	/// Change the global gravity vector.
 	void SetGravity(const b2Vec2& gravity);
 	
@@ -206,8 +418,16 @@ public:
 private:
 
 	friend class b2Body;
+	friend class b2Contact;
 	friend class b2ContactManager;
+	friend class b2IslandManager;
 	friend class b2Controller;
+	friend class b2ParticleSystem;
+	friend class b2WorldSnapshot;
+	friend class b2RecordScope;
+	friend class b2WorldRecorder;
+
+	void Initialize(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, float32 cellSize);
 
 	void Solve(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
@@ -215,9 +435,24 @@ private:
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Shape* shape, const b2XForm& xf, const b2Color& color, bool core);
 	void DrawDebugData();
+	void DrawDebugView(uint32 flags);
+	b2Color GetDebugColor(const b2Body* body) const;
 
 	//Is it safe to pass private static function pointers?
-	static float32 RaycastSortKey(void* shape);
+	static float32 RaycastSortKey(void* context, void* shape);
+
+	static void StepThread(void* world);
+
+	// Should a change made by the caller be deferred until the asynchronous step completes?
+	bool IsDeferring() const;
+
+	// Called before the world or a body is changed. Completes any asynchronous step.
+	void BeginEdit();
+
+	void Defer(b2BodyCommand::Type type, b2Body* body, const b2Vec2& vector, const b2Vec2& point, float32 scalar);
+	void FlushCommands();
+
+	void ReserveSnapshots();
 
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
@@ -226,15 +461,13 @@ private:
 
 	b2BroadPhase* m_broadPhase;
 	b2ContactManager m_contactManager;
+	b2IslandManager m_islandManager;
 
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
 	b2Controller* m_controllerList;
+	b2ParticleSystem* m_particleSystemList;
 
-	b2Vec2 m_raycastNormal;
-	void* m_raycastUserData;
-	const b2Segment* m_raycastSegment;
-	bool m_raycastSolidShape;
 
 
 	// Do not access
@@ -244,6 +477,7 @@ private:
 	int32 m_contactCount;
 	int32 m_jointCount;
 	int32 m_controllerCount;
+	int32 m_particleSystemCount;
 
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
@@ -253,8 +487,15 @@ private:
 	b2DestructionListener* m_destructionListener;
 	b2BoundaryListener* m_boundaryListener;
 	b2ContactFilter* m_contactFilter;
+	b2FilterTable m_filterTable;
+	uint32 m_bodyIdCounter;
+	uint32 m_shapeIdCounter;
+	uint32 m_jointIdCounter;
 	b2ContactListener* m_contactListener;
+	b2SensorListener* m_sensorListener;
 	b2DebugDraw* m_debugDraw;
+	b2AABB m_debugDrawView;
+	bool m_debugDrawViewSet;
 
 	// This is used to compute the time step ratio to
 	// support a variable time step.
@@ -265,6 +506,41 @@ private:
 
 	// This is for debugging the solver.
 	bool m_continuousPhysics;
+
+	float32 m_velocityTolerance;
+	bool m_directJoints;
+
+	bool m_profiling;
+	b2Profile m_profile;
+
+	// Fixed step accumulator used by Advance.
+	float32 m_accumulator;
+	float32 m_interpolationAlpha;
+
+	// Step budget governor. Costs are estimates in milliseconds.
+	b2Timer m_stepTimer;
+	float32 m_stepBudget;
+	float32 m_iterationCost;	// per body/constraint and iteration
+	float32 m_budgetReserve;	// time needed after the islands are solved
+	float32 m_budgetMark;		// step time when the islands were solved
+	bool m_degraded;
+
+	// Asynchronous stepping. The host reads the front snapshot while the worker
+	// steps and captures the back snapshot. They are swapped by Wait.
+	b2Thread m_thread;
+	bool m_stepping;
+	float32 m_asyncTimeStep;
+	int32 m_asyncVelocityIterations;
+	int32 m_asyncPositionIterations;
+	b2WorldSnapshot* m_frontSnapshot;
+	b2WorldSnapshot* m_backSnapshot;
+	bool m_snapshotDirty;
+
+	b2BodyCommand* m_commands;
+	int32 m_commandCount;
+	int32 m_commandCapacity;
+
+	b2WorldRecorder* m_recorder;
 };
 
 inline b2Body* b2World::GetGroundBody()
@@ -272,6 +548,16 @@ inline b2Body* b2World::GetGroundBody()
 	return m_groundBody;
 }
 
+inline b2WorldRecorder* b2World::GetRecorder()
+{
+	return m_recorder;
+}
+
+inline b2FilterTable* b2World::GetFilterTable()
+{
+	return &m_filterTable;
+}
+
 inline b2Body* b2World::GetBodyList()
 {
 	return m_bodyList;
@@ -307,6 +593,41 @@ inline int32 b2World::GetControllerCount() const
 	return m_controllerCount;
 }
 
+inline b2ParticleSystem* b2World::GetParticleSystemList()
+{
+	return m_particleSystemList;
+}
+
+inline int32 b2World::GetParticleSystemCount() const
+{
+	return m_particleSystemCount;
+}
+
+inline float32 b2World::GetInterpolationAlpha() const
+{
+	return m_interpolationAlpha;
+}
+
+inline bool b2World::IsStepping() const
+{
+	return m_stepping;
+}
+
+inline bool b2World::IsDeferring() const
+{
+	return m_stepping && m_thread.IsCurrent() == false;
+}
+
+inline bool b2World::IsDegraded() const
+{
+	return m_degraded;
+}
+
+inline const b2Profile& b2World::GetProfile() const
+{
+	return m_profile;
+}
+
 inline void b2World::SetGravity(const b2Vec2& gravity)
 {
 	m_gravity = gravity;
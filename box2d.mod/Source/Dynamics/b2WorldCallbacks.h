@@ -109,6 +109,24 @@ public:
 	virtual void Result(const b2ContactResult* point) { B2_NOT_USED(point); }
 };
 
+/// Implement this class to be told when sensors begin and end overlapping other shapes.
+/// Sensors never create contacts, so they report through this listener instead of
+/// b2ContactListener. You can also read the overlaps of a sensor at any time with
+/// b2Shape::GetOverlapList.
+/// @warning You cannot create/destroy Box2D entities inside these callbacks.
+class b2SensorListener
+{
+public:
+	virtual ~b2SensorListener() {}
+
+	/// Called when a sensor begins to overlap a shape. The shape may be a sensor too.
+	virtual void BeginOverlap(b2Shape* sensor, b2Shape* shape) { B2_NOT_USED(sensor); B2_NOT_USED(shape); }
+
+	/// Called when a sensor stops overlapping a shape. This is also called when
+	/// either shape is destroyed or its body is deactivated.
+	virtual void EndOverlap(b2Shape* sensor, b2Shape* shape) { B2_NOT_USED(sensor); B2_NOT_USED(shape); }
+};
+
 /// Color for debug drawing. Each value has the range [0,1].
 struct b2Color
 {
@@ -136,6 +154,7 @@ public:
 		e_pairBit				= 0x0020, ///< draw broad-phase pairs
 		e_centerOfMassBit		= 0x0040, ///< draw center of mass frame
 		e_controllerBit			= 0x0080, ///< draw controllers
+		e_particleBit			= 0x0100, ///< draw particles
 	};
 
 	/// Set the drawing flags.
@@ -150,6 +169,9 @@ public:
 	/// Clear flags from the current flags.
 	void ClearFlags(uint32 flags);
 
+	/// Called by b2World before it draws the debug data of a step.
+	virtual void BeginDraw() {}
+
 	/// Draw a closed polygon provided in CCW order.
 	virtual void DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) = 0;
 
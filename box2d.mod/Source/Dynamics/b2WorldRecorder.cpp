@@ -0,0 +1,1329 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2WorldRecorder.h"
+#include "b2Body.h"
+#include "Joints/b2DistanceJoint.h"
+#include "Joints/b2GearJoint.h"
+#include "Joints/b2LineJoint.h"
+#include "Joints/b2MouseJoint.h"
+#include "Joints/b2PrismaticJoint.h"
+#include "Joints/b2PulleyJoint.h"
+#include "Joints/b2RevoluteJoint.h"
+#include "../Collision/b2BroadPhase.h"
+#include "../Collision/b2SpatialHash.h"
+#include "../Collision/Shapes/b2CircleShape.h"
+#include "../Collision/Shapes/b2PolygonShape.h"
+#include "../Collision/Shapes/b2EdgeShape.h"
+#include "../Collision/Shapes/b2MeshShape.h"
+#include "../Collision/Shapes/b2TileGridShape.h"
+#include "../Collision/Shapes/b2HeightfieldShape.h"
+#include <new>
+#include <cstring>
+
+// 'B2RC' followed by the stream version.
+static const int32 b2_recordMagic = 0x43523242;
+static const int32 b2_recordVersion = 1;
+
+b2WorldRecorder::b2WorldRecorder()
+{
+	m_data = NULL;
+	m_size = 0;
+	m_capacity = 0;
+	m_stepCount = 0;
+	m_depth = 0;
+	m_gravity.SetZero();
+	m_warmStarting = false;
+	m_continuousPhysics = false;
+	m_directJoints = false;
+	m_velocityTolerance = 0.0f;
+}
+
+b2WorldRecorder::~b2WorldRecorder()
+{
+	b2Free(m_data);
+}
+
+void b2WorldRecorder::Begin(const b2World* world)
+{
+	m_size = 0;
+	m_stepCount = 0;
+
+	const b2BroadPhase* broadPhase = world->m_broadPhase;
+	float32 cellSize = 0.0f;
+	if (broadPhase->m_spatialHash)
+	{
+		cellSize = broadPhase->m_spatialHash->GetCellSize();
+	}
+
+	WriteInt32(b2_recordMagic);
+	WriteInt32(b2_recordVersion);
+	WriteVec2(broadPhase->m_worldAABB.lowerBound);
+	WriteVec2(broadPhase->m_worldAABB.upperBound);
+	WriteVec2(world->m_gravity);
+	WriteUInt8(world->m_allowSleep);
+	WriteFloat(cellSize);
+
+	WriteSettings(world);
+}
+
+void b2WorldRecorder::WriteSettings(const b2World* world)
+{
+	m_gravity = world->m_gravity;
+	m_warmStarting = world->m_warmStarting;
+	m_continuousPhysics = world->m_continuousPhysics;
+	m_directJoints = world->m_directJoints;
+	m_velocityTolerance = world->m_velocityTolerance;
+
+	WriteUInt8(e_recordSettings);
+	WriteVec2(m_gravity);
+	WriteUInt8(m_warmStarting);
+	WriteUInt8(m_continuousPhysics);
+	WriteUInt8(m_directJoints);
+	WriteFloat(m_velocityTolerance);
+}
+
+void b2WorldRecorder::RecordStep(const b2World* world, float32 dt, int32 velocityIterations, int32 positionIterations)
+{
+	// The settings are plain setters, so compare them here instead of hooking each one.
+	if (world->m_gravity.x != m_gravity.x || world->m_gravity.y != m_gravity.y ||
+		world->m_warmStarting != m_warmStarting ||
+		world->m_continuousPhysics != m_continuousPhysics ||
+		world->m_directJoints != m_directJoints ||
+		world->m_velocityTolerance != m_velocityTolerance)
+	{
+		WriteSettings(world);
+	}
+
+	WriteUInt8(e_recordStep);
+	WriteFloat(dt);
+	WriteUInt16((uint16)velocityIterations);
+	WriteUInt16((uint16)positionIterations);
+	++m_stepCount;
+}
+
+void b2WorldRecorder::RecordCreateBody(const b2BodyDef* def)
+{
+	WriteUInt8(e_recordCreateBody);
+	WriteFloat(def->massData.mass);
+	WriteVec2(def->massData.center);
+	WriteFloat(def->massData.I);
+	WriteVec2(def->position);
+	WriteFloat(def->angle);
+	WriteFloat(def->linearDamping);
+	WriteFloat(def->angularDamping);
+	WriteUInt8(def->allowSleep);
+	WriteUInt8(def->isSleeping);
+	WriteUInt8(def->fixedRotation);
+	WriteUInt8(def->isBullet);
+	WriteUInt8(def->isActive);
+}
+
+void b2WorldRecorder::RecordCreateShape(const b2Body* body, const b2ShapeDef* def)
+{
+	WriteUInt8(e_recordCreateShape);
+	WriteInt32(body->m_id);
+	WriteUInt8((uint8)def->type);
+	WriteFloat(def->friction);
+	WriteFloat(def->restitution);
+	WriteFloat(def->density);
+	WriteUInt8(def->isSensor);
+	WriteUInt16(def->filter.categoryBits);
+	WriteUInt16(def->filter.maskBits);
+	WriteUInt16((uint16)def->filter.groupIndex);
+
+	switch (def->type)
+	{
+	case e_circleShape:
+		{
+			const b2CircleDef* circleDef = (const b2CircleDef*)def;
+			WriteVec2(circleDef->localPosition);
+			WriteFloat(circleDef->radius);
+		}
+		break;
+
+	case e_polygonShape:
+		{
+			const b2PolygonDef* polygonDef = (const b2PolygonDef*)def;
+			WriteInt32(polygonDef->vertexCount);
+			for (int32 i = 0; i < polygonDef->vertexCount; ++i)
+			{
+				WriteVec2(polygonDef->vertices[i]);
+			}
+		}
+		break;
+
+	case e_edgeShape:
+		{
+			const b2EdgeChainDef* chainDef = (const b2EdgeChainDef*)def;
+			WriteUInt8(chainDef->isALoop);
+			WriteInt32(chainDef->vertexCount);
+			for (int32 i = 0; i < chainDef->vertexCount; ++i)
+			{
+				WriteVec2(chainDef->vertices[i]);
+			}
+		}
+		break;
+
+	case e_meshShape:
+		{
+			const b2MeshDef* meshDef = (const b2MeshDef*)def;
+			WriteUInt8(meshDef->isALoop);
+			WriteInt32(meshDef->vertexCount);
+			for (int32 i = 0; i < meshDef->vertexCount; ++i)
+			{
+				WriteVec2(meshDef->vertices[i]);
+			}
+		}
+		break;
+
+	case e_tileGridShape:
+		{
+			const b2TileGridDef* gridDef = (const b2TileGridDef*)def;
+			WriteInt32(gridDef->width);
+			WriteInt32(gridDef->height);
+			WriteFloat(gridDef->tileSize);
+			WriteUInt8(gridDef->tiles != NULL);
+			if (gridDef->tiles)
+			{
+				int32 count = gridDef->width * gridDef->height;
+				Reserve(count);
+				memcpy(m_data + m_size, gridDef->tiles, count);
+				m_size += count;
+			}
+		}
+		break;
+
+	case e_heightfieldShape:
+		{
+			const b2HeightfieldDef* fieldDef = (const b2HeightfieldDef*)def;
+			WriteInt32(fieldDef->sampleCount);
+			WriteFloat(fieldDef->spacing);
+			WriteFloat(fieldDef->minHeight);
+			WriteFloat(fieldDef->maxHeight);
+			for (int32 i = 0; i < fieldDef->sampleCount; ++i)
+			{
+				WriteFloat(fieldDef->heights[i]);
+			}
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+void b2WorldRecorder::RecordCreateJoint(const b2JointDef* def)
+{
+	WriteUInt8(e_recordCreateJoint);
+	WriteUInt8((uint8)def->type);
+	WriteInt32(def->body1->m_id);
+	WriteInt32(def->body2->m_id);
+	WriteUInt8(def->collideConnected);
+
+	switch (def->type)
+	{
+	case e_distanceJoint:
+		{
+			const b2DistanceJointDef* jointDef = (const b2DistanceJointDef*)def;
+			WriteVec2(jointDef->localAnchor1);
+			WriteVec2(jointDef->localAnchor2);
+			WriteFloat(jointDef->length);
+			WriteFloat(jointDef->frequencyHz);
+			WriteFloat(jointDef->dampingRatio);
+		}
+		break;
+
+	case e_revoluteJoint:
+		{
+			const b2RevoluteJointDef* jointDef = (const b2RevoluteJointDef*)def;
+			WriteVec2(jointDef->localAnchor1);
+			WriteVec2(jointDef->localAnchor2);
+			WriteFloat(jointDef->referenceAngle);
+			WriteUInt8(jointDef->enableLimit);
+			WriteFloat(jointDef->lowerAngle);
+			WriteFloat(jointDef->upperAngle);
+			WriteUInt8(jointDef->enableMotor);
+			WriteFloat(jointDef->motorSpeed);
+			WriteFloat(jointDef->maxMotorTorque);
+		}
+		break;
+
+	case e_prismaticJoint:
+		{
+			const b2PrismaticJointDef* jointDef = (const b2PrismaticJointDef*)def;
+			WriteVec2(jointDef->localAnchor1);
+			WriteVec2(jointDef->localAnchor2);
+			WriteVec2(jointDef->localAxis1);
+			WriteFloat(jointDef->referenceAngle);
+			WriteUInt8(jointDef->enableLimit);
+			WriteFloat(jointDef->lowerTranslation);
+			WriteFloat(jointDef->upperTranslation);
+			WriteUInt8(jointDef->enableMotor);
+			WriteFloat(jointDef->maxMotorForce);
+			WriteFloat(jointDef->motorSpeed);
+		}
+		break;
+
+	case e_lineJoint:
+		{
+			const b2LineJointDef* jointDef = (const b2LineJointDef*)def;
+			WriteVec2(jointDef->localAnchor1);
+			WriteVec2(jointDef->localAnchor2);
+			WriteVec2(jointDef->localAxis1);
+			WriteUInt8(jointDef->enableLimit);
+			WriteFloat(jointDef->lowerTranslation);
+			WriteFloat(jointDef->upperTranslation);
+			WriteUInt8(jointDef->enableMotor);
+			WriteFloat(jointDef->maxMotorForce);
+			WriteFloat(jointDef->motorSpeed);
+		}
+		break;
+
+	case e_pulleyJoint:
+		{
+			const b2PulleyJointDef* jointDef = (const b2PulleyJointDef*)def;
+			WriteVec2(jointDef->groundAnchor1);
+			WriteVec2(jointDef->groundAnchor2);
+			WriteVec2(jointDef->localAnchor1);
+			WriteVec2(jointDef->localAnchor2);
+			WriteFloat(jointDef->length1);
+			WriteFloat(jointDef->maxLength1);
+			WriteFloat(jointDef->length2);
+			WriteFloat(jointDef->maxLength2);
+			WriteFloat(jointDef->ratio);
+		}
+		break;
+
+	case e_mouseJoint:
+		{
+			const b2MouseJointDef* jointDef = (const b2MouseJointDef*)def;
+			WriteVec2(jointDef->target);
+			WriteFloat(jointDef->maxForce);
+			WriteFloat(jointDef->frequencyHz);
+			WriteFloat(jointDef->dampingRatio);
+		}
+		break;
+
+	case e_gearJoint:
+		{
+			const b2GearJointDef* jointDef = (const b2GearJointDef*)def;
+			WriteInt32(jointDef->joint1->m_id);
+			WriteInt32(jointDef->joint2->m_id);
+			WriteFloat(jointDef->ratio);
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+void b2WorldRecorder::RecordBody(b2RecordOp op, const b2Body* body)
+{
+	WriteUInt8((uint8)op);
+	WriteInt32(body->m_id);
+}
+
+void b2WorldRecorder::RecordBody(b2RecordOp op, const b2Body* body, float32 value)
+{
+	RecordBody(op, body);
+	WriteFloat(value);
+}
+
+void b2WorldRecorder::RecordBody(b2RecordOp op, const b2Body* body, const b2Vec2& vector)
+{
+	RecordBody(op, body);
+	WriteVec2(vector);
+}
+
+void b2WorldRecorder::RecordBody(b2RecordOp op, const b2Body* body, const b2Vec2& vector, const b2Vec2& point)
+{
+	RecordBody(op, body);
+	WriteVec2(vector);
+	WriteVec2(point);
+}
+
+void b2WorldRecorder::RecordBodyFlag(b2RecordOp op, const b2Body* body, bool flag)
+{
+	RecordBody(op, body);
+	WriteUInt8(flag);
+}
+
+void b2WorldRecorder::RecordSetXForm(const b2Body* body, const b2Vec2& position, float32 angle)
+{
+	RecordBody(e_recordSetXForm, body);
+	WriteVec2(position);
+	WriteFloat(angle);
+}
+
+void b2WorldRecorder::RecordSetMass(const b2Body* body, const b2MassData* massData)
+{
+	RecordBody(e_recordSetMass, body);
+	WriteFloat(massData->mass);
+	WriteVec2(massData->center);
+	WriteFloat(massData->I);
+}
+
+void b2WorldRecorder::RecordShape(b2RecordOp op, const b2Shape* shape)
+{
+	WriteUInt8((uint8)op);
+	WriteInt32(shape->m_id);
+}
+
+void b2WorldRecorder::RecordJoint(b2RecordOp op, const b2Joint* joint)
+{
+	WriteUInt8((uint8)op);
+	WriteInt32(joint->m_id);
+}
+
+void b2WorldRecorder::RecordJoint(b2RecordOp op, const b2Joint* joint, float32 value)
+{
+	RecordJoint(op, joint);
+	WriteFloat(value);
+}
+
+void b2WorldRecorder::RecordJoint(b2RecordOp op, const b2Joint* joint, float32 value1, float32 value2)
+{
+	RecordJoint(op, joint);
+	WriteFloat(value1);
+	WriteFloat(value2);
+}
+
+void b2WorldRecorder::RecordJointFlag(b2RecordOp op, const b2Joint* joint, bool flag)
+{
+	RecordJoint(op, joint);
+	WriteUInt8(flag);
+}
+
+void b2WorldRecorder::Reserve(int32 size)
+{
+	if (m_size + size <= m_capacity)
+	{
+		return;
+	}
+
+	int32 capacity = b2Max(2 * m_capacity, 4096);
+	while (capacity < m_size + size)
+	{
+		capacity *= 2;
+	}
+
+	uint8* data = (uint8*)b2Alloc(capacity);
+	if (m_data)
+	{
+		memcpy(data, m_data, m_size);
+		b2Free(m_data);
+	}
+	m_data = data;
+	m_capacity = capacity;
+}
+
+void b2WorldRecorder::WriteUInt8(uint8 value)
+{
+	Reserve(1);
+	m_data[m_size++] = value;
+}
+
+void b2WorldRecorder::WriteUInt16(uint16 value)
+{
+	Reserve(sizeof(uint16));
+	memcpy(m_data + m_size, &value, sizeof(uint16));
+	m_size += sizeof(uint16);
+}
+
+void b2WorldRecorder::WriteInt32(int32 value)
+{
+	Reserve(sizeof(int32));
+	memcpy(m_data + m_size, &value, sizeof(int32));
+	m_size += sizeof(int32);
+}
+
+void b2WorldRecorder::WriteFloat(float32 value)
+{
+	Reserve(sizeof(float32));
+	memcpy(m_data + m_size, &value, sizeof(float32));
+	m_size += sizeof(float32);
+}
+
+void b2WorldRecorder::WriteVec2(const b2Vec2& value)
+{
+	WriteFloat(value.x);
+	WriteFloat(value.y);
+}
+
+b2WorldPlayer::b2WorldPlayer(const void* data, int32 size)
+{
+	m_data = (const uint8*)data;
+	m_size = size;
+	m_offset = 0;
+	m_valid = true;
+	m_stepCount = 0;
+	m_world = NULL;
+	m_bodies = NULL;
+	m_bodyCapacity = 0;
+	m_shapes = NULL;
+	m_shapeCapacity = 0;
+	m_joints = NULL;
+	m_jointCapacity = 0;
+
+	int32 magic = ReadInt32();
+	int32 version = ReadInt32();
+	b2AABB worldAABB;
+	worldAABB.lowerBound = ReadVec2();
+	worldAABB.upperBound = ReadVec2();
+	b2Vec2 gravity = ReadVec2();
+	bool doSleep = ReadUInt8() != 0;
+	float32 cellSize = ReadFloat();
+
+	if (m_valid == false || magic != b2_recordMagic || version != b2_recordVersion)
+	{
+		m_valid = false;
+		return;
+	}
+
+	void* mem = b2Alloc(sizeof(b2World));
+	if (cellSize > 0.0f)
+	{
+		m_world = new (mem) b2World(worldAABB, gravity, doSleep, cellSize);
+	}
+	else
+	{
+		m_world = new (mem) b2World(worldAABB, gravity, doSleep);
+	}
+
+	b2Body* groundBody = m_world->GetGroundBody();
+	Map((void***)&m_bodies, &m_bodyCapacity, groundBody->m_id, groundBody);
+}
+
+b2WorldPlayer::~b2WorldPlayer()
+{
+	if (m_world)
+	{
+		m_world->~b2World();
+		b2Free(m_world);
+	}
+
+	b2Free(m_bodies);
+	b2Free(m_shapes);
+	b2Free(m_joints);
+}
+
+bool b2WorldPlayer::Step()
+{
+	while (m_valid && m_offset < m_size)
+	{
+		uint8 op = ReadUInt8();
+		if (op == e_recordEnd)
+		{
+			return false;
+		}
+
+		if (op == e_recordStep)
+		{
+			float32 dt = ReadFloat();
+			int32 velocityIterations = ReadUInt16();
+			int32 positionIterations = ReadUInt16();
+			if (m_valid == false)
+			{
+				return false;
+			}
+
+			m_world->Step(dt, velocityIterations, positionIterations);
+			++m_stepCount;
+			return true;
+		}
+
+		Play(op);
+	}
+
+	return false;
+}
+
+void b2WorldPlayer::Play(uint8 op)
+{
+	switch (op)
+	{
+	case e_recordSettings:
+		{
+			b2Vec2 gravity = ReadVec2();
+			bool warmStarting = ReadUInt8() != 0;
+			bool continuousPhysics = ReadUInt8() != 0;
+			bool directJoints = ReadUInt8() != 0;
+			float32 velocityTolerance = ReadFloat();
+			m_world->SetGravity(gravity);
+			m_world->SetWarmStarting(warmStarting);
+			m_world->SetContinuousPhysics(continuousPhysics);
+			m_world->SetDirectJointSolver(directJoints);
+			m_world->SetVelocityTolerance(velocityTolerance);
+		}
+		break;
+
+	case e_recordCreateBody:
+		{
+			b2BodyDef def;
+			def.massData.mass = ReadFloat();
+			def.massData.center = ReadVec2();
+			def.massData.I = ReadFloat();
+			def.position = ReadVec2();
+			def.angle = ReadFloat();
+			def.linearDamping = ReadFloat();
+			def.angularDamping = ReadFloat();
+			def.allowSleep = ReadUInt8() != 0;
+			def.isSleeping = ReadUInt8() != 0;
+			def.fixedRotation = ReadUInt8() != 0;
+			def.isBullet = ReadUInt8() != 0;
+			def.isActive = ReadUInt8() != 0;
+			if (m_valid)
+			{
+				Create(&def);
+			}
+		}
+		break;
+
+	case e_recordDestroyBody:
+		{
+			b2Body* body = ReadBody();
+			if (body)
+			{
+				m_bodies[body->m_id] = NULL;
+				m_world->DestroyBody(body);
+			}
+		}
+		break;
+
+	case e_recordCreateShape:
+		CreateShape();
+		break;
+
+	case e_recordDestroyShape:
+		{
+			b2Shape* shape = ReadShape();
+			if (shape)
+			{
+				m_shapes[shape->m_id] = NULL;
+				shape->GetBody()->DestroyShape(shape);
+			}
+		}
+		break;
+
+	case e_recordCreateJoint:
+		CreateJoint();
+		break;
+
+	case e_recordDestroyJoint:
+		{
+			b2Joint* joint = ReadJoint();
+			if (joint)
+			{
+				m_joints[joint->m_id] = NULL;
+				m_world->DestroyJoint(joint);
+			}
+		}
+		break;
+
+	case e_recordRefilter:
+		{
+			b2Shape* shape = ReadShape();
+			if (shape)
+			{
+				m_world->Refilter(shape);
+			}
+		}
+		break;
+
+	case e_recordSetMass:
+		{
+			b2Body* body = ReadBody();
+			b2MassData massData;
+			massData.mass = ReadFloat();
+			massData.center = ReadVec2();
+			massData.I = ReadFloat();
+			if (body && m_valid)
+			{
+				body->SetMass(&massData);
+			}
+		}
+		break;
+
+	case e_recordSetMassFromShapes:
+		{
+			b2Body* body = ReadBody();
+			if (body)
+			{
+				body->SetMassFromShapes();
+			}
+		}
+		break;
+
+	case e_recordSetXForm:
+		{
+			b2Body* body = ReadBody();
+			b2Vec2 position = ReadVec2();
+			float32 angle = ReadFloat();
+			if (body && m_valid)
+			{
+				body->SetXForm(position, angle);
+			}
+		}
+		break;
+
+	case e_recordSetLinearVelocity:
+		{
+			b2Body* body = ReadBody();
+			b2Vec2 v = ReadVec2();
+			if (body && m_valid)
+			{
+				body->SetLinearVelocity(v);
+			}
+		}
+		break;
+
+	case e_recordSetAngularVelocity:
+		{
+			b2Body* body = ReadBody();
+			float32 w = ReadFloat();
+			if (body && m_valid)
+			{
+				body->SetAngularVelocity(w);
+			}
+		}
+		break;
+
+	case e_recordApplyForce:
+	case e_recordApplyImpulse:
+		{
+			b2Body* body = ReadBody();
+			b2Vec2 vector = ReadVec2();
+			b2Vec2 point = ReadVec2();
+			if (body && m_valid)
+			{
+				if (op == e_recordApplyForce)
+				{
+					body->ApplyForce(vector, point);
+				}
+				else
+				{
+					body->ApplyImpulse(vector, point);
+				}
+			}
+		}
+		break;
+
+	case e_recordApplyTorque:
+		{
+			b2Body* body = ReadBody();
+			float32 torque = ReadFloat();
+			if (body && m_valid)
+			{
+				body->ApplyTorque(torque);
+			}
+		}
+		break;
+
+	case e_recordWakeUp:
+	case e_recordPutToSleep:
+		{
+			b2Body* body = ReadBody();
+			if (body)
+			{
+				if (op == e_recordWakeUp)
+				{
+					body->WakeUp();
+				}
+				else
+				{
+					body->PutToSleep();
+				}
+			}
+		}
+		break;
+
+	case e_recordSetActive:
+	case e_recordSetBullet:
+	case e_recordAllowSleeping:
+		{
+			b2Body* body = ReadBody();
+			bool flag = ReadUInt8() != 0;
+			if (body && m_valid)
+			{
+				if (op == e_recordSetActive)
+				{
+					body->SetActive(flag);
+				}
+				else if (op == e_recordSetBullet)
+				{
+					body->SetBullet(flag);
+				}
+				else
+				{
+					body->AllowSleeping(flag);
+				}
+			}
+		}
+		break;
+
+	case e_recordEnableLimit:
+	case e_recordEnableMotor:
+		{
+			b2Joint* joint = ReadJoint();
+			bool flag = ReadUInt8() != 0;
+			if (joint == NULL || m_valid == false)
+			{
+				break;
+			}
+
+			bool limit = op == e_recordEnableLimit;
+			switch (joint->GetType())
+			{
+			case e_revoluteJoint:
+				if (limit)
+				{
+					((b2RevoluteJoint*)joint)->EnableLimit(flag);
+				}
+				else
+				{
+					((b2RevoluteJoint*)joint)->EnableMotor(flag);
+				}
+				break;
+
+			case e_prismaticJoint:
+				if (limit)
+				{
+					((b2PrismaticJoint*)joint)->EnableLimit(flag);
+				}
+				else
+				{
+					((b2PrismaticJoint*)joint)->EnableMotor(flag);
+				}
+				break;
+
+			case e_lineJoint:
+				if (limit)
+				{
+					((b2LineJoint*)joint)->EnableLimit(flag);
+				}
+				else
+				{
+					((b2LineJoint*)joint)->EnableMotor(flag);
+				}
+				break;
+
+			default:
+				m_valid = false;
+				break;
+			}
+		}
+		break;
+
+	case e_recordSetMotorSpeed:
+	case e_recordSetMaxMotorForce:
+		{
+			b2Joint* joint = ReadJoint();
+			float32 value = ReadFloat();
+			if (joint == NULL || m_valid == false)
+			{
+				break;
+			}
+
+			bool speed = op == e_recordSetMotorSpeed;
+			switch (joint->GetType())
+			{
+			case e_revoluteJoint:
+				if (speed)
+				{
+					((b2RevoluteJoint*)joint)->SetMotorSpeed(value);
+				}
+				else
+				{
+					((b2RevoluteJoint*)joint)->SetMaxMotorTorque(value);
+				}
+				break;
+
+			case e_prismaticJoint:
+				if (speed)
+				{
+					((b2PrismaticJoint*)joint)->SetMotorSpeed(value);
+				}
+				else
+				{
+					((b2PrismaticJoint*)joint)->SetMaxMotorForce(value);
+				}
+				break;
+
+			case e_lineJoint:
+				if (speed)
+				{
+					((b2LineJoint*)joint)->SetMotorSpeed(value);
+				}
+				else
+				{
+					((b2LineJoint*)joint)->SetMaxMotorForce(value);
+				}
+				break;
+
+			default:
+				m_valid = false;
+				break;
+			}
+		}
+		break;
+
+	case e_recordSetLimits:
+	case e_recordSetTarget:
+		{
+			b2Joint* joint = ReadJoint();
+			float32 value1 = ReadFloat();
+			float32 value2 = ReadFloat();
+			if (joint == NULL || m_valid == false)
+			{
+				break;
+			}
+
+			b2JointType type = joint->GetType();
+			if (op == e_recordSetTarget && type == e_mouseJoint)
+			{
+				((b2MouseJoint*)joint)->SetTarget(b2Vec2(value1, value2));
+			}
+			else if (op == e_recordSetLimits && type == e_revoluteJoint)
+			{
+				((b2RevoluteJoint*)joint)->SetLimits(value1, value2);
+			}
+			else if (op == e_recordSetLimits && type == e_prismaticJoint)
+			{
+				((b2PrismaticJoint*)joint)->SetLimits(value1, value2);
+			}
+			else if (op == e_recordSetLimits && type == e_lineJoint)
+			{
+				((b2LineJoint*)joint)->SetLimits(value1, value2);
+			}
+			else
+			{
+				m_valid = false;
+			}
+		}
+		break;
+
+	default:
+		m_valid = false;
+		break;
+	}
+}
+
+void b2WorldPlayer::Create(const b2BodyDef* def)
+{
+	b2Body* body = m_world->CreateBody(def);
+	if (body == NULL)
+	{
+		m_valid = false;
+		return;
+	}
+
+	Map((void***)&m_bodies, &m_bodyCapacity, body->m_id, body);
+}
+
+void b2WorldPlayer::CreateShape()
+{
+	b2Body* body = ReadBody();
+	uint8 type = ReadUInt8();
+	float32 friction = ReadFloat();
+	float32 restitution = ReadFloat();
+	float32 density = ReadFloat();
+	bool isSensor = ReadUInt8() != 0;
+	b2FilterData filter;
+	filter.categoryBits = ReadUInt16();
+	filter.maskBits = ReadUInt16();
+	filter.groupIndex = (int16)ReadUInt16();
+	if (body == NULL || m_valid == false)
+	{
+		return;
+	}
+
+	b2CircleDef circleDef;
+	b2PolygonDef polygonDef;
+	b2EdgeChainDef chainDef;
+	b2MeshDef meshDef;
+	b2TileGridDef gridDef;
+	b2HeightfieldDef fieldDef;
+
+	// Vertices, heights or tiles copied out of the stream.
+	void* buffer = NULL;
+	b2ShapeDef* def = NULL;
+
+	switch (type)
+	{
+	case e_circleShape:
+		circleDef.localPosition = ReadVec2();
+		circleDef.radius = ReadFloat();
+		def = &circleDef;
+		break;
+
+	case e_polygonShape:
+		polygonDef.vertexCount = ReadInt32();
+		if (polygonDef.vertexCount < 0 || polygonDef.vertexCount > b2_maxPolygonVertices)
+		{
+			m_valid = false;
+			break;
+		}
+		for (int32 i = 0; i < polygonDef.vertexCount; ++i)
+		{
+			polygonDef.vertices[i] = ReadVec2();
+		}
+		def = &polygonDef;
+		break;
+
+	case e_edgeShape:
+	case e_meshShape:
+		{
+			bool isALoop = ReadUInt8() != 0;
+			int32 vertexCount = ReadInt32();
+			if (vertexCount < 2 || vertexCount > (m_size - m_offset) / (int32)sizeof(b2Vec2))
+			{
+				m_valid = false;
+				break;
+			}
+
+			buffer = b2Alloc(vertexCount * sizeof(b2Vec2));
+			Read(buffer, vertexCount * sizeof(b2Vec2));
+			if (type == e_edgeShape)
+			{
+				chainDef.isALoop = isALoop;
+				chainDef.vertexCount = vertexCount;
+				chainDef.vertices = (b2Vec2*)buffer;
+				def = &chainDef;
+			}
+			else
+			{
+				meshDef.isALoop = isALoop;
+				meshDef.vertexCount = vertexCount;
+				meshDef.vertices = (b2Vec2*)buffer;
+				def = &meshDef;
+			}
+		}
+		break;
+
+	case e_tileGridShape:
+		{
+			gridDef.width = ReadInt32();
+			gridDef.height = ReadInt32();
+			gridDef.tileSize = ReadFloat();
+			bool hasTiles = ReadUInt8() != 0;
+			if (gridDef.width <= 0 || gridDef.height <= 0 || gridDef.width > m_size || gridDef.height > m_size)
+			{
+				m_valid = false;
+				break;
+			}
+
+			if (hasTiles)
+			{
+				int32 count = gridDef.width * gridDef.height;
+				if (count > m_size - m_offset)
+				{
+					m_valid = false;
+					break;
+				}
+
+				buffer = b2Alloc(count);
+				Read(buffer, count);
+				gridDef.tiles = (const uint8*)buffer;
+			}
+			def = &gridDef;
+		}
+		break;
+
+	case e_heightfieldShape:
+		fieldDef.sampleCount = ReadInt32();
+		fieldDef.spacing = ReadFloat();
+		fieldDef.minHeight = ReadFloat();
+		fieldDef.maxHeight = ReadFloat();
+		if (fieldDef.sampleCount < 2 || fieldDef.sampleCount > (m_size - m_offset) / (int32)sizeof(float32))
+		{
+			m_valid = false;
+			break;
+		}
+
+		buffer = b2Alloc(fieldDef.sampleCount * sizeof(float32));
+		Read(buffer, fieldDef.sampleCount * sizeof(float32));
+		fieldDef.heights = (const float32*)buffer;
+		def = &fieldDef;
+		break;
+
+	default:
+		m_valid = false;
+		break;
+	}
+
+	if (m_valid && def)
+	{
+		def->friction = friction;
+		def->restitution = restitution;
+		def->density = density;
+		def->isSensor = isSensor;
+		def->filter = filter;
+
+		// An edge chain adds several shapes in front of the old ones.
+		b2Shape* last = body->GetShapeList();
+		b2Shape* shape = body->CreateShape(def);
+		if (shape == NULL)
+		{
+			m_valid = false;
+		}
+
+		for (b2Shape* s = shape; s && s != last; s = s->GetNext())
+		{
+			Map((void***)&m_shapes, &m_shapeCapacity, s->m_id, s);
+		}
+	}
+
+	b2Free(buffer);
+}
+
+void b2WorldPlayer::CreateJoint()
+{
+	uint8 type = ReadUInt8();
+	b2Body* body1 = ReadBody();
+	b2Body* body2 = ReadBody();
+	bool collideConnected = ReadUInt8() != 0;
+	if (body1 == NULL || body2 == NULL || m_valid == false)
+	{
+		return;
+	}
+
+	b2DistanceJointDef distanceDef;
+	b2RevoluteJointDef revoluteDef;
+	b2PrismaticJointDef prismaticDef;
+	b2LineJointDef lineDef;
+	b2PulleyJointDef pulleyDef;
+	b2MouseJointDef mouseDef;
+	b2GearJointDef gearDef;
+	b2JointDef* def = NULL;
+
+	switch (type)
+	{
+	case e_distanceJoint:
+		distanceDef.localAnchor1 = ReadVec2();
+		distanceDef.localAnchor2 = ReadVec2();
+		distanceDef.length = ReadFloat();
+		distanceDef.frequencyHz = ReadFloat();
+		distanceDef.dampingRatio = ReadFloat();
+		def = &distanceDef;
+		break;
+
+	case e_revoluteJoint:
+		revoluteDef.localAnchor1 = ReadVec2();
+		revoluteDef.localAnchor2 = ReadVec2();
+		revoluteDef.referenceAngle = ReadFloat();
+		revoluteDef.enableLimit = ReadUInt8() != 0;
+		revoluteDef.lowerAngle = ReadFloat();
+		revoluteDef.upperAngle = ReadFloat();
+		revoluteDef.enableMotor = ReadUInt8() != 0;
+		revoluteDef.motorSpeed = ReadFloat();
+		revoluteDef.maxMotorTorque = ReadFloat();
+		def = &revoluteDef;
+		break;
+
+	case e_prismaticJoint:
+		prismaticDef.localAnchor1 = ReadVec2();
+		prismaticDef.localAnchor2 = ReadVec2();
+		prismaticDef.localAxis1 = ReadVec2();
+		prismaticDef.referenceAngle = ReadFloat();
+		prismaticDef.enableLimit = ReadUInt8() != 0;
+		prismaticDef.lowerTranslation = ReadFloat();
+		prismaticDef.upperTranslation = ReadFloat();
+		prismaticDef.enableMotor = ReadUInt8() != 0;
+		prismaticDef.maxMotorForce = ReadFloat();
+		prismaticDef.motorSpeed = ReadFloat();
+		def = &prismaticDef;
+		break;
+
+	case e_lineJoint:
+		lineDef.localAnchor1 = ReadVec2();
+		lineDef.localAnchor2 = ReadVec2();
+		lineDef.localAxis1 = ReadVec2();
+		lineDef.enableLimit = ReadUInt8() != 0;
+		lineDef.lowerTranslation = ReadFloat();
+		lineDef.upperTranslation = ReadFloat();
+		lineDef.enableMotor = ReadUInt8() != 0;
+		lineDef.maxMotorForce = ReadFloat();
+		lineDef.motorSpeed = ReadFloat();
+		def = &lineDef;
+		break;
+
+	case e_pulleyJoint:
+		pulleyDef.groundAnchor1 = ReadVec2();
+		pulleyDef.groundAnchor2 = ReadVec2();
+		pulleyDef.localAnchor1 = ReadVec2();
+		pulleyDef.localAnchor2 = ReadVec2();
+		pulleyDef.length1 = ReadFloat();
+		pulleyDef.maxLength1 = ReadFloat();
+		pulleyDef.length2 = ReadFloat();
+		pulleyDef.maxLength2 = ReadFloat();
+		pulleyDef.ratio = ReadFloat();
+		def = &pulleyDef;
+		break;
+
+	case e_mouseJoint:
+		mouseDef.target = ReadVec2();
+		mouseDef.maxForce = ReadFloat();
+		mouseDef.frequencyHz = ReadFloat();
+		mouseDef.dampingRatio = ReadFloat();
+		def = &mouseDef;
+		break;
+
+	case e_gearJoint:
+		gearDef.joint1 = ReadJoint();
+		gearDef.joint2 = ReadJoint();
+		gearDef.ratio = ReadFloat();
+		def = &gearDef;
+		break;
+
+	default:
+		m_valid = false;
+		break;
+	}
+
+	if (m_valid == false || def == NULL)
+	{
+		return;
+	}
+
+	def->body1 = body1;
+	def->body2 = body2;
+	def->collideConnected = collideConnected;
+
+	b2Joint* joint = m_world->CreateJoint(def);
+	if (joint == NULL)
+	{
+		m_valid = false;
+		return;
+	}
+
+	Map((void***)&m_joints, &m_jointCapacity, joint->m_id, joint);
+}
+
+b2Body* b2WorldPlayer::ReadBody()
+{
+	uint32 id = (uint32)ReadInt32();
+	if (m_valid == false || id >= (uint32)m_bodyCapacity || m_bodies[id] == NULL)
+	{
+		m_valid = false;
+		return NULL;
+	}
+
+	return m_bodies[id];
+}
+
+b2Shape* b2WorldPlayer::ReadShape()
+{
+	uint32 id = (uint32)ReadInt32();
+	if (m_valid == false || id >= (uint32)m_shapeCapacity || m_shapes[id] == NULL)
+	{
+		m_valid = false;
+		return NULL;
+	}
+
+	return m_shapes[id];
+}
+
+b2Joint* b2WorldPlayer::ReadJoint()
+{
+	uint32 id = (uint32)ReadInt32();
+	if (m_valid == false || id >= (uint32)m_jointCapacity || m_joints[id] == NULL)
+	{
+		m_valid = false;
+		return NULL;
+	}
+
+	return m_joints[id];
+}
+
+bool b2WorldPlayer::Read(void* data, int32 size)
+{
+	if (m_valid == false || size > m_size - m_offset)
+	{
+		m_valid = false;
+		memset(data, 0, size);
+		return false;
+	}
+
+	memcpy(data, m_data + m_offset, size);
+	m_offset += size;
+	return true;
+}
+
+uint8 b2WorldPlayer::ReadUInt8()
+{
+	uint8 value;
+	Read(&value, sizeof(uint8));
+	return value;
+}
+
+uint16 b2WorldPlayer::ReadUInt16()
+{
+	uint16 value;
+	Read(&value, sizeof(uint16));
+	return value;
+}
+
+int32 b2WorldPlayer::ReadInt32()
+{
+	int32 value;
+	Read(&value, sizeof(int32));
+	return value;
+}
+
+float32 b2WorldPlayer::ReadFloat()
+{
+	float32 value;
+	Read(&value, sizeof(float32));
+	return value;
+}
+
+b2Vec2 b2WorldPlayer::ReadVec2()
+{
+	b2Vec2 value;
+	value.x = ReadFloat();
+	value.y = ReadFloat();
+	return value;
+}
+
+void b2WorldPlayer::Map(void*** objects, int32* capacity, uint32 id, void* object)
+{
+	if ((int32)id >= *capacity)
+	{
+		int32 newCapacity = b2Max(2 * *capacity, 256);
+		while (newCapacity <= (int32)id)
+		{
+			newCapacity *= 2;
+		}
+
+		void** newObjects = (void**)b2Alloc(newCapacity * sizeof(void*));
+		if (*objects)
+		{
+			memcpy(newObjects, *objects, *capacity * sizeof(void*));
+			b2Free(*objects);
+		}
+		memset(newObjects + *capacity, 0, (newCapacity - *capacity) * sizeof(void*));
+		*objects = newObjects;
+		*capacity = newCapacity;
+	}
+
+	(*objects)[id] = object;
+}
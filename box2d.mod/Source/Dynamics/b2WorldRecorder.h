@@ -0,0 +1,279 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WORLD_RECORDER_H
+#define B2_WORLD_RECORDER_H
+
+#include "b2World.h"
+
+struct b2BodyDef;
+struct b2ShapeDef;
+struct b2JointDef;
+struct b2MassData;
+class b2Body;
+class b2Shape;
+class b2Joint;
+
+/// The calls written to a recording.
+enum b2RecordOp
+{
+	e_recordEnd = 0,
+	e_recordStep,
+	e_recordSettings,
+	e_recordCreateBody,
+	e_recordDestroyBody,
+	e_recordCreateShape,
+	e_recordDestroyShape,
+	e_recordCreateJoint,
+	e_recordDestroyJoint,
+	e_recordRefilter,
+	e_recordSetMass,
+	e_recordSetMassFromShapes,
+	e_recordSetXForm,
+	e_recordSetLinearVelocity,
+	e_recordSetAngularVelocity,
+	e_recordApplyForce,
+	e_recordApplyTorque,
+	e_recordApplyImpulse,
+	e_recordWakeUp,
+	e_recordPutToSleep,
+	e_recordSetActive,
+	e_recordSetBullet,
+	e_recordAllowSleeping,
+	e_recordEnableLimit,
+	e_recordSetLimits,
+	e_recordEnableMotor,
+	e_recordSetMotorSpeed,
+	e_recordSetMaxMotorForce,
+	e_recordSetTarget,
+	e_recordOpCount
+};
+
+/// Records the calls that change a world into a compact binary stream, so that
+/// a session can be replayed headless with b2WorldPlayer, for example to profile
+/// it offline or to compare two builds on the same input.
+///
+/// Recorded: body, shape and joint creation and destruction, mass changes,
+/// SetXForm, velocities, forces, torques and impulses, sleeping, activation,
+/// bullets, refiltering, joint limits and motors, mouse joint targets, gravity,
+/// the solver settings of b2World and every step.
+///
+/// Not recorded: shape material changes and heightfield or tile grid edits,
+/// the filter table, controllers, particle systems, the step budget, and calls
+/// made from callbacks during a step. User data, listeners and contact filters
+/// belong to the application and are not replayed, so a custom contact filter
+/// makes the replay diverge.
+///
+/// The stream uses the byte order of the recording machine. Attach the recorder
+/// with b2World::SetRecorder right after creating the world.
+class b2WorldRecorder
+{
+public:
+	b2WorldRecorder();
+	~b2WorldRecorder();
+
+	/// Get the recorded stream. The pointer changes as the stream grows.
+	const void* GetData() const;
+
+	/// Get the size of the recorded stream in bytes.
+	int32 GetSize() const;
+
+	/// Get the number of steps recorded.
+	int32 GetStepCount() const;
+
+	//--------------- Internals Below -------------------
+
+	void Begin(const b2World* world);
+	void RecordStep(const b2World* world, float32 dt, int32 velocityIterations, int32 positionIterations);
+
+	void RecordCreateBody(const b2BodyDef* def);
+	void RecordCreateShape(const b2Body* body, const b2ShapeDef* def);
+	void RecordCreateJoint(const b2JointDef* def);
+
+	void RecordBody(b2RecordOp op, const b2Body* body);
+	void RecordBody(b2RecordOp op, const b2Body* body, float32 value);
+	void RecordBody(b2RecordOp op, const b2Body* body, const b2Vec2& vector);
+	void RecordBody(b2RecordOp op, const b2Body* body, const b2Vec2& vector, const b2Vec2& point);
+	void RecordBodyFlag(b2RecordOp op, const b2Body* body, bool flag);
+	void RecordSetXForm(const b2Body* body, const b2Vec2& position, float32 angle);
+	void RecordSetMass(const b2Body* body, const b2MassData* massData);
+
+	void RecordShape(b2RecordOp op, const b2Shape* shape);
+
+	void RecordJoint(b2RecordOp op, const b2Joint* joint);
+	void RecordJoint(b2RecordOp op, const b2Joint* joint, float32 value);
+	void RecordJoint(b2RecordOp op, const b2Joint* joint, float32 value1, float32 value2);
+	void RecordJointFlag(b2RecordOp op, const b2Joint* joint, bool flag);
+
+	void WriteSettings(const b2World* world);
+	void Reserve(int32 size);
+	void WriteUInt8(uint8 value);
+	void WriteUInt16(uint16 value);
+	void WriteInt32(int32 value);
+	void WriteFloat(float32 value);
+	void WriteVec2(const b2Vec2& value);
+
+	uint8* m_data;
+	int32 m_size;
+	int32 m_capacity;
+	int32 m_stepCount;
+
+	// Recorded calls made while another one runs are not written.
+	int32 m_depth;
+
+	// The world settings last written, compared before every step.
+	b2Vec2 m_gravity;
+	bool m_warmStarting;
+	bool m_continuousPhysics;
+	bool m_directJoints;
+	float32 m_velocityTolerance;
+};
+
+/// Replays a stream written by b2WorldRecorder on a new world, one step at a time.
+/// Replaying gives the same results as the recorded session when the build and
+/// the platform are the same.
+/// The player checks that the stream is well formed, not that the recorded
+/// values are sensible, so a damaged stream may still trip an assertion.
+class b2WorldPlayer
+{
+public:
+	/// Read the header and create the world. The data must stay valid while
+	/// replaying.
+	b2WorldPlayer(const void* data, int32 size);
+
+	/// Destroy the world.
+	~b2WorldPlayer();
+
+	/// Is the stream valid so far?
+	bool IsValid() const;
+
+	/// Get the world being replayed.
+	b2World* GetWorld();
+
+	/// Replay the calls up to and including the next step.
+	/// @return false at the end of the stream or if the stream is invalid.
+	bool Step();
+
+	/// Get the number of steps replayed.
+	int32 GetStepCount() const;
+
+private:
+
+	void Play(uint8 op);
+	void Create(const b2BodyDef* def);
+	void CreateShape();
+	void CreateJoint();
+
+	b2Body* ReadBody();
+	b2Shape* ReadShape();
+	b2Joint* ReadJoint();
+	bool Read(void* data, int32 size);
+	uint8 ReadUInt8();
+	uint16 ReadUInt16();
+	int32 ReadInt32();
+	float32 ReadFloat();
+	b2Vec2 ReadVec2();
+
+	void Map(void*** objects, int32* capacity, uint32 id, void* object);
+
+	const uint8* m_data;
+	int32 m_size;
+	int32 m_offset;
+	bool m_valid;
+	int32 m_stepCount;
+
+	b2World* m_world;
+
+	// Objects indexed by their id.
+	b2Body** m_bodies;
+	int32 m_bodyCapacity;
+	b2Shape** m_shapes;
+	int32 m_shapeCapacity;
+	b2Joint** m_joints;
+	int32 m_jointCapacity;
+};
+
+// Gives the recorder to one call, unless the call is made by another recorded
+// call or during a step. Replaying the outer call makes the inner ones again.
+class b2RecordScope
+{
+public:
+	b2RecordScope(b2World* world);
+	~b2RecordScope();
+
+	// NULL when the call is not recorded.
+	b2WorldRecorder* m_recorder;
+
+private:
+
+	b2WorldRecorder* m_owner;
+};
+
+inline const void* b2WorldRecorder::GetData() const
+{
+	return m_data;
+}
+
+inline int32 b2WorldRecorder::GetSize() const
+{
+	return m_size;
+}
+
+inline int32 b2WorldRecorder::GetStepCount() const
+{
+	return m_stepCount;
+}
+
+inline bool b2WorldPlayer::IsValid() const
+{
+	return m_valid;
+}
+
+inline b2World* b2WorldPlayer::GetWorld()
+{
+	return m_world;
+}
+
+inline int32 b2WorldPlayer::GetStepCount() const
+{
+	return m_stepCount;
+}
+
+inline b2RecordScope::b2RecordScope(b2World* world)
+{
+	m_owner = world->m_recorder;
+	m_recorder = NULL;
+	if (m_owner)
+	{
+		if (m_owner->m_depth == 0)
+		{
+			m_recorder = m_owner;
+		}
+		++m_owner->m_depth;
+	}
+}
+
+inline b2RecordScope::~b2RecordScope()
+{
+	if (m_owner)
+	{
+		--m_owner->m_depth;
+	}
+}
+
+#endif
@@ -0,0 +1,229 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2WorldSnapshot.h"
+#include "b2World.h"
+#include "b2Body.h"
+#include "../Collision/b2BroadPhase.h"
+#include "../Collision/Shapes/b2Shape.h"
+#include <new>
+
+b2WorldSnapshot::b2WorldSnapshot()
+{
+	m_world = NULL;
+	m_bodies = NULL;
+	m_positions = NULL;
+	m_angles = NULL;
+	m_bodyCount = 0;
+	m_bodyCapacity = 0;
+	m_broadPhase = NULL;
+	m_shapes = NULL;
+	m_shapeCapacity = 0;
+}
+
+b2WorldSnapshot::~b2WorldSnapshot()
+{
+	b2Free(m_bodies);
+	b2Free(m_positions);
+	b2Free(m_angles);
+	b2Free(m_shapes);
+
+	if (m_broadPhase)
+	{
+		m_broadPhase->~b2BroadPhase();
+		b2Free(m_broadPhase);
+	}
+}
+
+void b2WorldSnapshot::Capture(b2World* world)
+{
+	m_world = world;
+
+	if (m_bodyCapacity < world->m_bodyCount)
+	{
+		b2Free(m_bodies);
+		b2Free(m_positions);
+		b2Free(m_angles);
+
+		m_bodyCapacity = b2Max(2 * m_bodyCapacity, world->m_bodyCount);
+		m_bodies = (b2Body**)b2Alloc(m_bodyCapacity * sizeof(b2Body*));
+		m_positions = (b2Vec2*)b2Alloc(m_bodyCapacity * sizeof(b2Vec2));
+		m_angles = (float32*)b2Alloc(m_bodyCapacity * sizeof(float32));
+	}
+
+	m_bodyCount = 0;
+	for (b2Body* b = world->m_bodyList; b; b = b->GetNext())
+	{
+		if (b->IsStatic())
+		{
+			continue;
+		}
+
+		m_bodies[m_bodyCount] = b;
+		m_positions[m_bodyCount] = b->GetPosition();
+		m_angles[m_bodyCount] = b->GetAngle();
+		++m_bodyCount;
+	}
+
+	if (m_broadPhase == NULL)
+	{
+		// Never updated, so it needs no pair callback.
+		void* mem = b2Alloc(sizeof(b2BroadPhase));
+		m_broadPhase = new (mem) b2BroadPhase(world->m_broadPhase->m_worldAABB, NULL);
+	}
+
+	m_broadPhase->CopyQueryState(world->m_broadPhase);
+
+	int32 proxyCapacity = m_broadPhase->GetProxyCapacity();
+	if (m_shapeCapacity < proxyCapacity)
+	{
+		b2Free(m_shapes);
+		m_shapeCapacity = proxyCapacity;
+		m_shapes = (b2ShapeSnapshot*)b2Alloc(m_shapeCapacity * sizeof(b2ShapeSnapshot));
+	}
+
+	for (int32 i = 0; i < proxyCapacity; ++i)
+	{
+		if (m_broadPhase->IsProxyValid(i) == false)
+		{
+			continue;
+		}
+
+		b2Shape* shape = (b2Shape*)m_broadPhase->GetUserData(i);
+		m_shapes[i].shape = shape;
+		m_shapes[i].xf = shape->GetBody()->GetXForm();
+		m_broadPhase->SetUserData(i, m_shapes + i);
+	}
+}
+
+int32 b2WorldSnapshot::GetTransforms(b2Body** bodies, b2Vec2* positions, float32* angles, int32 maxCount) const
+{
+	int32 count = b2Min(maxCount, m_bodyCount);
+	for (int32 i = 0; i < count; ++i)
+	{
+		bodies[i] = m_bodies[i];
+		positions[i] = m_positions[i];
+		angles[i] = m_angles[i];
+	}
+
+	return count;
+}
+
+int32 b2WorldSnapshot::Query(const b2AABB& aabb, b2Shape** shapes, int32 maxCount) const
+{
+	// Query into the caller's buffer and map the snapshot shapes back in place.
+	void** results = (void**)shapes;
+
+	int32 count = m_broadPhase->Query(aabb, results, maxCount);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		shapes[i] = ((b2ShapeSnapshot*)results[i])->shape;
+	}
+
+	return count;
+}
+
+// Per-call raycast state handed to RaycastSortKey.
+struct b2SnapshotRaycastInput
+{
+	b2ContactFilter* filter;
+	const b2FilterTable* filterTable;
+	const b2Segment* segment;
+	void* userData;
+	int32 layer;
+	bool solidShapes;
+};
+
+int32 b2WorldSnapshot::Raycast(const b2Segment& segment, b2Shape** shapes, int32 maxCount, bool solidShapes, void* userData, int32 layer) const
+{
+	b2SnapshotRaycastInput input;
+	input.filter = m_world->m_contactFilter;
+	input.filterTable = &m_world->m_filterTable;
+	input.segment = &segment;
+	input.userData = userData;
+	input.layer = layer;
+	input.solidShapes = solidShapes;
+
+	void** results = (void**)shapes;
+
+	int32 count = m_broadPhase->QuerySegment(segment, results, maxCount, &RaycastSortKey, &input);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		shapes[i] = ((b2ShapeSnapshot*)results[i])->shape;
+	}
+
+	return count;
+}
+
+b2Shape* b2WorldSnapshot::RaycastOne(const b2Segment& segment, float32* lambda, b2Vec2* normal, bool solidShapes, void* userData, int32 layer) const
+{
+	b2SnapshotRaycastInput input;
+	input.filter = m_world->m_contactFilter;
+	input.filterTable = &m_world->m_filterTable;
+	input.segment = &segment;
+	input.userData = userData;
+	input.layer = layer;
+	input.solidShapes = solidShapes;
+
+	void* result;
+
+	int32 count = m_broadPhase->QuerySegment(segment, &result, 1, &RaycastSortKey, &input);
+
+	if (count == 0)
+	{
+		return NULL;
+	}
+
+	// Test again against the captured transform to recover the hit.
+	b2ShapeSnapshot* s = (b2ShapeSnapshot*)result;
+	s->shape->TestSegment(s->xf, lambda, normal, segment, 1);
+	return s->shape;
+}
+
+float32 b2WorldSnapshot::RaycastSortKey(void* context, void* data)
+{
+	b2SnapshotRaycastInput* input = (b2SnapshotRaycastInput*)context;
+	b2ShapeSnapshot* s = (b2ShapeSnapshot*)data;
+
+	if (input->filterTable->RayCollide(input->layer, s->shape) == false)
+	{
+		return -1;
+	}
+
+	if (input->filter && !input->filter->RayCollide(input->userData, s->shape))
+	{
+		return -1;
+	}
+
+	float32 lambda;
+	b2Vec2 normal;
+	b2SegmentCollide collide = s->shape->TestSegment(s->xf, &lambda, &normal, *input->segment, 1);
+
+	if (input->solidShapes && collide == e_missCollide)
+	{
+		return -1;
+	}
+	if (!input->solidShapes && collide != e_hitCollide)
+	{
+		return -1;
+	}
+
+	return lambda;
+}
@@ -0,0 +1,74 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WORLD_SNAPSHOT_H
+#define B2_WORLD_SNAPSHOT_H
+
+#include "../Common/b2Math.h"
+
+struct b2AABB;
+struct b2Segment;
+class b2Body;
+class b2Shape;
+class b2World;
+class b2BroadPhase;
+
+// A shape as it was when the snapshot was captured.
+struct b2ShapeSnapshot
+{
+	b2Shape* shape;
+	b2XForm xf;
+};
+
+// Delegate of b2World. A copy of the state the host reads while the world is
+// stepping on a worker thread: the poses of the non-static bodies and the
+// broad-phase proxies. Shapes are only dereferenced for their geometry, which
+// does not change while stepping.
+class b2WorldSnapshot
+{
+public:
+	b2WorldSnapshot();
+	~b2WorldSnapshot();
+
+	void Capture(b2World* world);
+
+	int32 GetTransforms(b2Body** bodies, b2Vec2* positions, float32* angles, int32 maxCount) const;
+
+	int32 Query(const b2AABB& aabb, b2Shape** shapes, int32 maxCount) const;
+	int32 Raycast(const b2Segment& segment, b2Shape** shapes, int32 maxCount, bool solidShapes, void* userData, int32 layer) const;
+	b2Shape* RaycastOne(const b2Segment& segment, float32* lambda, b2Vec2* normal, bool solidShapes, void* userData, int32 layer) const;
+
+private:
+
+	static float32 RaycastSortKey(void* context, void* data);
+
+	b2World* m_world;
+
+	b2Body** m_bodies;
+	b2Vec2* m_positions;
+	float32* m_angles;
+	int32 m_bodyCount;
+	int32 m_bodyCapacity;
+
+	// Proxy user data points into m_shapes, which is indexed by proxy id.
+	b2BroadPhase* m_broadPhase;
+	b2ShapeSnapshot* m_shapes;
+	int32 m_shapeCapacity;
+};
+
+#endif
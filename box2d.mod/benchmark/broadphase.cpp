@@ -0,0 +1,153 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Compares the sweep and prune broad-phase with the uniform grid on a container
+// filled with many circles of the same size, like debris or granular material.
+//
+// Sweep and prune is limited to b2_maxProxies, so raise it for the whole build.
+// From box2d.mod:
+//
+//   g++ -O2 -DB2_MAX_PROXIES=16384 -Iinclude benchmark/broadphase.cpp $(find Source -name '*.cpp') -lpthread -o broadphase
+//   ./broadphase [circles] [steps] [cellSize]
+
+#include "Box2D.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+struct BenchmarkResult
+{
+	float32 stepTime;
+	float32 broadphaseTime;
+	int32 pairCount;
+	int32 pairChurn;
+	float32 hash;
+};
+
+static void RunScene(BenchmarkResult* result, int32 circleCount, int32 stepCount, float32 cellSize)
+{
+	const float32 radius = 0.25f;
+
+	b2AABB worldAABB;
+	worldAABB.lowerBound.Set(-100.0f, -20.0f);
+	worldAABB.upperBound.Set(100.0f, 180.0f);
+
+	b2Vec2 gravity(0.0f, -10.0f);
+	b2World* world;
+	if (cellSize > 0.0f)
+	{
+		world = new b2World(worldAABB, gravity, true, cellSize);
+	}
+	else
+	{
+		world = new b2World(worldAABB, gravity, true);
+	}
+
+	world->SetProfiling(true);
+
+	// An open box.
+	b2BodyDef groundDef;
+	b2Body* ground = world->CreateBody(&groundDef);
+
+	b2PolygonDef wallDef;
+	wallDef.SetAsBox(40.0f, 1.0f, b2Vec2(0.0f, -1.0f), 0.0f);
+	ground->CreateShape(&wallDef);
+	wallDef.SetAsBox(1.0f, 80.0f, b2Vec2(-41.0f, 80.0f), 0.0f);
+	ground->CreateShape(&wallDef);
+	wallDef.SetAsBox(1.0f, 80.0f, b2Vec2(41.0f, 80.0f), 0.0f);
+	ground->CreateShape(&wallDef);
+
+	// Loosely stacked rows that collapse into a heap.
+	b2CircleDef circleDef;
+	circleDef.radius = radius;
+	circleDef.density = 1.0f;
+	circleDef.friction = 0.6f;
+
+	const int32 columns = 140;
+	for (int32 i = 0; i < circleCount; ++i)
+	{
+		int32 row = i / columns;
+		int32 column = i % columns;
+
+		b2BodyDef bodyDef;
+		bodyDef.position.Set(-39.5f + 0.56f * column + 0.1f * (row & 1), radius + 0.56f * row);
+
+		b2Body* body = world->CreateBody(&bodyDef);
+		body->CreateShape(&circleDef);
+		body->SetMassFromShapes();
+	}
+
+	result->stepTime = 0.0f;
+	result->broadphaseTime = 0.0f;
+	result->pairChurn = 0;
+
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		world->Step(1.0f / 60.0f, 8, 3);
+
+		const b2Profile& profile = world->GetProfile();
+		result->stepTime += profile.step;
+		result->broadphaseTime += profile.broadphase;
+		result->pairChurn += profile.pairsAdded + profile.pairsRemoved;
+	}
+
+	result->pairCount = world->GetPairCount();
+
+	result->hash = 0.0f;
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		b2Vec2 p = b->GetPosition();
+		result->hash += b2Abs(p.x) + b2Abs(p.y);
+	}
+
+	delete world;
+}
+
+static void Report(const char* name, const BenchmarkResult& result, int32 stepCount)
+{
+	printf("%-16s %10.3f %12.3f %10d %12d %14.4f\n", name,
+		result.stepTime / stepCount, result.broadphaseTime / stepCount,
+		result.pairCount, result.pairChurn, result.hash);
+}
+
+int main(int argc, char** argv)
+{
+	int32 circleCount = argc > 1 ? atoi(argv[1]) : 10000;
+	int32 stepCount = argc > 2 ? atoi(argv[2]) : 300;
+	float32 cellSize = argc > 3 ? (float32)atof(argv[3]) : 1.0f;
+
+	printf("%d circles, %d steps, cell size %.2f\n", circleCount, stepCount, cellSize);
+	printf("%-16s %10s %12s %10s %12s %14s\n", "broad-phase", "step ms", "broadphase", "pairs", "pair churn", "hash");
+
+	BenchmarkResult result;
+
+	if (circleCount + 3 <= b2_maxProxies)
+	{
+		RunScene(&result, circleCount, stepCount, 0.0f);
+		Report("sweep and prune", result, stepCount);
+	}
+	else
+	{
+		printf("%-16s skipped, build with -DB2_MAX_PROXIES=16384\n", "sweep and prune");
+	}
+
+	RunScene(&result, circleCount, stepCount, cellSize);
+	Report("uniform grid", result, stepCount);
+
+	return 0;
+}
@@ -0,0 +1,213 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Compares the direct joint tree solver (b2World::SetDirectJointSolver) with
+// sequential impulses on a rope with a heavy end and on a pile of ragdolls.
+// For each solver it reports the worst and the final separation of the joint
+// anchors over the run, and the time per step.
+// From box2d.mod:
+//
+//   g++ -O2 -Iinclude benchmark/joints.cpp $(find Source -name '*.cpp') -lpthread -o joints
+//   ./joints [steps] [velocityIterations] [positionIterations]
+
+#include "Box2D.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+struct BenchmarkResult
+{
+	float32 maxError;
+	float32 finalError;
+	float32 stepTime;
+};
+
+// A horizontal rope of revolute joints hanging from a static anchor, with
+// a last link 500 times heavier than the others.
+static void CreateRope(b2World* world)
+{
+	const int32 linkCount = 60;
+
+	b2BodyDef bd;
+	b2Body* ground = world->CreateBody(&bd);
+
+	b2PolygonDef sd;
+	sd.SetAsBox(0.5f, 0.125f);
+	sd.density = 20.0f;
+	sd.friction = 0.2f;
+	sd.filter.groupIndex = -1;
+
+	b2RevoluteJointDef jd;
+
+	b2Body* prevBody = ground;
+	for (int32 i = 0; i < linkCount; ++i)
+	{
+		bd.position.Set(0.5f + i, 40.0f);
+		b2Body* body = world->CreateBody(&bd);
+
+		if (i == linkCount - 1)
+		{
+			sd.density = 500.0f * 20.0f;
+		}
+
+		body->CreateShape(&sd);
+		body->SetMassFromShapes();
+
+		jd.Initialize(prevBody, body, b2Vec2(float32(i), 40.0f));
+		world->CreateJoint(&jd);
+
+		prevBody = body;
+	}
+}
+
+// Ragdolls of a torso, head and limbs joined by revolute joints without limits,
+// dropped onto the ground. Contacts stay on sequential impulses.
+static void CreateRagdolls(b2World* world)
+{
+	b2BodyDef bd;
+	bd.position.Set(0.0f, -10.0f);
+	b2Body* ground = world->CreateBody(&bd);
+
+	b2PolygonDef groundDef;
+	groundDef.SetAsBox(50.0f, 10.0f);
+	ground->CreateShape(&groundDef);
+
+	for (int32 k = 0; k < 20; ++k)
+	{
+		b2Vec2 origin(-20.0f + 2.0f * (k % 10), 5.0f + 6.0f * (k / 10));
+
+		bd.position = origin;
+		b2Body* torso = world->CreateBody(&bd);
+		b2PolygonDef sd;
+		sd.SetAsBox(0.3f, 0.6f);
+		sd.density = 1.0f;
+		torso->CreateShape(&sd);
+		torso->SetMassFromShapes();
+
+		bd.position = origin + b2Vec2(0.0f, 0.9f);
+		b2Body* head = world->CreateBody(&bd);
+		b2CircleDef cd;
+		cd.radius = 0.3f;
+		cd.density = 1.0f;
+		head->CreateShape(&cd);
+		head->SetMassFromShapes();
+
+		b2RevoluteJointDef jd;
+		jd.Initialize(torso, head, origin + b2Vec2(0.0f, 0.6f));
+		world->CreateJoint(&jd);
+
+		// Arms and legs of two segments, the lower ones heavier like hands and boots.
+		const b2Vec2 roots[4] = {b2Vec2(-0.3f, 0.5f), b2Vec2(0.3f, 0.5f), b2Vec2(-0.15f, -0.6f), b2Vec2(0.15f, -0.6f)};
+		for (int32 i = 0; i < 4; ++i)
+		{
+			b2Body* parent = torso;
+			b2Vec2 anchor = origin + roots[i];
+			for (int32 j = 0; j < 2; ++j)
+			{
+				bd.position = anchor + b2Vec2(0.0f, -0.35f);
+				b2Body* limb = world->CreateBody(&bd);
+				sd.SetAsBox(0.1f, 0.35f);
+				sd.density = j == 0 ? 1.0f : 10.0f;
+				limb->CreateShape(&sd);
+				limb->SetMassFromShapes();
+
+				jd.Initialize(parent, limb, anchor);
+				world->CreateJoint(&jd);
+
+				parent = limb;
+				anchor += b2Vec2(0.0f, -0.7f);
+			}
+		}
+	}
+}
+
+static float32 GetJointError(b2World* world)
+{
+	float32 maxError = 0.0f;
+	for (b2Joint* j = world->GetJointList(); j; j = j->GetNext())
+	{
+		b2Vec2 d = j->GetAnchor2() - j->GetAnchor1();
+		maxError = b2Max(maxError, d.Length());
+	}
+	return maxError;
+}
+
+static void RunScene(BenchmarkResult* result, void (*create)(b2World*), bool direct, int32 stepCount,
+						int32 velocityIterations, int32 positionIterations)
+{
+	b2AABB worldAABB;
+	worldAABB.lowerBound.Set(-200.0f, -200.0f);
+	worldAABB.upperBound.Set(200.0f, 200.0f);
+
+	b2World* world = new b2World(worldAABB, b2Vec2(0.0f, -10.0f), true);
+	world->SetDirectJointSolver(direct);
+	create(world);
+
+	result->maxError = 0.0f;
+	result->stepTime = 0.0f;
+
+	b2Timer timer;
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		timer.Reset();
+		world->Step(1.0f / 60.0f, velocityIterations, positionIterations);
+		result->stepTime += timer.GetMilliseconds();
+
+		result->maxError = b2Max(result->maxError, GetJointError(world));
+	}
+
+	result->finalError = GetJointError(world);
+	result->stepTime /= stepCount;
+
+	delete world;
+}
+
+int main(int argc, char** argv)
+{
+	int32 stepCount = argc > 1 ? atoi(argv[1]) : 600;
+	int32 velocityIterations = argc > 2 ? atoi(argv[2]) : 10;
+	int32 positionIterations = argc > 3 ? atoi(argv[3]) : 3;
+
+	struct Scene
+	{
+		const char* name;
+		void (*create)(b2World*);
+	};
+
+	const Scene scenes[] =
+	{
+		{"rope", CreateRope},
+		{"ragdolls", CreateRagdolls},
+	};
+
+	printf("%d steps, %d velocity and %d position iterations\n", stepCount, velocityIterations, positionIterations);
+	printf("%-10s %-10s %12s %12s %10s\n", "scene", "solver", "max error", "final error", "ms/step");
+
+	for (int32 i = 0; i < int32(sizeof(scenes) / sizeof(scenes[0])); ++i)
+	{
+		for (int32 k = 0; k < 2; ++k)
+		{
+			BenchmarkResult result;
+			RunScene(&result, scenes[i].create, k == 1, stepCount, velocityIterations, positionIterations);
+			printf("%-10s %-10s %12.4f %12.4f %10.4f\n", scenes[i].name, k == 1 ? "direct" : "iterative",
+				result.maxError, result.finalError, result.stepTime);
+		}
+	}
+
+	return 0;
+}
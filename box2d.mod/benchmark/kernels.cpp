@@ -0,0 +1,536 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Times the narrow phase kernels in isolation: the manifold functions, the edge
+// contacts, b2Distance and b2TimeOfImpact. Shape pairs, transforms and sweeps are
+// generated from a seed, so a run can be repeated exactly before and after a change.
+// About half of the pairs touch.
+//
+// Every kernel is timed over all the pairs, repeated a number of times. A separate
+// pass records the GJK iterations of each b2Distance call and a histogram of the
+// conservative advancement iterations of each b2TimeOfImpact call. The checksum
+// changes whenever the results of a kernel change.
+//
+// The polygon support searches are then timed against a scalar loop for each vertex
+// count, and a pile of polygons is stepped. To compare the SIMD and scalar paths on
+// the polygon kernels and the pile, build a second time with -DB2_NO_SIMD.
+// From box2d.mod:
+//
+//   g++ -O2 -Iinclude benchmark/kernels.cpp $(find Source -name '*.cpp') -lpthread -o kernels
+//   ./kernels [pairs] [repeat] [seed]
+
+#include "Box2D.h"
+#include "../Source/Dynamics/Contacts/b2PolyAndEdgeContact.h"
+#include "../Source/Dynamics/Contacts/b2EdgeAndCircleContact.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// The shapes are created once on a static body and reused with other transforms.
+const int32 k_shapeCount = 128;
+const int32 k_maxIterations = 20;
+
+static uint32 s_seed;
+
+// A linear congruential generator, the same on every platform.
+static float32 RandomFloat(float32 lo, float32 hi)
+{
+	s_seed = s_seed * 1664525u + 1013904223u;
+	float32 r = (float32)(s_seed >> 8) / (float32)(1 << 24);
+	return lo + r * (hi - lo);
+}
+
+static int32 RandomInt(int32 count)
+{
+	s_seed = s_seed * 1664525u + 1013904223u;
+	return (int32)((s_seed >> 8) % (uint32)count);
+}
+
+struct ShapeSet
+{
+	b2World* world;
+	b2Shape* circles[k_shapeCount];
+	b2Shape* polygons[k_shapeCount];
+	b2Shape* edges[k_shapeCount];
+};
+
+static void CreateShapes(ShapeSet* set)
+{
+	b2AABB worldAABB;
+	worldAABB.lowerBound.Set(-100.0f, -100.0f);
+	worldAABB.upperBound.Set(100.0f, 100.0f);
+	set->world = new b2World(worldAABB, b2Vec2_zero, false);
+
+	b2BodyDef bd;
+	b2Body* body = set->world->CreateBody(&bd);
+
+	for (int32 i = 0; i < k_shapeCount; ++i)
+	{
+		b2CircleDef cd;
+		cd.radius = RandomFloat(0.1f, 1.5f);
+		set->circles[i] = body->CreateShape(&cd);
+	}
+
+	// Half boxes, half regular polygons of three to eight sides.
+	for (int32 i = 0; i < k_shapeCount; ++i)
+	{
+		b2PolygonDef pd;
+		if (i & 1)
+		{
+			pd.SetAsBox(RandomFloat(0.1f, 1.5f), RandomFloat(0.1f, 1.5f));
+		}
+		else
+		{
+			pd.vertexCount = 3 + RandomInt(b2_maxPolygonVertices - 2);
+			float32 radius = RandomFloat(0.2f, 1.5f);
+			float32 angle = RandomFloat(0.0f, 2.0f * b2_pi);
+			for (int32 j = 0; j < pd.vertexCount; ++j)
+			{
+				float32 a = angle + 2.0f * b2_pi * j / pd.vertexCount;
+				pd.vertices[j].Set(radius * cosf(a), radius * sinf(a));
+			}
+		}
+		set->polygons[i] = body->CreateShape(&pd);
+	}
+
+	// Single segments, as found in static edge chains.
+	for (int32 i = 0; i < k_shapeCount; ++i)
+	{
+		float32 halfLength = RandomFloat(0.5f, 3.0f);
+		float32 angle = RandomFloat(0.0f, b2_pi);
+		b2Vec2 d(halfLength * cosf(angle), halfLength * sinf(angle));
+
+		b2Vec2 vertices[2] = {-d, d};
+		b2EdgeChainDef ed;
+		ed.vertices = vertices;
+		ed.vertexCount = 2;
+		ed.isALoop = false;
+		set->edges[i] = body->CreateShape(&ed);
+	}
+}
+
+struct ShapePair
+{
+	b2Shape* shape1;
+	b2Shape* shape2;
+	b2XForm xf1, xf2;
+	b2Sweep sweep1, sweep2;
+};
+
+static void RandomXForm(b2XForm* xf, const b2Vec2& position)
+{
+	xf->position = position;
+	xf->R.Set(RandomFloat(-b2_pi, b2_pi));
+}
+
+static void RandomSweep(b2Sweep* sweep, const b2Vec2& position, float32 maxTravel)
+{
+	sweep->localCenter.SetZero();
+	sweep->c0 = position;
+	sweep->c = position + b2Vec2(RandomFloat(-maxTravel, maxTravel), RandomFloat(-maxTravel, maxTravel));
+	sweep->a0 = RandomFloat(-b2_pi, b2_pi);
+	sweep->a = sweep->a0 + RandomFloat(-1.0f, 1.0f);
+	sweep->t0 = 0.0f;
+}
+
+// Place the shapes at a random distance up to a little more than the sum of their
+// sweep radii, so that some overlap, some touch and some are apart. The sweeps
+// start apart and the second one moves past the first, sometimes wide of it.
+static void CreatePairs(ShapePair* pairs, int32 count, b2Shape* const* shapes1, b2Shape* const* shapes2)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		ShapePair* pair = pairs + i;
+		pair->shape1 = shapes1[RandomInt(k_shapeCount)];
+		pair->shape2 = shapes2[RandomInt(k_shapeCount)];
+
+		float32 radius = pair->shape1->GetSweepRadius() + pair->shape2->GetSweepRadius();
+		float32 angle = RandomFloat(-b2_pi, b2_pi);
+		b2Vec2 direction(cosf(angle), sinf(angle));
+
+		b2Vec2 p1(RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f));
+		b2Vec2 p2 = p1 + RandomFloat(0.0f, 1.2f * radius) * direction;
+		RandomXForm(&pair->xf1, p1);
+		RandomXForm(&pair->xf2, p2);
+
+		b2Vec2 s2 = p1 + (radius + RandomFloat(0.1f, 2.0f)) * direction;
+		RandomSweep(&pair->sweep1, p1, 0.5f);
+		RandomSweep(&pair->sweep2, s2, 0.5f);
+		b2Vec2 side(-direction.y, direction.x);
+		pair->sweep2.c = p1 - RandomFloat(0.0f, radius) * direction + RandomFloat(-2.0f * radius, 2.0f * radius) * side;
+	}
+}
+
+enum KernelType
+{
+	e_collideCircles,
+	e_collidePolygonAndCircle,
+	e_collidePolygons,
+	e_collidePolyAndEdge,
+	e_collideEdgeAndCircle,
+	e_distance,
+	e_timeOfImpact,
+};
+
+struct Kernel
+{
+	const char* name;
+	KernelType type;
+	b2Shape* const* shapes1;
+	b2Shape* const* shapes2;
+};
+
+// Run a kernel once on a pair and fold the result into the checksum.
+inline float32 RunKernel(KernelType type, const ShapePair& pair)
+{
+	b2Manifold manifold;
+	b2Vec2 x1, x2;
+
+	switch (type)
+	{
+	case e_collideCircles:
+		b2CollideCircles(&manifold, (b2CircleShape*)pair.shape1, pair.xf1, (b2CircleShape*)pair.shape2, pair.xf2);
+		return (float32)manifold.pointCount;
+
+	case e_collidePolygonAndCircle:
+		b2CollidePolygonAndCircle(&manifold, (b2PolygonShape*)pair.shape1, pair.xf1, (b2CircleShape*)pair.shape2, pair.xf2);
+		return (float32)manifold.pointCount;
+
+	case e_collidePolygons:
+		b2CollidePolygons(&manifold, (b2PolygonShape*)pair.shape1, pair.xf1, (b2PolygonShape*)pair.shape2, pair.xf2);
+		return (float32)manifold.pointCount;
+
+	case e_collidePolyAndEdge:
+		b2PolyAndEdgeContact::b2CollidePolyAndEdge(&manifold, (b2PolygonShape*)pair.shape1, pair.xf1, (b2EdgeShape*)pair.shape2, pair.xf2);
+		return (float32)manifold.pointCount;
+
+	case e_collideEdgeAndCircle:
+		b2EdgeAndCircleContact::b2CollideEdgeAndCircle(&manifold, (b2EdgeShape*)pair.shape1, pair.xf1, (b2CircleShape*)pair.shape2, pair.xf2);
+		return (float32)manifold.pointCount;
+
+	case e_distance:
+		return b2Distance(&x1, &x2, pair.shape1, pair.xf1, pair.shape2, pair.xf2);
+
+	case e_timeOfImpact:
+		return b2TimeOfImpact(pair.shape1, pair.sweep1, pair.shape2, pair.sweep2);
+	}
+
+	return 0.0f;
+}
+
+struct KernelResult
+{
+	float32 nsPerCall;
+	float32 checksum;
+	int32 hitCount;
+	int32 gjkIterations;
+	int32 gjkMaxIterations;
+	int32 histogram[k_maxIterations + 1];
+};
+
+static void RunBenchmark(KernelResult* result, const Kernel& kernel, const ShapePair* pairs, int32 pairCount, int32 repeatCount)
+{
+	memset(result, 0, sizeof(KernelResult));
+
+	// Timed passes.
+	float32 checksum = 0.0f;
+	b2Timer timer;
+	timer.Reset();
+	for (int32 r = 0; r < repeatCount; ++r)
+	{
+		for (int32 i = 0; i < pairCount; ++i)
+		{
+			checksum += RunKernel(kernel.type, pairs[i]);
+		}
+	}
+	float32 ms = timer.GetMilliseconds();
+
+	result->nsPerCall = 1.0e6f * ms / ((float32)pairCount * repeatCount);
+	result->checksum = checksum / repeatCount;
+
+	// Counting pass. A hit is a manifold point, a touching distance or a TOI below one.
+	for (int32 i = 0; i < pairCount; ++i)
+	{
+		g_GJK_Iterations = 0;
+		g_TOI_Iterations = 0;
+
+		float32 value = RunKernel(kernel.type, pairs[i]);
+
+		switch (kernel.type)
+		{
+		case e_distance:
+			result->hitCount += value == 0.0f ? 1 : 0;
+			result->gjkIterations += g_GJK_Iterations;
+			result->gjkMaxIterations = b2Max(result->gjkMaxIterations, g_GJK_Iterations);
+			break;
+
+		case e_timeOfImpact:
+			result->hitCount += value < 1.0f ? 1 : 0;
+			++result->histogram[b2Clamp(g_TOI_Iterations, 0, k_maxIterations)];
+			break;
+
+		default:
+			result->hitCount += value > 0.0f ? 1 : 0;
+			break;
+		}
+	}
+}
+
+// The scalar support search, for comparison with b2FindMaxDot on any build.
+static int32 ScalarMaxDot(const b2Vec2* points, int32 count, const b2Vec2& d)
+{
+	int32 bestIndex = 0;
+	float32 bestValue = b2Dot(points[0], d);
+	for (int32 i = 1; i < count; ++i)
+	{
+		float32 value = b2Dot(points[i], d);
+		if (value > bestValue)
+		{
+			bestIndex = i;
+			bestValue = value;
+		}
+	}
+	return bestIndex;
+}
+
+static void RunSupportBenchmark(int32 directionCount, int32 repeatCount)
+{
+	b2Vec2* directions = (b2Vec2*)b2Alloc(directionCount * sizeof(b2Vec2));
+	for (int32 i = 0; i < directionCount; ++i)
+	{
+		float32 angle = RandomFloat(-b2_pi, b2_pi);
+		directions[i].Set(cosf(angle), sinf(angle));
+	}
+
+#ifdef B2_SIMD_SSE2
+	const char* path = "sse2";
+#else
+	const char* path = "scalar";
+#endif
+
+	printf("\n%-20s %9s %9s\n", "support search", path, "scalar");
+
+	for (int32 count = 3; count <= b2_maxPolygonVertices; ++count)
+	{
+		b2Vec2 points[b2_polygonLaneCount];
+		float32 radius = RandomFloat(0.2f, 1.5f);
+		float32 angle = RandomFloat(0.0f, 2.0f * b2_pi);
+		for (int32 j = 0; j < count; ++j)
+		{
+			float32 a = angle + 2.0f * b2_pi * j / count;
+			points[j].Set(radius * cosf(a), radius * sinf(a));
+		}
+		b2PadPolygonLanes(points, count);
+
+		int32 checksum = 0;
+		b2Timer timer;
+		timer.Reset();
+		for (int32 r = 0; r < repeatCount; ++r)
+		{
+			for (int32 i = 0; i < directionCount; ++i)
+			{
+				checksum += b2FindMaxDot(points, count, directions[i]);
+			}
+		}
+		float32 ms = timer.GetMilliseconds();
+
+		int32 scalarChecksum = 0;
+		timer.Reset();
+		for (int32 r = 0; r < repeatCount; ++r)
+		{
+			for (int32 i = 0; i < directionCount; ++i)
+			{
+				scalarChecksum += ScalarMaxDot(points, count, directions[i]);
+			}
+		}
+		float32 scalarMs = timer.GetMilliseconds();
+
+		float32 scale = 1.0e6f / ((float32)directionCount * repeatCount);
+		printf("%2d vertices          %9.2f %9.2f%s\n", count, scale * ms, scale * scalarMs,
+			checksum == scalarChecksum ? "" : "  results differ");
+	}
+
+	b2Free(directions);
+}
+
+// Polygons of three to eight sides dropped into a box.
+static void RunPolygonPile(int32 polygonCount, int32 stepCount)
+{
+	b2AABB worldAABB;
+	worldAABB.lowerBound.Set(-100.0f, -20.0f);
+	worldAABB.upperBound.Set(100.0f, 180.0f);
+	b2World* world = new b2World(worldAABB, b2Vec2(0.0f, -10.0f), true);
+	world->SetProfiling(true);
+
+	b2BodyDef bd;
+	b2Body* ground = world->CreateBody(&bd);
+
+	b2PolygonDef sd;
+	sd.SetAsBox(20.0f, 1.0f, b2Vec2(0.0f, -1.0f), 0.0f);
+	ground->CreateShape(&sd);
+	sd.SetAsBox(1.0f, 40.0f, b2Vec2(-21.0f, 40.0f), 0.0f);
+	ground->CreateShape(&sd);
+	sd.SetAsBox(1.0f, 40.0f, b2Vec2(21.0f, 40.0f), 0.0f);
+	ground->CreateShape(&sd);
+
+	for (int32 i = 0; i < polygonCount; ++i)
+	{
+		b2PolygonDef pd;
+		pd.vertexCount = 3 + RandomInt(b2_maxPolygonVertices - 2);
+		pd.density = 1.0f;
+		pd.friction = 0.6f;
+		float32 radius = RandomFloat(0.4f, 0.8f);
+		float32 angle = RandomFloat(0.0f, 2.0f * b2_pi);
+		for (int32 j = 0; j < pd.vertexCount; ++j)
+		{
+			float32 a = angle + 2.0f * b2_pi * j / pd.vertexCount;
+			pd.vertices[j].Set(radius * cosf(a), radius * sinf(a));
+		}
+
+		bd.position.Set(-19.0f + 2.0f * (i % 20), 2.0f + 2.0f * (i / 20));
+		b2Body* body = world->CreateBody(&bd);
+		body->CreateShape(&pd);
+		body->SetMassFromShapes();
+	}
+
+	float32 stepTime = 0.0f;
+	float32 collideTime = 0.0f;
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		world->Step(1.0f / 60.0f, 10, 8);
+		stepTime += world->GetProfile().step;
+		collideTime += world->GetProfile().collide;
+	}
+
+	float32 hash = 0.0f;
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		hash += b->GetPosition().x + b->GetPosition().y + b->GetAngle();
+	}
+
+	printf("\npolygon pile: %d polygons, %d steps, %.3f ms/step, collide %.3f ms/step, hash %.4f\n",
+		polygonCount, stepCount, stepTime / stepCount, collideTime / stepCount, hash);
+
+	delete world;
+}
+
+int main(int argc, char** argv)
+{
+	int32 pairCount = argc > 1 ? atoi(argv[1]) : 4096;
+	int32 repeatCount = argc > 2 ? atoi(argv[2]) : 100;
+	uint32 seed = argc > 3 ? (uint32)atoi(argv[3]) : 12345u;
+
+	if (pairCount <= 0 || repeatCount <= 0)
+	{
+		printf("usage: kernels [pairs] [repeat] [seed]\n");
+		return 1;
+	}
+
+	s_seed = seed;
+
+	ShapeSet set;
+	CreateShapes(&set);
+
+	const Kernel kernels[] =
+	{
+		{"CollideCircles", e_collideCircles, set.circles, set.circles},
+		{"CollidePolyCircle", e_collidePolygonAndCircle, set.polygons, set.circles},
+		{"CollidePolygons", e_collidePolygons, set.polygons, set.polygons},
+		{"CollidePolyEdge", e_collidePolyAndEdge, set.polygons, set.edges},
+		{"CollideEdgeCircle", e_collideEdgeAndCircle, set.edges, set.circles},
+		{"DistanceCircles", e_distance, set.circles, set.circles},
+		{"DistancePolyCircle", e_distance, set.polygons, set.circles},
+		{"DistancePolygons", e_distance, set.polygons, set.polygons},
+		{"DistancePolyEdge", e_distance, set.polygons, set.edges},
+		{"TOIPolyCircle", e_timeOfImpact, set.polygons, set.circles},
+		{"TOIPolygons", e_timeOfImpact, set.polygons, set.polygons},
+		{"TOIPolyEdge", e_timeOfImpact, set.polygons, set.edges},
+		{"TOIEdgeCircle", e_timeOfImpact, set.edges, set.circles},
+	};
+	const int32 kernelCount = sizeof(kernels) / sizeof(kernels[0]);
+
+	ShapePair* pairs = (ShapePair*)b2Alloc(pairCount * sizeof(ShapePair));
+
+	printf("%d pairs, %d repeats, seed %u\n", pairCount, repeatCount, seed);
+	printf("%-20s %9s %7s %14s %9s %8s\n", "kernel", "ns/call", "hits", "checksum", "gjk mean", "gjk max");
+
+	KernelResult toiResults[kernelCount];
+	int32 toiCount = 0;
+	const char* toiNames[kernelCount];
+
+	for (int32 i = 0; i < kernelCount; ++i)
+	{
+		const Kernel& kernel = kernels[i];
+		CreatePairs(pairs, pairCount, kernel.shapes1, kernel.shapes2);
+
+		KernelResult result;
+		RunBenchmark(&result, kernel, pairs, pairCount, repeatCount);
+
+		printf("%-20s %9.1f %6.1f%% %14.4f", kernel.name, result.nsPerCall,
+			100.0f * result.hitCount / pairCount, result.checksum);
+		if (kernel.type == e_distance)
+		{
+			printf(" %9.2f %8d", (float32)result.gjkIterations / pairCount, result.gjkMaxIterations);
+		}
+		printf("\n");
+
+		if (kernel.type == e_timeOfImpact)
+		{
+			toiNames[toiCount] = kernel.name;
+			toiResults[toiCount++] = result;
+		}
+	}
+
+	// One column per TOI kernel, one row per iteration count.
+	printf("\nTOI iterations");
+	for (int32 i = 0; i < toiCount; ++i)
+	{
+		printf(" %14s", toiNames[i]);
+	}
+	printf("\n");
+
+	for (int32 n = 0; n <= k_maxIterations; ++n)
+	{
+		bool used = false;
+		for (int32 i = 0; i < toiCount; ++i)
+		{
+			used = used || toiResults[i].histogram[n] > 0;
+		}
+
+		if (used == false)
+		{
+			continue;
+		}
+
+		printf("%14d", n);
+		for (int32 i = 0; i < toiCount; ++i)
+		{
+			printf(" %14d", toiResults[i].histogram[n]);
+		}
+		printf("\n");
+	}
+
+	RunSupportBenchmark(pairCount, repeatCount);
+	RunPolygonPile(400, 600);
+
+	b2Free(pairs);
+	delete set.world;
+
+	return 0;
+}
@@ -0,0 +1,417 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Replays a recording made with b2WorldRecorder headless and reports the time
+// spent in each phase of the step, the slowest steps and a hash of the final
+// body positions. Two builds replaying the same recording run the same steps,
+// so their timings can be compared directly, and their hashes match as long as
+// the simulation results did not change. From box2d.mod:
+//
+//   g++ -O2 -Iinclude benchmark/replay.cpp $(find Source -name '*.cpp') -lpthread -o replay
+//   ./replay recording.b2r [repeat]
+//   ./replay --record recording.b2r [steps]
+//
+// The second form records a small scene with joints, motors, a mouse joint,
+// forces, edge chains, an open mesh and bodies created and destroyed while it runs, then
+// replays it and checks that the replay ends in the same state.
+
+#include "Box2D.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+static const int32 k_slowestCount = 5;
+
+struct ReplayResult
+{
+	int32 stepCount;
+	float32 wallTime;
+	float32 maxStep;
+	b2Profile total;
+	int32 allocCount;
+	uint32 hash;
+	bool valid;
+
+	// The slowest steps, slowest first.
+	int32 slowestSteps[k_slowestCount];
+	float32 slowestTimes[k_slowestCount];
+};
+
+static void Accumulate(b2Profile* total, const b2Profile& profile)
+{
+	total->step += profile.step;
+	total->collide += profile.collide;
+	total->solve += profile.solve;
+	total->islandBuild += profile.islandBuild;
+	total->solveInit += profile.solveInit;
+	total->solveVelocity += profile.solveVelocity;
+	total->solvePosition += profile.solvePosition;
+	total->solveTOI += profile.solveTOI;
+	total->broadphase += profile.broadphase;
+	total->toiCount += profile.toiCount;
+	total->contactCount += profile.contactCount;
+}
+
+// FNV-1a over the bits of the final body positions and angles.
+static uint32 HashWorld(b2World* world)
+{
+	uint32 hash = 2166136261u;
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		float32 values[3] = {b->GetPosition().x, b->GetPosition().y, b->GetAngle()};
+		const uint8* bytes = (const uint8*)values;
+		for (int32 i = 0; i < (int32)sizeof(values); ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 16777619u;
+		}
+	}
+	return hash;
+}
+
+static void AddSlowStep(ReplayResult* result, int32 step, float32 time)
+{
+	for (int32 i = 0; i < k_slowestCount; ++i)
+	{
+		if (time > result->slowestTimes[i])
+		{
+			for (int32 j = k_slowestCount - 1; j > i; --j)
+			{
+				result->slowestSteps[j] = result->slowestSteps[j - 1];
+				result->slowestTimes[j] = result->slowestTimes[j - 1];
+			}
+			result->slowestSteps[i] = step;
+			result->slowestTimes[i] = time;
+			return;
+		}
+	}
+}
+
+static void Replay(ReplayResult* result, const void* data, int32 size)
+{
+	memset(result, 0, sizeof(ReplayResult));
+	for (int32 i = 0; i < k_slowestCount; ++i)
+	{
+		result->slowestSteps[i] = -1;
+	}
+
+	b2WorldPlayer player(data, size);
+	if (player.IsValid() == false)
+	{
+		return;
+	}
+
+	b2World* world = player.GetWorld();
+	world->SetProfiling(true);
+
+	int32 allocCount = b2_allocCount;
+	b2Timer timer;
+	timer.Reset();
+
+	while (player.Step())
+	{
+		const b2Profile& profile = world->GetProfile();
+		Accumulate(&result->total, profile);
+		result->maxStep = b2Max(result->maxStep, profile.step);
+		AddSlowStep(result, player.GetStepCount() - 1, profile.step);
+	}
+
+	result->wallTime = timer.GetMilliseconds();
+	result->allocCount = b2_allocCount - allocCount;
+	result->stepCount = player.GetStepCount();
+	result->hash = HashWorld(world);
+	result->valid = player.IsValid();
+}
+
+static void Report(const ReplayResult& result)
+{
+	if (result.stepCount == 0)
+	{
+		printf("no steps replayed%s\n", result.valid ? "" : ", the recording is invalid");
+		return;
+	}
+
+	float32 invCount = 1.0f / result.stepCount;
+	const b2Profile& p = result.total;
+
+	printf("%d steps in %.1f ms, %.1f steps/s, hash %08x%s\n",
+		result.stepCount, result.wallTime, result.stepCount * 1000.0f / result.wallTime,
+		result.hash, result.valid ? "" : ", stopped at an invalid call");
+	printf("per step: step %.3f max %.3f collide %.3f solve %.3f velocity %.3f position %.3f toi %.3f broadphase %.3f ms\n",
+		p.step * invCount, result.maxStep, p.collide * invCount, p.solve * invCount,
+		p.solveVelocity * invCount, p.solvePosition * invCount,
+		p.solveTOI * invCount, p.broadphase * invCount);
+	printf("per step: %.1f contacts, %.2f toi events, %.2f allocations\n",
+		p.contactCount * invCount, p.toiCount * invCount, result.allocCount * invCount);
+
+	printf("slowest steps:");
+	for (int32 i = 0; i < k_slowestCount && result.slowestSteps[i] >= 0; ++i)
+	{
+		printf(" %d (%.3f ms)", result.slowestSteps[i], result.slowestTimes[i]);
+	}
+	printf("\n");
+}
+
+static uint8* LoadFile(const char* fileName, int32* size)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (file == NULL)
+	{
+		return NULL;
+	}
+
+	fseek(file, 0, SEEK_END);
+	*size = (int32)ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	uint8* data = (uint8*)malloc(*size > 0 ? *size : 1);
+	if (fread(data, 1, *size, file) != (size_t)*size)
+	{
+		free(data);
+		data = NULL;
+	}
+
+	fclose(file);
+	return data;
+}
+
+static bool SaveFile(const char* fileName, const void* data, int32 size)
+{
+	FILE* file = fopen(fileName, "wb");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	bool ok = fwrite(data, 1, size, file) == (size_t)size;
+	fclose(file);
+	return ok;
+}
+
+// A small session touching most of what the recorder writes.
+static uint32 RecordSample(b2WorldRecorder* recorder, int32 stepCount)
+{
+	b2AABB worldAABB;
+	worldAABB.lowerBound.Set(-200.0f, -100.0f);
+	worldAABB.upperBound.Set(200.0f, 200.0f);
+	b2World world(worldAABB, b2Vec2(0.0f, -10.0f), true);
+	world.SetRecorder(recorder);
+
+	b2BodyDef bd;
+	b2Body* ground = world.CreateBody(&bd);
+
+	b2Vec2 vertices[5];
+	for (int32 i = 0; i < 5; ++i)
+	{
+		vertices[i].Set(-40.0f + 20.0f * i, (i & 1) ? 2.0f : 0.0f);
+	}
+	b2EdgeChainDef chainDef;
+	chainDef.vertices = vertices;
+	chainDef.vertexCount = 5;
+	chainDef.isALoop = false;
+	chainDef.friction = 0.6f;
+	ground->CreateShape(&chainDef);
+
+	// An open mesh shelf, with a box dropped across each of its free ends.
+	b2Vec2 shelf[4] = {b2Vec2(22.0f, 6.0f), b2Vec2(26.0f, 5.0f), b2Vec2(30.0f, 5.0f), b2Vec2(34.0f, 6.0f)};
+	b2MeshDef meshDef;
+	meshDef.vertices = shelf;
+	meshDef.vertexCount = 4;
+	meshDef.isALoop = false;
+	meshDef.friction = 0.6f;
+	ground->CreateShape(&meshDef);
+
+	b2PolygonDef endBox;
+	endBox.SetAsBox(0.5f, 0.5f);
+	endBox.density = 1.0f;
+	endBox.friction = 0.3f;
+	for (int32 i = 0; i < 2; ++i)
+	{
+		bd.position.Set(i == 0 ? 22.0f : 34.0f, 10.0f);
+		b2Body* b = world.CreateBody(&bd);
+		b->CreateShape(&endBox);
+		b->SetMassFromShapes();
+	}
+
+	// A motorized wheel on a pendulum.
+	bd.position.Set(-10.0f, 12.0f);
+	b2Body* arm = world.CreateBody(&bd);
+	b2PolygonDef box;
+	box.SetAsBox(0.25f, 3.0f);
+	box.density = 2.0f;
+	arm->CreateShape(&box);
+	arm->SetMassFromShapes();
+
+	b2RevoluteJointDef revoluteDef;
+	revoluteDef.Initialize(ground, arm, b2Vec2(-10.0f, 15.0f));
+	revoluteDef.enableMotor = true;
+	revoluteDef.maxMotorTorque = 200.0f;
+	revoluteDef.motorSpeed = 1.0f;
+	b2RevoluteJoint* motor = (b2RevoluteJoint*)world.CreateJoint(&revoluteDef);
+
+	// A prismatic slider with a limit.
+	bd.position.Set(10.0f, 8.0f);
+	b2Body* slider = world.CreateBody(&bd);
+	slider->CreateShape(&box);
+	slider->SetMassFromShapes();
+
+	b2PrismaticJointDef prismaticDef;
+	prismaticDef.Initialize(ground, slider, bd.position, b2Vec2(1.0f, 0.0f));
+	prismaticDef.enableLimit = true;
+	prismaticDef.lowerTranslation = -5.0f;
+	prismaticDef.upperTranslation = 5.0f;
+	b2PrismaticJoint* prismatic = (b2PrismaticJoint*)world.CreateJoint(&prismaticDef);
+
+	// A ball dragged by a mouse joint.
+	bd.position.Set(0.0f, 20.0f);
+	b2Body* ball = world.CreateBody(&bd);
+	b2CircleDef circle;
+	circle.radius = 1.0f;
+	circle.density = 1.0f;
+	circle.restitution = 0.3f;
+	ball->CreateShape(&circle);
+	ball->SetMassFromShapes();
+
+	b2MouseJointDef mouseDef;
+	mouseDef.body1 = ground;
+	mouseDef.body2 = ball;
+	mouseDef.target = ball->GetPosition();
+	mouseDef.maxForce = 500.0f;
+	b2MouseJoint* mouse = (b2MouseJoint*)world.CreateJoint(&mouseDef);
+
+	b2Body* boxes[8];
+	int32 boxCount = 0;
+
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		// Drop boxes for a while and then remove the oldest ones.
+		if (i % 20 == 0)
+		{
+			if (boxCount < 8)
+			{
+				bd.position.Set(-20.0f + 5.0f * boxCount, 25.0f);
+				bd.angle = 0.1f * boxCount;
+				b2Body* b = world.CreateBody(&bd);
+				b2PolygonDef small;
+				small.SetAsBox(0.5f, 0.5f);
+				small.density = 1.0f;
+				small.friction = 0.3f;
+				b->CreateShape(&small);
+				b->SetMassFromShapes();
+				boxes[boxCount++] = b;
+			}
+			else
+			{
+				world.DestroyBody(boxes[0]);
+				memmove(boxes, boxes + 1, (boxCount - 1) * sizeof(b2Body*));
+				--boxCount;
+			}
+		}
+
+		if (i == stepCount / 2)
+		{
+			world.DestroyJoint(mouse);
+			mouse = NULL;
+			ball->SetLinearVelocity(b2Vec2(5.0f, 10.0f));
+			motor->SetMotorSpeed(-2.0f);
+			prismatic->SetLimits(-2.0f, 8.0f);
+			world.SetGravity(b2Vec2(1.0f, -10.0f));
+		}
+
+		if (mouse)
+		{
+			mouse->SetTarget(b2Vec2(10.0f * sinf(0.02f * i), 20.0f + 4.0f * cosf(0.03f * i)));
+		}
+
+		slider->ApplyForce(b2Vec2(50.0f * cosf(0.05f * i), 0.0f), slider->GetWorldCenter());
+		arm->ApplyTorque(i % 60 < 30 ? 20.0f : -20.0f);
+
+		world.Step(1.0f / 60.0f, 10, 8);
+	}
+
+	world.SetRecorder(NULL);
+	return HashWorld(&world);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: replay recording [repeat]\n");
+		printf("       replay --record recording [steps]\n");
+		return 1;
+	}
+
+	if (strcmp(argv[1], "--record") == 0)
+	{
+		if (argc < 3)
+		{
+			printf("usage: replay --record recording [steps]\n");
+			return 1;
+		}
+
+		int32 stepCount = argc > 3 ? atoi(argv[3]) : 600;
+
+		b2WorldRecorder recorder;
+		uint32 hash = RecordSample(&recorder, stepCount);
+		if (SaveFile(argv[2], recorder.GetData(), recorder.GetSize()) == false)
+		{
+			printf("could not write %s\n", argv[2]);
+			return 1;
+		}
+
+		printf("recorded %d steps in %d bytes to %s, hash %08x\n",
+			recorder.GetStepCount(), recorder.GetSize(), argv[2], hash);
+
+		ReplayResult result;
+		Replay(&result, recorder.GetData(), recorder.GetSize());
+		Report(result);
+
+		if (result.valid == false || result.hash != hash)
+		{
+			printf("the replay does not match the recording\n");
+			return 1;
+		}
+
+		return 0;
+	}
+
+	int32 size = 0;
+	uint8* data = LoadFile(argv[1], &size);
+	if (data == NULL)
+	{
+		printf("could not read %s\n", argv[1]);
+		return 1;
+	}
+
+	int32 repeatCount = argc > 2 ? b2Max(atoi(argv[2]), 1) : 1;
+
+	bool valid = true;
+	for (int32 i = 0; i < repeatCount; ++i)
+	{
+		ReplayResult result;
+		Replay(&result, data, size);
+		Report(result);
+		valid = valid && result.valid;
+	}
+
+	free(data);
+	return valid ? 0 : 1;
+}
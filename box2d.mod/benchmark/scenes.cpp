@@ -0,0 +1,867 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Steps the example scenes headless and reports steps per second, the time
+// spent in each phase of the step, allocations per step and a hash of the final
+// body positions. The scenes are rebuilt here to match examples/*.bmx, with the
+// same world, time step and iterations as examples/test.bmx.
+//
+// A scale above one tiles that many copies of a scene side by side in one world.
+// Worlds with more shapes than b2_maxProxies use the uniform grid broad-phase, so
+// raise it for the whole build to keep sweep and prune for the larger scales.
+// From box2d.mod:
+//
+//   g++ -O2 -DB2_MAX_PROXIES=16384 -Iinclude benchmark/scenes.cpp $(find Source -name '*.cpp') -lpthread -o scenes
+//   ./scenes [steps] [scene|all] [scale]
+//
+// Without a scene all of them are run at the scales 1, 10 and 100. The hash
+// changes whenever the simulation results change, and should be the same from
+// run to run of the same build.
+
+#include "Box2D.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+static const float32 k_tileWidth = 120.0f;
+static const float32 k_tileHeight = 100.0f;
+static const float32 k_cellSize = 2.0f;
+
+static float32 DegreesToRadians(float32 degrees)
+{
+	return degrees * b2_pi / 180.0f;
+}
+
+// The 100 x 20 ground box shared by most of the scenes.
+static b2Body* CreateGround(b2World* world, const b2Vec2& offset)
+{
+	b2BodyDef bd;
+	bd.position = b2Vec2(0.0f, -10.0f) + offset;
+	b2Body* ground = world->CreateBody(&bd);
+
+	b2PolygonDef sd;
+	sd.SetAsBox(50.0f, 10.0f);
+	ground->CreateShape(&sd);
+
+	return ground;
+}
+
+static void CreatePyramid(b2World* world, const b2Vec2& offset)
+{
+	CreateGround(world, offset);
+
+	b2PolygonDef sd;
+	sd.SetAsBox(0.5f, 0.5f);
+	sd.density = 5.0f;
+
+	const int32 count = 25;
+	b2Vec2 x(-10.0f, 1.0f);
+	b2Vec2 deltaX(0.5625f, 2.0f);
+	b2Vec2 deltaY(1.125f, 0.0f);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Vec2 y = x;
+
+		for (int32 j = i; j < count; ++j)
+		{
+			b2BodyDef bd;
+			bd.position = y + offset;
+			b2Body* body = world->CreateBody(&bd);
+			body->CreateShape(&sd);
+			body->SetMassFromShapes();
+
+			y += deltaY;
+		}
+
+		x += deltaX;
+	}
+}
+
+static void CreateVerticalStack(b2World* world, const b2Vec2& offset)
+{
+	// The example offsets the ground box from its body, so it sits 10 lower than elsewhere.
+	b2BodyDef groundDef;
+	groundDef.position = b2Vec2(0.0f, -10.0f) + offset;
+	b2Body* ground = world->CreateBody(&groundDef);
+
+	b2PolygonDef wallDef;
+	wallDef.SetAsBox(50.0f, 10.0f, b2Vec2(0.0f, -10.0f), 0.0f);
+	ground->CreateShape(&wallDef);
+	wallDef.SetAsBox(0.1f, 10.0f, b2Vec2(20.0f, 10.0f), 0.0f);
+	ground->CreateShape(&wallDef);
+
+	b2PolygonDef sd;
+	sd.SetAsBox(0.5f, 0.5f);
+	sd.density = 1.0f;
+	sd.friction = 0.3f;
+
+	const float32 xs[5] = {0.0f, -10.0f, -5.0f, 5.0f, 10.0f};
+
+	for (int32 j = 0; j < 5; ++j)
+	{
+		for (int32 i = 0; i < 16; ++i)
+		{
+			b2BodyDef bd;
+			bd.position = b2Vec2(xs[j], 0.752f + 1.4f * i) + offset;
+			b2Body* body = world->CreateBody(&bd);
+			body->CreateShape(&sd);
+			body->SetMassFromShapes();
+		}
+	}
+}
+
+static void CreateDominos(b2World* world, const b2Vec2& offset)
+{
+	b2Body* b1 = CreateGround(world, offset);
+
+	{
+		b2PolygonDef sd;
+		sd.SetAsBox(6.0f, 0.25f);
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(-1.5f, 10.0f) + offset;
+		b2Body* ground = world->CreateBody(&bd);
+		ground->CreateShape(&sd);
+	}
+
+	{
+		b2PolygonDef sd;
+		sd.SetAsBox(0.1f, 1.0f);
+		sd.density = 20.0f;
+		sd.friction = 0.1f;
+
+		for (int32 i = 0; i < 10; ++i)
+		{
+			b2BodyDef bd;
+			bd.position = b2Vec2(-6.0f + 1.0f * i, 11.25f) + offset;
+			b2Body* body = world->CreateBody(&bd);
+			body->CreateShape(&sd);
+			body->SetMassFromShapes();
+		}
+	}
+
+	{
+		b2PolygonDef sd;
+		sd.SetAsBox(7.0f, 0.25f, b2Vec2_zero, 0.3f);
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(1.0f, 6.0f) + offset;
+		b2Body* ground = world->CreateBody(&bd);
+		ground->CreateShape(&sd);
+	}
+
+	b2Body* b2;
+	{
+		b2PolygonDef sd;
+		sd.SetAsBox(0.25f, 1.5f);
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(-7.0f, 4.0f) + offset;
+		b2 = world->CreateBody(&bd);
+		b2->CreateShape(&sd);
+	}
+
+	b2Body* b3;
+	{
+		b2PolygonDef sd;
+		sd.SetAsBox(6.0f, 0.125f);
+		sd.density = 10.0f;
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(-0.9f, 1.0f) + offset;
+		bd.angle = -0.15f;
+		b3 = world->CreateBody(&bd);
+		b3->CreateShape(&sd);
+		b3->SetMassFromShapes();
+	}
+
+	b2RevoluteJointDef jd;
+	b2Vec2 anchor;
+
+	anchor = b2Vec2(-2.0f, 1.0f) + offset;
+	jd.Initialize(b1, b3, anchor);
+	jd.collideConnected = true;
+	world->CreateJoint(&jd);
+
+	b2Body* b4;
+	{
+		b2PolygonDef sd;
+		sd.SetAsBox(0.25f, 0.25f);
+		sd.density = 10.0f;
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(-10.0f, 15.0f) + offset;
+		b4 = world->CreateBody(&bd);
+		b4->CreateShape(&sd);
+		b4->SetMassFromShapes();
+	}
+
+	anchor = b2Vec2(-7.0f, 15.0f) + offset;
+	jd.Initialize(b2, b4, anchor);
+	world->CreateJoint(&jd);
+
+	b2Body* b5;
+	{
+		b2BodyDef bd;
+		bd.position = b2Vec2(6.5f, 3.0f) + offset;
+		b5 = world->CreateBody(&bd);
+
+		b2PolygonDef sd;
+		sd.density = 10.0f;
+		sd.friction = 0.1f;
+
+		sd.SetAsBox(1.0f, 0.1f, b2Vec2(0.0f, -0.9f), 0.0f);
+		b5->CreateShape(&sd);
+
+		sd.SetAsBox(0.1f, 1.0f, b2Vec2(-0.9f, 0.0f), 0.0f);
+		b5->CreateShape(&sd);
+
+		sd.SetAsBox(0.1f, 1.0f, b2Vec2(0.9f, 0.0f), 0.0f);
+		b5->CreateShape(&sd);
+
+		b5->SetMassFromShapes();
+	}
+
+	anchor = b2Vec2(6.0f, 2.0f) + offset;
+	jd.Initialize(b1, b5, anchor);
+	world->CreateJoint(&jd);
+
+	b2Body* b6;
+	{
+		b2PolygonDef sd;
+		sd.SetAsBox(1.0f, 0.1f);
+		sd.density = 30.0f;
+		sd.friction = 0.2f;
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(6.5f, 4.1f) + offset;
+		b6 = world->CreateBody(&bd);
+		b6->CreateShape(&sd);
+		b6->SetMassFromShapes();
+	}
+
+	anchor = b2Vec2(7.5f, 4.0f) + offset;
+	jd.Initialize(b5, b6, anchor);
+	world->CreateJoint(&jd);
+
+	b2Body* b7;
+	{
+		b2PolygonDef sd;
+		sd.SetAsBox(0.1f, 1.0f);
+		sd.density = 10.0f;
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(7.4f, 1.0f) + offset;
+		b7 = world->CreateBody(&bd);
+		b7->CreateShape(&sd);
+		b7->SetMassFromShapes();
+	}
+
+	b2DistanceJointDef djd;
+	djd.body1 = b3;
+	djd.body2 = b7;
+	djd.localAnchor1.Set(6.0f, 0.0f);
+	djd.localAnchor2.Set(0.0f, -1.0f);
+	b2Vec2 d = djd.body2->GetWorldPoint(djd.localAnchor2) - djd.body1->GetWorldPoint(djd.localAnchor1);
+	djd.length = d.Length();
+	world->CreateJoint(&djd);
+
+	{
+		b2CircleDef sd;
+		sd.radius = 0.2f;
+		sd.density = 10.0f;
+
+		for (int32 i = 0; i < 4; ++i)
+		{
+			b2BodyDef bd;
+			bd.position = b2Vec2(5.9f + 0.4f * i, 2.4f) + offset;
+			b2Body* body = world->CreateBody(&bd);
+			body->CreateShape(&sd);
+			body->SetMassFromShapes();
+		}
+	}
+}
+
+static void CreateLeg(b2World* world, b2Body* chassis, b2Body* wheel, const b2Vec2& offset, const b2Vec2& wheelAnchor, float32 s)
+{
+	b2Vec2 p1(5.4f * s, -6.1f);
+	b2Vec2 p2(7.2f * s, -1.2f);
+	b2Vec2 p3(4.3f * s, -1.9f);
+	b2Vec2 p4(3.1f * s, 0.8f);
+	b2Vec2 p5(6.0f * s, 1.5f);
+	b2Vec2 p6(2.5f * s, 3.7f);
+
+	b2PolygonDef sd1, sd2;
+	sd1.vertexCount = 3;
+	sd2.vertexCount = 3;
+	sd1.filter.groupIndex = -1;
+	sd2.filter.groupIndex = -1;
+	sd1.density = 1.0f;
+	sd2.density = 1.0f;
+
+	if (s > 0.0f)
+	{
+		sd1.vertices[0] = p1;
+		sd1.vertices[1] = p2;
+		sd1.vertices[2] = p3;
+
+		sd2.vertices[0] = b2Vec2_zero;
+		sd2.vertices[1] = p5 - p4;
+		sd2.vertices[2] = p6 - p4;
+	}
+	else
+	{
+		sd1.vertices[0] = p1;
+		sd1.vertices[1] = p3;
+		sd1.vertices[2] = p2;
+
+		sd2.vertices[0] = b2Vec2_zero;
+		sd2.vertices[1] = p6 - p4;
+		sd2.vertices[2] = p5 - p4;
+	}
+
+	b2BodyDef bd1, bd2;
+	bd1.position = offset;
+	bd2.position = p4 + offset;
+	bd1.angularDamping = 10.0f;
+	bd2.angularDamping = 10.0f;
+
+	b2Body* body1 = world->CreateBody(&bd1);
+	b2Body* body2 = world->CreateBody(&bd2);
+
+	body1->CreateShape(&sd1);
+	body2->CreateShape(&sd2);
+
+	body1->SetMassFromShapes();
+	body2->SetMassFromShapes();
+
+	b2DistanceJointDef djd;
+	djd.dampingRatio = 0.5f;
+	djd.frequencyHz = 10.0f;
+
+	djd.Initialize(body1, body2, p2 + offset, p5 + offset);
+	world->CreateJoint(&djd);
+
+	djd.Initialize(body1, body2, p3 + offset, p4 + offset);
+	world->CreateJoint(&djd);
+
+	djd.Initialize(body1, wheel, p3 + offset, wheelAnchor + offset);
+	world->CreateJoint(&djd);
+
+	djd.Initialize(body2, wheel, p6 + offset, wheelAnchor + offset);
+	world->CreateJoint(&djd);
+
+	b2RevoluteJointDef rjd;
+	rjd.Initialize(body2, chassis, p4 + offset);
+	world->CreateJoint(&rjd);
+}
+
+static void CreateTheoJansen(b2World* world, const b2Vec2& tileOffset)
+{
+	b2Vec2 offset = b2Vec2(0.0f, 8.0f) + tileOffset;
+	b2Vec2 pivot(0.0f, 0.8f);
+
+	b2Body* ground = CreateGround(world, tileOffset);
+
+	b2PolygonDef wallDef;
+	wallDef.SetAsBox(0.5f, 5.0f, b2Vec2(-50.0f, 15.0f), 0.0f);
+	ground->CreateShape(&wallDef);
+	wallDef.SetAsBox(0.5f, 5.0f, b2Vec2(50.0f, 15.0f), 0.0f);
+	ground->CreateShape(&wallDef);
+
+	for (int32 i = 0; i < 40; ++i)
+	{
+		b2CircleDef sd;
+		sd.density = 1.0f;
+		sd.radius = 0.25f;
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(-40.0f + 2.0f * i, 0.5f) + tileOffset;
+
+		b2Body* body = world->CreateBody(&bd);
+		body->CreateShape(&sd);
+		body->SetMassFromShapes();
+	}
+
+	b2Body* chassis;
+	{
+		b2PolygonDef sd;
+		sd.density = 1.0f;
+		sd.SetAsBox(2.5f, 1.0f);
+		sd.filter.groupIndex = -1;
+
+		b2BodyDef bd;
+		bd.position = pivot + offset;
+		chassis = world->CreateBody(&bd);
+		chassis->CreateShape(&sd);
+		chassis->SetMassFromShapes();
+	}
+
+	b2Body* wheel;
+	{
+		b2CircleDef sd;
+		sd.density = 1.0f;
+		sd.radius = 1.6f;
+		sd.filter.groupIndex = -1;
+
+		b2BodyDef bd;
+		bd.position = pivot + offset;
+		wheel = world->CreateBody(&bd);
+		wheel->CreateShape(&sd);
+		wheel->SetMassFromShapes();
+	}
+
+	{
+		b2RevoluteJointDef jd;
+		jd.Initialize(wheel, chassis, pivot + offset);
+		jd.collideConnected = false;
+		jd.motorSpeed = 2.0f;
+		jd.maxMotorTorque = 400.0f;
+		jd.enableMotor = true;
+		world->CreateJoint(&jd);
+	}
+
+	b2Vec2 wheelAnchor = pivot + b2Vec2(0.0f, -0.8f);
+
+	CreateLeg(world, chassis, wheel, offset, wheelAnchor, -1.0f);
+	CreateLeg(world, chassis, wheel, offset, wheelAnchor, 1.0f);
+
+	wheel->SetXForm(wheel->GetPosition(), DegreesToRadians(120.0f));
+	CreateLeg(world, chassis, wheel, offset, wheelAnchor, -1.0f);
+	CreateLeg(world, chassis, wheel, offset, wheelAnchor, 1.0f);
+
+	wheel->SetXForm(wheel->GetPosition(), DegreesToRadians(-120.0f));
+	CreateLeg(world, chassis, wheel, offset, wheelAnchor, -1.0f);
+	CreateLeg(world, chassis, wheel, offset, wheelAnchor, 1.0f);
+}
+
+static void CreateWeb(b2World* world, const b2Vec2& offset)
+{
+	b2Body* ground = CreateGround(world, offset);
+
+	b2PolygonDef sd;
+	sd.SetAsBox(0.5f, 0.5f);
+	sd.density = 5.0f;
+	sd.friction = 0.2f;
+
+	const b2Vec2 positions[4] =
+	{
+		b2Vec2(-5.0f, 5.0f), b2Vec2(5.0f, 5.0f), b2Vec2(5.0f, 15.0f), b2Vec2(-5.0f, 15.0f)
+	};
+
+	b2Body* bodies[4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		b2BodyDef bd;
+		bd.position = positions[i] + offset;
+		bodies[i] = world->CreateBody(&bd);
+		bodies[i]->CreateShape(&sd);
+		bodies[i]->SetMassFromShapes();
+	}
+
+	// Ground anchors are local to the ground body, which sits at (0, -10).
+	struct WebJoint
+	{
+		int32 body1, body2;
+		b2Vec2 anchor1, anchor2;
+	};
+
+	const WebJoint joints[8] =
+	{
+		{-1, 0, b2Vec2(-10.0f, 10.0f), b2Vec2(-0.5f, -0.5f)},
+		{-1, 1, b2Vec2(10.0f, 10.0f), b2Vec2(0.5f, -0.5f)},
+		{-1, 2, b2Vec2(10.0f, 30.0f), b2Vec2(0.5f, 0.5f)},
+		{-1, 3, b2Vec2(-10.0f, 30.0f), b2Vec2(-0.5f, 0.5f)},
+		{0, 1, b2Vec2(0.5f, 0.0f), b2Vec2(-0.5f, 0.0f)},
+		{1, 2, b2Vec2(0.0f, 0.5f), b2Vec2(0.0f, -0.5f)},
+		{2, 3, b2Vec2(-0.5f, 0.0f), b2Vec2(0.5f, 0.0f)},
+		{3, 0, b2Vec2(0.0f, -0.5f), b2Vec2(0.0f, 0.5f)},
+	};
+
+	b2DistanceJointDef jd;
+	jd.frequencyHz = 4.0f;
+	jd.dampingRatio = 0.5f;
+
+	for (int32 i = 0; i < 8; ++i)
+	{
+		const WebJoint& j = joints[i];
+		jd.body1 = j.body1 < 0 ? ground : bodies[j.body1];
+		jd.body2 = bodies[j.body2];
+		jd.localAnchor1 = j.anchor1;
+		jd.localAnchor2 = j.anchor2;
+		b2Vec2 d = jd.body2->GetWorldPoint(jd.localAnchor2) - jd.body1->GetWorldPoint(jd.localAnchor1);
+		jd.length = d.Length();
+		world->CreateJoint(&jd);
+	}
+}
+
+// The bridge, with optional buoyancy for the buoyancy scene.
+static void CreateBridge(b2World* world, const b2Vec2& offset, float32 plankDensity, b2Controller* controller)
+{
+	b2Body* ground = CreateGround(world, offset);
+
+	b2PolygonDef sd;
+	sd.SetAsBox(0.5f, 0.125f);
+	sd.density = plankDensity;
+	sd.friction = 0.2f;
+
+	b2RevoluteJointDef jd;
+	const int32 numPlanks = 30;
+
+	b2Body* prevBody = ground;
+	for (int32 i = 0; i < numPlanks; ++i)
+	{
+		b2BodyDef bd;
+		bd.position = b2Vec2(-14.5f + 1.0f * i, 5.0f) + offset;
+		b2Body* body = world->CreateBody(&bd);
+		body->CreateShape(&sd);
+		body->SetMassFromShapes();
+
+		if (controller)
+		{
+			controller->AddBody(body);
+		}
+
+		b2Vec2 anchor = b2Vec2(-15.0f + 1.0f * i, 5.0f) + offset;
+		jd.Initialize(prevBody, body, anchor);
+		world->CreateJoint(&jd);
+
+		prevBody = body;
+	}
+
+	b2Vec2 anchor = b2Vec2(-15.0f + 1.0f * numPlanks, 5.0f) + offset;
+	jd.Initialize(prevBody, ground, anchor);
+	world->CreateJoint(&jd);
+
+	for (int32 i = 0; i < 2; ++i)
+	{
+		b2PolygonDef triangleDef;
+		triangleDef.vertexCount = 3;
+		triangleDef.vertices[0].Set(-0.5f, 0.0f);
+		triangleDef.vertices[1].Set(0.5f, 0.0f);
+		triangleDef.vertices[2].Set(0.0f, 1.5f);
+		triangleDef.density = 1.0f;
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(-8.0f + 8.0f * i, 12.0f) + offset;
+		b2Body* body = world->CreateBody(&bd);
+		body->CreateShape(&triangleDef);
+		body->SetMassFromShapes();
+
+		if (controller)
+		{
+			controller->AddBody(body);
+		}
+	}
+
+	for (int32 i = 0; i < 3; ++i)
+	{
+		b2CircleDef circleDef;
+		circleDef.radius = 0.5f;
+		circleDef.density = 1.0f;
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(-6.0f + 6.0f * i, 10.0f) + offset;
+		b2Body* body = world->CreateBody(&bd);
+		body->CreateShape(&circleDef);
+		body->SetMassFromShapes();
+
+		if (controller)
+		{
+			controller->AddBody(body);
+		}
+	}
+}
+
+static void CreateBridge(b2World* world, const b2Vec2& offset)
+{
+	CreateBridge(world, offset, 20.0f, NULL);
+}
+
+static void CreateBuoyancy(b2World* world, const b2Vec2& offset)
+{
+	b2BuoyancyControllerDef bcd;
+	bcd.offset = 15.0f + offset.y;
+	bcd.normal.Set(0.0f, 1.0f);
+	bcd.density = 2.0f;
+	bcd.linearDrag = 2.0f;
+	bcd.angularDrag = 1.0f;
+
+	b2Controller* controller = world->CreateController(&bcd);
+
+	CreateBridge(world, offset, 2.0f, controller);
+}
+
+static void CreateCCDTest(b2World* world, const b2Vec2& offset)
+{
+	const float32 k_restitution = 1.4f;
+
+	{
+		b2BodyDef bd;
+		bd.position = b2Vec2(0.0f, 20.0f) + offset;
+		b2Body* body = world->CreateBody(&bd);
+
+		b2PolygonDef sd;
+		sd.density = 0.0f;
+		sd.restitution = k_restitution;
+
+		sd.SetAsBox(0.1f, 10.0f, b2Vec2(-10.0f, 0.0f), 0.0f);
+		body->CreateShape(&sd);
+
+		sd.SetAsBox(0.1f, 10.0f, b2Vec2(10.0f, 0.0f), 0.0f);
+		body->CreateShape(&sd);
+
+		sd.SetAsBox(0.1f, 10.0f, b2Vec2(0.0f, -10.0f), 0.5f * b2_pi);
+		body->CreateShape(&sd);
+
+		sd.SetAsBox(0.1f, 10.0f, b2Vec2(0.0f, 10.0f), -0.5f * b2_pi);
+		body->CreateShape(&sd);
+	}
+
+	{
+		b2PolygonDef sd_bottom;
+		sd_bottom.SetAsBox(1.5f, 0.15f);
+		sd_bottom.density = 4.0f;
+
+		b2PolygonDef sd_left;
+		sd_left.SetAsBox(0.15f, 2.7f, b2Vec2(-1.45f, 2.35f), 0.2f);
+		sd_left.density = 4.0f;
+
+		b2PolygonDef sd_right;
+		sd_right.SetAsBox(0.15f, 2.7f, b2Vec2(1.45f, 2.35f), -0.2f);
+		sd_right.density = 4.0f;
+
+		b2BodyDef bd;
+		bd.position = b2Vec2(0.0f, 15.0f) + offset;
+		b2Body* body = world->CreateBody(&bd);
+		body->CreateShape(&sd_bottom);
+		body->CreateShape(&sd_left);
+		body->CreateShape(&sd_right);
+		body->SetMassFromShapes();
+	}
+}
+
+typedef void (*SceneCreateFcn)(b2World* world, const b2Vec2& offset);
+
+struct SceneEntry
+{
+	const char* name;
+	SceneCreateFcn createFcn;
+};
+
+static const SceneEntry s_scenes[] =
+{
+	{"pyramid", CreatePyramid},
+	{"verticalstack", CreateVerticalStack},
+	{"dominos", CreateDominos},
+	{"theojansen", CreateTheoJansen},
+	{"web", CreateWeb},
+	{"bridge", CreateBridge},
+	{"ccdtest", CreateCCDTest},
+	{"buoyancy", CreateBuoyancy},
+};
+
+static const int32 s_sceneCount = sizeof(s_scenes) / sizeof(s_scenes[0]);
+
+struct BenchmarkResult
+{
+	int32 bodyCount;
+	int32 proxyCount;
+	bool grid;
+	float32 wallTime;
+	b2Profile total;
+	int32 allocCount;
+	int32 byteCount;
+	uint32 hash;
+};
+
+// Build the copies of a scene in a new world, laid out in a square of tiles.
+static b2World* CreateWorld(const SceneEntry& scene, int32 scale, bool grid)
+{
+	int32 columns = (int32)ceilf(sqrtf((float32)scale));
+	int32 rows = (scale + columns - 1) / columns;
+
+	// The scale one world is the one used by examples/test.bmx.
+	b2AABB worldAABB;
+	worldAABB.lowerBound.Set(-200.0f, -100.0f);
+	worldAABB.upperBound.Set(200.0f + (columns - 1) * k_tileWidth, 200.0f + (rows - 1) * k_tileHeight);
+
+	b2Vec2 gravity(0.0f, -10.0f);
+	b2World* world;
+	if (grid)
+	{
+		world = new b2World(worldAABB, gravity, true, k_cellSize);
+	}
+	else
+	{
+		world = new b2World(worldAABB, gravity, true);
+	}
+
+	for (int32 i = 0; i < scale; ++i)
+	{
+		b2Vec2 offset(k_tileWidth * (i % columns), k_tileHeight * (i / columns));
+		scene.createFcn(world, offset);
+	}
+
+	return world;
+}
+
+// Count the shapes of one copy to choose the broad-phase before building the real world.
+static int32 CountProxies(const SceneEntry& scene)
+{
+	b2World* world = CreateWorld(scene, 1, true);
+	int32 proxyCount = world->GetProxyCount();
+	delete world;
+	return proxyCount;
+}
+
+static void Accumulate(b2Profile* total, const b2Profile& profile)
+{
+	total->step += profile.step;
+	total->collide += profile.collide;
+	total->solve += profile.solve;
+	total->islandBuild += profile.islandBuild;
+	total->solveInit += profile.solveInit;
+	total->solveVelocity += profile.solveVelocity;
+	total->solvePosition += profile.solvePosition;
+	total->solveTOI += profile.solveTOI;
+	total->broadphase += profile.broadphase;
+	total->toiCount += profile.toiCount;
+	total->contactCount += profile.contactCount;
+}
+
+// FNV-1a over the bits of the final body positions and angles.
+static uint32 HashWorld(b2World* world)
+{
+	uint32 hash = 2166136261u;
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		float32 values[3] = {b->GetPosition().x, b->GetPosition().y, b->GetAngle()};
+		const uint8* bytes = (const uint8*)values;
+		for (int32 i = 0; i < (int32)sizeof(values); ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 16777619u;
+		}
+	}
+	return hash;
+}
+
+static void RunScene(BenchmarkResult* result, const SceneEntry& scene, int32 scale, int32 stepCount)
+{
+	result->grid = CountProxies(scene) * scale > b2_maxProxies;
+
+	b2World* world = CreateWorld(scene, scale, result->grid);
+	world->SetProfiling(true);
+
+	result->bodyCount = world->GetBodyCount();
+	result->proxyCount = world->GetProxyCount();
+	memset(&result->total, 0, sizeof(result->total));
+
+	int32 allocCount = b2_allocCount;
+	b2Timer timer;
+	timer.Reset();
+
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		world->Step(1.0f / 60.0f, 10, 8);
+		Accumulate(&result->total, world->GetProfile());
+	}
+
+	result->wallTime = timer.GetMilliseconds();
+	result->allocCount = b2_allocCount - allocCount;
+	result->byteCount = b2_byteCount;
+	result->hash = HashWorld(world);
+
+	delete world;
+}
+
+static void Report(const char* name, int32 scale, const BenchmarkResult& result, int32 stepCount)
+{
+	float32 invCount = 1.0f / stepCount;
+	const b2Profile& p = result.total;
+
+	printf("%-14s %5d %7d %-5s %9.1f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %7.2f %7.1f %9.1f  %08x\n",
+		name, scale, result.bodyCount, result.grid ? "grid" : "sap",
+		stepCount * 1000.0f / result.wallTime,
+		p.step * invCount, p.collide * invCount, p.solve * invCount,
+		p.solveVelocity * invCount, p.solvePosition * invCount,
+		p.solveTOI * invCount, p.broadphase * invCount,
+		p.toiCount * invCount, result.allocCount * invCount,
+		result.byteCount / 1024.0f, result.hash);
+}
+
+int main(int argc, char** argv)
+{
+	int32 stepCount = argc > 1 ? atoi(argv[1]) : 600;
+	const char* sceneName = argc > 2 && strcmp(argv[2], "all") != 0 ? argv[2] : NULL;
+	int32 scale = argc > 3 ? atoi(argv[3]) : 0;
+
+	if (stepCount <= 0)
+	{
+		printf("usage: scenes [steps] [scene|all] [scale]\n");
+		return 1;
+	}
+
+	const int32 defaultScales[3] = {1, 10, 100};
+	const int32* scales = defaultScales;
+	int32 scaleCount = 3;
+	if (scale > 0)
+	{
+		scales = &scale;
+		scaleCount = 1;
+	}
+
+	printf("%d steps at 60 Hz, 10 velocity and 8 position iterations, times in ms per step\n", stepCount);
+	printf("%-14s %5s %7s %-5s %9s %8s %8s %8s %8s %8s %8s %8s %7s %7s %9s  %8s\n",
+		"scene", "scale", "bodies", "bp", "steps/s", "step", "collide", "solve",
+		"velocity", "position", "toi", "bphase", "tois", "allocs", "kbytes", "hash");
+
+	int32 runCount = 0;
+	for (int32 i = 0; i < s_sceneCount; ++i)
+	{
+		if (sceneName && strcmp(sceneName, s_scenes[i].name) != 0)
+		{
+			continue;
+		}
+
+		for (int32 j = 0; j < scaleCount; ++j)
+		{
+			BenchmarkResult result;
+			RunScene(&result, s_scenes[i], scales[j], stepCount);
+			Report(s_scenes[i].name, scales[j], result, stepCount);
+			++runCount;
+		}
+	}
+
+	if (runCount == 0)
+	{
+		printf("unknown scene %s, choose one of:", sceneName);
+		for (int32 i = 0; i < s_sceneCount; ++i)
+		{
+			printf(" %s", s_scenes[i].name);
+		}
+		printf("\n");
+		return 1;
+	}
+
+	return 0;
+}
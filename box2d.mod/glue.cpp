@@ -23,12 +23,18 @@
 #include <blitz.h>
 #include "Box2D.h"
 
+#include <cstring>
+
 class MaxDebugDraw;
 class MaxContactFilter;
 class MaxContactListener;
 class MaxBoundaryListener;
+class MaxSensorListener;
 class MaxDestructionListener;
 class Maxb2EdgeChainDef;
+class Maxb2MeshDef;
+class Maxb2TileGridDef;
+class Maxb2HeightfieldDef;
 
 enum b2ControllerType
 {
@@ -100,6 +106,33 @@ extern "C" {
 		int groupIndex;
 	} Maxb2FilterData;
 
+	typedef struct Maxb2Profile
+	{
+		float32 step;
+		float32 collide;
+		float32 solve;
+		float32 islandBuild;
+		float32 solveInit;
+		float32 solveVelocity;
+		float32 solvePosition;
+		float32 solveTOI;
+		float32 broadphase;
+		float32 listeners;
+		float32 particles;
+		int islandCount;
+		int bodyCount;
+		int contactCount;
+		int jointCount;
+		int velocityIterations;
+		int positionIterations;
+		int toiCount;
+		int listenerCalls;
+		int pairsAdded;
+		int pairsRemoved;
+		int pairsCancelled;
+		int particleCount;
+	} Maxb2Profile;
+
 	void bmx_Maxb2AABBtob2AABB(Maxb2AABB * m, b2AABB * b) {
 		b->lowerBound = b2Vec2(m->lowerBound.x, m->lowerBound.y);
 		b->upperBound = b2Vec2(m->upperBound.x, m->upperBound.y);
@@ -114,6 +147,7 @@ extern "C" {
 
 	BBArray * CB_PREF(physics_box2d_b2Vec2__newVecArray)(int count);
 	void CB_PREF(physics_box2d_b2World__setShape)(BBArray * shapes, int index, b2Shape * shape);
+	void CB_PREF(physics_box2d_b2World__setBody)(BBArray * bodies, int index, b2Body * body);
 
 	void CB_PREF(physics_box2d_b2DebugDraw__DrawPolygon)(BBObject * maxHandle, BBArray * array, int r, int g, int b);
 	void CB_PREF(physics_box2d_b2DebugDraw__DrawSolidPolygon)(BBObject * maxHandle, BBArray * array, int r, int g, int b);
@@ -126,6 +160,8 @@ extern "C" {
 	void CB_PREF(physics_box2d_b2ContactListener__Remove)(BBObject * maxHandle, Maxb2ContactPoint point);
 	void CB_PREF(physics_box2d_b2ContactListener__Result)(BBObject * maxHandle, Maxb2ContactResult result);
 	void CB_PREF(physics_box2d_b2BoundaryListener__Violation)(BBObject * maxHandle, b2Body * body);
+	void CB_PREF(physics_box2d_b2SensorListener__BeginOverlap)(BBObject * maxHandle, b2Shape * sensor, b2Shape * shape);
+	void CB_PREF(physics_box2d_b2SensorListener__EndOverlap)(BBObject * maxHandle, b2Shape * sensor, b2Shape * shape);
 
 	BBObject * CB_PREF(physics_box2d_b2World___createController)(b2ControllerType type);
 
@@ -158,13 +194,22 @@ extern "C" {
 	void bmx_b2world_setwarmstarting(b2World * world, int flag);
 	void bmx_b2world_setcontinuousphysics(b2World * world, int flag);
 	void bmx_b2world_validate(b2World * world);
+	void bmx_b2world_setstepbudget(b2World * world, float32 milliseconds);
+	int bmx_b2world_isdegraded(b2World * world);
+	void bmx_b2world_setprofiling(b2World * world, int flag);
+	void bmx_b2world_setvelocitytolerance(b2World * world, float32 tolerance);
+	Maxb2Profile bmx_b2world_getprofile(b2World * world);
+	void bmx_b2world_setrecorder(b2World * world, b2WorldRecorder * recorder);
 	void bmx_b2world_setdebugDraw(b2World * world, b2DebugDraw * debugDraw);
+	void bmx_b2world_setdebugdrawview(b2World * world, Maxb2AABB * view);
+	void bmx_b2world_cleardebugdrawview(b2World * world);
 	b2Joint * bmx_b2world_createjoint(b2World * world, b2JointDef * def);
 	void bmx_b2world_destroyjoint(b2World * world, b2Joint * joint);
 	b2Body * bmx_b2world_getbodylist(b2World * world);
 	b2Joint * bmx_b2world_getjointlist(b2World * world);
 	void bmx_b2world_setfilter(b2World * world, b2ContactFilter * filter);
 	void bmx_b2world_setcontactlistener(b2World * world, b2ContactListener * listener);
+	void bmx_b2world_setsensorlistener(b2World * world, b2SensorListener * listener);
 	void bmx_b2world_setboundarylistener(b2World * world, b2BoundaryListener * listener);
 	void bmx_b2world_setgravity(b2World * world, Maxb2Vec2 * gravity);
 	int32 bmx_b2world_getproxycount(b2World * world);
@@ -175,11 +220,24 @@ extern "C" {
 	void bmx_b2world_free(b2World * world);
 	void bmx_b2world_setdestructionlistener(b2World * world, b2DestructionListener * listener);
 	void bmx_b2world_refilter(b2World * world, b2Shape * shape);
-	int32 bmx_b2world_raycast(b2World * world, Maxb2Segment * segment, BBArray * shapes, int solidShapes);
-	b2Shape * bmx_b2world_raycastone(b2World * world, Maxb2Segment * segment, float32 * lambda, Maxb2Vec2 * normal, int solidShapes);
+	int32 bmx_b2world_raycast(b2World * world, Maxb2Segment * segment, BBArray * shapes, int solidShapes, int layer);
+	b2Shape * bmx_b2world_raycastone(b2World * world, Maxb2Segment * segment, float32 * lambda, Maxb2Vec2 * normal, int solidShapes, int layer);
+	b2FilterTable * bmx_b2world_getfiltertable(b2World * world);
+
+	void bmx_b2filtertable_setcategorycollision(b2FilterTable * table, int category1, int category2, int flag);
+	int bmx_b2filtertable_getcategorycollision(b2FilterTable * table, int category1, int category2);
+	void bmx_b2filtertable_setbodypairexcluded(b2FilterTable * table, b2Body * body1, b2Body * body2, int flag);
+	int bmx_b2filtertable_isbodypairexcluded(b2FilterTable * table, b2Body * body1, b2Body * body2);
+	int bmx_b2filtertable_getexcludedpaircount(b2FilterTable * table);
+	void bmx_b2filtertable_clearexcludedpairs(b2FilterTable * table);
+	void bmx_b2filtertable_setraymask(b2FilterTable * table, int layer, int maskBits);
+	int bmx_b2filtertable_getraymask(b2FilterTable * table, int layer);
 	int bmx_b2world_inrange(b2World * world, Maxb2AABB * aabb);
 	b2Controller * bmx_b2world_createcontroller(b2World * world, b2ControllerDef * def, b2ControllerType type);
 	void bmx_b2world_destroycontroller(b2World * world, b2Controller * controller);
+	b2ParticleSystem * bmx_b2world_createparticlesystem(b2World * world, b2ParticleSystemDef * def);
+	void bmx_b2world_destroyparticlesystem(b2World * world, b2ParticleSystem * system);
+	int bmx_b2world_getparticlesystemcount(b2World * world);
 
 	b2BodyDef * bmx_b2bodydef_create();
 	void bmx_b2bodydef_delete(b2BodyDef * def);
@@ -201,10 +259,20 @@ extern "C" {
 	Maxb2Vec2 bmx_b2bodydef_getposition(b2BodyDef * def);
 	float32 bmx_b2bodydef_getangle(b2BodyDef * def);
 	int bmx_b2bodydef_isbullet(b2BodyDef * def);
+	void bmx_b2bodydef_setisactive(b2BodyDef * def, int active);
+	int bmx_b2bodydef_isactive(b2BodyDef * def);
 	b2MassData * bmx_b2bodydef_getmassdata(b2BodyDef * def);
 
-	b2World * bmx_b2world_create(Maxb2AABB * worldAABB, Maxb2Vec2 * gravity, int doSleep);
+	b2World * bmx_b2world_create(Maxb2AABB * worldAABB, Maxb2Vec2 * gravity, int doSleep, float32 cellSize);
 	void bmx_b2world_dostep(b2World * world, float32 timeStep, int velocityIterations, int positionIterations);
+	int bmx_b2world_advance(b2World * world, float32 elapsed, float32 timeStep, int velocityIterations, int positionIterations, int maxSteps);
+	float32 bmx_b2world_getinterpolationalpha(b2World * world);
+	int bmx_b2world_getinterpolatedtransforms(b2World * world, BBArray * bodies, BBArray * positions, BBArray * angles);
+	void bmx_b2world_dostepasync(b2World * world, float32 timeStep, int velocityIterations, int positionIterations);
+	void bmx_b2world_wait(b2World * world);
+	int bmx_b2world_isstepping(b2World * world);
+	int bmx_b2world_gettransforms(b2World * world, BBArray * bodies, BBArray * positions, BBArray * angles);
+	void bmx_b2world_setdirectjointsolver(b2World * world, int flag);
 
 	void bmx_b2shapedef_setfriction(b2ShapeDef * def, float32 friction);
 	void bmx_b2shapedef_setrestitution(b2ShapeDef * def, float32 restitution);
@@ -243,6 +311,8 @@ extern "C" {
 	void bmx_b2body_wakeup(b2Body * body);
 	void bmx_b2body_puttosleep(b2Body * body);
 	int bmx_b2body_isbullet(b2Body * body);
+	void bmx_b2body_setactive(b2Body * body, int flag);
+	int bmx_b2body_isactive(b2Body * body);
 	void bmx_b2body_setbullet(b2Body * body, int flag);
 	Maxb2Vec2 bmx_b2body_getworldcenter(b2Body * body);
 	Maxb2Vec2 bmx_b2body_getlocalcenter(b2Body * body);
@@ -271,6 +341,29 @@ extern "C" {
 	void bmx_b2debugdraw_appendflags(MaxDebugDraw * dbg, uint32 flags);
 	void bmx_b2debugdraw_clearflags(MaxDebugDraw * dbg, uint32 flags);
 
+	b2DebugDrawBuffer * bmx_b2debugdrawbuffer_create();
+	void bmx_b2debugdrawbuffer_delete(b2DebugDrawBuffer * buffer);
+	void bmx_b2debugdrawbuffer_setflags(b2DebugDrawBuffer * buffer, uint32 flags);
+	uint32 bmx_b2debugdrawbuffer_getflags(b2DebugDrawBuffer * buffer);
+	void bmx_b2debugdrawbuffer_clear(b2DebugDrawBuffer * buffer);
+	void bmx_b2debugdrawbuffer_setfillalpha(b2DebugDrawBuffer * buffer, float32 alpha);
+	void bmx_b2debugdrawbuffer_setaxisscale(b2DebugDrawBuffer * buffer, float32 scale);
+	void bmx_b2debugdrawbuffer_setcirclesegments(b2DebugDrawBuffer * buffer, int segments);
+	const b2DebugVertex * bmx_b2debugdrawbuffer_getlinevertices(b2DebugDrawBuffer * buffer);
+	int bmx_b2debugdrawbuffer_getlinevertexcount(b2DebugDrawBuffer * buffer);
+	const b2DebugVertex * bmx_b2debugdrawbuffer_gettrianglevertices(b2DebugDrawBuffer * buffer);
+	int bmx_b2debugdrawbuffer_gettrianglevertexcount(b2DebugDrawBuffer * buffer);
+	const uint32 * bmx_b2debugdrawbuffer_gettriangleindices(b2DebugDrawBuffer * buffer);
+	int bmx_b2debugdrawbuffer_gettriangleindexcount(b2DebugDrawBuffer * buffer);
+	const b2DebugCircle * bmx_b2debugdrawbuffer_getcircles(b2DebugDrawBuffer * buffer);
+	int bmx_b2debugdrawbuffer_getcirclecount(b2DebugDrawBuffer * buffer);
+
+	b2WorldRecorder * bmx_b2worldrecorder_create();
+	void bmx_b2worldrecorder_delete(b2WorldRecorder * recorder);
+	const void * bmx_b2worldrecorder_getdata(b2WorldRecorder * recorder);
+	int bmx_b2worldrecorder_getsize(b2WorldRecorder * recorder);
+	int bmx_b2worldrecorder_getstepcount(b2WorldRecorder * recorder);
+
 	b2CircleDef * bmx_b2circledef_create();
 	void bmx_b2circledef_setradius(b2CircleDef * def, float32 radius);
 	void bmx_b2circledef_setlocalposition(b2CircleDef * def, Maxb2Vec2 * pos);
@@ -279,6 +372,8 @@ extern "C" {
 	Maxb2Vec2 bmx_b2circledef_getlocalposition(b2CircleDef * def);
 
 	int bmx_b2shape_issensor(b2Shape * shape);
+	int32 bmx_b2shape_getoverlapcount(b2Shape * shape);
+	int32 bmx_b2shape_getoverlaps(b2Shape * shape, BBArray * shapes);
 	b2Body * bmx_b2shape_getbody(b2Shape * shape);
 	BBObject * bmx_b2shape_getmaxshape(b2Shape * shape);
 	void bmx_b2shape_setmaxshape(b2Shape * shape, BBObject * obj);
@@ -344,6 +439,9 @@ extern "C" {
 	MaxBoundaryListener * bmx_b2boundarylistener_new(BBObject * handle);
 	void bmx_b2boundarylistener_delete(MaxBoundaryListener * filter);
 
+	MaxSensorListener * bmx_b2sensorlistener_new(BBObject * handle);
+	void bmx_b2sensorlistener_delete(MaxSensorListener * listener);
+
 	void bmx_b2jointdef_setcollideconnected(b2JointDef * def, int collideConnected);
 	int bmx_b2jointdef_getcollideconnected(b2JointDef * def);
 	void bmx_b2jointdef_setbody1(b2JointDef * def, b2Body * body);
@@ -582,6 +680,50 @@ extern "C" {
 	void bmx_b2edgechaindef_delete(Maxb2EdgeChainDef * def);
 	void bmx_b2edgechaindef_setvertices(Maxb2EdgeChainDef * def, BBArray * vertices);
 
+	Maxb2MeshDef * bmx_b2meshdef_create();
+	b2MeshDef * bmx_b2meshdef_getdef(Maxb2MeshDef * def);
+	int bmx_b2meshdef_isaloop(Maxb2MeshDef * def);
+	void bmx_b2meshdef_setisaloop(Maxb2MeshDef * def, int value);
+	void bmx_b2meshdef_delete(Maxb2MeshDef * def);
+	void bmx_b2meshdef_setvertices(Maxb2MeshDef * def, BBArray * vertices);
+
+	int bmx_b2meshshape_getedgecount(b2MeshShape * shape);
+	b2EdgeShape * bmx_b2meshshape_getedge(b2MeshShape * shape, int index);
+
+	Maxb2TileGridDef * bmx_b2tilegriddef_create();
+	b2TileGridDef * bmx_b2tilegriddef_getdef(Maxb2TileGridDef * def);
+	void bmx_b2tilegriddef_setsize(Maxb2TileGridDef * def, int width, int height);
+	int bmx_b2tilegriddef_getwidth(Maxb2TileGridDef * def);
+	int bmx_b2tilegriddef_getheight(Maxb2TileGridDef * def);
+	void bmx_b2tilegriddef_settilesize(Maxb2TileGridDef * def, float32 size);
+	float32 bmx_b2tilegriddef_gettilesize(Maxb2TileGridDef * def);
+	void bmx_b2tilegriddef_settile(Maxb2TileGridDef * def, int x, int y, int tileType);
+	int bmx_b2tilegriddef_gettile(Maxb2TileGridDef * def, int x, int y);
+	void bmx_b2tilegriddef_settiles(Maxb2TileGridDef * def, BBArray * tiles);
+	void bmx_b2tilegriddef_delete(Maxb2TileGridDef * def);
+
+	int bmx_b2tilegridshape_getwidth(b2TileGridShape * shape);
+	int bmx_b2tilegridshape_getheight(b2TileGridShape * shape);
+	float32 bmx_b2tilegridshape_gettilesize(b2TileGridShape * shape);
+	int bmx_b2tilegridshape_gettile(b2TileGridShape * shape, int x, int y);
+	void bmx_b2tilegridshape_settile(b2TileGridShape * shape, int x, int y, int tileType);
+
+	Maxb2HeightfieldDef * bmx_b2heightfielddef_create();
+	b2HeightfieldDef * bmx_b2heightfielddef_getdef(Maxb2HeightfieldDef * def);
+	void bmx_b2heightfielddef_setheights(Maxb2HeightfieldDef * def, BBArray * heights);
+	void bmx_b2heightfielddef_setspacing(Maxb2HeightfieldDef * def, float32 spacing);
+	float32 bmx_b2heightfielddef_getspacing(Maxb2HeightfieldDef * def);
+	void bmx_b2heightfielddef_setheightrange(Maxb2HeightfieldDef * def, float32 minHeight, float32 maxHeight);
+	void bmx_b2heightfielddef_delete(Maxb2HeightfieldDef * def);
+
+	int bmx_b2heightfieldshape_getsamplecount(b2HeightfieldShape * shape);
+	float32 bmx_b2heightfieldshape_getspacing(b2HeightfieldShape * shape);
+	float32 bmx_b2heightfieldshape_getheight(b2HeightfieldShape * shape, int index);
+	void bmx_b2heightfieldshape_setheight(b2HeightfieldShape * shape, int index, float32 height);
+	void bmx_b2heightfieldshape_setheights(b2HeightfieldShape * shape, int first, BBArray * heights);
+	int bmx_b2heightfieldshape_getedgecount(b2HeightfieldShape * shape);
+	b2EdgeShape * bmx_b2heightfieldshape_getedge(b2HeightfieldShape * shape, int index);
+
 	float32 bmx_b2edgeshape_getlength(b2EdgeShape * shape);
 	Maxb2Vec2 bmx_b2edgeshape_getvertex1(b2EdgeShape * shape);
 	Maxb2Vec2 bmx_b2edgeshape_getvertex2(b2EdgeShape * shape);
@@ -694,6 +836,42 @@ extern "C" {
 	b2World * bmx_b2controller_getworld(b2Controller * c);
 	b2ControllerEdge * bmx_b2controller_getbodylist(b2Controller * c);
 
+	b2ParticleSystemDef * bmx_b2particlesystemdef_create();
+	void bmx_b2particlesystemdef_setdensity(b2ParticleSystemDef * def, float32 density);
+	float32 bmx_b2particlesystemdef_getdensity(b2ParticleSystemDef * def);
+	void bmx_b2particlesystemdef_setgravityscale(b2ParticleSystemDef * def, float32 scale);
+	float32 bmx_b2particlesystemdef_getgravityscale(b2ParticleSystemDef * def);
+	void bmx_b2particlesystemdef_setdamping(b2ParticleSystemDef * def, float32 damping);
+	float32 bmx_b2particlesystemdef_getdamping(b2ParticleSystemDef * def);
+	void bmx_b2particlesystemdef_setfriction(b2ParticleSystemDef * def, float32 friction);
+	float32 bmx_b2particlesystemdef_getfriction(b2ParticleSystemDef * def);
+	void bmx_b2particlesystemdef_setrestitution(b2ParticleSystemDef * def, float32 restitution);
+	float32 bmx_b2particlesystemdef_getrestitution(b2ParticleSystemDef * def);
+	void bmx_b2particlesystemdef_setpressurestrength(b2ParticleSystemDef * def, float32 strength);
+	float32 bmx_b2particlesystemdef_getpressurestrength(b2ParticleSystemDef * def);
+	void bmx_b2particlesystemdef_setviscousstrength(b2ParticleSystemDef * def, float32 strength);
+	float32 bmx_b2particlesystemdef_getviscousstrength(b2ParticleSystemDef * def);
+	void bmx_b2particlesystemdef_setmaxcount(b2ParticleSystemDef * def, int maxCount);
+	int bmx_b2particlesystemdef_getmaxcount(b2ParticleSystemDef * def);
+	void bmx_b2particlesystemdef_setfilter(b2ParticleSystemDef * def, Maxb2FilterData filterData);
+	Maxb2FilterData bmx_b2particlesystemdef_getfilter(b2ParticleSystemDef * def);
+	void bmx_b2particlesystemdef_delete(b2ParticleSystemDef * def);
+
+	int bmx_b2particlesystem_createparticle(b2ParticleSystem * system, Maxb2Vec2 * position, Maxb2Vec2 * velocity, float32 radius, int flags, float32 lifetime);
+	void bmx_b2particlesystem_destroyparticle(b2ParticleSystem * system, int index);
+	int bmx_b2particlesystem_getparticlecount(b2ParticleSystem * system);
+	int bmx_b2particlesystem_getmaxparticlecount(b2ParticleSystem * system);
+	Maxb2Vec2 bmx_b2particlesystem_getposition(b2ParticleSystem * system, int index);
+	void bmx_b2particlesystem_setposition(b2ParticleSystem * system, int index, Maxb2Vec2 * position);
+	Maxb2Vec2 bmx_b2particlesystem_getvelocity(b2ParticleSystem * system, int index);
+	void bmx_b2particlesystem_setvelocity(b2ParticleSystem * system, int index, Maxb2Vec2 * velocity);
+	int bmx_b2particlesystem_getpositions(b2ParticleSystem * system, BBArray * positions);
+	int bmx_b2particlesystem_getvelocities(b2ParticleSystem * system, BBArray * velocities);
+	int bmx_b2particlesystem_getradii(b2ParticleSystem * system, BBArray * radii);
+	int bmx_b2particlesystem_getflags(b2ParticleSystem * system, BBArray * flags);
+	int bmx_b2particlesystem_getcontactcount(b2ParticleSystem * system);
+	int bmx_b2particlesystem_getshapecontactcount(b2ParticleSystem * system);
+
 }
 
 // *****************************************************
@@ -730,6 +908,110 @@ public:
 	b2Vec2 * vertices;
 };
 
+// *****************************************************
+
+class Maxb2MeshDef
+{
+public:
+	Maxb2MeshDef()
+	{
+		def = new b2MeshDef;
+		vertices = NULL;
+	}
+	
+	~Maxb2MeshDef()
+	{
+		delete def;
+		if (vertices) {
+			delete [] vertices;
+		}
+	}
+
+	void initVertices(int size) {
+		if (vertices) {
+			delete [] vertices;
+			def->vertices = NULL;
+		}
+		
+		vertices = new b2Vec2[size];
+		def->vertexCount = size;
+		def->vertices = vertices;
+	}	
+	
+	b2MeshDef * def;
+	b2Vec2 * vertices;
+};
+
+// *****************************************************
+
+class Maxb2TileGridDef
+{
+public:
+	Maxb2TileGridDef()
+	{
+		def = new b2TileGridDef;
+		tiles = NULL;
+	}
+	
+	~Maxb2TileGridDef()
+	{
+		delete def;
+		if (tiles) {
+			delete [] tiles;
+		}
+	}
+
+	void initTiles(int width, int height) {
+		if (tiles) {
+			delete [] tiles;
+			def->tiles = NULL;
+		}
+		
+		tiles = new uint8[width * height];
+		memset(tiles, e_tileEmpty, width * height);
+		def->width = width;
+		def->height = height;
+		def->tiles = tiles;
+	}	
+	
+	b2TileGridDef * def;
+	uint8 * tiles;
+};
+
+// *****************************************************
+
+class Maxb2HeightfieldDef
+{
+public:
+	Maxb2HeightfieldDef()
+	{
+		def = new b2HeightfieldDef;
+		heights = NULL;
+	}
+	
+	~Maxb2HeightfieldDef()
+	{
+		delete def;
+		if (heights) {
+			delete [] heights;
+		}
+	}
+
+	void initHeights(int size) {
+		if (heights) {
+			delete [] heights;
+			def->heights = NULL;
+		}
+		
+		heights = new float32[size];
+		def->sampleCount = size;
+		def->heights = heights;
+	}	
+	
+	b2HeightfieldDef * def;
+	float32 * heights;
+};
+
 
 // *****************************************************
 
@@ -803,10 +1085,49 @@ void bmx_b2world_validate(b2World * world) {
 	world->Validate();
 }
 
+void bmx_b2world_setvelocitytolerance(b2World * world, float32 tolerance) {
+	world->SetVelocityTolerance(tolerance);
+}
+
+void bmx_b2world_setstepbudget(b2World * world, float32 milliseconds) {
+	world->SetStepBudget(milliseconds);
+}
+
+int bmx_b2world_isdegraded(b2World * world) {
+	return world->IsDegraded();
+}
+
+void bmx_b2world_setprofiling(b2World * world, int flag) {
+	world->SetProfiling(flag);
+}
+
+Maxb2Profile bmx_b2world_getprofile(b2World * world) {
+	const b2Profile& p = world->GetProfile();
+	Maxb2Profile profile = {p.step, p.collide, p.solve, p.islandBuild, p.solveInit, p.solveVelocity,
+		p.solvePosition, p.solveTOI, p.broadphase, p.listeners, p.particles, p.islandCount, p.bodyCount, p.contactCount,
+		p.jointCount, p.velocityIterations, p.positionIterations, p.toiCount, p.listenerCalls,
+		p.pairsAdded, p.pairsRemoved, p.pairsCancelled, p.particleCount};
+	return profile;
+}
+
+void bmx_b2world_setrecorder(b2World * world, b2WorldRecorder * recorder) {
+	world->SetRecorder(recorder);
+}
+
 void bmx_b2world_setdebugDraw(b2World * world, b2DebugDraw * debugDraw) {
 	world->SetDebugDraw(debugDraw);
 }
 
+void bmx_b2world_setdebugdrawview(b2World * world, Maxb2AABB * view) {
+	b2AABB b;
+	bmx_Maxb2AABBtob2AABB(view, &b);
+	world->SetDebugDrawView(b);
+}
+
+void bmx_b2world_cleardebugdrawview(b2World * world) {
+	world->ClearDebugDrawView();
+}
+
 b2Joint * bmx_b2world_createjoint(b2World * world, b2JointDef * def) {
 	BBObject * joint = CB_PREF(physics_box2d_b2World__createJoint)(def->type);
 	def->userData = joint;
@@ -838,6 +1159,10 @@ void bmx_b2world_setcontactlistener(b2World * world, b2ContactListener * listene
 	world->SetContactListener(listener);
 }
 
+void bmx_b2world_setsensorlistener(b2World * world, b2SensorListener * listener) {
+	world->SetSensorListener(listener);
+}
+
 void bmx_b2world_setboundarylistener(b2World * world, b2BoundaryListener * listener) {
 	world->SetBoundaryListener(listener);
 }
@@ -892,7 +1217,7 @@ void bmx_b2world_refilter(b2World * world, b2Shape * shape) {
 	world->Refilter(shape);
 }
 
-int32 bmx_b2world_raycast(b2World * world, Maxb2Segment * segment, BBArray * shapes, int solidShapes) {
+int32 bmx_b2world_raycast(b2World * world, Maxb2Segment * segment, BBArray * shapes, int solidShapes, int layer) {
 	int32 n = shapes->scales[0];
 	b2Shape* _shapes[n];
 	
@@ -900,7 +1225,7 @@ int32 bmx_b2world_raycast(b2World * world, Maxb2Segment * segment, BBArray * sha
 	s.p1 = b2Vec2(segment->p1.x, segment->p1.y);
 	s.p2 = b2Vec2(segment->p2.x, segment->p2.y);
 	
-	int32 ret = world->Raycast(s, _shapes, n, solidShapes, NULL);
+	int32 ret = world->Raycast(s, _shapes, n, solidShapes, NULL, layer);
 
 	int32 count = (ret < n) ? ret : n;
 
@@ -911,18 +1236,56 @@ int32 bmx_b2world_raycast(b2World * world, Maxb2Segment * segment, BBArray * sha
 	return ret;
 }
 
-b2Shape * bmx_b2world_raycastone(b2World * world, Maxb2Segment * segment, float32 * lambda, Maxb2Vec2 * normal, int solidShapes) {
+b2Shape * bmx_b2world_raycastone(b2World * world, Maxb2Segment * segment, float32 * lambda, Maxb2Vec2 * normal, int solidShapes, int layer) {
 	b2Vec2 norm;
 	b2Segment s;
 	s.p1 = b2Vec2(segment->p1.x, segment->p1.y);
 	s.p2 = b2Vec2(segment->p2.x, segment->p2.y);
 
-	b2Shape * shape = world->RaycastOne(s, lambda, &norm, solidShapes, NULL);
+	b2Shape * shape = world->RaycastOne(s, lambda, &norm, solidShapes, NULL, layer);
 	normal->x = norm.x;
 	normal->y = norm.y;
 	return shape;
 }
 
+b2FilterTable * bmx_b2world_getfiltertable(b2World * world) {
+	return world->GetFilterTable();
+}
+
+// *****************************************************
+
+void bmx_b2filtertable_setcategorycollision(b2FilterTable * table, int category1, int category2, int flag) {
+	table->SetCategoryCollision(category1, category2, flag);
+}
+
+int bmx_b2filtertable_getcategorycollision(b2FilterTable * table, int category1, int category2) {
+	return table->GetCategoryCollision(category1, category2);
+}
+
+void bmx_b2filtertable_setbodypairexcluded(b2FilterTable * table, b2Body * body1, b2Body * body2, int flag) {
+	table->SetBodyPairExcluded(body1, body2, flag);
+}
+
+int bmx_b2filtertable_isbodypairexcluded(b2FilterTable * table, b2Body * body1, b2Body * body2) {
+	return table->IsBodyPairExcluded(body1, body2);
+}
+
+int bmx_b2filtertable_getexcludedpaircount(b2FilterTable * table) {
+	return table->GetExcludedPairCount();
+}
+
+void bmx_b2filtertable_clearexcludedpairs(b2FilterTable * table) {
+	table->ClearExcludedPairs();
+}
+
+void bmx_b2filtertable_setraymask(b2FilterTable * table, int layer, int maskBits) {
+	table->SetRayMask(layer, maskBits);
+}
+
+int bmx_b2filtertable_getraymask(b2FilterTable * table, int layer) {
+	return table->GetRayMask(layer);
+}
+
 int bmx_b2world_inrange(b2World * world, Maxb2AABB * aabb) {
 	b2AABB b;
 	bmx_Maxb2AABBtob2AABB(aabb, &b);
@@ -947,6 +1310,18 @@ void bmx_b2world_destroycontroller(b2World * world, b2Controller * controller) {
 	world->DestroyController(controller);
 }
 
+b2ParticleSystem * bmx_b2world_createparticlesystem(b2World * world, b2ParticleSystemDef * def) {
+	return world->CreateParticleSystem(def);
+}
+
+void bmx_b2world_destroyparticlesystem(b2World * world, b2ParticleSystem * system) {
+	world->DestroyParticleSystem(system);
+}
+
+int bmx_b2world_getparticlesystemcount(b2World * world) {
+	return world->GetParticleSystemCount();
+}
+
 
 // *****************************************************
 
@@ -1031,15 +1406,26 @@ int bmx_b2bodydef_isbullet(b2BodyDef * def) {
 	return def->isBullet;
 }
 
+void bmx_b2bodydef_setisactive(b2BodyDef * def, int active) {
+	def->isActive = active;
+}
+
+int bmx_b2bodydef_isactive(b2BodyDef * def) {
+	return def->isActive;
+}
+
 b2MassData * bmx_b2bodydef_getmassdata(b2BodyDef * def) {
 	return &def->massData;
 }
 
 // *****************************************************
 
-b2World * bmx_b2world_create(Maxb2AABB * worldAABB, Maxb2Vec2 * gravity, int doSleep) {
+b2World * bmx_b2world_create(Maxb2AABB * worldAABB, Maxb2Vec2 * gravity, int doSleep, float32 cellSize) {
 	b2AABB b;
 	bmx_Maxb2AABBtob2AABB( worldAABB, &b);
+	if (cellSize > 0.0f) {
+		return new b2World(b, b2Vec2(gravity->x, gravity->y), doSleep, cellSize);
+	}
 	return new b2World(b, b2Vec2(gravity->x, gravity->y), doSleep);
 }
 
@@ -1047,6 +1433,82 @@ void bmx_b2world_dostep(b2World * world, float32 timeStep, int velocityIteration
 	world->Step(timeStep, velocityIterations, positionIterations);
 }
 
+int bmx_b2world_advance(b2World * world, float32 elapsed, float32 timeStep, int velocityIterations, int positionIterations, int maxSteps) {
+	return world->Advance(elapsed, timeStep, velocityIterations, positionIterations, maxSteps);
+}
+
+float32 bmx_b2world_getinterpolationalpha(b2World * world) {
+	return world->GetInterpolationAlpha();
+}
+
+int bmx_b2world_getinterpolatedtransforms(b2World * world, BBArray * bodies, BBArray * positions, BBArray * angles) {
+	int32 n = bodies->scales[0];
+	if (positions->scales[0] < n) {
+		n = positions->scales[0];
+	}
+	if (angles->scales[0] < n) {
+		n = angles->scales[0];
+	}
+
+	b2Body* _bodies[n];
+	b2Vec2 _positions[n];
+
+	float32* _angles = (float32*)BBARRAYDATA(angles, angles->dims);
+	int32 count = world->GetInterpolatedTransforms(_bodies, _positions, _angles, n);
+
+	Maxb2Vec2* mv = (Maxb2Vec2*)BBARRAYDATA(positions, positions->dims);
+	for (int i = 0; i < count; i++) {
+		mv[i].x = _positions[i].x;
+		mv[i].y = _positions[i].y;
+		_angles[i] *= 57.2957795f;
+		CB_PREF(physics_box2d_b2World__setBody)(bodies, i, _bodies[i]);
+	}
+
+	return count;
+}
+
+void bmx_b2world_dostepasync(b2World * world, float32 timeStep, int velocityIterations, int positionIterations) {
+	world->StepAsync(timeStep, velocityIterations, positionIterations);
+}
+
+void bmx_b2world_wait(b2World * world) {
+	world->Wait();
+}
+
+int bmx_b2world_isstepping(b2World * world) {
+	return world->IsStepping();
+}
+
+int bmx_b2world_gettransforms(b2World * world, BBArray * bodies, BBArray * positions, BBArray * angles) {
+	int32 n = bodies->scales[0];
+	if (positions->scales[0] < n) {
+		n = positions->scales[0];
+	}
+	if (angles->scales[0] < n) {
+		n = angles->scales[0];
+	}
+
+	b2Body* _bodies[n];
+	b2Vec2 _positions[n];
+
+	float32* _angles = (float32*)BBARRAYDATA(angles, angles->dims);
+	int32 count = world->GetTransforms(_bodies, _positions, _angles, n);
+
+	Maxb2Vec2* mv = (Maxb2Vec2*)BBARRAYDATA(positions, positions->dims);
+	for (int i = 0; i < count; i++) {
+		mv[i].x = _positions[i].x;
+		mv[i].y = _positions[i].y;
+		_angles[i] *= 57.2957795f;
+		CB_PREF(physics_box2d_b2World__setBody)(bodies, i, _bodies[i]);
+	}
+
+	return count;
+}
+
+void bmx_b2world_setdirectjointsolver(b2World * world, int flag) {
+	world->SetDirectJointSolver(flag);
+}
+
 
 // *****************************************************
 
@@ -1242,6 +1704,14 @@ void bmx_b2body_setbullet(b2Body * body, int flag) {
 	body->SetBullet(flag);
 }
 
+void bmx_b2body_setactive(b2Body * body, int flag) {
+	body->SetActive(flag);
+}
+
+int bmx_b2body_isactive(b2Body * body) {
+	return body->IsActive();
+}
+
 Maxb2Vec2 bmx_b2body_getworldcenter(b2Body * body) {
 	b2Vec2 c = body->GetWorldCenter();
 	return {c.x, c.y};
@@ -1426,6 +1896,94 @@ void bmx_b2debugdraw_clearflags(MaxDebugDraw * dbg, uint32 flags) {
 
 // *****************************************************
 
+b2DebugDrawBuffer * bmx_b2debugdrawbuffer_create() {
+	return new b2DebugDrawBuffer;
+}
+
+void bmx_b2debugdrawbuffer_delete(b2DebugDrawBuffer * buffer) {
+	delete buffer;
+}
+
+void bmx_b2debugdrawbuffer_setflags(b2DebugDrawBuffer * buffer, uint32 flags) {
+	buffer->SetFlags(flags);
+}
+
+uint32 bmx_b2debugdrawbuffer_getflags(b2DebugDrawBuffer * buffer) {
+	return buffer->GetFlags();
+}
+
+void bmx_b2debugdrawbuffer_clear(b2DebugDrawBuffer * buffer) {
+	buffer->Clear();
+}
+
+void bmx_b2debugdrawbuffer_setfillalpha(b2DebugDrawBuffer * buffer, float32 alpha) {
+	buffer->SetFillAlpha(alpha);
+}
+
+void bmx_b2debugdrawbuffer_setaxisscale(b2DebugDrawBuffer * buffer, float32 scale) {
+	buffer->SetAxisScale(scale);
+}
+
+void bmx_b2debugdrawbuffer_setcirclesegments(b2DebugDrawBuffer * buffer, int segments) {
+	buffer->SetCircleSegments(segments);
+}
+
+const b2DebugVertex * bmx_b2debugdrawbuffer_getlinevertices(b2DebugDrawBuffer * buffer) {
+	return buffer->GetLineVertices();
+}
+
+int bmx_b2debugdrawbuffer_getlinevertexcount(b2DebugDrawBuffer * buffer) {
+	return buffer->GetLineVertexCount();
+}
+
+const b2DebugVertex * bmx_b2debugdrawbuffer_gettrianglevertices(b2DebugDrawBuffer * buffer) {
+	return buffer->GetTriangleVertices();
+}
+
+int bmx_b2debugdrawbuffer_gettrianglevertexcount(b2DebugDrawBuffer * buffer) {
+	return buffer->GetTriangleVertexCount();
+}
+
+const uint32 * bmx_b2debugdrawbuffer_gettriangleindices(b2DebugDrawBuffer * buffer) {
+	return buffer->GetTriangleIndices();
+}
+
+int bmx_b2debugdrawbuffer_gettriangleindexcount(b2DebugDrawBuffer * buffer) {
+	return buffer->GetTriangleIndexCount();
+}
+
+const b2DebugCircle * bmx_b2debugdrawbuffer_getcircles(b2DebugDrawBuffer * buffer) {
+	return buffer->GetCircles();
+}
+
+int bmx_b2debugdrawbuffer_getcirclecount(b2DebugDrawBuffer * buffer) {
+	return buffer->GetCircleCount();
+}
+
+// *****************************************************
+
+b2WorldRecorder * bmx_b2worldrecorder_create() {
+	return new b2WorldRecorder;
+}
+
+void bmx_b2worldrecorder_delete(b2WorldRecorder * recorder) {
+	delete recorder;
+}
+
+const void * bmx_b2worldrecorder_getdata(b2WorldRecorder * recorder) {
+	return recorder->GetData();
+}
+
+int bmx_b2worldrecorder_getsize(b2WorldRecorder * recorder) {
+	return recorder->GetSize();
+}
+
+int bmx_b2worldrecorder_getstepcount(b2WorldRecorder * recorder) {
+	return recorder->GetStepCount();
+}
+
+// *****************************************************
+
 b2CircleDef * bmx_b2circledef_create() {
 	return new b2CircleDef;
 }
@@ -1458,6 +2016,21 @@ int bmx_b2shape_issensor(b2Shape * shape) {
 	return shape->IsSensor();
 }
 
+int32 bmx_b2shape_getoverlapcount(b2Shape * shape) {
+	return shape->GetOverlapCount();
+}
+
+int32 bmx_b2shape_getoverlaps(b2Shape * shape, BBArray * shapes) {
+	int32 n = shapes->scales[0];
+	int32 count = 0;
+
+	for (b2SensorEdge * edge = shape->GetOverlapList(); edge && count < n; edge = edge->next) {
+		CB_PREF(physics_box2d_b2World__setShape)(shapes, count++, edge->other);
+	}
+
+	return count;
+}
+
 b2Body * bmx_b2shape_getbody(b2Shape * shape) {
 	return shape->GetBody();
 }
@@ -1862,6 +2435,37 @@ void bmx_b2boundarylistener_delete(MaxBoundaryListener * listener) {
 
 // *****************************************************
 
+class MaxSensorListener : public b2SensorListener
+{
+public:
+	MaxSensorListener(BBObject * handle)
+		: maxHandle(handle)
+	{
+	}
+	
+	void BeginOverlap(b2Shape* sensor, b2Shape* shape) {
+		CB_PREF(physics_box2d_b2SensorListener__BeginOverlap)(maxHandle, sensor, shape);
+	}
+	
+	void EndOverlap(b2Shape* sensor, b2Shape* shape) {
+		CB_PREF(physics_box2d_b2SensorListener__EndOverlap)(maxHandle, sensor, shape);
+	}
+	
+private:
+	BBObject * maxHandle;
+};
+
+
+MaxSensorListener * bmx_b2sensorlistener_new(BBObject * handle) {
+	return new MaxSensorListener(handle);
+}
+
+void bmx_b2sensorlistener_delete(MaxSensorListener * listener) {
+	delete listener;
+}
+
+// *****************************************************
+
 void bmx_b2jointdef_setcollideconnected(b2JointDef * def, int collideConnected) {
 	def->collideConnected = collideConnected;
 }
@@ -2882,6 +3486,193 @@ void bmx_b2edgechaindef_setvertices(Maxb2EdgeChainDef * def, BBArray * vertices)
 
 // *****************************************************
 
+Maxb2MeshDef * bmx_b2meshdef_create() {
+	return new Maxb2MeshDef;
+}
+
+b2MeshDef * bmx_b2meshdef_getdef(Maxb2MeshDef * def) {
+	return def->def;
+}
+
+int bmx_b2meshdef_isaloop(Maxb2MeshDef * def) {
+	return def->def->isALoop;
+}
+
+void bmx_b2meshdef_setisaloop(Maxb2MeshDef * def, int value) {
+	def->def->isALoop = value;
+}
+
+void bmx_b2meshdef_delete(Maxb2MeshDef * def) {
+	delete def;
+}
+
+void bmx_b2meshdef_setvertices(Maxb2MeshDef * def, BBArray * vertices) {
+
+	int n = vertices->scales[0];
+
+	def->initVertices(n);
+	
+	Maxb2Vec2* mv=(Maxb2Vec2*)BBARRAYDATA( vertices,vertices->dims );
+	b2Vec2* vp = def->vertices;
+	
+	for (int i = 0; i < n; i++) {
+		vp->x = mv->x;
+		vp->y = mv->y;
+		
+		vp++;
+		mv++;
+	}
+}
+
+// *****************************************************
+
+int bmx_b2meshshape_getedgecount(b2MeshShape * shape) {
+	return shape->GetEdgeCount();
+}
+
+b2EdgeShape * bmx_b2meshshape_getedge(b2MeshShape * shape, int index) {
+	return const_cast<b2EdgeShape*>(shape->GetEdge(index));
+}
+
+// *****************************************************
+
+Maxb2TileGridDef * bmx_b2tilegriddef_create() {
+	return new Maxb2TileGridDef;
+}
+
+b2TileGridDef * bmx_b2tilegriddef_getdef(Maxb2TileGridDef * def) {
+	return def->def;
+}
+
+void bmx_b2tilegriddef_setsize(Maxb2TileGridDef * def, int width, int height) {
+	def->initTiles(width, height);
+}
+
+int bmx_b2tilegriddef_getwidth(Maxb2TileGridDef * def) {
+	return def->def->width;
+}
+
+int bmx_b2tilegriddef_getheight(Maxb2TileGridDef * def) {
+	return def->def->height;
+}
+
+void bmx_b2tilegriddef_settilesize(Maxb2TileGridDef * def, float32 size) {
+	def->def->tileSize = size;
+}
+
+float32 bmx_b2tilegriddef_gettilesize(Maxb2TileGridDef * def) {
+	return def->def->tileSize;
+}
+
+void bmx_b2tilegriddef_settile(Maxb2TileGridDef * def, int x, int y, int tileType) {
+	b2Assert(0 <= x && x < def->def->width && 0 <= y && y < def->def->height);
+	def->tiles[y * def->def->width + x] = tileType;
+}
+
+int bmx_b2tilegriddef_gettile(Maxb2TileGridDef * def, int x, int y) {
+	b2Assert(0 <= x && x < def->def->width && 0 <= y && y < def->def->height);
+	return def->tiles[y * def->def->width + x];
+}
+
+void bmx_b2tilegriddef_settiles(Maxb2TileGridDef * def, BBArray * tiles) {
+	int n = tiles->scales[0];
+	b2Assert(n == def->def->width * def->def->height);
+
+	memcpy(def->tiles, BBARRAYDATA(tiles, tiles->dims), n);
+}
+
+void bmx_b2tilegriddef_delete(Maxb2TileGridDef * def) {
+	delete def;
+}
+
+// *****************************************************
+
+int bmx_b2tilegridshape_getwidth(b2TileGridShape * shape) {
+	return shape->GetWidth();
+}
+
+int bmx_b2tilegridshape_getheight(b2TileGridShape * shape) {
+	return shape->GetHeight();
+}
+
+float32 bmx_b2tilegridshape_gettilesize(b2TileGridShape * shape) {
+	return shape->GetTileSize();
+}
+
+int bmx_b2tilegridshape_gettile(b2TileGridShape * shape, int x, int y) {
+	return shape->GetTile(x, y);
+}
+
+void bmx_b2tilegridshape_settile(b2TileGridShape * shape, int x, int y, int tileType) {
+	shape->SetTile(x, y, tileType);
+}
+
+// *****************************************************
+
+Maxb2HeightfieldDef * bmx_b2heightfielddef_create() {
+	return new Maxb2HeightfieldDef;
+}
+
+b2HeightfieldDef * bmx_b2heightfielddef_getdef(Maxb2HeightfieldDef * def) {
+	return def->def;
+}
+
+void bmx_b2heightfielddef_setheights(Maxb2HeightfieldDef * def, BBArray * heights) {
+	int n = heights->scales[0];
+
+	def->initHeights(n);
+	memcpy(def->heights, BBARRAYDATA(heights, heights->dims), n * sizeof(float32));
+}
+
+void bmx_b2heightfielddef_setspacing(Maxb2HeightfieldDef * def, float32 spacing) {
+	def->def->spacing = spacing;
+}
+
+float32 bmx_b2heightfielddef_getspacing(Maxb2HeightfieldDef * def) {
+	return def->def->spacing;
+}
+
+void bmx_b2heightfielddef_setheightrange(Maxb2HeightfieldDef * def, float32 minHeight, float32 maxHeight) {
+	def->def->minHeight = minHeight;
+	def->def->maxHeight = maxHeight;
+}
+
+void bmx_b2heightfielddef_delete(Maxb2HeightfieldDef * def) {
+	delete def;
+}
+
+// *****************************************************
+
+int bmx_b2heightfieldshape_getsamplecount(b2HeightfieldShape * shape) {
+	return shape->GetSampleCount();
+}
+
+float32 bmx_b2heightfieldshape_getspacing(b2HeightfieldShape * shape) {
+	return shape->GetSpacing();
+}
+
+float32 bmx_b2heightfieldshape_getheight(b2HeightfieldShape * shape, int index) {
+	return shape->GetHeight(index);
+}
+
+void bmx_b2heightfieldshape_setheight(b2HeightfieldShape * shape, int index, float32 height) {
+	shape->SetHeight(index, height);
+}
+
+void bmx_b2heightfieldshape_setheights(b2HeightfieldShape * shape, int first, BBArray * heights) {
+	shape->SetHeights(first, (float32*)BBARRAYDATA(heights, heights->dims), heights->scales[0]);
+}
+
+int bmx_b2heightfieldshape_getedgecount(b2HeightfieldShape * shape) {
+	return shape->GetEdgeCount();
+}
+
+b2EdgeShape * bmx_b2heightfieldshape_getedge(b2HeightfieldShape * shape, int index) {
+	return const_cast<b2EdgeShape*>(shape->GetEdge(index));
+}
+
+// *****************************************************
+
 float32 bmx_b2edgeshape_getlength(b2EdgeShape * shape) {
 	return shape->GetLength();
 }
@@ -3339,3 +4130,166 @@ b2World * bmx_b2controller_getworld(b2Controller * c) {
 b2ControllerEdge * bmx_b2controller_getbodylist(b2Controller * c) {
 	return c->GetBodyList();
 }
+
+// *****************************************************
+
+b2ParticleSystemDef * bmx_b2particlesystemdef_create() {
+	return new b2ParticleSystemDef;
+}
+
+void bmx_b2particlesystemdef_setdensity(b2ParticleSystemDef * def, float32 density) {
+	def->density = density;
+}
+
+float32 bmx_b2particlesystemdef_getdensity(b2ParticleSystemDef * def) {
+	return def->density;
+}
+
+void bmx_b2particlesystemdef_setgravityscale(b2ParticleSystemDef * def, float32 scale) {
+	def->gravityScale = scale;
+}
+
+float32 bmx_b2particlesystemdef_getgravityscale(b2ParticleSystemDef * def) {
+	return def->gravityScale;
+}
+
+void bmx_b2particlesystemdef_setdamping(b2ParticleSystemDef * def, float32 damping) {
+	def->damping = damping;
+}
+
+float32 bmx_b2particlesystemdef_getdamping(b2ParticleSystemDef * def) {
+	return def->damping;
+}
+
+void bmx_b2particlesystemdef_setfriction(b2ParticleSystemDef * def, float32 friction) {
+	def->friction = friction;
+}
+
+float32 bmx_b2particlesystemdef_getfriction(b2ParticleSystemDef * def) {
+	return def->friction;
+}
+
+void bmx_b2particlesystemdef_setrestitution(b2ParticleSystemDef * def, float32 restitution) {
+	def->restitution = restitution;
+}
+
+float32 bmx_b2particlesystemdef_getrestitution(b2ParticleSystemDef * def) {
+	return def->restitution;
+}
+
+void bmx_b2particlesystemdef_setpressurestrength(b2ParticleSystemDef * def, float32 strength) {
+	def->pressureStrength = strength;
+}
+
+float32 bmx_b2particlesystemdef_getpressurestrength(b2ParticleSystemDef * def) {
+	return def->pressureStrength;
+}
+
+void bmx_b2particlesystemdef_setviscousstrength(b2ParticleSystemDef * def, float32 strength) {
+	def->viscousStrength = strength;
+}
+
+float32 bmx_b2particlesystemdef_getviscousstrength(b2ParticleSystemDef * def) {
+	return def->viscousStrength;
+}
+
+void bmx_b2particlesystemdef_setmaxcount(b2ParticleSystemDef * def, int maxCount) {
+	def->maxCount = maxCount;
+}
+
+int bmx_b2particlesystemdef_getmaxcount(b2ParticleSystemDef * def) {
+	return def->maxCount;
+}
+
+void bmx_b2particlesystemdef_setfilter(b2ParticleSystemDef * def, Maxb2FilterData filterData) {
+	def->filter.categoryBits = filterData.categoryBits;
+	def->filter.groupIndex = filterData.groupIndex;
+	def->filter.maskBits = filterData.maskBits;
+}
+
+Maxb2FilterData bmx_b2particlesystemdef_getfilter(b2ParticleSystemDef * def) {
+	Maxb2FilterData filter = {def->filter.categoryBits, def->filter.maskBits, def->filter.groupIndex};
+	return filter;
+}
+
+void bmx_b2particlesystemdef_delete(b2ParticleSystemDef * def) {
+	delete def;
+}
+
+// *****************************************************
+
+int bmx_b2particlesystem_createparticle(b2ParticleSystem * system, Maxb2Vec2 * position, Maxb2Vec2 * velocity, float32 radius, int flags, float32 lifetime) {
+	b2ParticleDef def;
+	def.flags = flags;
+	def.position = b2Vec2(position->x, position->y);
+	def.velocity = b2Vec2(velocity->x, velocity->y);
+	def.radius = radius;
+	def.lifetime = lifetime;
+	return system->CreateParticle(def);
+}
+
+void bmx_b2particlesystem_destroyparticle(b2ParticleSystem * system, int index) {
+	system->DestroyParticle(index);
+}
+
+int bmx_b2particlesystem_getparticlecount(b2ParticleSystem * system) {
+	return system->GetParticleCount();
+}
+
+int bmx_b2particlesystem_getmaxparticlecount(b2ParticleSystem * system) {
+	return system->GetMaxParticleCount();
+}
+
+Maxb2Vec2 bmx_b2particlesystem_getposition(b2ParticleSystem * system, int index) {
+	b2Assert(0 <= index && index < system->GetParticleCount());
+	b2Vec2 v = system->GetPositionBuffer()[index];
+	return {v.x, v.y};
+}
+
+void bmx_b2particlesystem_setposition(b2ParticleSystem * system, int index, Maxb2Vec2 * position) {
+	b2Assert(0 <= index && index < system->GetParticleCount());
+	system->GetPositionBuffer()[index].Set(position->x, position->y);
+}
+
+Maxb2Vec2 bmx_b2particlesystem_getvelocity(b2ParticleSystem * system, int index) {
+	b2Assert(0 <= index && index < system->GetParticleCount());
+	b2Vec2 v = system->GetVelocityBuffer()[index];
+	return {v.x, v.y};
+}
+
+void bmx_b2particlesystem_setvelocity(b2ParticleSystem * system, int index, Maxb2Vec2 * velocity) {
+	b2Assert(0 <= index && index < system->GetParticleCount());
+	system->GetVelocityBuffer()[index].Set(velocity->x, velocity->y);
+}
+
+int bmx_b2particlesystem_getpositions(b2ParticleSystem * system, BBArray * positions) {
+	int32 n = b2Min(system->GetParticleCount(), (int32)positions->scales[0]);
+	memcpy(BBARRAYDATA(positions, positions->dims), system->GetPositionBuffer(), n * sizeof(Maxb2Vec2));
+	return n;
+}
+
+int bmx_b2particlesystem_getvelocities(b2ParticleSystem * system, BBArray * velocities) {
+	int32 n = b2Min(system->GetParticleCount(), (int32)velocities->scales[0]);
+	memcpy(BBARRAYDATA(velocities, velocities->dims), system->GetVelocityBuffer(), n * sizeof(Maxb2Vec2));
+	return n;
+}
+
+int bmx_b2particlesystem_getradii(b2ParticleSystem * system, BBArray * radii) {
+	int32 n = b2Min(system->GetParticleCount(), (int32)radii->scales[0]);
+	memcpy(BBARRAYDATA(radii, radii->dims), system->GetRadiusBuffer(), n * sizeof(float32));
+	return n;
+}
+
+int bmx_b2particlesystem_getflags(b2ParticleSystem * system, BBArray * flags) {
+	int32 n = b2Min(system->GetParticleCount(), (int32)flags->scales[0]);
+	memcpy(BBARRAYDATA(flags, flags->dims), system->GetFlagsBuffer(), n * sizeof(uint32));
+	return n;
+}
+
+int bmx_b2particlesystem_getcontactcount(b2ParticleSystem * system) {
+	return system->GetContactCount();
+}
+
+int bmx_b2particlesystem_getshapecontactcount(b2ParticleSystem * system) {
+	return system->GetShapeContactCount();
+}
@@ -36,12 +36,21 @@ For discussion please visit http://www.box2d.org/forum
 #include "../Source/Collision/Shapes/b2CircleShape.h"
 #include "../Source/Collision/Shapes/b2PolygonShape.h"
 #include "../Source/Collision/Shapes/b2EdgeShape.h"
+#include "../Source/Collision/Shapes/b2MeshShape.h"
+#include "../Source/Collision/Shapes/b2TileGridShape.h"
+#include "../Source/Collision/Shapes/b2HeightfieldShape.h"
 #include "../Source/Collision/b2BroadPhase.h"
+#include "../Source/Collision/b2SpatialHash.h"
 #include "../Source/Dynamics/b2WorldCallbacks.h"
+#include "../Source/Dynamics/b2DebugDrawBuffer.h"
+#include "../Source/Dynamics/b2FilterTable.h"
+#include "../Source/Dynamics/b2ParticleSystem.h"
 #include "../Source/Dynamics/b2World.h"
+#include "../Source/Dynamics/b2WorldRecorder.h"
 #include "../Source/Dynamics/b2Body.h"
 
 #include "../Source/Dynamics/Contacts/b2Contact.h"
+#include "../Source/Dynamics/Contacts/b2SensorPair.h"
 
 #include "../Source/Dynamics/Joints/b2DistanceJoint.h"
 #include "../Source/Dynamics/Joints/b2GearJoint.h"